@@ -60,6 +60,9 @@ COMMON_SRC_FILES += \
 	Main/FrameBufferAndroid.cpp \
 	Main/SwiftConfig.cpp
 
+COMMON_SRC_FILES += \
+	System/ThreadPool.cpp
+
 COMMON_SRC_FILES += \
 	Reactor/Routine.cpp \
 	Reactor/Debug.cpp \
@@ -79,6 +82,7 @@ COMMON_SRC_FILES += \
 endif
 
 COMMON_SRC_FILES += \
+	Renderer/ASTC_Decoder.cpp \
 	Renderer/Blitter.cpp \
 	Renderer/Clipper.cpp \
 	Renderer/Color.cpp \
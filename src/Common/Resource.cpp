@@ -19,14 +19,10 @@
 
 namespace sw
 {
-	Resource::Resource(size_t bytes) : size(bytes)
+	Resource::Resource(size_t bytes) : size(bytes), state(PUBLIC << ACCESSOR_SHIFT)
 	{
 		blocked = 0;
 
-		accessor = PUBLIC;
-		count = 0;
-		orphaned = false;
-
 		buffer = allocate(bytes);
 	}
 
@@ -37,144 +33,183 @@ namespace sw
 
 	void *Resource::lock(Accessor claimer)
 	{
-		criticalSection.lock();
+		unsigned int current = state.load(std::memory_order_relaxed);
 
-		while(count > 0 && accessor != claimer)
+		while(count(current) == 0 || accessor(current) == claimer)
 		{
-			blocked++;
-			criticalSection.unlock();
-
-			unblock.wait();
-
-			criticalSection.lock();
-			blocked--;
+			if(state.compare_exchange_weak(current, claim(current, claimer), std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return buffer;
+			}
 		}
 
-		accessor = claimer;
-		count++;
-
-		criticalSection.unlock();
-
-		return buffer;
+		return block(claimer);
 	}
 
 	void *Resource::lock(Accessor relinquisher, Accessor claimer)
 	{
-		criticalSection.lock();
+		unsigned int current = state.load(std::memory_order_relaxed);
 
-		// Release
-		while(count > 0 && accessor == relinquisher)
+		// Hand the lock over directly, unless others have to be woken up
+		while(count(current) > 0 && accessor(current) == relinquisher && !(current & (WAITING | ORPHANED)))
 		{
-			count--;
+			unsigned int handedOver = (claimer << ACCESSOR_SHIFT) | 1;
 
-			if(count == 0)
+			if(state.compare_exchange_weak(current, handedOver, std::memory_order_acq_rel, std::memory_order_relaxed))
 			{
-				if(blocked)
-				{
-					unblock.signal();
-				}
-				else if(orphaned)
-				{
-					criticalSection.unlock();
-
-					delete this;
-
-					return 0;
-				}
+				return buffer;
 			}
 		}
 
-		// Acquire
-		while(count > 0 && accessor != claimer)
+		if(count(current) > 0 && accessor(current) == relinquisher)
 		{
-			blocked++;
-			criticalSection.unlock();
+			if(!release(relinquisher, true))
+			{
+				return nullptr;
+			}
+		}
+
+		return lock(claimer);
+	}
 
-			unblock.wait();
+	void Resource::unlock()
+	{
+		unsigned int current = state.load(std::memory_order_relaxed);
+		ASSERT(count(current) > 0);
 
-			criticalSection.lock();
-			blocked--;
+		while(count(current) > 1 || !(current & (WAITING | ORPHANED)))
+		{
+			if(state.compare_exchange_weak(current, current - 1, std::memory_order_release, std::memory_order_relaxed))
+			{
+				return;
+			}
 		}
 
-		accessor = claimer;
-		count++;
+		release(accessor(current), false);
+	}
 
-		criticalSection.unlock();
+	void Resource::unlock(Accessor relinquisher)
+	{
+		unsigned int current = state.load(std::memory_order_relaxed);
+		ASSERT(count(current) > 0);
 
-		return buffer;
+		while(count(current) > 0 && accessor(current) == relinquisher)
+		{
+			if(current & (WAITING | ORPHANED))
+			{
+				release(relinquisher, true);
+
+				return;
+			}
+
+			if(state.compare_exchange_weak(current, current & ~COUNT_MASK, std::memory_order_release, std::memory_order_relaxed))
+			{
+				return;
+			}
+		}
 	}
 
-	void Resource::unlock()
+	void *Resource::block(Accessor claimer)
 	{
-		criticalSection.lock();
-		ASSERT(count > 0);
+		std::unique_lock<std::mutex> lock(mutex);
+		blocked++;
 
-		count--;
+		unsigned int current = state.load(std::memory_order_relaxed);
 
-		if(count == 0)
+		while(true)
 		{
-			if(blocked)
+			if(count(current) == 0 || accessor(current) == claimer)
 			{
-				unblock.signal();
+				unsigned int claimed = claim(current, claimer);
+
+				if(blocked == 1)
+				{
+					claimed &= ~WAITING;
+				}
+
+				if(state.compare_exchange_weak(current, claimed, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					break;
+				}
 			}
-			else if(orphaned)
+			else if(!(current & WAITING))
 			{
-				criticalSection.unlock();
-
-				delete this;
+				// Releasing threads only take the mutex when they see this flag
+				if(state.compare_exchange_weak(current, current | WAITING, std::memory_order_relaxed, std::memory_order_relaxed))
+				{
+					current |= WAITING;
+				}
+			}
+			else
+			{
+				unblock.wait(lock);
 
-				return;
+				current = state.load(std::memory_order_relaxed);
 			}
 		}
 
-		criticalSection.unlock();
+		blocked--;
+
+		return buffer;
 	}
 
-	void Resource::unlock(Accessor relinquisher)
+	bool Resource::release(Accessor relinquisher, bool all)
 	{
-		criticalSection.lock();
-		ASSERT(count > 0);
+		// Dropping the count under the mutex keeps waiters from taking and releasing the
+		// resource, and deleting it if orphaned, before this thread is done with it.
+		std::unique_lock<std::mutex> lock(mutex);
+
+		unsigned int current = state.load(std::memory_order_relaxed);
+		unsigned int released = 0;
 
-		while(count > 0 && accessor == relinquisher)
+		do
 		{
-			count--;
+			if(count(current) == 0 || accessor(current) != relinquisher)
+			{
+				return true;
+			}
 
-			if(count == 0)
+			released = all ? (current & ~COUNT_MASK) : (current - 1);
+		}
+		while(!state.compare_exchange_weak(current, released, std::memory_order_release, std::memory_order_relaxed));
+
+		if(count(released) == 0)
+		{
+			if(blocked > 0)
 			{
-				if(blocked)
-				{
-					unblock.signal();
-				}
-				else if(orphaned)
-				{
-					criticalSection.unlock();
+				unblock.notify_all();
+			}
+			else if(released & ORPHANED)
+			{
+				lock.unlock();
 
-					delete this;
+				delete this;
 
-					return;
-				}
+				return false;
 			}
 		}
 
-		criticalSection.unlock();
+		return true;
 	}
 
 	void Resource::destruct()
 	{
-		criticalSection.lock();
+		std::unique_lock<std::mutex> lock(mutex);
+
+		unsigned int current = state.load(std::memory_order_relaxed);
 
-		if(count == 0 && !blocked)
+		do
 		{
-			criticalSection.unlock();
+			if(count(current) == 0 && blocked == 0)
+			{
+				lock.unlock();
 
-			delete this;
+				delete this;
 
-			return;
+				return;
+			}
 		}
-
-		orphaned = true;
-
-		criticalSection.unlock();
+		while(!state.compare_exchange_weak(current, current | ORPHANED, std::memory_order_relaxed, std::memory_order_relaxed));
 	}
 
 	const void *Resource::data() const
@@ -15,7 +15,10 @@
 #ifndef sw_Resource_hpp
 #define sw_Resource_hpp
 
-#include "MutexLock.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
 
 namespace sw
 {
@@ -45,13 +48,28 @@ namespace sw
 	private:
 		~Resource();   // Always call destruct() instead
 
-		MutexLock criticalSection;
-		Event unblock;
-		volatile int blocked;
+		// The accessor, lock count and flags share one word, so that locking and unlocking
+		// without contention is a single compare-and-swap. The mutex is only taken to block.
+		enum : unsigned int
+		{
+			COUNT_MASK = 0x0FFFFFFF,
+			WAITING = 0x10000000,    // Threads are blocked on the condition
+			ORPHANED = 0x20000000,   // Deleted once the count drops to zero with no one waiting
+			ACCESSOR_SHIFT = 30,
+		};
 
-		volatile Accessor accessor;
-		volatile int count;
-		bool orphaned;
+		static Accessor accessor(unsigned int state) { return static_cast<Accessor>(state >> ACCESSOR_SHIFT); }
+		static unsigned int count(unsigned int state) { return state & COUNT_MASK; }
+		static unsigned int claim(unsigned int state, Accessor claimer) { return (claimer << ACCESSOR_SHIFT) | (state & (WAITING | ORPHANED)) | (count(state) + 1); }
+
+		void *block(Accessor claimer);
+		bool release(Accessor relinquisher, bool all);   // Returns false if the resource got deleted
+
+		std::atomic<unsigned int> state;
+
+		std::mutex mutex;
+		std::condition_variable unblock;
+		int blocked;   // Guarded by the mutex
 
 		void *buffer;
 	};
@@ -112,10 +112,7 @@ namespace sw
 		#endif
 	};
 
-	#if PERF_PROFILE
-	int64_t atomicExchange(int64_t volatile *target, int64_t value);
 	int atomicExchange(int volatile *target, int value);
-	#endif
 
 	int atomicIncrement(int volatile *value);
 	int atomicDecrement(int volatile *value);
@@ -234,18 +231,6 @@ namespace sw
 		#endif
 	}
 
-	#if PERF_PROFILE
-	inline int64_t atomicExchange(volatile int64_t *target, int64_t value)
-	{
-		#if defined(_WIN32)
-			return InterlockedExchange64(target, value);
-		#else
-			int ret;
-			__asm__ __volatile__("lock; xchg8 %x0,(%x1)" : "=r" (ret) :"r" (target), "0" (value) : "memory" );
-			return ret;
-		#endif
-	}
-
 	inline int atomicExchange(volatile int *target, int value)
 	{
 		#if defined(_WIN32)
@@ -256,7 +241,6 @@ namespace sw
 			return ret;
 		#endif
 	}
-	#endif
 
 	inline int atomicIncrement(volatile int *value)
 	{
@@ -30,6 +30,7 @@
 	#include <intrin.h>
 #else
 	#include <sys/time.h>
+	#include <time.h>
 	#if defined(__i386__) || defined(__x86_64__)
 		#include <x86intrin.h>
 	#endif
@@ -61,9 +62,7 @@ namespace sw
 		#if defined(_WIN32)
 			return __rdtsc();
 		#elif defined(__i386__) || defined(__x86_64__)
-			int64_t tsc;
-			__asm volatile("rdtsc": "=A" (tsc));
-			return tsc;
+			return __rdtsc();   // The "=A" constraint only yields the low half on x86-64
 		#else
 			return 0;
 		#endif
@@ -76,9 +75,9 @@ namespace sw
 			QueryPerformanceCounter((LARGE_INTEGER*)&counter);
 			return counter;
 		#else
-			timeval t;
-			gettimeofday(&t, 0);
-			return t.tv_sec * 1000000 + t.tv_usec;
+			timespec t;
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
 		#endif
 	}
 
@@ -89,7 +88,7 @@ namespace sw
 			QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
 			return frequency;
 		#else
-			return 1000000;   // gettimeofday uses microsecond resolution
+			return 1000000000;   // clock_gettime uses nanosecond resolution
 		#endif
 	}
 }
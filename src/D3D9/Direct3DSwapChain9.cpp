@@ -83,11 +83,8 @@ namespace D3D9
 
 		TRACE("");
 
-		#if PERF_PROFILE
-			profiler.nextFrame();
-		#endif
-
-		#if PERF_HUD
+		if(sw::profiler.isInstrumenting())
+		{
 			sw::Renderer *renderer = device->renderer;
 
 			static int64_t frame = sw::Timer::ticks();
@@ -146,7 +143,7 @@ namespace D3D9
 			}
 
 			renderer->resetTimers();
-		#endif
+		}
 
 		HWND window = destWindowOverride ? destWindowOverride : presentParameters.hDeviceWindow;
 
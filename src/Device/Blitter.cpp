@@ -24,15 +24,19 @@ namespace sw
 	Blitter::Blitter()
 	{
 		blitCache = new RoutineCache<State>(1024);
+		resolveCache = new RoutineCache<State>(64);
 	}
 
 	Blitter::~Blitter()
 	{
 		delete blitCache;
+		delete resolveCache;
 	}
 
 	void Blitter::clear(void *pixel, VkFormat format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
 	{
+		attachResolveRoutine(dest);
+
 		if(fastClear(pixel, format, dest, dRect, rgbaMask))
 		{
 			return;
@@ -122,6 +126,8 @@ namespace sw
 
 	void Blitter::blit(Surface *source, const SliceRectF &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options& options)
 	{
+		attachResolveRoutine(dest);
+
 		if(dest->getInternalFormat() == VK_FORMAT_UNDEFINED)
 		{
 			return;
@@ -1093,6 +1099,95 @@ namespace sw
 		return function(L"BlitRoutine");
 	}
 
+	Routine *Blitter::generateResolve(const State &state)
+	{
+		Function<Void(Pointer<Byte>, Int, Int)> function;
+		{
+			Pointer<Byte> element(function.Arg<0>());
+			Int count(function.Arg<1>());
+			Int sliceB(function.Arg<2>());
+
+			int bytes = Surface::bytes(state.destFormat);
+
+			For(Int i = 0, i < count, i++)
+			{
+				Float4 color;
+
+				if(!read(color, element, state))
+				{
+					return nullptr;
+				}
+
+				Pointer<Byte> sample = element;
+
+				for(int s = 1; s < state.destSamples; s++)
+				{
+					sample += sliceB;
+
+					Float4 c;
+
+					if(!read(c, sample, state))
+					{
+						return nullptr;
+					}
+
+					color += c;
+				}
+
+				// Both formats are the same, so no scaling or clamping is needed, just rounding on write
+				color *= Float4(1.0f / state.destSamples);
+
+				if(!write(color, element, state))
+				{
+					return nullptr;
+				}
+
+				element += bytes;
+			}
+		}
+
+		return function(L"ResolveRoutine");
+	}
+
+	Routine *Blitter::getResolveRoutine(VkFormat format, int samples)
+	{
+		// Integer samples can't be averaged, and are never resolved
+		if(Surface::isNonNormalizedInteger(format))
+		{
+			return nullptr;
+		}
+
+		State state(Options(false, false, false));
+		state.sourceFormat = format;
+		state.destFormat = format;
+		state.destSamples = samples;
+
+		criticalSection.lock();
+		Routine *resolveRoutine = resolveCache->query(state);
+
+		if(!resolveRoutine)
+		{
+			resolveRoutine = generateResolve(state);
+
+			if(resolveRoutine)
+			{
+				resolveCache->add(state, resolveRoutine);
+			}
+		}
+
+		criticalSection.unlock();
+
+		return resolveRoutine;
+	}
+
+	void Blitter::attachResolveRoutine(Surface *surface)
+	{
+		if(surface->getSamples() > 1 && !surface->hasResolveRoutine())
+		{
+			surface->setResolveRoutine(getResolveRoutine(surface->getInternalFormat(), surface->getSamples()));
+		}
+	}
+
 	bool Blitter::blitReactor(Surface *source, const SliceRectF &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options &options)
 	{
 		ASSERT(!options.clearOperation || ((source->getWidth() == 1) && (source->getHeight() == 1) && (source->getDepth() == 1)));
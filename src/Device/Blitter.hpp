@@ -18,6 +18,7 @@
 #include "Surface.hpp"
 #include "RoutineCache.hpp"
 #include "Reactor/Reactor.hpp"
+#include "System/MutexLock.hpp"
 
 #include <string.h>
 
@@ -97,6 +98,8 @@ namespace sw
 		void clear(void *pixel, VkFormat format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
 		void blit(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
 		void blit3D(Surface *source, Surface *dest);
+		Routine *getResolveRoutine(VkFormat format, int samples);   // void(void *element, int count, int sliceB)
+		void attachResolveRoutine(Surface *surface);   // Lets a multisampled surface written through this blitter resolve with its cache
 
 	private:
 		bool fastClear(void *pixel, VkFormat format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
@@ -112,8 +115,10 @@ namespace sw
 		static Float4 sRGBtoLinear(Float4 &color);
 		bool blitReactor(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
 		Routine *generate(const State &state);
+		Routine *generateResolve(const State &state);
 
 		RoutineCache<State> *blitCache;
+		RoutineCache<State> *resolveCache;
 		MutexLock criticalSection;
 	};
 }
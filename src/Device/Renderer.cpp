@@ -533,6 +533,8 @@ namespace sw
 				{
 					unsigned int layer = context->renderTargetLayer[index];
 					data->colorBuffer[index] = (unsigned int*)context->renderTarget[index]->lockInternal(0, 0, layer, LOCK_READWRITE, MANAGED);
+					blitter->attachResolveRoutine(context->renderTarget[index]);
+					context->renderTarget[index]->markSamplesDirty(scissor, layer);
 					data->colorPitchB[index] = context->renderTarget[index]->getInternalPitchB();
 					data->colorSliceB[index] = context->renderTarget[index]->getInternalSliceB();
 				}
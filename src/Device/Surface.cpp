@@ -14,15 +14,18 @@
 
 #include "Surface.hpp"
 
+#include "Blitter.hpp"
 #include "Color.hpp"
 #include "Context.hpp"
 #include "ETC_Decoder.hpp"
+#include "ASTC_Decoder.hpp"
 #include "Renderer.hpp"
 #include "System/Half.hpp"
 #include "System/Memory.hpp"
 #include "System/CPUID.hpp"
 #include "System/Resource.hpp"
 #include "System/Debug.hpp"
+#include "System/ThreadPool.hpp"
 #include "Reactor/Reactor.hpp"
 
 #if defined(__i386__) || defined(__x86_64__)
@@ -33,6 +36,42 @@
 #undef min
 #undef max
 
+namespace
+{
+	// 8-bit sRGB to linear conversion, built once on first use
+	struct SRGBtoLinearTable
+	{
+		SRGBtoLinearTable()
+		{
+			for(int i = 0; i < 256; i++)
+			{
+				table[i] = static_cast<sw::byte>(sw::sRGBtoLinear(static_cast<float>(i) / 255.0f) * 255.0f + 0.5f);
+			}
+		}
+
+		sw::byte table[256];
+	};
+
+	// Converts the RGB channels of 8-bit sRGB texels to linear, in place
+	void sRGBtoLinearRows(sw::byte *dest, int width, int height, int pitchB, int bytes)
+	{
+		static const SRGBtoLinearTable sRGBtoLinearTable;
+
+		for(int j = 0; j < height; j++)
+		{
+			sw::byte *destRow = dest + j * pitchB;
+			for(int x = 0; x < width; x++)
+			{
+				sw::byte *destPix = destRow + x * bytes;
+				for(int i = 0; i < 3; i++)
+				{
+					destPix[i] = sRGBtoLinearTable.table[destPix[i]];
+				}
+			}
+		}
+	}
+}
+
 namespace sw
 {
 	extern bool quadLayoutEnabled;
@@ -825,6 +864,11 @@ namespace sw
 		stencil.dirty = false;
 
 		dirtyContents = true;
+
+		resolveRect = Rect(0, 0, 0, 0);
+		resolveLayer0 = 0;
+		resolveLayer1 = 0;
+		resolveRoutine = nullptr;
 	}
 
 	Surface::Surface(Resource *texture, int width, int height, int depth, int border, int samples, VkFormat format, bool lockable, bool renderTarget, int pitchPprovided) : lockable(lockable), renderTarget(renderTarget)
@@ -881,6 +925,11 @@ namespace sw
 		stencil.dirty = false;
 
 		dirtyContents = true;
+
+		resolveRect = Rect(0, 0, 0, 0);
+		resolveLayer0 = 0;
+		resolveLayer1 = 0;
+		resolveRoutine = nullptr;
 	}
 
 	Surface::~Surface()
@@ -906,6 +955,11 @@ namespace sw
 
 		deallocate(stencil.buffer);
 
+		if(resolveRoutine)
+		{
+			resolveRoutine->unbind();
+		}
+
 		external.buffer = nullptr;
 		internal.buffer = nullptr;
 		stencil.buffer = nullptr;
@@ -1021,6 +1075,14 @@ namespace sw
 		case LOCK_READWRITE:
 		case LOCK_DISCARD:
 			dirtyContents = true;
+
+			// The renderer reports the regions it draws to, any other writer may touch all samples
+			if(client != MANAGED)
+			{
+				resolveRect = Rect(0, 0, internal.width, internal.height);
+				resolveLayer0 = 0;
+				resolveLayer1 = internal.depth;
+			}
 			break;
 		default:
 			ASSERT(false);
@@ -1528,367 +1590,363 @@ namespace sw
 
 	void Surface::decodeDXT1(Buffer &internal, Buffer &external)
 	{
-		unsigned int *destSlice = (unsigned int*)internal.lockRect(0, 0, 0, LOCK_UPDATE);
-		const DXT1 *source = (const DXT1*)external.lockRect(0, 0, 0, LOCK_READONLY);
+		DecodeTask task = {decodeDXT1Rows};
+		decodeBlocks(task, internal, external, external.depth);
+	}
+
+	void Surface::decodeDXT1Rows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
+		const DXT1 *source = (const DXT1*)task.source + first * task.columns;
+		int rowsPerSlice = (external.height + 3) / 4;
 
-		for(int z = 0; z < external.depth; z++)
+		for(int row = first; row < last; row++)
 		{
-			unsigned int *dest = destSlice;
+			unsigned int *dest = (unsigned int*)(task.destination + (row / rowsPerSlice) * internal.sliceB);
+			int y = (row % rowsPerSlice) * 4;
 
-			for(int y = 0; y < external.height; y += 4)
+			for(int x = 0; x < external.width; x += 4)
 			{
-				for(int x = 0; x < external.width; x += 4)
-				{
-					Color<byte> c[4];
+				Color<byte> c[4];
 
-					c[0] = source->c0;
-					c[1] = source->c1;
+				c[0] = source->c0;
+				c[1] = source->c1;
 
-					if(source->c0 > source->c1)   // No transparency
-					{
-						// c2 = 2 / 3 * c0 + 1 / 3 * c1
-						c[2].r = (byte)((2 * (word)c[0].r + (word)c[1].r + 1) / 3);
-						c[2].g = (byte)((2 * (word)c[0].g + (word)c[1].g + 1) / 3);
-						c[2].b = (byte)((2 * (word)c[0].b + (word)c[1].b + 1) / 3);
-						c[2].a = 0xFF;
-
-						// c3 = 1 / 3 * c0 + 2 / 3 * c1
-						c[3].r = (byte)(((word)c[0].r + 2 * (word)c[1].r + 1) / 3);
-						c[3].g = (byte)(((word)c[0].g + 2 * (word)c[1].g + 1) / 3);
-						c[3].b = (byte)(((word)c[0].b + 2 * (word)c[1].b + 1) / 3);
-						c[3].a = 0xFF;
-					}
-					else   // c3 transparent
-					{
-						// c2 = 1 / 2 * c0 + 1 / 2 * c1
-						c[2].r = (byte)(((word)c[0].r + (word)c[1].r) / 2);
-						c[2].g = (byte)(((word)c[0].g + (word)c[1].g) / 2);
-						c[2].b = (byte)(((word)c[0].b + (word)c[1].b) / 2);
-						c[2].a = 0xFF;
-
-						c[3].r = 0;
-						c[3].g = 0;
-						c[3].b = 0;
-						c[3].a = 0;
-					}
+				if(source->c0 > source->c1)   // No transparency
+				{
+					// c2 = 2 / 3 * c0 + 1 / 3 * c1
+					c[2].r = (byte)((2 * (word)c[0].r + (word)c[1].r + 1) / 3);
+					c[2].g = (byte)((2 * (word)c[0].g + (word)c[1].g + 1) / 3);
+					c[2].b = (byte)((2 * (word)c[0].b + (word)c[1].b + 1) / 3);
+					c[2].a = 0xFF;
+
+					// c3 = 1 / 3 * c0 + 2 / 3 * c1
+					c[3].r = (byte)(((word)c[0].r + 2 * (word)c[1].r + 1) / 3);
+					c[3].g = (byte)(((word)c[0].g + 2 * (word)c[1].g + 1) / 3);
+					c[3].b = (byte)(((word)c[0].b + 2 * (word)c[1].b + 1) / 3);
+					c[3].a = 0xFF;
+				}
+				else   // c3 transparent
+				{
+					// c2 = 1 / 2 * c0 + 1 / 2 * c1
+					c[2].r = (byte)(((word)c[0].r + (word)c[1].r) / 2);
+					c[2].g = (byte)(((word)c[0].g + (word)c[1].g) / 2);
+					c[2].b = (byte)(((word)c[0].b + (word)c[1].b) / 2);
+					c[2].a = 0xFF;
+
+					c[3].r = 0;
+					c[3].g = 0;
+					c[3].b = 0;
+					c[3].a = 0;
+				}
 
-					for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				{
+					for(int i = 0; i < 4 && (x + i) < internal.width; i++)
 					{
-						for(int i = 0; i < 4 && (x + i) < internal.width; i++)
-						{
-							dest[(x + i) + (y + j) * internal.pitchP] = c[(unsigned int)(source->lut >> 2 * (i + j * 4)) % 4];
-						}
+						dest[(x + i) + (y + j) * internal.pitchP] = c[(unsigned int)(source->lut >> 2 * (i + j * 4)) % 4];
 					}
-
-					source++;
 				}
-			}
 
-			(byte*&)destSlice += internal.sliceB;
+				source++;
+			}
 		}
-
-		external.unlockRect();
-		internal.unlockRect();
 	}
 
 	void Surface::decodeDXT3(Buffer &internal, Buffer &external)
 	{
-		unsigned int *destSlice = (unsigned int*)internal.lockRect(0, 0, 0, LOCK_UPDATE);
-		const DXT3 *source = (const DXT3*)external.lockRect(0, 0, 0, LOCK_READONLY);
+		DecodeTask task = {decodeDXT3Rows};
+		decodeBlocks(task, internal, external, external.depth);
+	}
+
+	void Surface::decodeDXT3Rows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
+		const DXT3 *source = (const DXT3*)task.source + first * task.columns;
+		int rowsPerSlice = (external.height + 3) / 4;
 
-		for(int z = 0; z < external.depth; z++)
+		for(int row = first; row < last; row++)
 		{
-			unsigned int *dest = destSlice;
+			unsigned int *dest = (unsigned int*)(task.destination + (row / rowsPerSlice) * internal.sliceB);
+			int y = (row % rowsPerSlice) * 4;
 
-			for(int y = 0; y < external.height; y += 4)
+			for(int x = 0; x < external.width; x += 4)
 			{
-				for(int x = 0; x < external.width; x += 4)
-				{
-					Color<byte> c[4];
+				Color<byte> c[4];
 
-					c[0] = source->c0;
-					c[1] = source->c1;
+				c[0] = source->c0;
+				c[1] = source->c1;
 
-					// c2 = 2 / 3 * c0 + 1 / 3 * c1
-					c[2].r = (byte)((2 * (word)c[0].r + (word)c[1].r + 1) / 3);
-					c[2].g = (byte)((2 * (word)c[0].g + (word)c[1].g + 1) / 3);
-					c[2].b = (byte)((2 * (word)c[0].b + (word)c[1].b + 1) / 3);
+				// c2 = 2 / 3 * c0 + 1 / 3 * c1
+				c[2].r = (byte)((2 * (word)c[0].r + (word)c[1].r + 1) / 3);
+				c[2].g = (byte)((2 * (word)c[0].g + (word)c[1].g + 1) / 3);
+				c[2].b = (byte)((2 * (word)c[0].b + (word)c[1].b + 1) / 3);
 
-					// c3 = 1 / 3 * c0 + 2 / 3 * c1
-					c[3].r = (byte)(((word)c[0].r + 2 * (word)c[1].r + 1) / 3);
-					c[3].g = (byte)(((word)c[0].g + 2 * (word)c[1].g + 1) / 3);
-					c[3].b = (byte)(((word)c[0].b + 2 * (word)c[1].b + 1) / 3);
+				// c3 = 1 / 3 * c0 + 2 / 3 * c1
+				c[3].r = (byte)(((word)c[0].r + 2 * (word)c[1].r + 1) / 3);
+				c[3].g = (byte)(((word)c[0].g + 2 * (word)c[1].g + 1) / 3);
+				c[3].b = (byte)(((word)c[0].b + 2 * (word)c[1].b + 1) / 3);
 
-					for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				{
+					for(int i = 0; i < 4 && (x + i) < internal.width; i++)
 					{
-						for(int i = 0; i < 4 && (x + i) < internal.width; i++)
-						{
-							unsigned int a = (unsigned int)(source->a >> 4 * (i + j * 4)) & 0x0F;
-							unsigned int color = (c[(unsigned int)(source->lut >> 2 * (i + j * 4)) % 4] & 0x00FFFFFF) | ((a << 28) + (a << 24));
+						unsigned int a = (unsigned int)(source->a >> 4 * (i + j * 4)) & 0x0F;
+						unsigned int color = (c[(unsigned int)(source->lut >> 2 * (i + j * 4)) % 4] & 0x00FFFFFF) | ((a << 28) + (a << 24));
 
-							dest[(x + i) + (y + j) * internal.pitchP] = color;
-						}
+						dest[(x + i) + (y + j) * internal.pitchP] = color;
 					}
-
-					source++;
 				}
-			}
 
-			(byte*&)destSlice += internal.sliceB;
+				source++;
+			}
 		}
-
-		external.unlockRect();
-		internal.unlockRect();
 	}
 
 	void Surface::decodeDXT5(Buffer &internal, Buffer &external)
 	{
-		unsigned int *destSlice = (unsigned int*)internal.lockRect(0, 0, 0, LOCK_UPDATE);
-		const DXT5 *source = (const DXT5*)external.lockRect(0, 0, 0, LOCK_READONLY);
+		DecodeTask task = {decodeDXT5Rows};
+		decodeBlocks(task, internal, external, external.depth);
+	}
+
+	void Surface::decodeDXT5Rows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
+		const DXT5 *source = (const DXT5*)task.source + first * task.columns;
+		int rowsPerSlice = (external.height + 3) / 4;
 
-		for(int z = 0; z < external.depth; z++)
+		for(int row = first; row < last; row++)
 		{
-			unsigned int *dest = destSlice;
+			unsigned int *dest = (unsigned int*)(task.destination + (row / rowsPerSlice) * internal.sliceB);
+			int y = (row % rowsPerSlice) * 4;
 
-			for(int y = 0; y < external.height; y += 4)
+			for(int x = 0; x < external.width; x += 4)
 			{
-				for(int x = 0; x < external.width; x += 4)
-				{
-					Color<byte> c[4];
+				Color<byte> c[4];
 
-					c[0] = source->c0;
-					c[1] = source->c1;
+				c[0] = source->c0;
+				c[1] = source->c1;
 
-					// c2 = 2 / 3 * c0 + 1 / 3 * c1
-					c[2].r = (byte)((2 * (word)c[0].r + (word)c[1].r + 1) / 3);
-					c[2].g = (byte)((2 * (word)c[0].g + (word)c[1].g + 1) / 3);
-					c[2].b = (byte)((2 * (word)c[0].b + (word)c[1].b + 1) / 3);
+				// c2 = 2 / 3 * c0 + 1 / 3 * c1
+				c[2].r = (byte)((2 * (word)c[0].r + (word)c[1].r + 1) / 3);
+				c[2].g = (byte)((2 * (word)c[0].g + (word)c[1].g + 1) / 3);
+				c[2].b = (byte)((2 * (word)c[0].b + (word)c[1].b + 1) / 3);
 
-					// c3 = 1 / 3 * c0 + 2 / 3 * c1
-					c[3].r = (byte)(((word)c[0].r + 2 * (word)c[1].r + 1) / 3);
-					c[3].g = (byte)(((word)c[0].g + 2 * (word)c[1].g + 1) / 3);
-					c[3].b = (byte)(((word)c[0].b + 2 * (word)c[1].b + 1) / 3);
+				// c3 = 1 / 3 * c0 + 2 / 3 * c1
+				c[3].r = (byte)(((word)c[0].r + 2 * (word)c[1].r + 1) / 3);
+				c[3].g = (byte)(((word)c[0].g + 2 * (word)c[1].g + 1) / 3);
+				c[3].b = (byte)(((word)c[0].b + 2 * (word)c[1].b + 1) / 3);
 
-					byte a[8];
+				byte a[8];
 
-					a[0] = source->a0;
-					a[1] = source->a1;
+				a[0] = source->a0;
+				a[1] = source->a1;
 
-					if(a[0] > a[1])
-					{
-						a[2] = (byte)((6 * (word)a[0] + 1 * (word)a[1] + 3) / 7);
-						a[3] = (byte)((5 * (word)a[0] + 2 * (word)a[1] + 3) / 7);
-						a[4] = (byte)((4 * (word)a[0] + 3 * (word)a[1] + 3) / 7);
-						a[5] = (byte)((3 * (word)a[0] + 4 * (word)a[1] + 3) / 7);
-						a[6] = (byte)((2 * (word)a[0] + 5 * (word)a[1] + 3) / 7);
-						a[7] = (byte)((1 * (word)a[0] + 6 * (word)a[1] + 3) / 7);
-					}
-					else
-					{
-						a[2] = (byte)((4 * (word)a[0] + 1 * (word)a[1] + 2) / 5);
-						a[3] = (byte)((3 * (word)a[0] + 2 * (word)a[1] + 2) / 5);
-						a[4] = (byte)((2 * (word)a[0] + 3 * (word)a[1] + 2) / 5);
-						a[5] = (byte)((1 * (word)a[0] + 4 * (word)a[1] + 2) / 5);
-						a[6] = 0;
-						a[7] = 0xFF;
-					}
+				if(a[0] > a[1])
+				{
+					a[2] = (byte)((6 * (word)a[0] + 1 * (word)a[1] + 3) / 7);
+					a[3] = (byte)((5 * (word)a[0] + 2 * (word)a[1] + 3) / 7);
+					a[4] = (byte)((4 * (word)a[0] + 3 * (word)a[1] + 3) / 7);
+					a[5] = (byte)((3 * (word)a[0] + 4 * (word)a[1] + 3) / 7);
+					a[6] = (byte)((2 * (word)a[0] + 5 * (word)a[1] + 3) / 7);
+					a[7] = (byte)((1 * (word)a[0] + 6 * (word)a[1] + 3) / 7);
+				}
+				else
+				{
+					a[2] = (byte)((4 * (word)a[0] + 1 * (word)a[1] + 2) / 5);
+					a[3] = (byte)((3 * (word)a[0] + 2 * (word)a[1] + 2) / 5);
+					a[4] = (byte)((2 * (word)a[0] + 3 * (word)a[1] + 2) / 5);
+					a[5] = (byte)((1 * (word)a[0] + 4 * (word)a[1] + 2) / 5);
+					a[6] = 0;
+					a[7] = 0xFF;
+				}
 
-					for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				{
+					for(int i = 0; i < 4 && (x + i) < internal.width; i++)
 					{
-						for(int i = 0; i < 4 && (x + i) < internal.width; i++)
-						{
-							unsigned int alpha = (unsigned int)a[(unsigned int)(source->alut >> (16 + 3 * (i + j * 4))) % 8] << 24;
-							unsigned int color = (c[(source->clut >> 2 * (i + j * 4)) % 4] & 0x00FFFFFF) | alpha;
+						unsigned int alpha = (unsigned int)a[(unsigned int)(source->alut >> (16 + 3 * (i + j * 4))) % 8] << 24;
+						unsigned int color = (c[(source->clut >> 2 * (i + j * 4)) % 4] & 0x00FFFFFF) | alpha;
 
-							dest[(x + i) + (y + j) * internal.pitchP] = color;
-						}
+						dest[(x + i) + (y + j) * internal.pitchP] = color;
 					}
-
-					source++;
 				}
-			}
 
-			(byte*&)destSlice += internal.sliceB;
+				source++;
+			}
 		}
-
-		external.unlockRect();
-		internal.unlockRect();
 	}
 
 	void Surface::decodeATI1(Buffer &internal, Buffer &external)
 	{
-		byte *destSlice = (byte*)internal.lockRect(0, 0, 0, LOCK_UPDATE);
-		const ATI1 *source = (const ATI1*)external.lockRect(0, 0, 0, LOCK_READONLY);
+		DecodeTask task = {decodeATI1Rows};
+		decodeBlocks(task, internal, external, external.depth);
+	}
+
+	void Surface::decodeATI1Rows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
+		const ATI1 *source = (const ATI1*)task.source + first * task.columns;
+		int rowsPerSlice = (external.height + 3) / 4;
 
-		for(int z = 0; z < external.depth; z++)
+		for(int row = first; row < last; row++)
 		{
-			byte *dest = destSlice;
+			byte *dest = (byte*)(task.destination + (row / rowsPerSlice) * internal.sliceB);
+			int y = (row % rowsPerSlice) * 4;
 
-			for(int y = 0; y < external.height; y += 4)
+			for(int x = 0; x < external.width; x += 4)
 			{
-				for(int x = 0; x < external.width; x += 4)
-				{
-					byte r[8];
+				byte r[8];
 
-					r[0] = source->r0;
-					r[1] = source->r1;
+				r[0] = source->r0;
+				r[1] = source->r1;
 
-					if(r[0] > r[1])
-					{
-						r[2] = (byte)((6 * (word)r[0] + 1 * (word)r[1] + 3) / 7);
-						r[3] = (byte)((5 * (word)r[0] + 2 * (word)r[1] + 3) / 7);
-						r[4] = (byte)((4 * (word)r[0] + 3 * (word)r[1] + 3) / 7);
-						r[5] = (byte)((3 * (word)r[0] + 4 * (word)r[1] + 3) / 7);
-						r[6] = (byte)((2 * (word)r[0] + 5 * (word)r[1] + 3) / 7);
-						r[7] = (byte)((1 * (word)r[0] + 6 * (word)r[1] + 3) / 7);
-					}
-					else
-					{
-						r[2] = (byte)((4 * (word)r[0] + 1 * (word)r[1] + 2) / 5);
-						r[3] = (byte)((3 * (word)r[0] + 2 * (word)r[1] + 2) / 5);
-						r[4] = (byte)((2 * (word)r[0] + 3 * (word)r[1] + 2) / 5);
-						r[5] = (byte)((1 * (word)r[0] + 4 * (word)r[1] + 2) / 5);
-						r[6] = 0;
-						r[7] = 0xFF;
-					}
+				if(r[0] > r[1])
+				{
+					r[2] = (byte)((6 * (word)r[0] + 1 * (word)r[1] + 3) / 7);
+					r[3] = (byte)((5 * (word)r[0] + 2 * (word)r[1] + 3) / 7);
+					r[4] = (byte)((4 * (word)r[0] + 3 * (word)r[1] + 3) / 7);
+					r[5] = (byte)((3 * (word)r[0] + 4 * (word)r[1] + 3) / 7);
+					r[6] = (byte)((2 * (word)r[0] + 5 * (word)r[1] + 3) / 7);
+					r[7] = (byte)((1 * (word)r[0] + 6 * (word)r[1] + 3) / 7);
+				}
+				else
+				{
+					r[2] = (byte)((4 * (word)r[0] + 1 * (word)r[1] + 2) / 5);
+					r[3] = (byte)((3 * (word)r[0] + 2 * (word)r[1] + 2) / 5);
+					r[4] = (byte)((2 * (word)r[0] + 3 * (word)r[1] + 2) / 5);
+					r[5] = (byte)((1 * (word)r[0] + 4 * (word)r[1] + 2) / 5);
+					r[6] = 0;
+					r[7] = 0xFF;
+				}
 
-					for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				{
+					for(int i = 0; i < 4 && (x + i) < internal.width; i++)
 					{
-						for(int i = 0; i < 4 && (x + i) < internal.width; i++)
-						{
-							dest[(x + i) + (y + j) * internal.pitchP] = r[(unsigned int)(source->rlut >> (16 + 3 * (i + j * 4))) % 8];
-						}
+						dest[(x + i) + (y + j) * internal.pitchP] = r[(unsigned int)(source->rlut >> (16 + 3 * (i + j * 4))) % 8];
 					}
-
-					source++;
 				}
-			}
 
-			destSlice += internal.sliceB;
+				source++;
+			}
 		}
-
-		external.unlockRect();
-		internal.unlockRect();
 	}
 
 	void Surface::decodeATI2(Buffer &internal, Buffer &external)
 	{
-		word *destSlice = (word*)internal.lockRect(0, 0, 0, LOCK_UPDATE);
-		const ATI2 *source = (const ATI2*)external.lockRect(0, 0, 0, LOCK_READONLY);
+		DecodeTask task = {decodeATI2Rows};
+		decodeBlocks(task, internal, external, external.depth);
+	}
+
+	void Surface::decodeATI2Rows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
+		const ATI2 *source = (const ATI2*)task.source + first * task.columns;
+		int rowsPerSlice = (external.height + 3) / 4;
 
-		for(int z = 0; z < external.depth; z++)
+		for(int row = first; row < last; row++)
 		{
-			word *dest = destSlice;
+			word *dest = (word*)(task.destination + (row / rowsPerSlice) * internal.sliceB);
+			int y = (row % rowsPerSlice) * 4;
 
-			for(int y = 0; y < external.height; y += 4)
+			for(int x = 0; x < external.width; x += 4)
 			{
-				for(int x = 0; x < external.width; x += 4)
-				{
-					byte X[8];
+				byte X[8];
 
-					X[0] = source->x0;
-					X[1] = source->x1;
+				X[0] = source->x0;
+				X[1] = source->x1;
 
-					if(X[0] > X[1])
-					{
-						X[2] = (byte)((6 * (word)X[0] + 1 * (word)X[1] + 3) / 7);
-						X[3] = (byte)((5 * (word)X[0] + 2 * (word)X[1] + 3) / 7);
-						X[4] = (byte)((4 * (word)X[0] + 3 * (word)X[1] + 3) / 7);
-						X[5] = (byte)((3 * (word)X[0] + 4 * (word)X[1] + 3) / 7);
-						X[6] = (byte)((2 * (word)X[0] + 5 * (word)X[1] + 3) / 7);
-						X[7] = (byte)((1 * (word)X[0] + 6 * (word)X[1] + 3) / 7);
-					}
-					else
-					{
-						X[2] = (byte)((4 * (word)X[0] + 1 * (word)X[1] + 2) / 5);
-						X[3] = (byte)((3 * (word)X[0] + 2 * (word)X[1] + 2) / 5);
-						X[4] = (byte)((2 * (word)X[0] + 3 * (word)X[1] + 2) / 5);
-						X[5] = (byte)((1 * (word)X[0] + 4 * (word)X[1] + 2) / 5);
-						X[6] = 0;
-						X[7] = 0xFF;
-					}
+				if(X[0] > X[1])
+				{
+					X[2] = (byte)((6 * (word)X[0] + 1 * (word)X[1] + 3) / 7);
+					X[3] = (byte)((5 * (word)X[0] + 2 * (word)X[1] + 3) / 7);
+					X[4] = (byte)((4 * (word)X[0] + 3 * (word)X[1] + 3) / 7);
+					X[5] = (byte)((3 * (word)X[0] + 4 * (word)X[1] + 3) / 7);
+					X[6] = (byte)((2 * (word)X[0] + 5 * (word)X[1] + 3) / 7);
+					X[7] = (byte)((1 * (word)X[0] + 6 * (word)X[1] + 3) / 7);
+				}
+				else
+				{
+					X[2] = (byte)((4 * (word)X[0] + 1 * (word)X[1] + 2) / 5);
+					X[3] = (byte)((3 * (word)X[0] + 2 * (word)X[1] + 2) / 5);
+					X[4] = (byte)((2 * (word)X[0] + 3 * (word)X[1] + 2) / 5);
+					X[5] = (byte)((1 * (word)X[0] + 4 * (word)X[1] + 2) / 5);
+					X[6] = 0;
+					X[7] = 0xFF;
+				}
 
-					byte Y[8];
+				byte Y[8];
 
-					Y[0] = source->y0;
-					Y[1] = source->y1;
+				Y[0] = source->y0;
+				Y[1] = source->y1;
 
-					if(Y[0] > Y[1])
-					{
-						Y[2] = (byte)((6 * (word)Y[0] + 1 * (word)Y[1] + 3) / 7);
-						Y[3] = (byte)((5 * (word)Y[0] + 2 * (word)Y[1] + 3) / 7);
-						Y[4] = (byte)((4 * (word)Y[0] + 3 * (word)Y[1] + 3) / 7);
-						Y[5] = (byte)((3 * (word)Y[0] + 4 * (word)Y[1] + 3) / 7);
-						Y[6] = (byte)((2 * (word)Y[0] + 5 * (word)Y[1] + 3) / 7);
-						Y[7] = (byte)((1 * (word)Y[0] + 6 * (word)Y[1] + 3) / 7);
-					}
-					else
-					{
-						Y[2] = (byte)((4 * (word)Y[0] + 1 * (word)Y[1] + 2) / 5);
-						Y[3] = (byte)((3 * (word)Y[0] + 2 * (word)Y[1] + 2) / 5);
-						Y[4] = (byte)((2 * (word)Y[0] + 3 * (word)Y[1] + 2) / 5);
-						Y[5] = (byte)((1 * (word)Y[0] + 4 * (word)Y[1] + 2) / 5);
-						Y[6] = 0;
-						Y[7] = 0xFF;
-					}
+				if(Y[0] > Y[1])
+				{
+					Y[2] = (byte)((6 * (word)Y[0] + 1 * (word)Y[1] + 3) / 7);
+					Y[3] = (byte)((5 * (word)Y[0] + 2 * (word)Y[1] + 3) / 7);
+					Y[4] = (byte)((4 * (word)Y[0] + 3 * (word)Y[1] + 3) / 7);
+					Y[5] = (byte)((3 * (word)Y[0] + 4 * (word)Y[1] + 3) / 7);
+					Y[6] = (byte)((2 * (word)Y[0] + 5 * (word)Y[1] + 3) / 7);
+					Y[7] = (byte)((1 * (word)Y[0] + 6 * (word)Y[1] + 3) / 7);
+				}
+				else
+				{
+					Y[2] = (byte)((4 * (word)Y[0] + 1 * (word)Y[1] + 2) / 5);
+					Y[3] = (byte)((3 * (word)Y[0] + 2 * (word)Y[1] + 2) / 5);
+					Y[4] = (byte)((2 * (word)Y[0] + 3 * (word)Y[1] + 2) / 5);
+					Y[5] = (byte)((1 * (word)Y[0] + 4 * (word)Y[1] + 2) / 5);
+					Y[6] = 0;
+					Y[7] = 0xFF;
+				}
 
-					for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				for(int j = 0; j < 4 && (y + j) < internal.height; j++)
+				{
+					for(int i = 0; i < 4 && (x + i) < internal.width; i++)
 					{
-						for(int i = 0; i < 4 && (x + i) < internal.width; i++)
-						{
-							word r = X[(unsigned int)(source->xlut >> (16 + 3 * (i + j * 4))) % 8];
-							word g = Y[(unsigned int)(source->ylut >> (16 + 3 * (i + j * 4))) % 8];
+						word r = X[(unsigned int)(source->xlut >> (16 + 3 * (i + j * 4))) % 8];
+						word g = Y[(unsigned int)(source->ylut >> (16 + 3 * (i + j * 4))) % 8];
 
-							dest[(x + i) + (y + j) * internal.pitchP] = (g << 8) + r;
-						}
+						dest[(x + i) + (y + j) * internal.pitchP] = (g << 8) + r;
 					}
-
-					source++;
 				}
-			}
 
-			(byte*&)destSlice += internal.sliceB;
+				source++;
+			}
 		}
-
-		external.unlockRect();
-		internal.unlockRect();
 	}
 
 	void Surface::decodeETC2(Buffer &internal, Buffer &external, int nbAlphaBits, bool isSRGB)
 	{
-		ETC_Decoder::Decode((const byte*)external.lockRect(0, 0, 0, LOCK_READONLY), (byte*)internal.lockRect(0, 0, 0, LOCK_UPDATE), external.width, external.height, internal.width, internal.height, internal.pitchB, internal.bytes,
-		                    (nbAlphaBits == 8) ? ETC_Decoder::ETC_RGBA : ((nbAlphaBits == 1) ? ETC_Decoder::ETC_RGB_PUNCHTHROUGH_ALPHA : ETC_Decoder::ETC_RGB));
-		external.unlockRect();
-		internal.unlockRect();
+		DecodeTask task = {decodeETC2Rows};
+		task.blockBytes = (nbAlphaBits == 8) ? 16 : 8;
+		task.parameter = (nbAlphaBits == 8) ? ETC_Decoder::ETC_RGBA : ((nbAlphaBits == 1) ? ETC_Decoder::ETC_RGB_PUNCHTHROUGH_ALPHA : ETC_Decoder::ETC_RGB);
+		task.isSRGB = isSRGB;
+		decodeBlocks(task, internal, external, 1);
+	}
 
-		if(isSRGB)
-		{
-			static byte sRGBtoLinearTable[256];
-			static bool sRGBtoLinearTableDirty = true;
-			if(sRGBtoLinearTableDirty)
-			{
-				for(int i = 0; i < 256; i++)
-				{
-					sRGBtoLinearTable[i] = static_cast<byte>(sRGBtoLinear(static_cast<float>(i) / 255.0f) * 255.0f + 0.5f);
-				}
-				sRGBtoLinearTableDirty = false;
-			}
+	void Surface::decodeETC2Rows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
 
-			// Perform sRGB conversion in place after decoding
-			byte *src = (byte*)internal.lockRect(0, 0, 0, LOCK_READWRITE);
-			for(int y = 0; y < internal.height; y++)
-			{
-				byte *srcRow = src + y * internal.pitchB;
-				for(int x = 0; x <  internal.width; x++)
-				{
-					byte *srcPix = srcRow + x * internal.bytes;
-					for(int i = 0; i < 3; i++)
-					{
-						srcPix[i] = sRGBtoLinearTable[srcPix[i]];
-					}
-				}
-			}
-			internal.unlockRect();
+		int y = first * 4;
+		byte *dest = task.destination + y * internal.pitchB;
+		const byte *source = task.source + first * task.columns * task.blockBytes;
+
+		ETC_Decoder::Decode(source, dest, external.width, min((last - first) * 4, external.height - y), internal.width, internal.height - y, internal.pitchB, internal.bytes,
+		                    static_cast<ETC_Decoder::InputType>(task.parameter));
+
+		if(task.isSRGB)
+		{
+			// Perform sRGB conversion in place while the band is still in cache
+			int height = ((last == task.rows) ? internal.height : min(last * 4, internal.height)) - y;
+			sRGBtoLinearRows(dest, internal.width, height, internal.pitchB, internal.bytes);
 		}
 	}
 
@@ -1896,17 +1954,33 @@ namespace sw
 	{
 		ASSERT(nbChannels == 1 || nbChannels == 2);
 
-		byte *src = (byte*)internal.lockRect(0, 0, 0, LOCK_READWRITE);
-		ETC_Decoder::Decode((const byte*)external.lockRect(0, 0, 0, LOCK_READONLY), src, external.width, external.height, internal.width, internal.height, internal.pitchB, internal.bytes,
-		                    (nbChannels == 1) ? (isSigned ? ETC_Decoder::ETC_R_SIGNED : ETC_Decoder::ETC_R_UNSIGNED) : (isSigned ? ETC_Decoder::ETC_RG_SIGNED : ETC_Decoder::ETC_RG_UNSIGNED));
-		external.unlockRect();
+		DecodeTask task = {decodeEACRows};
+		task.blockBytes = 8 * nbChannels;
+		task.parameter = (nbChannels == 1) ? (isSigned ? ETC_Decoder::ETC_R_SIGNED : ETC_Decoder::ETC_R_UNSIGNED) : (isSigned ? ETC_Decoder::ETC_RG_SIGNED : ETC_Decoder::ETC_RG_UNSIGNED);
+		decodeBlocks(task, internal, external, 1, LOCK_READWRITE);
+	}
+
+	void Surface::decodeEACRows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
+		ETC_Decoder::InputType inputType = static_cast<ETC_Decoder::InputType>(task.parameter);
+		bool isSigned = (inputType == ETC_Decoder::ETC_R_SIGNED) || (inputType == ETC_Decoder::ETC_RG_SIGNED);
+		int nbChannels = task.blockBytes / 8;
+
+		int y = first * 4;
+		byte *src = task.destination + y * internal.pitchB;
+		const byte *source = task.source + first * task.columns * task.blockBytes;
+
+		ETC_Decoder::Decode(source, src, external.width, min((last - first) * 4, external.height - y), internal.width, internal.height - y, internal.pitchB, internal.bytes, inputType);
 
 		// FIXME: We convert EAC data to float, until signed short internal formats are supported
 		//        This code can be removed if ETC2 images are decoded to internal 16 bit signed R/RG formats
 		const float normalization = isSigned ? (1.0f / (8.0f * 127.875f)) : (1.0f / (8.0f * 255.875f));
-		for(int y = 0; y < internal.height; y++)
+		int height = ((last == task.rows) ? internal.height : min(last * 4, internal.height)) - y;
+		for(int j = 0; j < height; j++)
 		{
-			byte* srcRow = src + y * internal.pitchB;
+			byte* srcRow = src + j * internal.pitchB;
 			for(int x = internal.width - 1; x >= 0; x--)
 			{
 				int* srcPix = reinterpret_cast<int*>(srcRow + x * internal.bytes);
@@ -1917,12 +1991,68 @@ namespace sw
 				}
 			}
 		}
+	}
+
+	void Surface::decodeBlocks(DecodeTask &task, Buffer &internal, Buffer &external, int slices, Lock lock, int blockWidth, int blockHeight)
+	{
+		task.internal = &internal;
+		task.external = &external;
+		task.destination = (byte*)internal.lockRect(0, 0, 0, lock);
+		task.source = (const byte*)external.lockRect(0, 0, 0, LOCK_READONLY);
+		task.columns = (external.width + blockWidth - 1) / blockWidth;
+		task.rows = slices * ((external.height + blockHeight - 1) / blockHeight);
+		task.blockWidth = blockWidth;
+		task.blockHeight = blockHeight;
+
+		// Bands of block rows are independent, but only large images are worth spreading over the workers
+		const int minimumBlocksPerBand = 4096;
+
+		ThreadPool::Get().parallelForRange(task.rows, task.columns, minimumBlocksPerBand, [&](unsigned int first, unsigned int last)
+		{
+			task.decode(task, first, last);
+		});
 
+		external.unlockRect();
 		internal.unlockRect();
 	}
 
 	void Surface::decodeASTC(Buffer &internal, Buffer &external, int xBlockSize, int yBlockSize, int zBlockSize, bool isSRGB)
 	{
+		ASSERT(zBlockSize == 1);   // FIXME: 3D blocks are only part of the full ASTC profile
+
+		DecodeTask task = {decodeASTCRows};
+		task.blockBytes = 16;
+		task.isSRGB = isSRGB;
+		decodeBlocks(task, internal, external, external.depth, LOCK_UPDATE, xBlockSize, yBlockSize);
+	}
+
+	void Surface::decodeASTCRows(const DecodeTask &task, int first, int last)
+	{
+		const Buffer &internal = *task.internal;
+		const Buffer &external = *task.external;
+		int rowsPerSlice = task.rows / external.depth;
+
+		for(int row = first; row < last; )
+		{
+			// Decode the band one slice at a time
+			int slice = row / rowsPerSlice;
+			int sliceLast = min(last, (slice + 1) * rowsPerSlice);
+			int y = (row % rowsPerSlice) * task.blockHeight;
+			int height = min((sliceLast - row) * task.blockHeight, external.height - y);
+
+			byte *dest = task.destination + slice * internal.sliceB + y * internal.pitchB;
+			const byte *source = task.source + row * task.columns * task.blockBytes;
+
+			ASTC_Decoder::Decode(source, dest, external.width, height, internal.width, min(height, internal.height - y), internal.pitchB, internal.bytes,
+			                     task.blockWidth, task.blockHeight, task.isSRGB);
+
+			if(task.isSRGB)
+			{
+				sRGBtoLinearRows(dest, internal.width, min(height, internal.height - y), internal.pitchB, internal.bytes);
+			}
+
+			row = sliceLast;
+		}
 	}
 
 	size_t Surface::size(int width, int height, int depth, int border, int samples, VkFormat format)
@@ -2963,2218 +3093,131 @@ namespace sw
 		return VK_FORMAT_UNDEFINED;
 	}
 
-	void Surface::resolve()
+	void Surface::markSamplesDirty(const Rect &rect, int layer)
 	{
-		if(internal.samples <= 1 || !internal.dirty || !renderTarget || internal.format == VK_FORMAT_UNDEFINED)
+		Rect region = rect;
+		region.clip(0, 0, internal.width, internal.height);
+
+		if(region.x0 >= region.x1 || region.y0 >= region.y1)
 		{
 			return;
 		}
 
-		ASSERT(internal.depth == 1);  // Unimplemented
-
-		void *source = internal.lockRect(0, 0, 0, LOCK_READWRITE);
-
-		int width = internal.width;
-		int height = internal.height;
-		int pitch = internal.pitchB;
-		int slice = internal.sliceB;
-
-		unsigned char *source0 = (unsigned char*)source;
-		unsigned char *source1 = source0 + slice;
-		unsigned char *source2 = source1 + slice;
-		unsigned char *source3 = source2 + slice;
-		unsigned char *source4 = source3 + slice;
-		unsigned char *source5 = source4 + slice;
-		unsigned char *source6 = source5 + slice;
-		unsigned char *source7 = source6 + slice;
-		unsigned char *source8 = source7 + slice;
-		unsigned char *source9 = source8 + slice;
-		unsigned char *sourceA = source9 + slice;
-		unsigned char *sourceB = sourceA + slice;
-		unsigned char *sourceC = sourceB + slice;
-		unsigned char *sourceD = sourceC + slice;
-		unsigned char *sourceE = sourceD + slice;
-		unsigned char *sourceF = sourceE + slice;
-
-		if(internal.format == VK_FORMAT_B8G8R8A8_UNORM ||
-		   internal.format == VK_FORMAT_R8G8B8A8_UNORM ||
-		   internal.format == VK_FORMAT_R8G8B8A8_SRGB)
+		if(resolveRect.x0 >= resolveRect.x1)
 		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE2() && (width % 4) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
+			resolveRect = region;
+			resolveLayer0 = layer;
+			resolveLayer1 = layer + 1;
+		}
+		else
+		{
+			resolveRect.x0 = min(resolveRect.x0, region.x0);
+			resolveRect.y0 = min(resolveRect.y0, region.y0);
+			resolveRect.x1 = max(resolveRect.x1, region.x1);
+			resolveRect.y1 = max(resolveRect.y1, region.y1);
+			resolveLayer0 = min(resolveLayer0, layer);
+			resolveLayer1 = max(resolveLayer1, layer + 1);
+		}
+	}
 
-								c0 = _mm_avg_epu8(c0, c1);
+	void Surface::setResolveRoutine(Routine *routine)
+	{
+		if(routine)
+		{
+			routine->bind();
+		}
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+		if(resolveRoutine)
+		{
+			resolveRoutine->unbind();
+		}
 
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-
-								c0 = _mm_avg_epu8(c0, c1);
-								c2 = _mm_avg_epu8(c2, c3);
-								c0 = _mm_avg_epu8(c0, c2);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-
-								c0 = _mm_avg_epu8(c0, c1);
-								c2 = _mm_avg_epu8(c2, c3);
-								c4 = _mm_avg_epu8(c4, c5);
-								c6 = _mm_avg_epu8(c6, c7);
-								c0 = _mm_avg_epu8(c0, c2);
-								c4 = _mm_avg_epu8(c4, c6);
-								c0 = _mm_avg_epu8(c0, c4);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 4 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 4 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 4 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 4 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 4 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 4 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 4 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 4 * x));
-
-								c0 = _mm_avg_epu8(c0, c1);
-								c2 = _mm_avg_epu8(c2, c3);
-								c4 = _mm_avg_epu8(c4, c5);
-								c6 = _mm_avg_epu8(c6, c7);
-								c8 = _mm_avg_epu8(c8, c9);
-								cA = _mm_avg_epu8(cA, cB);
-								cC = _mm_avg_epu8(cC, cD);
-								cE = _mm_avg_epu8(cE, cF);
-								c0 = _mm_avg_epu8(c0, c2);
-								c4 = _mm_avg_epu8(c4, c6);
-								c8 = _mm_avg_epu8(c8, cA);
-								cC = _mm_avg_epu8(cC, cE);
-								c0 = _mm_avg_epu8(c0, c4);
-								c8 = _mm_avg_epu8(c8, cC);
-								c0 = _mm_avg_epu8(c0, c8);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				#define AVERAGE(x, y) (((x) & (y)) + ((((x) ^ (y)) >> 1) & 0x7F7F7F7F) + (((x) ^ (y)) & 0x01010101))
+		resolveRoutine = routine;
+	}
 
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
+	void Surface::resolve()
+	{
+		if(internal.samples <= 1 || resolveRect.x0 >= resolveRect.x1 || !renderTarget || internal.format == VK_FORMAT_UNDEFINED)
+		{
+			return;
+		}
 
-							c0 = AVERAGE(c0, c1);
+		if(isNonNormalizedInteger(internal.format))
+		{
+			resolveRect = Rect(0, 0, 0, 0);
+			return;   // Integer samples can't be averaged, the first sample is kept
+		}
 
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
+		if(!resolveRoutine)
+		{
+			// Nothing which writes through a blitter has touched the samples yet, e.g. they were
+			// written through a public lock. The routine stays bound to the surface, so it
+			// outlives this blitter.
+			Blitter blitter;
+			blitter.attachResolveRoutine(this);
 
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c0 = AVERAGE(c0, c2);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c0 = AVERAGE(c0, c4);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-							unsigned int c8 = *(unsigned int*)(source8 + 4 * x);
-							unsigned int c9 = *(unsigned int*)(source9 + 4 * x);
-							unsigned int cA = *(unsigned int*)(sourceA + 4 * x);
-							unsigned int cB = *(unsigned int*)(sourceB + 4 * x);
-							unsigned int cC = *(unsigned int*)(sourceC + 4 * x);
-							unsigned int cD = *(unsigned int*)(sourceD + 4 * x);
-							unsigned int cE = *(unsigned int*)(sourceE + 4 * x);
-							unsigned int cF = *(unsigned int*)(sourceF + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c8 = AVERAGE(c8, c9);
-							cA = AVERAGE(cA, cB);
-							cC = AVERAGE(cC, cD);
-							cE = AVERAGE(cE, cF);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c8 = AVERAGE(c8, cA);
-							cC = AVERAGE(cC, cE);
-							c0 = AVERAGE(c0, c4);
-							c8 = AVERAGE(c8, cC);
-							c0 = AVERAGE(c0, c8);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-
-				#undef AVERAGE
-			}
-		}
-		else if(internal.format == VK_FORMAT_R16G16_UNORM)
-		{
-
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE2() && (width % 4) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c0 = _mm_avg_epu16(c0, c2);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c0 = _mm_avg_epu16(c0, c4);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 4 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 4 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 4 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 4 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 4 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 4 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 4 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 4 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c8 = _mm_avg_epu16(c8, c9);
-								cA = _mm_avg_epu16(cA, cB);
-								cC = _mm_avg_epu16(cC, cD);
-								cE = _mm_avg_epu16(cE, cF);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c8 = _mm_avg_epu16(c8, cA);
-								cC = _mm_avg_epu16(cC, cE);
-								c0 = _mm_avg_epu16(c0, c4);
-								c8 = _mm_avg_epu16(c8, cC);
-								c0 = _mm_avg_epu16(c0, c8);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
+			if(!resolveRoutine)
 			{
-				#define AVERAGE(x, y) (((x) & (y)) + ((((x) ^ (y)) >> 1) & 0x7FFF7FFF) + (((x) ^ (y)) & 0x00010001))
-
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c0 = AVERAGE(c0, c2);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c0 = AVERAGE(c0, c4);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-							unsigned int c8 = *(unsigned int*)(source8 + 4 * x);
-							unsigned int c9 = *(unsigned int*)(source9 + 4 * x);
-							unsigned int cA = *(unsigned int*)(sourceA + 4 * x);
-							unsigned int cB = *(unsigned int*)(sourceB + 4 * x);
-							unsigned int cC = *(unsigned int*)(sourceC + 4 * x);
-							unsigned int cD = *(unsigned int*)(sourceD + 4 * x);
-							unsigned int cE = *(unsigned int*)(sourceE + 4 * x);
-							unsigned int cF = *(unsigned int*)(sourceF + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c8 = AVERAGE(c8, c9);
-							cA = AVERAGE(cA, cB);
-							cC = AVERAGE(cC, cD);
-							cE = AVERAGE(cE, cF);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c8 = AVERAGE(c8, cA);
-							cC = AVERAGE(cC, cE);
-							c0 = AVERAGE(c0, c4);
-							c8 = AVERAGE(c8, cC);
-							c0 = AVERAGE(c0, c8);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-
-				#undef AVERAGE
+				return;   // The blitter can't read or write this format
 			}
 		}
-		else if(internal.format == VK_FORMAT_R16G16B16A16_UNORM)
-		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE2() && (width % 2) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
 
-								c0 = _mm_avg_epu16(c0, c1);
+		Rect rect = resolveRect;
+		int rowsPerLayer = rect.height();
 
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
+		ResolveTask task;
+		task.resolve = (void(*)(void*, int, int))resolveRoutine->getEntry();
+		task.buffer = (byte*)internal.lockRect(0, 0, 0, LOCK_READWRITE);
+		task.layerB = internal.samples * internal.sliceB;
+		task.pitchB = internal.pitchB;
+		task.offsetB = (internal.border + rect.x0) * internal.bytes;
+		task.count = rect.width();
+		task.sliceB = internal.sliceB;
 
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c0 = _mm_avg_epu16(c0, c2);
-
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 8 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 8 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 8 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 8 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c0 = _mm_avg_epu16(c0, c4);
-
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 8 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 8 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 8 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 8 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 8 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 8 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 8 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 8 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 8 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 8 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 8 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 8 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c8 = _mm_avg_epu16(c8, c9);
-								cA = _mm_avg_epu16(cA, cB);
-								cC = _mm_avg_epu16(cC, cD);
-								cE = _mm_avg_epu16(cE, cF);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c8 = _mm_avg_epu16(c8, cA);
-								cC = _mm_avg_epu16(cC, cE);
-								c0 = _mm_avg_epu16(c0, c4);
-								c8 = _mm_avg_epu16(c8, cC);
-								c0 = _mm_avg_epu16(c0, c8);
-
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				#define AVERAGE(x, y) (((x) & (y)) + ((((x) ^ (y)) >> 1) & 0x7FFF7FFF) + (((x) ^ (y)) & 0x00010001))
-
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c0 = AVERAGE(c0, c2);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c0 = AVERAGE(c0, c4);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-							unsigned int c8 = *(unsigned int*)(source8 + 4 * x);
-							unsigned int c9 = *(unsigned int*)(source9 + 4 * x);
-							unsigned int cA = *(unsigned int*)(sourceA + 4 * x);
-							unsigned int cB = *(unsigned int*)(sourceB + 4 * x);
-							unsigned int cC = *(unsigned int*)(sourceC + 4 * x);
-							unsigned int cD = *(unsigned int*)(sourceD + 4 * x);
-							unsigned int cE = *(unsigned int*)(sourceE + 4 * x);
-							unsigned int cF = *(unsigned int*)(sourceF + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c8 = AVERAGE(c8, c9);
-							cA = AVERAGE(cA, cB);
-							cC = AVERAGE(cC, cD);
-							cE = AVERAGE(cE, cF);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c8 = AVERAGE(c8, cA);
-							cC = AVERAGE(cC, cE);
-							c0 = AVERAGE(c0, c4);
-							c8 = AVERAGE(c8, cC);
-							c0 = AVERAGE(c0, c8);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-
-				#undef AVERAGE
-			}
-		}
-		else if(internal.format == VK_FORMAT_R32_SFLOAT)
+		if(hasQuadLayout(internal.format))
 		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE() && (width % 4) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c0 = _mm_add_ps(c0, c2);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 4 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 4 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 4 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c0 = _mm_add_ps(c0, c4);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 4 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 4 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 4 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 4 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 4 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 4 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 4 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 4 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 4 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 4 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 4 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c8 = _mm_add_ps(c8, c9);
-								cA = _mm_add_ps(cA, cB);
-								cC = _mm_add_ps(cC, cD);
-								cE = _mm_add_ps(cE, cF);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c8 = _mm_add_ps(c8, cA);
-								cC = _mm_add_ps(cC, cE);
-								c0 = _mm_add_ps(c0, c4);
-								c8 = _mm_add_ps(c8, cC);
-								c0 = _mm_add_ps(c0, c8);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-
-							c0 = c0 + c1;
-							c0 *= 1.0f / 2.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c0 = c0 + c2;
-							c0 *= 1.0f / 4.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c0 = c0 + c4;
-							c0 *= 1.0f / 8.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-							float c8 = *(float*)(source8 + 4 * x);
-							float c9 = *(float*)(source9 + 4 * x);
-							float cA = *(float*)(sourceA + 4 * x);
-							float cB = *(float*)(sourceB + 4 * x);
-							float cC = *(float*)(sourceC + 4 * x);
-							float cD = *(float*)(sourceD + 4 * x);
-							float cE = *(float*)(sourceE + 4 * x);
-							float cF = *(float*)(sourceF + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c8 = c8 + c9;
-							cA = cA + cB;
-							cC = cC + cD;
-							cE = cE + cF;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c8 = c8 + cA;
-							cC = cC + cE;
-							c0 = c0 + c4;
-							c8 = c8 + cC;
-							c0 = c0 + c8;
-							c0 *= 1.0f / 16.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
+			// Row pairs are stored interleaved by 2x2 quads, and resolved as a whole
+			rect.x0 &= ~1;
+			rect.y0 &= ~1;
+			rect.x1 = (rect.x1 + 1) & ~1;
+			rect.y1 = (rect.y1 + 1) & ~1;
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-			}
+			rowsPerLayer = rect.height() / 2;
+			task.pitchB = 2 * internal.pitchB;
+			task.offsetB = 2 * rect.x0 * internal.bytes;
+			task.count = 2 * rect.width();
+			task.buffer += rect.y0 * internal.pitchB;
 		}
-		else if(internal.format == VK_FORMAT_R32G32_SFLOAT)
+		else
 		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE() && (width % 2) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c0 = _mm_add_ps(c0, c2);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 8 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 8 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 8 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c0 = _mm_add_ps(c0, c4);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 8 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 8 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 8 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 8 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 8 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 8 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 8 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 8 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 8 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 8 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 8 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c8 = _mm_add_ps(c8, c9);
-								cA = _mm_add_ps(cA, cB);
-								cC = _mm_add_ps(cC, cD);
-								cE = _mm_add_ps(cE, cF);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c8 = _mm_add_ps(c8, cA);
-								cC = _mm_add_ps(cC, cE);
-								c0 = _mm_add_ps(c0, c4);
-								c8 = _mm_add_ps(c8, cC);
-								c0 = _mm_add_ps(c0, c8);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-
-							c0 = c0 + c1;
-							c0 *= 1.0f / 2.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c0 = c0 + c2;
-							c0 *= 1.0f / 4.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c0 = c0 + c4;
-							c0 *= 1.0f / 8.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-							float c8 = *(float*)(source8 + 4 * x);
-							float c9 = *(float*)(source9 + 4 * x);
-							float cA = *(float*)(sourceA + 4 * x);
-							float cB = *(float*)(sourceB + 4 * x);
-							float cC = *(float*)(sourceC + 4 * x);
-							float cD = *(float*)(sourceD + 4 * x);
-							float cE = *(float*)(sourceE + 4 * x);
-							float cF = *(float*)(sourceF + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c8 = c8 + c9;
-							cA = cA + cB;
-							cC = cC + cD;
-							cE = cE + cF;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c8 = c8 + cA;
-							cC = cC + cE;
-							c0 = c0 + c4;
-							c8 = c8 + cC;
-							c0 = c0 + c8;
-							c0 *= 1.0f / 16.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-			}
+			task.buffer += (internal.border + rect.y0) * internal.pitchB;
 		}
-		else if(internal.format == VK_FORMAT_R32G32B32A32_SFLOAT)
-		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE())
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
 
-								c0 = _mm_add_ps(c0, c1);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
+		task.buffer += resolveLayer0 * task.layerB;
+		task.rowsPerLayer = rowsPerLayer;
 
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
+		int rows = (resolveLayer1 - resolveLayer0) * rowsPerLayer;
 
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c0 = _mm_add_ps(c0, c2);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
-
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 16 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 16 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 16 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 16 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c0 = _mm_add_ps(c0, c4);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
-
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 16 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 16 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 16 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 16 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 16 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 16 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 16 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 16 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 16 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 16 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 16 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 16 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c8 = _mm_add_ps(c8, c9);
-								cA = _mm_add_ps(cA, cB);
-								cC = _mm_add_ps(cC, cD);
-								cE = _mm_add_ps(cE, cF);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c8 = _mm_add_ps(c8, cA);
-								cC = _mm_add_ps(cC, cE);
-								c0 = _mm_add_ps(c0, c4);
-								c8 = _mm_add_ps(c8, cC);
-								c0 = _mm_add_ps(c0, c8);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
-
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-
-							c0 = c0 + c1;
-							c0 *= 1.0f / 2.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c0 = c0 + c2;
-							c0 *= 1.0f / 4.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c0 = c0 + c4;
-							c0 *= 1.0f / 8.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-							float c8 = *(float*)(source8 + 4 * x);
-							float c9 = *(float*)(source9 + 4 * x);
-							float cA = *(float*)(sourceA + 4 * x);
-							float cB = *(float*)(sourceB + 4 * x);
-							float cC = *(float*)(sourceC + 4 * x);
-							float cD = *(float*)(sourceD + 4 * x);
-							float cE = *(float*)(sourceE + 4 * x);
-							float cF = *(float*)(sourceF + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c8 = c8 + c9;
-							cA = cA + cB;
-							cC = cC + cD;
-							cE = cE + cF;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c8 = c8 + cA;
-							cC = cC + cE;
-							c0 = c0 + c4;
-							c8 = c8 + cC;
-							c0 = c0 + c8;
-							c0 *= 1.0f / 16.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
+		// Like decoding, only resolves touching many samples are worth spreading over the workers
+		const int minimumSamplesPerBand = 65536;
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-			}
-		}
-		else if(internal.format == VK_FORMAT_R5G6B5_UNORM_PACK16)
+		ThreadPool::Get().parallelForRange(rows, task.count * internal.samples, minimumSamplesPerBand, [&](unsigned int first, unsigned int last)
 		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE2() && (width % 8) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 8)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
-
-								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
-								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
-								__m128i c0_r_b = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c0__g_ = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c1_r_b = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c1__g_ = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-
-								c0 = _mm_avg_epu8(c0_r_b, c1_r_b);
-								c0 = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								c1 = _mm_avg_epu16(c0__g_, c1__g_);
-								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-								c0 = _mm_or_si128(c0, c1);
-
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 8)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 2 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 2 * x));
-
-								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
-								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
-								__m128i c0_r_b = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c0__g_ = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c1_r_b = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c1__g_ = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c2_r_b = _mm_and_si128(c2, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c2__g_ = _mm_and_si128(c2, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c3_r_b = _mm_and_si128(c3, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c3__g_ = _mm_and_si128(c3, reinterpret_cast<const __m128i&>(_g_));
-
-								c0 = _mm_avg_epu8(c0_r_b, c1_r_b);
-								c2 = _mm_avg_epu8(c2_r_b, c3_r_b);
-								c0 = _mm_avg_epu8(c0, c2);
-								c0 = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								c1 = _mm_avg_epu16(c0__g_, c1__g_);
-								c3 = _mm_avg_epu16(c2__g_, c3__g_);
-								c1 = _mm_avg_epu16(c1, c3);
-								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-								c0 = _mm_or_si128(c0, c1);
-
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 8)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 2 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 2 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 2 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 2 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 2 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 2 * x));
-
-								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
-								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
-								__m128i c0_r_b = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c0__g_ = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c1_r_b = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c1__g_ = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c2_r_b = _mm_and_si128(c2, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c2__g_ = _mm_and_si128(c2, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c3_r_b = _mm_and_si128(c3, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c3__g_ = _mm_and_si128(c3, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c4_r_b = _mm_and_si128(c4, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c4__g_ = _mm_and_si128(c4, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c5_r_b = _mm_and_si128(c5, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c5__g_ = _mm_and_si128(c5, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c6_r_b = _mm_and_si128(c6, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c6__g_ = _mm_and_si128(c6, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c7_r_b = _mm_and_si128(c7, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c7__g_ = _mm_and_si128(c7, reinterpret_cast<const __m128i&>(_g_));
-
-								c0 = _mm_avg_epu8(c0_r_b, c1_r_b);
-								c2 = _mm_avg_epu8(c2_r_b, c3_r_b);
-								c4 = _mm_avg_epu8(c4_r_b, c5_r_b);
-								c6 = _mm_avg_epu8(c6_r_b, c7_r_b);
-								c0 = _mm_avg_epu8(c0, c2);
-								c4 = _mm_avg_epu8(c4, c6);
-								c0 = _mm_avg_epu8(c0, c4);
-								c0 = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								c1 = _mm_avg_epu16(c0__g_, c1__g_);
-								c3 = _mm_avg_epu16(c2__g_, c3__g_);
-								c5 = _mm_avg_epu16(c4__g_, c5__g_);
-								c7 = _mm_avg_epu16(c6__g_, c7__g_);
-								c1 = _mm_avg_epu16(c1, c3);
-								c5 = _mm_avg_epu16(c5, c7);
-								c1 = _mm_avg_epu16(c1, c5);
-								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-								c0 = _mm_or_si128(c0, c1);
-
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 8)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 2 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 2 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 2 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 2 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 2 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 2 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 2 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 2 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 2 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 2 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 2 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 2 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 2 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 2 * x));
-
-								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
-								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
-								__m128i c0_r_b = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c0__g_ = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c1_r_b = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c1__g_ = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c2_r_b = _mm_and_si128(c2, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c2__g_ = _mm_and_si128(c2, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c3_r_b = _mm_and_si128(c3, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c3__g_ = _mm_and_si128(c3, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c4_r_b = _mm_and_si128(c4, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c4__g_ = _mm_and_si128(c4, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c5_r_b = _mm_and_si128(c5, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c5__g_ = _mm_and_si128(c5, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c6_r_b = _mm_and_si128(c6, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c6__g_ = _mm_and_si128(c6, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c7_r_b = _mm_and_si128(c7, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c7__g_ = _mm_and_si128(c7, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c8_r_b = _mm_and_si128(c8, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c8__g_ = _mm_and_si128(c8, reinterpret_cast<const __m128i&>(_g_));
-								__m128i c9_r_b = _mm_and_si128(c9, reinterpret_cast<const __m128i&>(r_b));
-								__m128i c9__g_ = _mm_and_si128(c9, reinterpret_cast<const __m128i&>(_g_));
-								__m128i cA_r_b = _mm_and_si128(cA, reinterpret_cast<const __m128i&>(r_b));
-								__m128i cA__g_ = _mm_and_si128(cA, reinterpret_cast<const __m128i&>(_g_));
-								__m128i cB_r_b = _mm_and_si128(cB, reinterpret_cast<const __m128i&>(r_b));
-								__m128i cB__g_ = _mm_and_si128(cB, reinterpret_cast<const __m128i&>(_g_));
-								__m128i cC_r_b = _mm_and_si128(cC, reinterpret_cast<const __m128i&>(r_b));
-								__m128i cC__g_ = _mm_and_si128(cC, reinterpret_cast<const __m128i&>(_g_));
-								__m128i cD_r_b = _mm_and_si128(cD, reinterpret_cast<const __m128i&>(r_b));
-								__m128i cD__g_ = _mm_and_si128(cD, reinterpret_cast<const __m128i&>(_g_));
-								__m128i cE_r_b = _mm_and_si128(cE, reinterpret_cast<const __m128i&>(r_b));
-								__m128i cE__g_ = _mm_and_si128(cE, reinterpret_cast<const __m128i&>(_g_));
-								__m128i cF_r_b = _mm_and_si128(cF, reinterpret_cast<const __m128i&>(r_b));
-								__m128i cF__g_ = _mm_and_si128(cF, reinterpret_cast<const __m128i&>(_g_));
-
-								c0 = _mm_avg_epu8(c0_r_b, c1_r_b);
-								c2 = _mm_avg_epu8(c2_r_b, c3_r_b);
-								c4 = _mm_avg_epu8(c4_r_b, c5_r_b);
-								c6 = _mm_avg_epu8(c6_r_b, c7_r_b);
-								c8 = _mm_avg_epu8(c8_r_b, c9_r_b);
-								cA = _mm_avg_epu8(cA_r_b, cB_r_b);
-								cC = _mm_avg_epu8(cC_r_b, cD_r_b);
-								cE = _mm_avg_epu8(cE_r_b, cF_r_b);
-								c0 = _mm_avg_epu8(c0, c2);
-								c4 = _mm_avg_epu8(c4, c6);
-								c8 = _mm_avg_epu8(c8, cA);
-								cC = _mm_avg_epu8(cC, cE);
-								c0 = _mm_avg_epu8(c0, c4);
-								c8 = _mm_avg_epu8(c8, cC);
-								c0 = _mm_avg_epu8(c0, c8);
-								c0 = _mm_and_si128(c0, reinterpret_cast<const __m128i&>(r_b));
-								c1 = _mm_avg_epu16(c0__g_, c1__g_);
-								c3 = _mm_avg_epu16(c2__g_, c3__g_);
-								c5 = _mm_avg_epu16(c4__g_, c5__g_);
-								c7 = _mm_avg_epu16(c6__g_, c7__g_);
-								c9 = _mm_avg_epu16(c8__g_, c9__g_);
-								cB = _mm_avg_epu16(cA__g_, cB__g_);
-								cD = _mm_avg_epu16(cC__g_, cD__g_);
-								cF = _mm_avg_epu16(cE__g_, cF__g_);
-								c1 = _mm_avg_epu8(c1, c3);
-								c5 = _mm_avg_epu8(c5, c7);
-								c9 = _mm_avg_epu8(c9, cB);
-								cD = _mm_avg_epu8(cD, cF);
-								c1 = _mm_avg_epu8(c1, c5);
-								c9 = _mm_avg_epu8(c9, cD);
-								c1 = _mm_avg_epu8(c1, c9);
-								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
-								c0 = _mm_or_si128(c0, c1);
-
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				#define AVERAGE(x, y) (((x) & (y)) + ((((x) ^ (y)) >> 1) & 0x7BEF) + (((x) ^ (y)) & 0x0821))
-
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned short c0 = *(unsigned short*)(source0 + 2 * x);
-							unsigned short c1 = *(unsigned short*)(source1 + 2 * x);
-
-							c0 = AVERAGE(c0, c1);
-
-							*(unsigned short*)(source0 + 2 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned short c0 = *(unsigned short*)(source0 + 2 * x);
-							unsigned short c1 = *(unsigned short*)(source1 + 2 * x);
-							unsigned short c2 = *(unsigned short*)(source2 + 2 * x);
-							unsigned short c3 = *(unsigned short*)(source3 + 2 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c0 = AVERAGE(c0, c2);
-
-							*(unsigned short*)(source0 + 2 * x) = c0;
-						}
+			resolveRows(task, first, last);
+		});
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned short c0 = *(unsigned short*)(source0 + 2 * x);
-							unsigned short c1 = *(unsigned short*)(source1 + 2 * x);
-							unsigned short c2 = *(unsigned short*)(source2 + 2 * x);
-							unsigned short c3 = *(unsigned short*)(source3 + 2 * x);
-							unsigned short c4 = *(unsigned short*)(source4 + 2 * x);
-							unsigned short c5 = *(unsigned short*)(source5 + 2 * x);
-							unsigned short c6 = *(unsigned short*)(source6 + 2 * x);
-							unsigned short c7 = *(unsigned short*)(source7 + 2 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c0 = AVERAGE(c0, c4);
-
-							*(unsigned short*)(source0 + 2 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned short c0 = *(unsigned short*)(source0 + 2 * x);
-							unsigned short c1 = *(unsigned short*)(source1 + 2 * x);
-							unsigned short c2 = *(unsigned short*)(source2 + 2 * x);
-							unsigned short c3 = *(unsigned short*)(source3 + 2 * x);
-							unsigned short c4 = *(unsigned short*)(source4 + 2 * x);
-							unsigned short c5 = *(unsigned short*)(source5 + 2 * x);
-							unsigned short c6 = *(unsigned short*)(source6 + 2 * x);
-							unsigned short c7 = *(unsigned short*)(source7 + 2 * x);
-							unsigned short c8 = *(unsigned short*)(source8 + 2 * x);
-							unsigned short c9 = *(unsigned short*)(source9 + 2 * x);
-							unsigned short cA = *(unsigned short*)(sourceA + 2 * x);
-							unsigned short cB = *(unsigned short*)(sourceB + 2 * x);
-							unsigned short cC = *(unsigned short*)(sourceC + 2 * x);
-							unsigned short cD = *(unsigned short*)(sourceD + 2 * x);
-							unsigned short cE = *(unsigned short*)(sourceE + 2 * x);
-							unsigned short cF = *(unsigned short*)(sourceF + 2 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c8 = AVERAGE(c8, c9);
-							cA = AVERAGE(cA, cB);
-							cC = AVERAGE(cC, cD);
-							cE = AVERAGE(cE, cF);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c8 = AVERAGE(c8, cA);
-							cC = AVERAGE(cC, cE);
-							c0 = AVERAGE(c0, c4);
-							c8 = AVERAGE(c8, cC);
-							c0 = AVERAGE(c0, c8);
-
-							*(unsigned short*)(source0 + 2 * x) = c0;
-						}
+		internal.unlockRect();
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
+		resolveRect = Rect(0, 0, 0, 0);
+	}
 
-				#undef AVERAGE
-			}
-		}
-		else
+	void Surface::resolveRows(const ResolveTask &task, int first, int last)
+	{
+		for(int row = first; row < last; row++)
 		{
-		//	UNIMPLEMENTED();
+			byte *element = task.buffer + (row / task.rowsPerLayer) * task.layerB + (row % task.rowsPerLayer) * task.pitchB + task.offsetB;
+
+			task.resolve(element, task.count, task.sliceB);
 		}
 	}
 }
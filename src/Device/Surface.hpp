@@ -18,8 +18,14 @@
 #include "Color.hpp"
 #include "Device/Config.hpp"
 #include "System/Resource.hpp"
+#include "System/Thread.hpp"
 #include <vulkan/vulkan.h>
 
+namespace rr
+{
+	class Routine;
+}
+
 namespace sw
 {
 	class Resource;
@@ -161,6 +167,9 @@ namespace sw
 		inline int getSamples() const;
 		inline int getMultiSampleCount() const;
 		inline int getSuperSampleCount() const;
+		void markSamplesDirty(const Rect &rect, int layer);   // Adds a region rendered to by the renderer to the next resolve
+		bool hasResolveRoutine() const { return resolveRoutine != nullptr; }
+		void setResolveRoutine(rr::Routine *routine);   // Provided by the renderer writing to the samples
 
 		bool isEntire(const Rect& rect) const;
 		Rect getRect() const;
@@ -304,6 +313,52 @@ namespace sw
 		static void decodeETC2(Buffer &internal, Buffer &external, int nbAlphaBits, bool isSRGB);
 		static void decodeASTC(Buffer &internal, Buffer &external, int xSize, int ySize, int zSize, bool isSRGB);
 
+		// Compressed images are decoded in bands of block rows, which are independent and can be spread over the workers
+		struct DecodeTask
+		{
+			void (*decode)(const DecodeTask &task, int first, int last);   // Decodes block rows [first, last)
+
+			const Buffer *internal;
+			const Buffer *external;
+			byte *destination;
+			const byte *source;
+
+			int columns;      // Blocks per row
+			int rows;         // Total number of block rows, over all slices
+			int blockWidth;   // Texels per block
+			int blockHeight;
+			int blockBytes;
+			int parameter;    // Format specific (e.g. ETC_Decoder input type)
+			bool isSRGB;
+		};
+
+		static void decodeBlocks(DecodeTask &task, Buffer &internal, Buffer &external, int slices, Lock lock = LOCK_UPDATE, int blockWidth = 4, int blockHeight = 4);
+
+		static void decodeDXT1Rows(const DecodeTask &task, int first, int last);
+		static void decodeDXT3Rows(const DecodeTask &task, int first, int last);
+		static void decodeDXT5Rows(const DecodeTask &task, int first, int last);
+		static void decodeATI1Rows(const DecodeTask &task, int first, int last);
+		static void decodeATI2Rows(const DecodeTask &task, int first, int last);
+		static void decodeEACRows(const DecodeTask &task, int first, int last);
+		static void decodeETC2Rows(const DecodeTask &task, int first, int last);
+		static void decodeASTCRows(const DecodeTask &task, int first, int last);
+
+		// Multisample resolves average spans of elements, in bands of rows spread over the workers like decoding
+		struct ResolveTask
+		{
+			void (*resolve)(void *element, int count, int sliceB);
+
+			byte *buffer;
+			int rowsPerLayer;
+			int layerB;        // Bytes between the first samples of consecutive layers
+			int pitchB;        // Bytes between rows (row pairs for quad layout)
+			int offsetB;       // Offset of the first element within each row
+			int count;         // Elements per row
+			int sliceB;        // Bytes between samples
+		};
+
+		static void resolveRows(const ResolveTask &task, int first, int last);   // Rows [first, last), over all layers
+
 		static void update(Buffer &destination, Buffer &source);
 		static void genericUpdate(Buffer &destination, Buffer &source);
 		static void *allocateBuffer(int width, int height, int depth, int border, int samples, VkFormat format);
@@ -314,6 +369,11 @@ namespace sw
 
 		void resolve();
 
+		Rect resolveRect;   // Region written since the last resolve, empty if none
+		int resolveLayer0;
+		int resolveLayer1;
+		rr::Routine *resolveRoutine;   // From the routine cache of a blitter, null until the samples get written or resolved
+
 		Buffer external;
 		Buffer internal;
 		Buffer stencil;
@@ -29,7 +29,7 @@ namespace sw
 
 	void VertexCache::clear()
 	{
-		for(int i = 0; i < 16; i++)
+		for(int i = 0; i < 64; i++)
 		{
 			tag[i] = 0x80000000;
 		}
@@ -394,6 +394,7 @@ namespace sw
 
 		state.fixedFunction = !context->vertexShader && context->pixelShaderModel() < 0x0300;
 		state.textureSampling = context->vertexShader ? context->vertexShader->containsTextureSampling() : false;
+		state.gatherVertices = (drawType & DRAW_INDEXED32) && !state.textureSampling;   // Set for 8, 16 and 32-bit indices
 		state.positionRegister = context->vertexShader ? context->vertexShader->getPositionRegister() : Pos;
 		state.pointSizeRegister = context->vertexShader ? context->vertexShader->getPointSizeRegister() : Pts;
 
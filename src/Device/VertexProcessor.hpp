@@ -29,7 +29,7 @@ namespace sw
 		void clear();
 
 		Vertex vertex[16][4];
-		unsigned int tag[16];
+		unsigned int tag[64];   // Quads of vertices use the first 16, gathered vertices one per cache line
 
 		int drawCall;
 	};
@@ -52,6 +52,7 @@ namespace sw
 
 			bool fixedFunction             : 1;   // TODO: Eliminate by querying shader.
 			bool textureSampling           : 1;   // TODO: Eliminate by querying shader.
+			bool gatherVertices            : 1;   // Shade unique indices four at a time instead of aligned quads
 			unsigned int positionRegister  : BITS(MAX_VERTEX_OUTPUTS);   // TODO: Eliminate by querying shader.
 			unsigned int pointSizeRegister : BITS(MAX_VERTEX_OUTPUTS);   // TODO: Eliminate by querying shader.
 
@@ -14,15 +14,39 @@
 
 #include "Config.hpp"
 
-#include "Common/Thread.hpp"
 #include "Common/Timer.hpp"
 
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
 namespace sw
 {
 	Profiler profiler;
 
+	void DrawStatistics::accumulate(const DrawStatistics &statistics)
+	{
+		primitivesIn += statistics.primitivesIn;
+		primitivesOut += statistics.primitivesOut;
+		vertexCacheHits += statistics.vertexCacheHits;
+		vertexCacheMisses += statistics.vertexCacheMisses;
+		pixelsShaded += statistics.pixelsShaded;
+		quadsKilled += statistics.quadsKilled;
+		texelFetches += statistics.texelFetches;
+
+		for(int i = 0; i < PERF_TIMERS; i++)
+		{
+			ticks[i] += statistics.ticks[i];
+		}
+	}
+
 	Profiler::Profiler()
 	{
+		instrumentation = false;
+		tracing = false;
+		traceStart = 0;
+		recordedDraws = 0;
+
 		reset();
 	}
 
@@ -32,37 +56,30 @@ namespace sw
 		framesTotal = 0;
 		FPS = 0;
 
-		#if PERF_PROFILE
-			for(int i = 0; i < PERF_TIMERS; i++)
-			{
-				cycles[i] = 0;
-			}
-
-			ropOperations = 0;
-			ropOperationsTotal = 0;
-			ropOperationsFrame = 0;
-
-			texOperations = 0;
-			texOperationsTotal = 0;
-			texOperationsFrame = 0;
+		std::lock_guard<std::mutex> lock(mutex);
 
-			compressedTex = 0;
-			compressedTexTotal = 0;
-			compressedTexFrame = 0;
-		#endif
+		memset(&frame, 0, sizeof(DrawStatistics));
+		memset(&total, 0, sizeof(DrawStatistics));
+		memset(&current, 0, sizeof(DrawStatistics));
+		drawsInFrame = 0;
 	};
 
 	void Profiler::nextFrame()
 	{
-		#if PERF_PROFILE
-			ropOperationsFrame = sw::atomicExchange(&ropOperations, 0);
-			texOperationsFrame = sw::atomicExchange(&texOperations, 0);
-			compressedTexFrame = sw::atomicExchange(&compressedTex, 0);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
 
-			ropOperationsTotal += ropOperationsFrame;
-			texOperationsTotal += texOperationsFrame;
-			compressedTexTotal += compressedTexFrame;
-		#endif
+			frame = current;
+			total.accumulate(current);
+			memset(&current, 0, sizeof(DrawStatistics));
+			drawsInFrame = 0;
+		}
+
+		if(tracing)
+		{
+			int64_t time = Timer::counter();
+			trace("frame", TRACE_APPLICATION_THREAD, framesTotal + framesSec, time, time);
+		}
 
 		static double fpsTime = sw::Timer::seconds();
 
@@ -79,4 +96,193 @@ namespace sw
 			framesSec = 0;
 		}
 	}
-}
\ No newline at end of file
+
+	void Profiler::setInstrumentation(bool enable)
+	{
+		instrumentation = enable;
+	}
+
+	void Profiler::record(DrawStatistics &statistics)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		statistics.frame = framesTotal + framesSec;
+		statistics.draw = drawsInFrame++;
+		current.accumulate(statistics);
+
+		if(draws.size() < MAX_RECORDED_DRAWS)
+		{
+			draws.push_back(statistics);
+		}
+		else
+		{
+			draws[recordedDraws % MAX_RECORDED_DRAWS] = statistics;
+		}
+
+		recordedDraws++;
+	}
+
+	std::vector<DrawStatistics> Profiler::takeStatistics()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// Oldest first, a no-op until the ring wrapped around
+		std::rotate(draws.begin(), draws.begin() + recordedDraws % MAX_RECORDED_DRAWS, draws.end());
+
+		std::vector<DrawStatistics> statistics;
+		statistics.swap(draws);
+		recordedDraws = 0;
+
+		return statistics;
+	}
+
+	std::string Profiler::statisticsJSON()
+	{
+		static const char *const timerNames[PERF_TIMERS] = {"vertex", "setup", "pixel", "pipe", "interp", "shader", "tex", "rop"};
+
+		std::vector<DrawStatistics> statistics = takeStatistics();
+		std::string json = "{\"draws\":[";   // Ticks are time stamp counter cycles
+
+		for(size_t i = 0; i < statistics.size(); i++)
+		{
+			const DrawStatistics &draw = statistics[i];
+
+			json += (i == 0) ? "\n" : ",\n";
+			json += "{\"frame\":" + std::to_string(draw.frame) +
+			        ",\"draw\":" + std::to_string(draw.draw) +
+			        ",\"primitivesIn\":" + std::to_string(draw.primitivesIn) +
+			        ",\"primitivesOut\":" + std::to_string(draw.primitivesOut) +
+			        ",\"vertexCacheHits\":" + std::to_string(draw.vertexCacheHits) +
+			        ",\"vertexCacheMisses\":" + std::to_string(draw.vertexCacheMisses) +
+			        ",\"pixelsShaded\":" + std::to_string(draw.pixelsShaded) +
+			        ",\"quadsKilled\":" + std::to_string(draw.quadsKilled) +
+			        ",\"texelFetches\":" + std::to_string(draw.texelFetches) +
+			        ",\"ticks\":{";
+
+			for(int t = 0; t < PERF_TIMERS; t++)
+			{
+				json += std::string(t == 0 ? "" : ",") + "\"" + timerNames[t] + "\":" + std::to_string(draw.ticks[t]);
+			}
+
+			json += "}}";
+		}
+
+		json += "]}\n";
+
+		return json;
+	}
+
+	bool Profiler::dumpStatistics(const char *filename)
+	{
+		FILE *file = fopen(filename, "w");
+
+		if(!file)
+		{
+			return false;
+		}
+
+		std::string json = statisticsJSON();
+		bool written = fwrite(json.c_str(), 1, json.size(), file) == json.size();
+		fclose(file);
+
+		return written;
+	}
+
+	void Profiler::setTracing(bool enable)
+	{
+		std::lock_guard<std::mutex> lock(traceMutex);
+
+		if(enable && !tracing)
+		{
+			traceStart = Timer::counter();
+			events.clear();
+		}
+
+		tracing = enable;
+	}
+
+	void Profiler::trace(const char *name, int thread, unsigned int id, int64_t begin, int64_t end)
+	{
+		std::lock_guard<std::mutex> lock(traceMutex);
+
+		if(events.size() < MAX_TRACE_EVENTS)
+		{
+			events.push_back({name, thread, id, begin, end});
+		}
+	}
+
+	std::string Profiler::traceJSON()
+	{
+		std::vector<TraceEvent> traceEvents;
+		int64_t start;
+
+		{
+			std::lock_guard<std::mutex> lock(traceMutex);
+
+			traceEvents.swap(events);
+			start = traceStart;
+		}
+
+		double microseconds = 1.0e6 / Timer::frequency();
+		bool named[TRACE_APPLICATION_THREAD + 1] = {};
+		std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		char event[256];
+
+		for(size_t i = 0; i < traceEvents.size(); i++)
+		{
+			const TraceEvent &traceEvent = traceEvents[i];
+			double ts = (traceEvent.begin - start) * microseconds;
+
+			json += (i == 0) ? "\n" : ",\n";
+
+			if(!named[traceEvent.thread])
+			{
+				named[traceEvent.thread] = true;
+
+				if(traceEvent.thread == TRACE_APPLICATION_THREAD)
+				{
+					snprintf(event, sizeof(event), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Application\"}},\n", traceEvent.thread);
+				}
+				else
+				{
+					snprintf(event, sizeof(event), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Worker %d\"}},\n", traceEvent.thread, traceEvent.thread);
+				}
+
+				json += event;
+			}
+
+			if(traceEvent.end == traceEvent.begin)
+			{
+				snprintf(event, sizeof(event), "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"args\":{\"id\":%u}}",
+				         traceEvent.name, traceEvent.thread, ts, traceEvent.id);
+			}
+			else
+			{
+				snprintf(event, sizeof(event), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%u}}",
+				         traceEvent.name, traceEvent.thread, ts, (traceEvent.end - traceEvent.begin) * microseconds, traceEvent.id);
+			}
+
+			json += event;
+		}
+
+		json += "]}\n";
+
+		return json;
+	}
+
+	bool Profiler::dumpTrace(const char *filename)
+	{
+		FILE *file = fopen(filename, "w");
+
+		if(!file)
+		{
+			return false;
+		}
+
+		std::string json = traceJSON();
+		bool written = fwrite(json.c_str(), 1, json.size(), file) == json.size();
+		fclose(file);
+
+		return written;
+	}
+}
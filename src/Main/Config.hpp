@@ -17,10 +17,12 @@
 
 #include "Common/Types.hpp"
 
-#define PERF_HUD 0       // Display time spent on vertex, setup and pixel processing for each thread
-#define PERF_PROFILE 0   // Profile various pipeline stages and display the timing in SwiftConfig
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
 
-#define ASTC_SUPPORT 0
+#define ASTC_SUPPORT 1
 
 // Worker thread count when not set by SwiftConfig
 // 0 = process affinity count (recommended)
@@ -33,7 +35,9 @@ namespace sw
 {
 	enum
 	{
-		PERF_PIXEL,
+		PERF_VERTEX,
+		PERF_SETUP,
+		PERF_PIXEL,    // Pixel routines as a whole, the timers below are part of it
 		PERF_PIPE,
 		PERF_INTERP,
 		PERF_SHADER,
@@ -43,6 +47,34 @@ namespace sw
 		PERF_TIMERS
 	};
 
+	// Counters of a draw call, gathered while instrumentation is enabled
+	struct DrawStatistics
+	{
+		void accumulate(const DrawStatistics &statistics);
+
+		int frame;   // Identify the draw call, not accumulated
+		int draw;
+
+		int64_t primitivesIn;
+		int64_t primitivesOut;       // Left to rasterize after clipping and culling
+		int64_t vertexCacheHits;
+		int64_t vertexCacheMisses;
+		int64_t pixelsShaded;
+		int64_t quadsKilled;         // Rejected by the early depth test
+		int64_t texelFetches;        // Pixel shader texture lookups, regardless of the filter's footprint
+		int64_t ticks[PERF_TIMERS];
+	};
+
+	// Span of work on one thread, in Timer::counter() units
+	struct TraceEvent
+	{
+		const char *name;   // Must be a string literal
+		int thread;         // Worker thread index, or TRACE_APPLICATION_THREAD
+		unsigned int id;    // Draw call number or routine state hash
+		int64_t begin;
+		int64_t end;        // Equal to begin for instant events
+	};
+
 	struct Profiler
 	{
 		Profiler();
@@ -50,25 +82,48 @@ namespace sw
 		void reset();
 		void nextFrame();
 
+		// Routines generated while instrumentation is disabled don't contain any counters
+		void setInstrumentation(bool enable);
+		bool isInstrumenting() const { return instrumentation; }
+
+		void record(DrawStatistics &statistics);   // Called by the worker threads as draws retire
+		std::vector<DrawStatistics> takeStatistics();
+		std::string statisticsJSON();   // Takes the recorded draws
+		bool dumpStatistics(const char *filename);
+
+		// Records worker tasks, routine compilations and frame boundaries in the Chrome trace event format
+		enum { TRACE_APPLICATION_THREAD = 16 };
+		void setTracing(bool enable);
+		bool isTracing() const { return tracing; }
+
+		void trace(const char *name, int thread, unsigned int id, int64_t begin, int64_t end);
+		std::string traceJSON();   // Takes the recorded events
+		bool dumpTrace(const char *filename);
+
 		int framesSec;
 		int framesTotal;
 		double FPS;
 
-		#if PERF_PROFILE
-		double cycles[PERF_TIMERS];
+		DrawStatistics frame;   // Sums over the last frame and since the last reset
+		DrawStatistics total;
+
+	private:
+		enum { MAX_RECORDED_DRAWS = 1 << 14 };   // Older draws get overwritten, only the sums include them
+		enum { MAX_TRACE_EVENTS = 1 << 22 };
 
-		int64_t ropOperations;
-		int64_t ropOperationsTotal;
-		int64_t ropOperationsFrame;
+		// Switched by SwiftConfig's server thread, and read by the renderer threads
+		std::atomic<bool> instrumentation;
+		std::atomic<bool> tracing;
 
-		int64_t texOperations;
-		int64_t texOperationsTotal;
-		int64_t texOperationsFrame;
+		std::mutex mutex;
+		DrawStatistics current;
+		std::vector<DrawStatistics> draws;   // Ring of the most recent draws
+		size_t recordedDraws;                // Since they were last taken
+		int drawsInFrame;
 
-		int64_t compressedTex;
-		int64_t compressedTexTotal;
-		int64_t compressedTexFrame;
-		#endif
+		std::mutex traceMutex;
+		int64_t traceStart;
+		std::vector<TraceEvent> events;
 	};
 
 	extern Profiler profiler;
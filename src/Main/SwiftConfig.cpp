@@ -178,6 +178,14 @@ namespace sw
 				{
 					return send(clientSocket, OK, page());
 				}
+				else if(match(&request, "/statistics "))
+				{
+					return send(clientSocket, OK, profiler.statisticsJSON(), "application/json");
+				}
+				else if(match(&request, "/trace "))
+				{
+					return send(clientSocket, OK, profiler.traceJSON(), "application/json");
+				}
 			}
 		}
 		else if(match(&request, "POST /"))
@@ -440,6 +448,12 @@ namespace sw
 		html += "</select></td>\n";
 		html += "<tr><td>Force clearing registers that have no default value:</td><td><input name = 'forceClearRegisters' type='checkbox'" + (config.forceClearRegisters == true ? checked : empty) + " title='Initializes shader register values to 0 even if they have no default.'></td></tr>";
 		html += "</table>\n";
+		html += "<h2><em>Profiling</em></h2>\n";
+		html += "<table>\n";
+		html += "<tr><td>Pipeline instrumentation:</td><td><input name = 'instrumentation' type='checkbox'" + (config.instrumentation == true ? checked : empty) + " title='If checked routines count primitives, pixels and texel fetches and time each pipeline stage. The counters of each draw call are available at /swiftshader/statistics.'></td></tr>";
+		html += "<tr><td>Trace recording:</td><td><input name = 'tracing' type='checkbox'" + (config.tracing == true ? checked : empty) + " title='If checked the worker tasks and routine compilations are recorded. The trace is available at /swiftshader/trace, for chrome://tracing.'></td></tr>";
+		html += "<tr><td>Perf symbol map:</td><td><input name = 'perfMap' type='checkbox'" + (config.perfMap == true ? checked : empty) + " title='If checked routines generated from now on are named in /tmp/perf-PID.map, for Linux perf.'></td></tr>";
+		html += "</table>\n";
 	#ifndef NDEBUG
 		html += "<h2><em>Debugging</em></h2>\n";
 		html += "<table>\n";
@@ -467,12 +481,17 @@ namespace sw
 		html += "<p>FPS: " + ftoa(profiler.FPS) + "</p>\n";
 		html += "<p>Frame: " + itoa(profiler.framesTotal) + "</p>\n";
 
-		#if PERF_PROFILE
-			int texTime = (int)(1000 * profiler.cycles[PERF_TEX] / profiler.cycles[PERF_PIXEL] + 0.5);
-			int shaderTime = (int)(1000 * profiler.cycles[PERF_SHADER] / profiler.cycles[PERF_PIXEL] + 0.5);
-			int pipeTime = (int)(1000 * profiler.cycles[PERF_PIPE] / profiler.cycles[PERF_PIXEL] + 0.5);
-			int ropTime = (int)(1000 * profiler.cycles[PERF_ROP] / profiler.cycles[PERF_PIXEL] + 0.5);
-			int interpTime = (int)(1000 * profiler.cycles[PERF_INTERP] / profiler.cycles[PERF_PIXEL] + 0.5);
+		if(profiler.isInstrumenting())
+		{
+			const DrawStatistics &frame = profiler.frame;
+			const DrawStatistics &total = profiler.total;
+			double pixelTicks = (double)std::max(frame.ticks[PERF_PIXEL], (int64_t)1);
+
+			int texTime = (int)(1000 * frame.ticks[PERF_TEX] / pixelTicks + 0.5);
+			int shaderTime = (int)(1000 * frame.ticks[PERF_SHADER] / pixelTicks + 0.5);
+			int pipeTime = (int)(1000 * frame.ticks[PERF_PIPE] / pixelTicks + 0.5);
+			int ropTime = (int)(1000 * frame.ticks[PERF_ROP] / pixelTicks + 0.5);
+			int interpTime = (int)(1000 * frame.ticks[PERF_INTERP] / pixelTicks + 0.5);
 			int rastTime = 1000 - pipeTime;
 
 			pipeTime -= shaderTime + ropTime + interpTime;
@@ -485,13 +504,14 @@ namespace sw
 			double interpTimeF = (double)interpTime / 10;
 			double rastTimeF = (double)rastTime / 10;
 
-			double averageRopOperations = profiler.ropOperationsTotal / std::max(profiler.framesTotal, 1) / 1.0e6f;
-			double averageCompressedTex = profiler.compressedTexTotal / std::max(profiler.framesTotal, 1) / 1.0e6f;
-			double averageTexOperations = profiler.texOperationsTotal / std::max(profiler.framesTotal, 1) / 1.0e6f;
+			double frames = std::max(profiler.framesTotal, 1);
+			double averagePrimitives = total.primitivesOut / frames / 1.0e6f;
+			double averagePixels = total.pixelsShaded / frames / 1.0e6f;
+			double averageTexelFetches = total.texelFetches / frames / 1.0e6f;
 
-			html += "<p>Raster operations (million): " + ftoa(profiler.ropOperationsFrame / 1.0e6f) + " (current), " + ftoa(averageRopOperations) + " (average)</p>\n";
-			html += "<p>Texture operations (million): " + ftoa(profiler.texOperationsFrame / 1.0e6f) + " (current), " + ftoa(averageTexOperations) + " (average)</p>\n";
-			html += "<p>Compressed texture operations (million): " + ftoa(profiler.compressedTexFrame / 1.0e6f) + " (current), " + ftoa(averageCompressedTex) + " (average)</p>\n";
+			html += "<p>Primitives rasterized (million): " + ftoa(frame.primitivesOut / 1.0e6f) + " (current), " + ftoa(averagePrimitives) + " (average)</p>\n";
+			html += "<p>Pixels shaded (million): " + ftoa(frame.pixelsShaded / 1.0e6f) + " (current), " + ftoa(averagePixels) + " (average)</p>\n";
+			html += "<p>Texel fetches (million): " + ftoa(frame.texelFetches / 1.0e6f) + " (current), " + ftoa(averageTexelFetches) + " (average)</p>\n";
 			html += "<div id='profile' style='position:relative; width:1010px; height:50px; background-color:silver;'>";
 			html += "<div style='position:relative; width:1000px; height:40px; background-color:white; left:5px; top:5px;'>";
 			html += "<div style='position:relative; float:left; width:" + itoa(rastTime)   + "px; height:40px; border-style:none; text-align:center; line-height:40px; background-color:#FFFF7F; overflow:hidden;'>" + ftoa(rastTimeF)   + "% rast</div>\n";
@@ -501,17 +521,12 @@ namespace sw
 			html += "<div style='position:relative; float:left; width:" + itoa(texTime)    + "px; height:40px; border-style:none; text-align:center; line-height:40px; background-color:#FF7FFF; overflow:hidden;'>" + ftoa(texTimeF)    + "% tex</div>\n";
 			html += "<div style='position:relative; float:left; width:" + itoa(ropTime)    + "px; height:40px; border-style:none; text-align:center; line-height:40px; background-color:#7F7FFF; overflow:hidden;'>" + ftoa(ropTimeF)    + "% rop</div>\n";
 			html += "</div></div>\n";
-
-			for(int i = 0; i < PERF_TIMERS; i++)
-			{
-				profiler.cycles[i] = 0;
-			}
-		#endif
+		}
 
 		return html;
 	}
 
-	void SwiftConfig::send(Socket *clientSocket, Status code, std::string body)
+	void SwiftConfig::send(Socket *clientSocket, Status code, std::string body, const char *contentType)
 	{
 		std::string status;
 		char header[1024];
@@ -522,10 +537,10 @@ namespace sw
 		case NotFound: status += "HTTP/1.1 404 Not Found\r\n"; break;
 		}
 
-		sprintf(header, "Content-Type: text/html; charset=UTF-8\r\n"
+		sprintf(header, "Content-Type: %s; charset=UTF-8\r\n"
 						"Content-Length: %zd\r\n"
 						"Host: localhost\r\n"
-						"\r\n", body.size());
+						"\r\n", contentType, body.size());
 
 		std::string message = status + header + body;
 		clientSocket->send(message.c_str(), (int)message.length());
@@ -548,6 +563,9 @@ namespace sw
 		config.disable10BitMode = false;
 		config.precache = false;
 		config.forceClearRegisters = false;
+		config.instrumentation = false;
+		config.tracing = false;
+		config.perfMap = false;
 
 		while(*post != 0)
 		{
@@ -690,6 +708,18 @@ namespace sw
 			{
 				config.forceClearRegisters = true;
 			}
+			else if(strstr(post, "instrumentation=on"))
+			{
+				config.instrumentation = true;
+			}
+			else if(strstr(post, "tracing=on"))
+			{
+				config.tracing = true;
+			}
+			else if(strstr(post, "perfMap=on"))
+			{
+				config.perfMap = true;
+			}
 		#ifndef NDEBUG
 			else if(sscanf(post, "minPrimitives=%d", &integer))
 			{
@@ -753,6 +783,10 @@ namespace sw
 		config.precache = ini.getBoolean("Testing", "Precache", false);
 		config.shadowMapping = ini.getInteger("Testing", "ShadowMapping", 3);
 		config.forceClearRegisters = ini.getBoolean("Testing", "ForceClearRegisters", false);
+		config.instrumentation = ini.getBoolean("Profiling", "Instrumentation", false);
+		config.statisticsFile = ini.getValue("Profiling", "StatisticsFile", "");
+		config.tracing = ini.getBoolean("Profiling", "Tracing", false);
+		config.perfMap = ini.getBoolean("Profiling", "PerfMap", false);
 
 	#ifndef NDEBUG
 		config.minPrimitives = 1;
@@ -811,6 +845,10 @@ namespace sw
 		ini.addValue("Testing", "Precache", itoa(config.precache));
 		ini.addValue("Testing", "ShadowMapping", itoa(config.shadowMapping));
 		ini.addValue("Testing", "ForceClearRegisters", itoa(config.forceClearRegisters));
+		ini.addValue("Profiling", "Instrumentation", itoa(config.instrumentation));
+		ini.addValue("Profiling", "StatisticsFile", config.statisticsFile);
+		ini.addValue("Profiling", "Tracing", itoa(config.tracing));
+		ini.addValue("Profiling", "PerfMap", itoa(config.perfMap));
 		ini.addValue("LastModified", "Time", itoa((int)time(0)));
 
 		ini.writeFile("SwiftShader Configuration File\n"
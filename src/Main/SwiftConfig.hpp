@@ -62,6 +62,10 @@ namespace sw
 			bool precache;
 			int shadowMapping;
 			bool forceClearRegisters;
+			bool instrumentation;
+			std::string statisticsFile;   // Receives the recorded draws as JSON when a renderer shuts down, unless empty
+			bool tracing;
+			bool perfMap;
 		#ifndef NDEBUG
 			unsigned int minPrimitives;
 			unsigned int maxPrimitives;
@@ -91,7 +95,7 @@ namespace sw
 		void respond(Socket *clientSocket, const char *request);
 		std::string page();
 		std::string profile();
-		void send(Socket *clientSocket, Status code, std::string body = "");
+		void send(Socket *clientSocket, Status code, std::string body = "", const char *contentType = "text/html");
 		void parsePost(const char *post);
 
 		void readConfiguration(bool disableServerOverride = false);
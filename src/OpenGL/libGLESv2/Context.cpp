@@ -98,6 +98,7 @@ Context::Context(egl::Display *display, const Context *shareContext, const egl::
 	mState.ditherEnabled = true;
 	mState.primitiveRestartFixedIndexEnabled = false;
 	mState.rasterizerDiscardEnabled = false;
+	mState.conditionalMode = GL_QUERY_WAIT_NV;
 	mState.generateMipmapHint = GL_DONT_CARE;
 	mState.fragmentShaderDerivativeHint = GL_DONT_CARE;
 	mState.textureFilteringHint = GL_DONT_CARE;
@@ -232,6 +233,8 @@ Context::~Context()
 		mState.activeQuery[i] = nullptr;
 	}
 
+	mState.conditionalQuery = nullptr;
+
 	mState.arrayBuffer = nullptr;
 	mState.copyReadBuffer = nullptr;
 	mState.copyWriteBuffer = nullptr;
@@ -1387,6 +1390,12 @@ void Context::beginQuery(GLenum target, GLuint query)
 		return error(GL_INVALID_OPERATION);
 	}
 
+	// Draws in flight may still depend on the result of the query used for conditional rendering
+	if(queryObject == mState.conditionalQuery)
+	{
+		return error(GL_INVALID_OPERATION);
+	}
+
 	// Set query as active for specified target
 	mState.activeQuery[qType] = queryObject;
 
@@ -1418,6 +1427,69 @@ void Context::endQuery(GLenum target)
 	mState.activeQuery[qType] = nullptr;
 }
 
+void Context::beginConditionalRender(GLuint query, GLenum mode)
+{
+	switch(mode)
+	{
+	case GL_QUERY_WAIT_NV:
+	case GL_QUERY_NO_WAIT_NV:
+	case GL_QUERY_BY_REGION_WAIT_NV:
+	case GL_QUERY_BY_REGION_NO_WAIT_NV:
+		break;
+	default:
+		return error(GL_INVALID_ENUM);
+	}
+
+	if(mState.conditionalQuery)
+	{
+		return error(GL_INVALID_OPERATION);
+	}
+
+	Query *queryObject = getQuery(query);
+
+	if(!queryObject || !queryObject->getQuery())
+	{
+		return error(GL_INVALID_VALUE);
+	}
+
+	switch(queryObject->getType())
+	{
+	case GL_ANY_SAMPLES_PASSED_EXT:
+	case GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT:
+		break;
+	default:
+		return error(GL_INVALID_OPERATION);
+	}
+
+	for(int i = 0; i < QUERY_TYPE_COUNT; i++)
+	{
+		if(mState.activeQuery[i] == queryObject)
+		{
+			return error(GL_INVALID_OPERATION);
+		}
+	}
+
+	mState.conditionalQuery = queryObject;
+	mState.conditionalMode = mode;
+
+	// Regions are as large as the render targets, so the result is the same either way.
+	// The worker threads discard the draws, the application never waits on the result.
+	bool wait = (mode == GL_QUERY_WAIT_NV) || (mode == GL_QUERY_BY_REGION_WAIT_NV);
+	device->setCondition(queryObject->getQuery(), wait);
+}
+
+void Context::endConditionalRender()
+{
+	if(!mState.conditionalQuery)
+	{
+		return error(GL_INVALID_OPERATION);
+	}
+
+	device->setCondition(nullptr, false);
+
+	mState.conditionalQuery = nullptr;
+}
+
 void Context::setFramebufferZero(Framebuffer *buffer)
 {
 	delete mFramebufferNameSpace.remove(0);
@@ -3413,7 +3485,7 @@ void Context::readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum
 
 void Context::clear(GLbitfield mask)
 {
-	if(mState.rasterizerDiscardEnabled)
+	if(mState.rasterizerDiscardEnabled || conditionSkipsClear())
 	{
 		return;
 	}
@@ -3462,7 +3534,7 @@ void Context::clear(GLbitfield mask)
 void Context::clearColorBuffer(GLint drawbuffer, void *value, sw::Format format)
 {
 	unsigned int rgbaMask = getColorMask();
-	if(rgbaMask && !mState.rasterizerDiscardEnabled)
+	if(rgbaMask && !mState.rasterizerDiscardEnabled && !conditionSkipsClear())
 	{
 		Framebuffer *framebuffer = getDrawFramebuffer();
 		if(!framebuffer || (framebuffer->completeness() != GL_FRAMEBUFFER_COMPLETE))
@@ -3504,7 +3576,7 @@ void Context::clearColorBuffer(GLint drawbuffer, const GLfloat *value)
 
 void Context::clearDepthBuffer(const GLfloat value)
 {
-	if(mState.depthMask && !mState.rasterizerDiscardEnabled)
+	if(mState.depthMask && !mState.rasterizerDiscardEnabled && !conditionSkipsClear())
 	{
 		Framebuffer *framebuffer = getDrawFramebuffer();
 		if(!framebuffer || (framebuffer->completeness() != GL_FRAMEBUFFER_COMPLETE))
@@ -3532,7 +3604,7 @@ void Context::clearDepthBuffer(const GLfloat value)
 
 void Context::clearStencilBuffer(const GLint value)
 {
-	if(mState.stencilWritemask && !mState.rasterizerDiscardEnabled)
+	if(mState.stencilWritemask && !mState.rasterizerDiscardEnabled && !conditionSkipsClear())
 	{
 		Framebuffer *framebuffer = getDrawFramebuffer();
 		if(!framebuffer || (framebuffer->completeness() != GL_FRAMEBUFFER_COMPLETE))
@@ -3968,6 +4040,26 @@ bool Context::cullSkipsDraw(GLenum drawMode)
 	return mState.cullFaceEnabled && mState.cullMode == GL_FRONT_AND_BACK && isTriangleMode(drawMode);
 }
 
+bool Context::conditionSkipsClear()
+{
+	Query *query = mState.conditionalQuery;
+
+	if(!query)
+	{
+		return false;
+	}
+
+	// Clears are performed by the application thread, so they can't be held back like draws
+	switch(mState.conditionalMode)
+	{
+	case GL_QUERY_WAIT_NV:
+	case GL_QUERY_BY_REGION_WAIT_NV:
+		return query->getResult() == GL_FALSE;
+	default:
+		return query->isResultAvailable() && (query->getResult() == GL_FALSE);
+	}
+}
+
 bool Context::isTriangleMode(GLenum drawMode)
 {
 	switch(drawMode)
@@ -4492,7 +4584,6 @@ const GLubyte *Context::getExtensions(GLuint index, GLuint *numExt) const
 		"GL_EXT_texture_format_BGRA8888",
 		"GL_EXT_texture_rg",
 #if (ASTC_SUPPORT)
-		"GL_KHR_texture_compression_astc_hdr",
 		"GL_KHR_texture_compression_astc_ldr",
 #endif
 		"GL_ARB_texture_rectangle",
@@ -4504,6 +4595,7 @@ const GLubyte *Context::getExtensions(GLuint index, GLuint *numExt) const
 		"GL_APPLE_texture_format_BGRA8888",
 		"GL_CHROMIUM_color_buffer_float_rgba", // A subset of EXT_color_buffer_float on top of OpenGL ES 2.0
 		"GL_CHROMIUM_texture_filtering_hint",
+		"GL_NV_conditional_render",
 		"GL_NV_depth_buffer_float2",
 		"GL_NV_fence",
 		"GL_NV_framebuffer_blit",
@@ -422,6 +422,8 @@ struct State
 	VertexAttribute vertexAttribute[MAX_VERTEX_ATTRIBS];
 	gl::BindingPointer<Texture> samplerTexture[TEXTURE_TYPE_COUNT][MAX_COMBINED_TEXTURE_IMAGE_UNITS];
 	gl::BindingPointer<Query> activeQuery[QUERY_TYPE_COUNT];
+	gl::BindingPointer<Query> conditionalQuery;   // Non-null while conditional rendering is active
+	GLenum conditionalMode;
 
 	gl::PixelStorageModes unpackParameters;
 	gl::PixelStorageModes packParameters;
@@ -602,6 +604,9 @@ public:
 	void beginQuery(GLenum target, GLuint query);
 	void endQuery(GLenum target);
 
+	void beginConditionalRender(GLuint query, GLenum mode);
+	void endConditionalRender();
+
 	void setFramebufferZero(Framebuffer *framebuffer);
 
 	void setRenderbufferStorage(RenderbufferStorage *renderbuffer);
@@ -722,6 +727,7 @@ private:
 	void detachSampler(GLuint sampler);
 
 	bool cullSkipsDraw(GLenum drawMode);
+	bool conditionSkipsClear();
 	bool isTriangleMode(GLenum drawMode);
 
 	Query *createQuery(GLuint handle, GLenum type);
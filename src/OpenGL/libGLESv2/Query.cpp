@@ -17,7 +17,6 @@
 #include "Query.h"
 
 #include "main.h"
-#include "Common/Thread.hpp"
 
 namespace es2
 {
@@ -37,6 +36,13 @@ Query::~Query()
 
 void Query::begin()
 {
+	if(mQuery && mQuery->isShared())
+	{
+		// Draws still in flight may contribute to, or be predicated on, the previous result
+		mQuery->release();
+		mQuery = nullptr;
+	}
+
 	if(!mQuery)
 	{
 		sw::Query::Type type;
@@ -44,7 +50,7 @@ void Query::begin()
 		{
 		case GL_ANY_SAMPLES_PASSED_EXT:
 		case GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT:
-			type = sw::Query::FRAGMENTS_PASSED;
+			type = sw::Query::ANY_FRAGMENTS_PASSED;
 			break;
 		case GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN:
 			type = sw::Query::TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN;
@@ -114,7 +120,7 @@ GLuint Query::getResult()
 	{
 		while(!testQuery())
 		{
-			sw::Thread::yield();
+			mQuery->wait();
 		}
 	}
 
@@ -37,6 +37,7 @@ public:
 	GLboolean isResultAvailable();
 
 	GLenum getType() const;
+	sw::Query *getQuery() const { return mQuery; }
 
 private:
 	GLboolean testQuery();
@@ -786,7 +786,13 @@ void Texture2D::generateMipmaps()
 			return error(GL_OUT_OF_MEMORY);
 		}
 
-		getDevice()->stretchRect(image[i - 1], 0, image[i], 0, Device::ALL_BUFFERS | Device::USE_FILTER);
+		sw::Surface *source = image[i - 1];
+		sw::Surface *dest = image[i];
+
+		if(!getDevice()->downsample(&source, &dest, 1))
+		{
+			getDevice()->stretchRect(image[i - 1], 0, image[i], 0, Device::ALL_BUFFERS | Device::USE_FILTER);
+		}
 	}
 }
 
@@ -1319,12 +1325,15 @@ void TextureCubeMap::generateMipmaps()
 	int p = log2(image[0][mBaseLevel]->getWidth()) + mBaseLevel;
 	int q = std::min(p, mMaxLevel);
 
-	for(int f = 0; f < 6; f++)
+	for(int i = mBaseLevel + 1; i <= q; i++)
 	{
-		ASSERT(image[f][mBaseLevel]);
+		sw::Surface *source[6];
+		sw::Surface *dest[6];
 
-		for(int i = mBaseLevel + 1; i <= q; i++)
+		for(int f = 0; f < 6; f++)
 		{
+			ASSERT(image[f][mBaseLevel]);
+
 			if(image[f][i])
 			{
 				image[f][i]->release();
@@ -1337,7 +1346,17 @@ void TextureCubeMap::generateMipmaps()
 				return error(GL_OUT_OF_MEMORY);
 			}
 
-			getDevice()->stretchRect(image[f][i - 1], 0, image[f][i], 0, Device::ALL_BUFFERS | Device::USE_FILTER);
+			source[f] = image[f][i - 1];
+			dest[f] = image[f][i];
+		}
+
+		// All faces of a level are filtered at once, so they can be spread over threads
+		if(!getDevice()->downsample(source, dest, 6))
+		{
+			for(int f = 0; f < 6; f++)
+			{
+				getDevice()->stretchRect(image[f][i - 1], 0, image[f][i], 0, Device::ALL_BUFFERS | Device::USE_FILTER);
+			}
 		}
 	}
 }
@@ -1759,7 +1778,13 @@ void Texture3D::generateMipmaps()
 			return error(GL_OUT_OF_MEMORY);
 		}
 
-		getDevice()->stretchCube(image[i - 1], image[i]);
+		sw::Surface *source = image[i - 1];
+		sw::Surface *dest = image[i];
+
+		if(!getDevice()->downsample(&source, &dest, 1))
+		{
+			getDevice()->stretchCube(image[i - 1], image[i]);
+		}
 	}
 }
 
@@ -1864,13 +1889,19 @@ void Texture2DArray::generateMipmaps()
 			return error(GL_OUT_OF_MEMORY);
 		}
 
-		GLsizei srcw = image[i - 1]->getWidth();
-		GLsizei srch = image[i - 1]->getHeight();
-		for(int z = 0; z < depth; ++z)
+		sw::Surface *source = image[i - 1];
+		sw::Surface *dest = image[i];
+
+		if(!getDevice()->downsample(&source, &dest, 1))   // All slices at once
 		{
-			sw::SliceRectF srcRect(0.0f, 0.0f, static_cast<float>(srcw), static_cast<float>(srch), z);
-			sw::SliceRect dstRect(0, 0, w, h, z);
-			getDevice()->stretchRect(image[i - 1], &srcRect, image[i], &dstRect, Device::ALL_BUFFERS | Device::USE_FILTER);
+			GLsizei srcw = image[i - 1]->getWidth();
+			GLsizei srch = image[i - 1]->getHeight();
+			for(int z = 0; z < depth; ++z)
+			{
+				sw::SliceRectF srcRect(0.0f, 0.0f, static_cast<float>(srcw), static_cast<float>(srch), z);
+				sw::SliceRect dstRect(0, 0, w, h, z);
+				getDevice()->stretchRect(image[i - 1], &srcRect, image[i], &dstRect, Device::ALL_BUFFERS | Device::USE_FILTER);
+			}
 		}
 	}
 }
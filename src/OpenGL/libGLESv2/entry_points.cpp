@@ -30,6 +30,11 @@ GL_APICALL void GL_APIENTRY glAttachShader(GLuint program, GLuint shader)
 	return gl::AttachShader(program, shader);
 }
 
+GL_APICALL void GL_APIENTRY glBeginConditionalRenderNV(GLuint id, GLenum mode)
+{
+	return gl::BeginConditionalRenderNV(id, mode);
+}
+
 GL_APICALL void GL_APIENTRY glBeginQueryEXT(GLenum target, GLuint name)
 {
 	return gl::BeginQueryEXT(target, name);
@@ -312,6 +317,11 @@ GL_APICALL void GL_APIENTRY glEnableVertexAttribArray(GLuint index)
 	return gl::EnableVertexAttribArray(index);
 }
 
+GL_APICALL void GL_APIENTRY glEndConditionalRenderNV(void)
+{
+	return gl::EndConditionalRenderNV();
+}
+
 GL_APICALL void GL_APIENTRY glEndQueryEXT(GLenum target)
 {
 	return gl::EndQueryEXT(target);
@@ -1544,6 +1554,7 @@ LibGLESv2exports::LibGLESv2exports()
 {
 	this->glActiveTexture = gl::ActiveTexture;
 	this->glAttachShader = gl::AttachShader;
+	this->glBeginConditionalRenderNV = gl::BeginConditionalRenderNV;
 	this->glBeginQueryEXT = gl::BeginQueryEXT;
 	this->glBindAttribLocation = gl::BindAttribLocation;
 	this->glBindBuffer = gl::BindBuffer;
@@ -1595,6 +1606,7 @@ LibGLESv2exports::LibGLESv2exports()
 	this->glVertexAttribDivisorANGLE = gl::VertexAttribDivisorANGLE;
 	this->glEnable = gl::Enable;
 	this->glEnableVertexAttribArray = gl::EnableVertexAttribArray;
+	this->glEndConditionalRenderNV = gl::EndConditionalRenderNV;
 	this->glEndQueryEXT = gl::EndQueryEXT;
 	this->glFinishFenceNV = gl::FinishFenceNV;
 	this->glFinish = gl::Finish;
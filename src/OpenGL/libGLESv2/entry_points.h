@@ -23,6 +23,7 @@ namespace gl
 {
 	void ActiveTexture(GLenum texture);
 	void AttachShader(GLuint program, GLuint shader);
+	void BeginConditionalRenderNV(GLuint id, GLenum mode);
 	void BeginQueryEXT(GLenum target, GLuint name);
 	void BindAttribLocation(GLuint program, GLuint index, const GLchar* name);
 	void BindBuffer(GLenum target, GLuint buffer);
@@ -76,6 +77,7 @@ namespace gl
 	void VertexAttribDivisorANGLE(GLuint index, GLuint divisor);
 	void Enable(GLenum cap);
 	void EnableVertexAttribArray(GLuint index);
+	void EndConditionalRenderNV(void);
 	void EndQueryEXT(GLenum target);
 	void FinishFenceNV(GLuint fence);
 	void Finish(void);
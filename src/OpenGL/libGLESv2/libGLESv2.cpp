@@ -116,6 +116,18 @@ void AttachShader(GLuint program, GLuint shader)
 	}
 }
 
+void BeginConditionalRenderNV(GLuint id, GLenum mode)
+{
+	TRACE("(GLuint id = %d, GLenum mode = 0x%X)", id, mode);
+
+	auto context = es2::getContext();
+
+	if(context)
+	{
+		context->beginConditionalRender(id, mode);
+	}
+}
+
 void BeginQueryEXT(GLenum target, GLuint name)
 {
 	TRACE("(GLenum target = 0x%X, GLuint name = %d)", target, name);
@@ -1805,6 +1817,18 @@ void EnableVertexAttribArray(GLuint index)
 	}
 }
 
+void EndConditionalRenderNV(void)
+{
+	TRACE("()");
+
+	auto context = es2::getContext();
+
+	if(context)
+	{
+		context->endConditionalRender();
+	}
+}
+
 void EndQueryEXT(GLenum target)
 {
 	TRACE("GLenum target = 0x%X)", target);
@@ -6315,6 +6339,7 @@ extern "C" NO_SANITIZE_FUNCTION __eglMustCastToProperFunctionPointerType es2GetP
 
 		FUNCTION(ActiveTexture),
 		FUNCTION(AttachShader),
+		FUNCTION(BeginConditionalRenderNV),
 		FUNCTION(BeginQuery),
 		FUNCTION(BeginQueryEXT),
 		FUNCTION(BeginTransformFeedback),
@@ -6397,6 +6422,7 @@ extern "C" NO_SANITIZE_FUNCTION __eglMustCastToProperFunctionPointerType es2GetP
 		FUNCTION(EGLImageTargetTexture2DOES),
 		FUNCTION(Enable),
 		FUNCTION(EnableVertexAttribArray),
+		FUNCTION(EndConditionalRenderNV),
 		FUNCTION(EndQuery),
 		FUNCTION(EndQueryEXT),
 		FUNCTION(EndTransformFeedback),
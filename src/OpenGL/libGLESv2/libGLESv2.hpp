@@ -43,6 +43,7 @@ public:
 
 	void (*glActiveTexture)(GLenum texture);
 	void (*glAttachShader)(GLuint program, GLuint shader);
+	void (*glBeginConditionalRenderNV)(GLuint id, GLenum mode);
 	void (*glBeginQueryEXT)(GLenum target, GLuint name);
 	void (*glBindAttribLocation)(GLuint program, GLuint index, const GLchar* name);
 	void (*glBindBuffer)(GLenum target, GLuint buffer);
@@ -96,6 +97,7 @@ public:
 	void (*glVertexAttribDivisorANGLE)(GLuint index, GLuint divisor);
 	void (*glEnable)(GLenum cap);
 	void (*glEnableVertexAttribArray)(GLuint index);
+	void (*glEndConditionalRenderNV)(void);
 	void (*glEndQueryEXT)(GLenum target);
 	void (*glFinishFenceNV)(GLuint fence);
 	void (*glFinish)(void);
@@ -59,7 +59,7 @@ namespace sw
 	{
 	}
 
-	void VertexProgram::program(UInt &index)
+	void VertexProgram::program(Int4 &indices)
 	{
 		//	shader->print("VertexShader-%0.8X.txt", state.shaderID);
 
@@ -75,17 +75,7 @@ namespace sw
 
 		if(shader->isVertexIdDeclared())
 		{
-			if(state.textureSampling)
-			{
-				vertexID = Int4(index);
-			}
-			else
-			{
-				vertexID = Insert(vertexID, As<Int>(index), 0);
-				vertexID = Insert(vertexID, As<Int>(index + 1), 1);
-				vertexID = Insert(vertexID, As<Int>(index + 2), 2);
-				vertexID = Insert(vertexID, As<Int>(index + 3), 3);
-			}
+			vertexID = indices;
 		}
 
 		// Create all call site return blocks up front
@@ -63,7 +63,7 @@ namespace sw
 		typedef Shader::Control Control;
 		typedef Shader::Usage Usage;
 
-		void program(UInt &index) override;
+		void program(Int4 &indices) override;
 
 		Vector4f fetchRegister(const Src &src, unsigned int offset = 0);
 		Vector4f readConstant(const Src &src, unsigned int offset = 0);
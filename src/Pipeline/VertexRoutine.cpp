@@ -51,58 +51,128 @@ namespace sw
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
 
-		Do
+		if(!state.gatherVertices)
 		{
-			UInt index = *Pointer<UInt>(batch);
-			UInt tagIndex = index & 0x0000003C;
-			UInt indexQ = !textureSampling ? UInt(index & 0xFFFFFFFC) : index;   // FIXME: TEXLDL hack to have independent LODs, hurts performance.
-
-			If(*Pointer<UInt>(tagCache + tagIndex) != indexQ)
+			Do
 			{
-				*Pointer<UInt>(tagCache + tagIndex) = indexQ;
+				UInt index = *Pointer<UInt>(batch);
+				UInt tagIndex = index & 0x0000003C;
+				UInt indexQ = !textureSampling ? UInt(index & 0xFFFFFFFC) : index;   // FIXME: TEXLDL hack to have independent LODs, hurts performance.
+
+				If(*Pointer<UInt>(tagCache + tagIndex) != indexQ)
+				{
+					*Pointer<UInt>(tagCache + tagIndex) = indexQ;
 
-				readInput(indexQ);
-				program(indexQ);
-				postTransform();
-				computeClipFlags();
+					Int4 indices = Int4(As<Int>(indexQ)) + (!textureSampling ? Int4(0, 1, 2, 3) : Int4(0));
+					shade(indices, vertexCache, Int4(As<Int>(tagIndex)) + Int4(0, 1, 2, 3));
+				}
 
-				Pointer<Byte> cacheLine0 = vertexCache + tagIndex * UInt((int)sizeof(Vertex));
-				writeCache(cacheLine0);
+				UInt cacheIndex = index & 0x0000003F;
+				Pointer<Byte> cacheLine = vertexCache + cacheIndex * UInt((int)sizeof(Vertex));
+				outputVertex(cacheLine, primitiveNumber, indexInPrimitive);
+
+				batch += sizeof(unsigned int);
+				vertexCount--;
 			}
+			Until(vertexCount == 0)
+		}
+		else
+		{
+			// Shade up to four cache misses at a time, whatever their indices. A group ends early when a miss
+			// would evict a cache line still needed by an earlier vertex of the group, which is output first.
+			Array<Int> pending(4);
+			Array<UInt> group(64);   // Last group which referenced each cache line
 
-			UInt cacheIndex = index & 0x0000003F;
-			Pointer<Byte> cacheLine = vertexCache + cacheIndex * UInt((int)sizeof(Vertex));
-			writeVertex(vertex, cacheLine);
+			For(UInt line = 0, line < 64, line++)
+			{
+				group[line] = 0xFFFFFFFF;
+			}
+
+			UInt first = 0;
+			UInt current = 0;
 
-			if(state.transformFeedbackEnabled != 0)
+			Do
 			{
-				transformFeedback(vertex, primitiveNumber, indexInPrimitive);
+				UInt next = first;
+				Int lanes = 0;
+				Bool flush = false;
 
-				indexInPrimitive++;
-				If(indexInPrimitive == 3)
+				While(next < vertexCount && !flush)
 				{
-					primitiveNumber++;
-					indexInPrimitive = 0;
+					UInt index = *Pointer<UInt>(batch + next * UInt((int)sizeof(unsigned int)));
+					UInt line = index & 0x0000003F;
+					Pointer<UInt> tag = Pointer<UInt>(tagCache + line * UInt((int)sizeof(unsigned int)));
+
+					If(*tag != index)
+					{
+						If(lanes == 4 || UInt(group[line]) == current)
+						{
+							flush = Bool(true);
+						}
+						Else
+						{
+							*tag = index;
+							pending[lanes] = As<Int>(index);
+							lanes++;
+						}
+					}
+
+					If(!flush)
+					{
+						group[line] = current;
+						next++;
+					}
 				}
-			}
 
-			vertex += sizeof(Vertex);
-			batch += sizeof(unsigned int);
-			vertexCount--;
+				If(lanes != 0)
+				{
+					For(Int lane = lanes, lane < 4, lane++)
+					{
+						pending[lane] = pending[0];   // Shading a duplicate is harmless, and cheaper than a partial group
+					}
+
+					Int4 indices;
+					indices = Insert(indices, pending[0], 0);
+					indices = Insert(indices, pending[1], 1);
+					indices = Insert(indices, pending[2], 2);
+					indices = Insert(indices, pending[3], 3);
+
+					shade(indices, vertexCache, indices & Int4(0x0000003F));
+				}
+
+				For(UInt i = first, i < next, i++)
+				{
+					UInt index = *Pointer<UInt>(batch + i * UInt((int)sizeof(unsigned int)));
+					Pointer<Byte> cacheLine = vertexCache + (index & 0x0000003F) * UInt((int)sizeof(Vertex));
+					outputVertex(cacheLine, primitiveNumber, indexInPrimitive);
+				}
+
+				first = next;
+				current++;
+			}
+			Until(first == vertexCount)
 		}
-		Until(vertexCount == 0)
 
 		Return();
 	}
 
-	void VertexRoutine::readInput(UInt &index)
+	void VertexRoutine::shade(Int4 &indices, Pointer<Byte> &vertexCache, const Int4 &cacheIndices)
+	{
+		readInput(indices);
+		program(indices);
+		postTransform();
+		computeClipFlags();
+		writeCache(vertexCache, cacheIndices);
+	}
+
+	void VertexRoutine::readInput(const Int4 &indices)
 	{
 		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
 		{
 			Pointer<Byte> input = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,input) + sizeof(void*) * i);
 			UInt stride = *Pointer<UInt>(data + OFFSET(DrawData,stride) + sizeof(unsigned int) * i);
 
-			v[i] = readStream(input, stride, state.input[i], index);
+			v[i] = readStream(input, stride, state.input[i], indices);
 		}
 	}
 
@@ -132,16 +202,14 @@ namespace sw
 		clipFlags |= *Pointer<Int>(constants + OFFSET(Constants,fini) + SignMask(finiteXYZ) * 4);
 	}
 
-	Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const UInt &index)
+	Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const Int4 &indices)
 	{
-		const bool textureSampling = state.textureSampling;
-
 		Vector4f v;
 
-		Pointer<Byte> source0 = buffer + index * stride;
-		Pointer<Byte> source1 = source0 + (!textureSampling ? stride : 0);
-		Pointer<Byte> source2 = source1 + (!textureSampling ? stride : 0);
-		Pointer<Byte> source3 = source2 + (!textureSampling ? stride : 0);
+		Pointer<Byte> source0 = buffer + As<UInt>(Extract(indices, 0)) * stride;
+		Pointer<Byte> source1 = buffer + As<UInt>(Extract(indices, 1)) * stride;
+		Pointer<Byte> source2 = buffer + As<UInt>(Extract(indices, 2)) * stride;
+		Pointer<Byte> source3 = buffer + As<UInt>(Extract(indices, 3)) * stride;
 
 		bool isNativeFloatAttrib = (stream.attribType == VertexShader::ATTRIBTYPE_FLOAT) || stream.normalized;
 
@@ -614,8 +682,15 @@ namespace sw
 		}
 	}
 
-	void VertexRoutine::writeCache(Pointer<Byte> &cacheLine)
+	void VertexRoutine::writeCache(Pointer<Byte> &vertexCache, const Int4 &cacheIndices)
 	{
+		Pointer<Byte> cacheLine[4];
+
+		for(int i = 0; i < 4; i++)
+		{
+			cacheLine[i] = vertexCache + As<UInt>(Extract(cacheIndices, i)) * UInt((int)sizeof(Vertex));
+		}
+
 		Vector4f v;
 
 		for(int i = 0; i < MAX_VERTEX_OUTPUTS; i++)
@@ -653,10 +728,10 @@ namespace sw
 
 				if(state.output[i].write == 0x01)
 				{
-					*Pointer<Float>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 0) = v.x.x;
-					*Pointer<Float>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 1) = v.x.y;
-					*Pointer<Float>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 2) = v.x.z;
-					*Pointer<Float>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 3) = v.x.w;
+					*Pointer<Float>(cacheLine[0] + OFFSET(Vertex,v[i])) = v.x.x;
+					*Pointer<Float>(cacheLine[1] + OFFSET(Vertex,v[i])) = v.x.y;
+					*Pointer<Float>(cacheLine[2] + OFFSET(Vertex,v[i])) = v.x.z;
+					*Pointer<Float>(cacheLine[3] + OFFSET(Vertex,v[i])) = v.x.w;
 				}
 				else
 				{
@@ -669,18 +744,18 @@ namespace sw
 						transpose4x4(v.x, v.y, v.z, v.w);
 					}
 
-					*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 0, 16) = v.x;
-					*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 1, 16) = v.y;
-					*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 2, 16) = v.z;
-					*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 3, 16) = v.w;
+					*Pointer<Float4>(cacheLine[0] + OFFSET(Vertex,v[i]), 16) = v.x;
+					*Pointer<Float4>(cacheLine[1] + OFFSET(Vertex,v[i]), 16) = v.y;
+					*Pointer<Float4>(cacheLine[2] + OFFSET(Vertex,v[i]), 16) = v.z;
+					*Pointer<Float4>(cacheLine[3] + OFFSET(Vertex,v[i]), 16) = v.w;
 				}
 			}
 		}
 
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 0) = (clipFlags >> 0)  & 0x0000000FF;
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 1) = (clipFlags >> 8)  & 0x0000000FF;
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 2) = (clipFlags >> 16) & 0x0000000FF;
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 3) = (clipFlags >> 24) & 0x0000000FF;
+		*Pointer<Int>(cacheLine[0] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 0)  & 0x0000000FF;
+		*Pointer<Int>(cacheLine[1] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 8)  & 0x0000000FF;
+		*Pointer<Int>(cacheLine[2] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 16) & 0x0000000FF;
+		*Pointer<Int>(cacheLine[3] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 24) & 0x0000000FF;
 
 		// Viewport transform
 		int pos = state.positionRegister;
@@ -705,10 +780,10 @@ namespace sw
 
 		transpose4x4(v.x, v.y, v.z, v.w);
 
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,X) + sizeof(Vertex) * 0, 16) = v.x;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,X) + sizeof(Vertex) * 1, 16) = v.y;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,X) + sizeof(Vertex) * 2, 16) = v.z;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,X) + sizeof(Vertex) * 3, 16) = v.w;
+		*Pointer<Float4>(cacheLine[0] + OFFSET(Vertex,X), 16) = v.x;
+		*Pointer<Float4>(cacheLine[1] + OFFSET(Vertex,X), 16) = v.y;
+		*Pointer<Float4>(cacheLine[2] + OFFSET(Vertex,X), 16) = v.z;
+		*Pointer<Float4>(cacheLine[3] + OFFSET(Vertex,X), 16) = v.w;
 	}
 
 	void VertexRoutine::writeVertex(const Pointer<Byte> &vertex, Pointer<Byte> &cache)
@@ -725,6 +800,25 @@ namespace sw
 		*Pointer<Int>(vertex + OFFSET(Vertex,clipFlags)) = *Pointer<Int>(cache + OFFSET(Vertex,clipFlags));
 	}
 
+	void VertexRoutine::outputVertex(Pointer<Byte> &cacheLine, UInt &primitiveNumber, UInt &indexInPrimitive)
+	{
+		writeVertex(vertex, cacheLine);
+
+		if(state.transformFeedbackEnabled != 0)
+		{
+			transformFeedback(vertex, primitiveNumber, indexInPrimitive);
+
+			indexInPrimitive++;
+			If(indexInPrimitive == 3)
+			{
+				primitiveNumber++;
+				indexInPrimitive = 0;
+			}
+		}
+
+		vertex += sizeof(Vertex);
+	}
+
 	void VertexRoutine::transformFeedback(const Pointer<Byte> &vertex, const UInt &primitiveNumber, const UInt &indexInPrimitive)
 	{
 		If(indexInPrimitive < state.verticesPerPrimitive)
@@ -63,6 +63,7 @@
 	#include "llvm/IR/LegacyPassManager.h"
 	#include "llvm/IR/Mangler.h"
 	#include "llvm/IR/Module.h"
+	#include "llvm/Object/SymbolSize.h"
 	#include "llvm/Support/Error.h"
 	#include "llvm/Support/TargetSelect.h"
 	#include "llvm/Target/TargetOptions.h"
@@ -570,6 +571,7 @@ namespace rr
 		ObjLayer objLayer;
 		CompileLayer compileLayer;
 		size_t emittedFunctionsNum;
+		size_t loadedCodeSize;
 
 	public:
 		LLVMReactorJIT(const char *arch, const llvm::SmallVectorImpl<std::string>& mattrs,
@@ -605,9 +607,26 @@ namespace rr
 					return ObjLayer::Resources{
 						std::make_shared<llvm::SectionMemoryManager>(),
 						resolver};
+				},
+				[this](llvm::orc::VModuleKey, const llvm::object::ObjectFile &object, const llvm::RuntimeDyld::LoadedObjectInfo &) {
+					// Each module holds a single function, which is compiled when its address is looked up
+					for(const auto &symbolSize : llvm::object::computeSymbolSizes(object))
+					{
+						llvm::Expected<llvm::object::SymbolRef::Type> type = symbolSize.first.getType();
+
+						if(!type)
+						{
+							llvm::consumeError(type.takeError());
+						}
+						else if(*type == llvm::object::SymbolRef::ST_Function)
+						{
+							loadedCodeSize = symbolSize.second;
+						}
+					}
 				}),
 			compileLayer(objLayer, llvm::orc::SimpleCompiler(*targetMachine)),
-			emittedFunctionsNum(0)
+			emittedFunctionsNum(0),
+			loadedCodeSize(0)
 		{
 		}
 
@@ -642,6 +661,7 @@ namespace rr
 				llvm::Mangler::getNameWithPrefix(mangledNameStream, name, dataLayout);
 			}
 
+			loadedCodeSize = 0;
 			llvm::JITSymbol symbol = compileLayer.findSymbolIn(moduleKey, mangledName, false);
 
 			llvm::Expected<llvm::JITTargetAddress> expectAddr = symbol.getAddress();
@@ -651,7 +671,7 @@ namespace rr
 			}
 
 			void *addr = reinterpret_cast<void *>(static_cast<intptr_t>(expectAddr.get()));
-			return new LLVMRoutine(addr, releaseRoutineCallback, this, moduleKey);
+			return new LLVMRoutine(addr, loadedCodeSize, releaseRoutineCallback, this, moduleKey);
 		}
 
 		void optimize(llvm::Module *module)
@@ -961,6 +981,11 @@ namespace rr
 		}
 #endif
 
+		if(perfMap && routine)
+		{
+			addToPerfMap(routine->getEntry(), routine->getCodeSize(), name);
+		}
+
 		return routine;
 	}
 
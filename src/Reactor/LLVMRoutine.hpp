@@ -17,6 +17,7 @@
 
 #include "Routine.hpp"
 
+#include <cstddef>
 #include <cstdint>
 
 namespace rr
@@ -57,9 +58,9 @@ namespace rr
 	class LLVMRoutine : public Routine
 	{
 	public:
-		LLVMRoutine(void *ent, void (*callback)(LLVMReactorJIT *, uint64_t),
+		LLVMRoutine(void *ent, size_t size, void (*callback)(LLVMReactorJIT *, uint64_t),
 		            LLVMReactorJIT *jit, uint64_t key)
-			: entry(ent), dtor(callback), reactorJIT(jit), moduleKey(key)
+			: entry(ent), codeSize(size), dtor(callback), reactorJIT(jit), moduleKey(key)
 		{ }
 
 		virtual ~LLVMRoutine();
@@ -69,8 +70,14 @@ namespace rr
 			return entry;
 		}
 
+		size_t getCodeSize()
+		{
+			return codeSize;
+		}
+
 	private:
 		const void *entry;
+		size_t codeSize;
 
 		void (*dtor)(LLVMReactorJIT *, uint64_t);
 		LLVMReactorJIT *reactorJIT;
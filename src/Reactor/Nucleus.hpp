@@ -15,6 +15,7 @@
 #ifndef rr_Nucleus_hpp
 #define rr_Nucleus_hpp
 
+#include <atomic>
 #include <cassert>
 #include <cstdarg>
 #include <cstdint>
@@ -45,6 +46,7 @@ namespace rr
 	};
 
 	extern Optimization optimization[10];
+	extern std::atomic<bool> perfMap;   // Name the routines generated from now on in /tmp/perf-<pid>.map, for Linux perf
 
 	class Nucleus
 	{
@@ -14,9 +14,16 @@
 
 #include "Routine.hpp"
 
+#include "Nucleus.hpp"
 #include "Thread.hpp"
 
 #include <cassert>
+#include <cstdio>
+#include <mutex>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
 
 namespace rr
 {
@@ -44,4 +51,40 @@ namespace rr
 	{
 		assert(bindCount == 0);
 	}
+
+	std::atomic<bool> perfMap(false);   // Set by every renderer's configuration update, while other threads generate routines
+
+	void addToPerfMap(const void *entry, size_t codeSize, const wchar_t *name)
+	{
+		#if !defined(_WIN32)
+			static std::mutex mutex;
+			static FILE *file = nullptr;
+
+			if(!perfMap || !entry)
+			{
+				return;
+			}
+
+			// Routines are generated on several threads, which must not interleave their lines
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if(!file)
+			{
+				char filename[64];
+				snprintf(filename, sizeof(filename), "/tmp/perf-%d.map", (int)getpid());
+				file = fopen(filename, "a");
+
+				if(!file)
+				{
+					perfMap = false;
+					return;
+				}
+			}
+
+			// One "<start> <size> <name>" line per routine, in hexadecimal without prefix. The
+			// format can't express the release of a routine, so its entry stays.
+			fprintf(file, "%zx %zx %ls\n", (size_t)entry, codeSize, name);
+			fflush(file);
+		#endif
+	}
 }
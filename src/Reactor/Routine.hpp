@@ -15,6 +15,8 @@
 #ifndef rr_Routine_hpp
 #define rr_Routine_hpp
 
+#include <cstddef>
+
 namespace rr
 {
 	class Routine
@@ -33,6 +35,9 @@ namespace rr
 	private:
 		volatile int bindCount;
 	};
+
+	// Appends a line to the perf map, if enabled
+	void addToPerfMap(const void *entry, size_t codeSize, const wchar_t *name);
 }
 
 #endif   // rr_Routine_hpp
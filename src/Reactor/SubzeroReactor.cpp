@@ -48,6 +48,14 @@
 #endif
 #endif
 
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
 #include <mutex>
 #include <limits>
 #include <iostream>
@@ -448,7 +456,7 @@ namespace rr
 		ELFMemoryStreamer &operator=(const ELFMemoryStreamer &) = delete;
 
 	public:
-		ELFMemoryStreamer() : Routine(), entry(nullptr)
+		ELFMemoryStreamer() : Routine(), entry(nullptr), codeSize(0)
 		{
 			position = 0;
 			buffer.reserve(0x1000);
@@ -498,7 +506,6 @@ namespace rr
 			{
 				position = std::numeric_limits<std::size_t>::max();   // Can't stream more data after this
 
-				size_t codeSize = 0;
 				entry = loadImage(&buffer[0], codeSize);
 
 				#if defined(_WIN32)
@@ -513,8 +520,16 @@ namespace rr
 			return entry;
 		}
 
+		size_t getCodeSize()
+		{
+			getEntry();
+
+			return codeSize;
+		}
+
 	private:
 		void *entry;
+		size_t codeSize;
 		std::vector<uint8_t, ExecutableAllocator<uint8_t>> buffer;
 		std::size_t position;
 
@@ -616,6 +631,12 @@ namespace rr
 		Routine *handoffRoutine = ::routine;
 		::routine = nullptr;
 
+		if(perfMap && handoffRoutine)
+		{
+			ELFMemoryStreamer *elfMemory = static_cast<ELFMemoryStreamer*>(handoffRoutine);
+			addToPerfMap(elfMemory->getEntry(), elfMemory->getCodeSize(), name);
+		}
+
 		return handoffRoutine;
 	}
 
@@ -7188,8 +7209,24 @@ namespace rr
 		Nucleus::setInsertBlock(bodyBB);
 	}
 
+	static int64_t readCycleCounter()
+	{
+		#if defined(__i386__) || defined(__x86_64__)
+			return __rdtsc();
+		#else
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		#endif
+	}
+
 	RValue<Long> Ticks()
 	{
-		assert(false && "UNIMPLEMENTED"); return RValue<Long>(V(nullptr));
+		// Subzero has no cycle counter intrinsic, so call out to a function which reads it
+		Ice::Operand *target = (sizeof(void*) == 8) ? ::context->getConstantInt64(reinterpret_cast<intptr_t>(readCycleCounter))
+		                                            : ::context->getConstantInt32(reinterpret_cast<intptr_t>(readCycleCounter));
+		Ice::Variable *result = ::function->makeVariable(Ice::IceType_i64);
+		auto call = Ice::InstCall::create(::function, 0, result, target, false);
+		::basicBlock->appendInst(call);
+
+		return RValue<Long>(V(result));
 	}
 }
@@ -0,0 +1,988 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ASTC_Decoder.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+namespace
+{
+	const int MAX_BLOCK_TEXELS = 12 * 12;
+	const int MAX_WEIGHTS = 64;            // Including both planes of dual plane blocks
+	const int MAX_COLOR_VALUES = 18;
+	const int MIN_WEIGHT_BITS = 24;
+	const int MAX_WEIGHT_BITS = 96;
+
+	// Integer sequence encoding ranges, in order of increasing number of levels
+	struct Range
+	{
+		int levels;
+		bool trit;
+		bool quint;
+		int bits;
+	};
+
+	const Range ranges[] =
+	{
+		{2,   false, false, 1},
+		{3,   true,  false, 0},
+		{4,   false, false, 2},
+		{5,   false, true,  0},
+		{6,   true,  false, 1},
+		{8,   false, false, 3},
+		{10,  false, true,  1},
+		{12,  true,  false, 2},
+		{16,  false, false, 4},
+		{20,  false, true,  2},
+		{24,  true,  false, 3},
+		{32,  false, false, 5},
+		{40,  false, true,  3},
+		{48,  true,  false, 4},
+		{64,  false, false, 6},
+		{80,  false, true,  4},
+		{96,  true,  false, 5},
+		{128, false, false, 7},
+		{160, false, true,  5},
+		{192, true,  false, 6},
+		{256, false, false, 8},
+	};
+
+	const int RANGE_6 = 4;     // Fewest levels allowed for color endpoints
+	const int RANGE_256 = 20;
+
+	inline int clampByte(int value)
+	{
+		return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+	}
+
+	inline uint64_t reverseBits(uint64_t x)
+	{
+		x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+		x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+		x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+		x = ((x >> 8) & 0x00FF00FF00FF00FFull) | ((x & 0x00FF00FF00FF00FFull) << 8);
+		x = ((x >> 16) & 0x0000FFFF0000FFFFull) | ((x & 0x0000FFFF0000FFFFull) << 16);
+		return (x >> 32) | (x << 32);
+	}
+
+	// Replicates the most significant bits of 'value' to fill 'targetBits' bits
+	inline int replicate(int value, int bits, int targetBits)
+	{
+		if(bits == 0)
+		{
+			return 0;
+		}
+
+		int result = 0;
+		int filled = 0;
+
+		while(filled < targetBits)
+		{
+			result = (result << bits) | value;
+			filled += bits;
+		}
+
+		return result >> (filled - targetBits);
+	}
+
+	// 128-bit block, addressed from the least significant bit
+	struct Block
+	{
+		Block(const unsigned char *source)
+		{
+			memcpy(data, source, sizeof(data));
+		}
+
+		Block(uint64_t low, uint64_t high)
+		{
+			data[0] = low;
+			data[1] = high;
+		}
+
+		// Reads up to 32 bits starting at 'start'. Bits past 'end' read as zero.
+		unsigned int bits(int start, int count, int end = 128) const
+		{
+			if(start + count > end)
+			{
+				count = end - start;
+			}
+
+			if(count <= 0)
+			{
+				return 0;
+			}
+
+			uint64_t value = (start >= 64) ? (data[1] >> (start - 64)) :
+			                 (start == 0) ? data[0] : ((data[0] >> start) | (data[1] << (64 - start)));
+
+			return static_cast<unsigned int>(value & ((1ull << count) - 1));
+		}
+
+		Block reversed() const
+		{
+			return Block(reverseBits(data[1]), reverseBits(data[0]));
+		}
+
+		uint64_t data[2];
+	};
+
+	int iseBitCount(int count, int range)
+	{
+		const Range &r = ranges[range];
+
+		return count * r.bits + (r.trit ? (8 * count + 4) / 5 : 0) + (r.quint ? (7 * count + 2) / 3 : 0);
+	}
+
+	void decodeTrits(int T, int t[5])
+	{
+		int C;
+
+		if(((T >> 2) & 7) == 7)
+		{
+			C = (((T >> 5) & 7) << 2) | (T & 3);
+			t[4] = 2;
+			t[3] = 2;
+		}
+		else
+		{
+			C = T & 0x1F;
+
+			if(((T >> 5) & 3) == 3)
+			{
+				t[4] = 2;
+				t[3] = (T >> 7) & 1;
+			}
+			else
+			{
+				t[4] = (T >> 7) & 1;
+				t[3] = (T >> 5) & 3;
+			}
+		}
+
+		if((C & 3) == 3)
+		{
+			t[2] = 2;
+			t[1] = (C >> 4) & 1;
+			t[0] = (((C >> 3) & 1) << 1) | (((C >> 2) & 1) & ~(C >> 3) & 1);
+		}
+		else if(((C >> 2) & 3) == 3)
+		{
+			t[2] = 2;
+			t[1] = 2;
+			t[0] = C & 3;
+		}
+		else
+		{
+			t[2] = (C >> 4) & 1;
+			t[1] = (C >> 2) & 3;
+			t[0] = (((C >> 1) & 1) << 1) | ((C & 1) & ~(C >> 1) & 1);
+		}
+	}
+
+	void decodeQuints(int Q, int q[3])
+	{
+		if(((Q >> 1) & 3) == 3 && ((Q >> 5) & 3) == 0)
+		{
+			int q0 = Q & 1;
+			int q3 = (Q >> 3) & 1;
+			int q4 = (Q >> 4) & 1;
+
+			q[2] = (q0 << 2) | ((q4 & ~q0 & 1) << 1) | (q3 & ~q0 & 1);
+			q[1] = 4;
+			q[0] = 4;
+		}
+		else
+		{
+			int C;
+
+			if(((Q >> 1) & 3) == 3)
+			{
+				q[2] = 4;
+				C = (((Q >> 3) & 3) << 3) | ((~(Q >> 5) & 3) << 1) | (Q & 1);
+			}
+			else
+			{
+				q[2] = (Q >> 5) & 3;
+				C = Q & 0x1F;
+			}
+
+			if((C & 7) == 5)
+			{
+				q[1] = 4;
+				q[0] = (C >> 3) & 3;
+			}
+			else
+			{
+				q[1] = (C >> 3) & 3;
+				q[0] = C & 7;
+			}
+		}
+	}
+
+	// Decodes 'count' integers of the given range. Each value holds its trit or quint above its bits.
+	void decodeISE(const Block &block, int start, int count, int range, int *values)
+	{
+		const Range &r = ranges[range];
+		int end = start + iseBitCount(count, range);
+		int position = start;
+		int mask = (1 << r.bits) - 1;
+
+		if(r.trit)
+		{
+			for(int i = 0; i < count; i += 5)
+			{
+				static const int tritBits[5] = {2, 2, 1, 2, 1};
+				int m[5];
+				int T = 0;
+				int shift = 0;
+
+				for(int j = 0; j < 5; j++)
+				{
+					m[j] = block.bits(position, r.bits, end);
+					position += r.bits;
+					T |= block.bits(position, tritBits[j], end) << shift;
+					position += tritBits[j];
+					shift += tritBits[j];
+				}
+
+				int t[5];
+				decodeTrits(T, t);
+
+				for(int j = 0; j < 5 && (i + j) < count; j++)
+				{
+					values[i + j] = (t[j] << r.bits) | (m[j] & mask);
+				}
+			}
+		}
+		else if(r.quint)
+		{
+			for(int i = 0; i < count; i += 3)
+			{
+				static const int quintBits[3] = {3, 2, 2};
+				int m[3];
+				int Q = 0;
+				int shift = 0;
+
+				for(int j = 0; j < 3; j++)
+				{
+					m[j] = block.bits(position, r.bits, end);
+					position += r.bits;
+					Q |= block.bits(position, quintBits[j], end) << shift;
+					position += quintBits[j];
+					shift += quintBits[j];
+				}
+
+				int q[3];
+				decodeQuints(Q, q);
+
+				for(int j = 0; j < 3 && (i + j) < count; j++)
+				{
+					values[i + j] = (q[j] << r.bits) | (m[j] & mask);
+				}
+			}
+		}
+		else
+		{
+			for(int i = 0; i < count; i++)
+			{
+				values[i] = block.bits(position, r.bits, end);
+				position += r.bits;
+			}
+		}
+	}
+
+	// Unquantizes a color endpoint value to the [0, 255] range
+	int unquantizeColor(int value, int range)
+	{
+		const Range &r = ranges[range];
+		int m = value & ((1 << r.bits) - 1);
+
+		if(!r.trit && !r.quint)
+		{
+			return replicate(m, r.bits, 8);
+		}
+
+		int D = value >> r.bits;
+		int A = (m & 1) ? 0x1FF : 0;
+		int b = (m >> 1) & 1;
+		int c = (m >> 2) & 1;
+		int d = (m >> 3) & 1;
+		int e = (m >> 4) & 1;
+		int f = (m >> 5) & 1;
+		int B = 0;
+		int C = 0;
+
+		switch(r.levels)
+		{
+		case 6:   C = 204;                                                                       break;
+		case 10:  C = 113;                                                                       break;
+		case 12:  C = 93;  B = b * 0x116;                                                        break;
+		case 20:  C = 54;  B = b * 0x10C;                                                        break;
+		case 24:  C = 44;  B = c * 0x10A + b * 0x085;                                            break;
+		case 40:  C = 26;  B = c * 0x105 + b * 0x082;                                            break;
+		case 48:  C = 22;  B = d * 0x104 + c * 0x082 + b * 0x041;                                break;
+		case 80:  C = 13;  B = d * 0x102 + c * 0x081 + b * 0x040;                                break;
+		case 96:  C = 11;  B = e * 0x102 + d * 0x081 + c * 0x040 + b * 0x020;                    break;
+		case 160: C = 6;   B = e * 0x101 + d * 0x080 + c * 0x040 + b * 0x020;                    break;
+		case 192: C = 5;   B = f * 0x101 + e * 0x080 + d * 0x040 + c * 0x020 + b * 0x010;        break;
+		default:
+			return 0;   // Ranges with fewer than 6 levels are invalid for colors
+		}
+
+		int T = (D * C + B) ^ A;
+
+		return (A & 0x80) | (T >> 2);
+	}
+
+	// Unquantizes a weight to the [0, 64] range
+	int unquantizeWeight(int value, int range)
+	{
+		const Range &r = ranges[range];
+		int m = value & ((1 << r.bits) - 1);
+		int result;
+
+		if(!r.trit && !r.quint)
+		{
+			result = replicate(m, r.bits, 6);
+		}
+		else if(r.bits == 0)
+		{
+			static const int trits[3] = {0, 32, 63};
+			static const int quints[5] = {0, 16, 32, 47, 63};
+
+			result = r.trit ? trits[value] : quints[value];
+		}
+		else
+		{
+			int D = value >> r.bits;
+			int A = (m & 1) ? 0x7F : 0;
+			int b = (m >> 1) & 1;
+			int c = (m >> 2) & 1;
+			int B = 0;
+			int C = 0;
+
+			switch(r.levels)
+			{
+			case 6:  C = 50;                               break;
+			case 10: C = 28;                               break;
+			case 12: C = 23; B = b * 0x45;                 break;
+			case 20: C = 13; B = b * 0x42;                 break;
+			case 24: C = 11; B = c * 0x42 + b * 0x21;      break;
+			default:
+				return 0;
+			}
+
+			int T = (D * C + B) ^ A;
+
+			result = (A & 0x20) | (T >> 2);
+		}
+
+		return (result > 32) ? result + 1 : result;
+	}
+
+	uint32_t hash52(uint32_t p)
+	{
+		p ^= p >> 15;
+		p *= 0xEEDE0891;
+		p ^= p >> 5;
+		p += p << 16;
+		p ^= p >> 7;
+		p ^= p >> 3;
+		p ^= p << 6;
+		p ^= p >> 17;
+		return p;
+	}
+
+	int selectPartition(int seed, int x, int y, int z, int partitionCount, bool smallBlock)
+	{
+		if(smallBlock)
+		{
+			x <<= 1;
+			y <<= 1;
+			z <<= 1;
+		}
+
+		seed += (partitionCount - 1) * 1024;
+
+		uint32_t rnum = hash52(seed);
+
+		int seed1 = rnum & 0xF;
+		int seed2 = (rnum >> 4) & 0xF;
+		int seed3 = (rnum >> 8) & 0xF;
+		int seed4 = (rnum >> 12) & 0xF;
+		int seed5 = (rnum >> 16) & 0xF;
+		int seed6 = (rnum >> 20) & 0xF;
+		int seed7 = (rnum >> 24) & 0xF;
+		int seed8 = (rnum >> 28) & 0xF;
+		int seed9 = (rnum >> 18) & 0xF;
+		int seed10 = (rnum >> 22) & 0xF;
+		int seed11 = (rnum >> 26) & 0xF;
+		int seed12 = ((rnum >> 30) | (rnum << 2)) & 0xF;
+
+		seed1 *= seed1;
+		seed2 *= seed2;
+		seed3 *= seed3;
+		seed4 *= seed4;
+		seed5 *= seed5;
+		seed6 *= seed6;
+		seed7 *= seed7;
+		seed8 *= seed8;
+		seed9 *= seed9;
+		seed10 *= seed10;
+		seed11 *= seed11;
+		seed12 *= seed12;
+
+		int sh1, sh2;
+
+		if(seed & 1)
+		{
+			sh1 = (seed & 2) ? 4 : 5;
+			sh2 = (partitionCount == 3) ? 6 : 5;
+		}
+		else
+		{
+			sh1 = (partitionCount == 3) ? 6 : 5;
+			sh2 = (seed & 2) ? 4 : 5;
+		}
+
+		int sh3 = (seed & 0x10) ? sh1 : sh2;
+
+		seed1 >>= sh1;
+		seed2 >>= sh2;
+		seed3 >>= sh1;
+		seed4 >>= sh2;
+		seed5 >>= sh1;
+		seed6 >>= sh2;
+		seed7 >>= sh1;
+		seed8 >>= sh2;
+		seed9 >>= sh3;
+		seed10 >>= sh3;
+		seed11 >>= sh3;
+		seed12 >>= sh3;
+
+		int a = (seed1 * x + seed2 * y + seed11 * z + (rnum >> 14)) & 0x3F;
+		int b = (seed3 * x + seed4 * y + seed12 * z + (rnum >> 10)) & 0x3F;
+		int c = (seed5 * x + seed6 * y + seed9 * z + (rnum >> 6)) & 0x3F;
+		int d = (seed7 * x + seed8 * y + seed10 * z + (rnum >> 2)) & 0x3F;
+
+		if(partitionCount < 4) d = 0;
+		if(partitionCount < 3) c = 0;
+
+		if(a >= b && a >= c && a >= d)
+		{
+			return 0;
+		}
+		else if(b >= c && b >= d)
+		{
+			return 1;
+		}
+		else if(c >= d)
+		{
+			return 2;
+		}
+
+		return 3;
+	}
+
+	inline void bitTransferSigned(int &a, int &b)
+	{
+		b >>= 1;
+		b |= a & 0x80;
+		a >>= 1;
+		a &= 0x3F;
+		if(a & 0x20) a -= 0x40;
+	}
+
+	inline void set(int e[4], int r, int g, int b, int a)
+	{
+		e[0] = r;
+		e[1] = g;
+		e[2] = b;
+		e[3] = a;
+	}
+
+	inline void blueContract(int e[4], int r, int g, int b, int a)
+	{
+		set(e, (r + b) >> 1, (g + b) >> 1, b, a);
+	}
+
+	// Decodes the endpoints of one partition. Returns false for HDR modes, which the LDR profile doesn't support.
+	bool decodeEndpoints(int mode, const int *v, int e0[4], int e1[4])
+	{
+		switch(mode)
+		{
+		case 0:   // LDR luminance, direct
+			set(e0, v[0], v[0], v[0], 0xFF);
+			set(e1, v[1], v[1], v[1], 0xFF);
+			break;
+		case 1:   // LDR luminance, base+offset
+			{
+				int L0 = (v[0] >> 2) | (v[1] & 0xC0);
+				int L1 = L0 + (v[1] & 0x3F);
+
+				set(e0, L0, L0, L0, 0xFF);
+				set(e1, L1, L1, L1, 0xFF);
+			}
+			break;
+		case 4:   // LDR luminance+alpha, direct
+			set(e0, v[0], v[0], v[0], v[2]);
+			set(e1, v[1], v[1], v[1], v[3]);
+			break;
+		case 5:   // LDR luminance+alpha, base+offset
+			{
+				int v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+
+				bitTransferSigned(v1, v0);
+				bitTransferSigned(v3, v2);
+
+				set(e0, v0, v0, v0, v2);
+				set(e1, v0 + v1, v0 + v1, v0 + v1, v2 + v3);
+			}
+			break;
+		case 6:   // LDR RGB, base+scale
+			set(e0, (v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, 0xFF);
+			set(e1, v[0], v[1], v[2], 0xFF);
+			break;
+		case 8:   // LDR RGB, direct
+			if(v[1] + v[3] + v[5] >= v[0] + v[2] + v[4])
+			{
+				set(e0, v[0], v[2], v[4], 0xFF);
+				set(e1, v[1], v[3], v[5], 0xFF);
+			}
+			else
+			{
+				blueContract(e0, v[1], v[3], v[5], 0xFF);
+				blueContract(e1, v[0], v[2], v[4], 0xFF);
+			}
+			break;
+		case 9:   // LDR RGB, base+offset
+			{
+				int v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3], v4 = v[4], v5 = v[5];
+
+				bitTransferSigned(v1, v0);
+				bitTransferSigned(v3, v2);
+				bitTransferSigned(v5, v4);
+
+				if(v1 + v3 + v5 >= 0)
+				{
+					set(e0, v0, v2, v4, 0xFF);
+					set(e1, v0 + v1, v2 + v3, v4 + v5, 0xFF);
+				}
+				else
+				{
+					blueContract(e0, v0 + v1, v2 + v3, v4 + v5, 0xFF);
+					blueContract(e1, v0, v2, v4, 0xFF);
+				}
+			}
+			break;
+		case 10:   // LDR RGB, base+scale plus two alpha
+			set(e0, (v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, v[4]);
+			set(e1, v[0], v[1], v[2], v[5]);
+			break;
+		case 12:   // LDR RGBA, direct
+			if(v[1] + v[3] + v[5] >= v[0] + v[2] + v[4])
+			{
+				set(e0, v[0], v[2], v[4], v[6]);
+				set(e1, v[1], v[3], v[5], v[7]);
+			}
+			else
+			{
+				blueContract(e0, v[1], v[3], v[5], v[7]);
+				blueContract(e1, v[0], v[2], v[4], v[6]);
+			}
+			break;
+		case 13:   // LDR RGBA, base+offset
+			{
+				int v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3], v4 = v[4], v5 = v[5], v6 = v[6], v7 = v[7];
+
+				bitTransferSigned(v1, v0);
+				bitTransferSigned(v3, v2);
+				bitTransferSigned(v5, v4);
+				bitTransferSigned(v7, v6);
+
+				if(v1 + v3 + v5 >= 0)
+				{
+					set(e0, v0, v2, v4, v6);
+					set(e1, v0 + v1, v2 + v3, v4 + v5, v6 + v7);
+				}
+				else
+				{
+					blueContract(e0, v0 + v1, v2 + v3, v4 + v5, v6 + v7);
+					blueContract(e1, v0, v2, v4, v6);
+				}
+			}
+			break;
+		default:   // HDR modes
+			return false;
+		}
+
+		for(int c = 0; c < 4; c++)
+		{
+			e0[c] = clampByte(e0[c]);
+			e1[c] = clampByte(e1[c]);
+		}
+
+		return true;
+	}
+
+	// Decodes the block mode field into the weight grid layout. Returns false for reserved modes.
+	bool decodeBlockMode(int blockMode, int &weightWidth, int &weightHeight, bool &dualPlane, int &weightRange)
+	{
+		int R = (blockMode >> 4) & 1;
+		int H = (blockMode >> 9) & 1;
+		int D = (blockMode >> 10) & 1;
+		int A = (blockMode >> 5) & 3;
+
+		if((blockMode & 3) != 0)
+		{
+			R |= (blockMode & 3) << 1;
+			int B = (blockMode >> 7) & 3;
+
+			switch((blockMode >> 2) & 3)
+			{
+			case 0: weightWidth = B + 4; weightHeight = A + 2; break;
+			case 1: weightWidth = B + 8; weightHeight = A + 2; break;
+			case 2: weightWidth = A + 2; weightHeight = B + 8; break;
+			case 3:
+				B &= 1;
+				if(blockMode & 0x100)
+				{
+					weightWidth = B + 2;
+					weightHeight = A + 2;
+				}
+				else
+				{
+					weightWidth = A + 2;
+					weightHeight = B + 6;
+				}
+				break;
+			}
+		}
+		else
+		{
+			R |= ((blockMode >> 2) & 3) << 1;
+
+			if(((blockMode >> 2) & 3) == 0)
+			{
+				return false;
+			}
+
+			int B = (blockMode >> 9) & 3;
+
+			switch((blockMode >> 7) & 3)
+			{
+			case 0: weightWidth = 12;    weightHeight = A + 2; break;
+			case 1: weightWidth = A + 2; weightHeight = 12;    break;
+			case 2:
+				weightWidth = A + 6;
+				weightHeight = B + 6;
+				D = 0;
+				H = 0;
+				break;
+			case 3:
+				switch(A)
+				{
+				case 0: weightWidth = 6;  weightHeight = 10; break;
+				case 1: weightWidth = 10; weightHeight = 6;  break;
+				default:
+					return false;
+				}
+				break;
+			}
+		}
+
+		dualPlane = (D != 0);
+		weightRange = (R - 2) + 6 * H;
+
+		return true;
+	}
+
+	// Decodes one block to 16-bit UNORM texels. Returns false for blocks which must produce the error color.
+	bool decodeBlock(const Block &block, int blockWidth, int blockHeight, bool isSRGB, unsigned short texels[MAX_BLOCK_TEXELS][4])
+	{
+		int texelCount = blockWidth * blockHeight;
+		int blockMode = block.bits(0, 11);
+
+		if((blockMode & 0x1FF) == 0x1FC)   // Void-extent block
+		{
+			if((blockMode & 0x200) || block.bits(10, 2) != 3)
+			{
+				return false;   // HDR or reserved
+			}
+
+			// The extent coordinates only serve as an optimization hint, the block is uniform
+			for(int i = 0; i < texelCount; i++)
+			{
+				for(int c = 0; c < 4; c++)
+				{
+					texels[i][c] = static_cast<unsigned short>(block.bits(64 + 16 * c, 16));
+				}
+			}
+
+			return true;
+		}
+
+		int weightWidth, weightHeight, weightRange;
+		bool dualPlane;
+
+		if(!decodeBlockMode(blockMode, weightWidth, weightHeight, dualPlane, weightRange))
+		{
+			return false;
+		}
+
+		int planes = dualPlane ? 2 : 1;
+		int weightCount = weightWidth * weightHeight * planes;
+		int weightBits = iseBitCount(weightCount, weightRange);
+
+		if(weightWidth > blockWidth || weightHeight > blockHeight || weightCount > MAX_WEIGHTS ||
+		   weightBits < MIN_WEIGHT_BITS || weightBits > MAX_WEIGHT_BITS)
+		{
+			return false;
+		}
+
+		int partitionCount = block.bits(11, 2) + 1;
+
+		if(dualPlane && partitionCount == 4)
+		{
+			return false;
+		}
+
+		int belowWeights = 128 - weightBits;
+		int partitionIndex = 0;
+		int colorStart = 17;
+		int cem[4];
+
+		if(partitionCount == 1)
+		{
+			cem[0] = block.bits(13, 4);
+		}
+		else
+		{
+			partitionIndex = block.bits(13, 10);
+			colorStart = 29;
+
+			int selector = block.bits(23, 2);
+
+			if(selector == 0)
+			{
+				for(int p = 0; p < partitionCount; p++)
+				{
+					cem[p] = block.bits(25, 4);
+				}
+			}
+			else
+			{
+				// Class bits for each partition followed by 2 mode bits for each partition.
+				// The ones which don't fit in the 4 bits below the partition index are stored under the weights.
+				int extraBits = 3 * partitionCount - 4;
+				belowWeights -= extraBits;
+
+				unsigned int encoded = block.bits(25, 4) | (block.bits(belowWeights, extraBits) << 4);
+				int baseClass = selector - 1;
+
+				for(int p = 0; p < partitionCount; p++)
+				{
+					cem[p] = ((baseClass + ((encoded >> p) & 1)) << 2) | ((encoded >> (partitionCount + 2 * p)) & 3);
+				}
+			}
+		}
+
+		int ccs = -1;   // Color component using the second weight plane
+
+		if(dualPlane)
+		{
+			belowWeights -= 2;
+			ccs = block.bits(belowWeights, 2);
+		}
+
+		int colorValueCount = 0;
+
+		for(int p = 0; p < partitionCount; p++)
+		{
+			colorValueCount += 2 * ((cem[p] >> 2) + 1);
+		}
+
+		if(colorValueCount > MAX_COLOR_VALUES)
+		{
+			return false;
+		}
+
+		// The endpoints use the largest range that fits in the remaining bits
+		int colorBits = belowWeights - colorStart;
+		int colorRange = -1;
+
+		for(int range = RANGE_256; range >= 0; range--)
+		{
+			if(iseBitCount(colorValueCount, range) <= colorBits)
+			{
+				colorRange = range;
+				break;
+			}
+		}
+
+		if(colorRange < RANGE_6)
+		{
+			return false;
+		}
+
+		int colorValues[MAX_COLOR_VALUES];
+		decodeISE(block, colorStart, colorValueCount, colorRange, colorValues);
+
+		for(int i = 0; i < colorValueCount; i++)
+		{
+			colorValues[i] = unquantizeColor(colorValues[i], colorRange);
+		}
+
+		int endpoints[4][2][4];
+		const int *v = colorValues;
+
+		for(int p = 0; p < partitionCount; p++)
+		{
+			if(!decodeEndpoints(cem[p], v, endpoints[p][0], endpoints[p][1]))
+			{
+				return false;
+			}
+
+			v += 2 * ((cem[p] >> 2) + 1);
+		}
+
+		// Weights are stored bit-reversed from the top of the block. The infill below reads up
+		// to one row and column past the grid, with zero contribution, so pad the array.
+		int weights[MAX_WEIGHTS + 4 * (12 + 1)] = {};
+		decodeISE(block.reversed(), 0, weightCount, weightRange, weights);
+
+		for(int i = 0; i < weightCount; i++)
+		{
+			weights[i] = unquantizeWeight(weights[i], weightRange);
+		}
+
+		int Ds = (1024 + blockWidth / 2) / (blockWidth - 1);
+		int Dt = (1024 + blockHeight / 2) / (blockHeight - 1);
+		bool smallBlock = texelCount < 31;
+
+		for(int t = 0; t < blockHeight; t++)
+		{
+			for(int s = 0; s < blockWidth; s++)
+			{
+				// Bilinear infill of the weight grid
+				int gs = (Ds * s * (weightWidth - 1) + 32) >> 6;
+				int gt = (Dt * t * (weightHeight - 1) + 32) >> 6;
+				int js = gs >> 4;
+				int fs = gs & 0xF;
+				int jt = gt >> 4;
+				int ft = gt & 0xF;
+
+				int w11 = (fs * ft + 8) >> 4;
+				int w10 = ft - w11;
+				int w01 = fs - w11;
+				int w00 = 16 - fs - ft + w11;
+
+				int v0 = js + jt * weightWidth;
+				int weight[2];
+
+				for(int plane = 0; plane < planes; plane++)
+				{
+					int p00 = weights[(v0) * planes + plane];
+					int p01 = weights[(v0 + 1) * planes + plane];
+					int p10 = weights[(v0 + weightWidth) * planes + plane];
+					int p11 = weights[(v0 + weightWidth + 1) * planes + plane];
+
+					weight[plane] = (p00 * w00 + p01 * w01 + p10 * w10 + p11 * w11 + 8) >> 4;
+				}
+
+				int partition = (partitionCount > 1) ? selectPartition(partitionIndex, s, t, 0, partitionCount, smallBlock) : 0;
+				unsigned short *texel = texels[s + t * blockWidth];
+
+				for(int c = 0; c < 4; c++)
+				{
+					int w = (c == ccs) ? weight[1] : weight[0];
+					int e0 = endpoints[partition][0][c];
+					int e1 = endpoints[partition][1][c];
+
+					// sRGB endpoints expand to the center of the 8-bit interval
+					int C0 = (e0 << 8) | (isSRGB ? 0x80 : e0);
+					int C1 = (e1 << 8) | (isSRGB ? 0x80 : e1);
+
+					texel[c] = static_cast<unsigned short>((C0 * (64 - w) + C1 * w + 32) >> 6);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void writeBlock(const unsigned short texels[MAX_BLOCK_TEXELS][4], unsigned char *dest, int x, int y, int w, int h, int pitch, int bpp, int blockWidth, int blockHeight, bool isSRGB)
+	{
+		for(int j = 0; j < blockHeight && (y + j) < h; j++)
+		{
+			unsigned char *row = dest + j * pitch;
+
+			for(int i = 0; i < blockWidth && (x + i) < w; i++)
+			{
+				const unsigned short *texel = texels[i + j * blockWidth];
+
+				if(isSRGB)
+				{
+					unsigned char *bgra = row + i * bpp;
+
+					bgra[0] = static_cast<unsigned char>(texel[2] >> 8);
+					bgra[1] = static_cast<unsigned char>(texel[1] >> 8);
+					bgra[2] = static_cast<unsigned char>(texel[0] >> 8);
+					bgra[3] = static_cast<unsigned char>(texel[3] >> 8);
+				}
+				else
+				{
+					float *rgba = reinterpret_cast<float*>(row + i * bpp);
+
+					for(int c = 0; c < 4; c++)
+					{
+						rgba[c] = static_cast<float>(texel[c]) * (1.0f / 65535.0f);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool ASTC_Decoder::Decode(const unsigned char *src, unsigned char *dst, int w, int h, int dstW, int dstH, int dstPitch, int dstBpp, int xBlockSize, int yBlockSize, bool isSRGB)
+{
+	if(xBlockSize < 4 || xBlockSize > 12 || yBlockSize < 4 || yBlockSize > 12)
+	{
+		return false;
+	}
+
+	static const unsigned short errorColor[4] = {0xFFFF, 0x0000, 0xFFFF, 0xFFFF};   // Magenta
+	unsigned short texels[MAX_BLOCK_TEXELS][4];
+
+	for(int y = 0; y < h; y += yBlockSize)
+	{
+		unsigned char *dstRow = dst + (y * dstPitch);
+
+		for(int x = 0; x < w; x += xBlockSize, src += 16)
+		{
+			if(!decodeBlock(Block(src), xBlockSize, yBlockSize, isSRGB, texels))
+			{
+				for(int i = 0; i < xBlockSize * yBlockSize; i++)
+				{
+					memcpy(texels[i], errorColor, sizeof(errorColor));
+				}
+			}
+
+			writeBlock(texels, dstRow + (x * dstBpp), x, y, dstW, dstH, dstPitch, dstBpp, xBlockSize, yBlockSize, isSRGB);
+		}
+	}
+
+	return true;
+}
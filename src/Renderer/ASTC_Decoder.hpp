@@ -0,0 +1,32 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+class ASTC_Decoder
+{
+public:
+	/// ASTC_Decoder::Decode - Decodes 2D ASTC images using the LDR profile
+	/// @param src            Pointer to ASTC encoded image
+	/// @param dst            Pointer to RGBA, 32 bit float output, or BGRA, 8 bit output for sRGB
+	/// @param w              src image width
+	/// @param h              src image height
+	/// @param dstW           dst image width
+	/// @param dstH           dst image height
+	/// @param dstPitch       dst image pitch (bytes per row)
+	/// @param dstBpp         dst image bytes per pixel
+	/// @param xBlockSize     block width, in texels
+	/// @param yBlockSize     block height, in texels
+	/// @param isSRGB         true if the image holds sRGB encoded colors
+	/// @return               true if the decoding was performed
+	static bool Decode(const unsigned char *src, unsigned char *dst, int w, int h, int dstW, int dstH, int dstPitch, int dstBpp, int xBlockSize, int yBlockSize, bool isSRGB);
+};
@@ -18,6 +18,9 @@
 #include "Reactor/Reactor.hpp"
 #include "Common/Memory.hpp"
 #include "Common/Debug.hpp"
+#include "System/ThreadPool.hpp"
+
+#include <vector>
 
 namespace sw
 {
@@ -26,15 +29,21 @@ namespace sw
 	Blitter::Blitter()
 	{
 		blitCache = new RoutineCache<State>(1024);
+		resolveCache = new RoutineCache<State>(64);
+		downsampleCache = new RoutineCache<State>(64);
 	}
 
 	Blitter::~Blitter()
 	{
 		delete blitCache;
+		delete resolveCache;
+		delete downsampleCache;
 	}
 
 	void Blitter::clear(void *pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
 	{
+		attachResolveRoutine(dest);
+
 		if(fastClear(pixel, format, dest, dRect, rgbaMask))
 		{
 			return;
@@ -138,6 +147,8 @@ namespace sw
 
 	void Blitter::blit(Surface *source, const SliceRectF &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options& options)
 	{
+		attachResolveRoutine(dest);
+
 		if(dest->getInternalFormat() == FORMAT_NULL)
 		{
 			return;
@@ -1388,6 +1399,407 @@ namespace sw
 		return function(L"BlitRoutine");
 	}
 
+	Routine *Blitter::generateResolve(const State &state)
+	{
+		Function<Void(Pointer<Byte>, Int, Int)> function;
+		{
+			Pointer<Byte> element(function.Arg<0>());
+			Int count(function.Arg<1>());
+			Int sliceB(function.Arg<2>());
+
+			int bytes = Surface::bytes(state.destFormat);
+
+			For(Int i = 0, i < count, i++)
+			{
+				Float4 color;
+
+				if(!read(color, element, state))
+				{
+					return nullptr;
+				}
+
+				Pointer<Byte> sample = element;
+
+				for(int s = 1; s < state.destSamples; s++)
+				{
+					sample += sliceB;
+
+					Float4 c;
+
+					if(!read(c, sample, state))
+					{
+						return nullptr;
+					}
+
+					color += c;
+				}
+
+				// Both formats are the same, so no scaling or clamping is needed, just rounding on write
+				color *= Float4(1.0f / state.destSamples);
+
+				if(!write(color, element, state))
+				{
+					return nullptr;
+				}
+
+				element += bytes;
+			}
+		}
+
+		return function(L"ResolveRoutine");
+	}
+
+	Routine *Blitter::getResolveRoutine(Format format, int samples)
+	{
+		// Integer samples can't be averaged, and are never resolved
+		if(Surface::isNonNormalizedInteger(format))
+		{
+			return nullptr;
+		}
+
+		State state(Options(false, false, false));
+		state.sourceFormat = format;
+		state.destFormat = format;
+		state.destSamples = samples;
+
+		criticalSection.lock();
+		Routine *resolveRoutine = resolveCache->query(state);
+
+		if(!resolveRoutine)
+		{
+			resolveRoutine = generateResolve(state);
+
+			if(resolveRoutine)
+			{
+				resolveCache->add(state, resolveRoutine);
+			}
+		}
+
+		criticalSection.unlock();
+
+		return resolveRoutine;
+	}
+
+	void Blitter::attachResolveRoutine(Surface *surface)
+	{
+		if(surface->getSamples() > 1 && !surface->hasResolveRoutine())
+		{
+			surface->setResolveRoutine(getResolveRoutine(surface->getInternalFormat(), surface->getSamples()));
+		}
+	}
+
+	Routine *Blitter::generateDownsample(const State &state)
+	{
+		Function<Void(Pointer<Byte>)> function;
+		{
+			Pointer<Byte> data(function.Arg<0>());
+
+			Pointer<Byte> source0 = *Pointer<Pointer<Byte>>(data + OFFSET(DownsampleData,source0));
+			Pointer<Byte> source1 = *Pointer<Pointer<Byte>>(data + OFFSET(DownsampleData,source1));
+			Pointer<Byte> dest = *Pointer<Pointer<Byte>>(data + OFFSET(DownsampleData,dest));
+			Int sPitchB = *Pointer<Int>(data + OFFSET(DownsampleData,sPitchB));
+			Int dPitchB = *Pointer<Int>(data + OFFSET(DownsampleData,dPitchB));
+
+			Int sWidth = *Pointer<Int>(data + OFFSET(DownsampleData,sWidth));
+			Int sHeight = *Pointer<Int>(data + OFFSET(DownsampleData,sHeight));
+			Int dWidth = *Pointer<Int>(data + OFFSET(DownsampleData,dWidth));
+
+			Int y0d = *Pointer<Int>(data + OFFSET(DownsampleData,y0d));
+			Int y1d = *Pointer<Int>(data + OFFSET(DownsampleData,y1d));
+
+			bool quadLayout = Surface::hasQuadLayout(state.sourceFormat);
+			int bytes = Surface::bytes(state.sourceFormat);
+			int texels = state.filter3D ? 8 : 4;
+
+			// sRGB encoded texels are averaged in linear space
+			bool linearize = state.convertSRGB && Surface::isSRGBformat(state.sourceFormat);
+			float4 scale;
+
+			if(!GetScale(scale, state.sourceFormat))
+			{
+				return nullptr;
+			}
+
+			// Halving an odd size can't pair up texels, so each destination texel then covers 2 + 1/n source
+			// texels. Those get weighted over three taps by their overlap, like a box filter of the exact footprint.
+			auto axisWeights = [](Float w[3], Int i, Int size)
+			{
+				If((size & 1) == 0)
+				{
+					w[0] = Float(0.5f);
+					w[1] = Float(0.5f);
+					w[2] = Float(0.0f);
+				}
+				Else
+				{
+					Float n = Float(size >> 1);
+					Float rcp = Float(1.0f) / Float(size);
+
+					w[0] = (n - Float(i)) * rcp;
+					w[1] = n * rcp;
+					w[2] = Float(i + 1) * rcp;
+				}
+			};
+
+			auto filter = [&](Pointer<Byte> s, Float4 &color, Float4 weight) -> bool
+			{
+				Float4 c;
+
+				if(!read(c, s, state))
+				{
+					return false;
+				}
+
+				if(linearize)
+				{
+					c *= Float4(1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z, 1.0f / scale.w);
+					c = sRGBtoLinear(c);
+				}
+
+				color += c * weight;
+
+				return true;
+			};
+
+			auto store = [&](Float4 &color, Int i, Int j) -> bool
+			{
+				if(linearize)
+				{
+					color = LinearToSRGB(color);
+					color *= Float4(scale.x, scale.y, scale.z, scale.w);
+				}
+
+				Pointer<Byte> d = dest + ComputeOffset(i, j, dPitchB, bytes, quadLayout);
+
+				return write(color, d, state);
+			};
+
+			bool valid = true;
+			Int odd = *Pointer<Int>(data + OFFSET(DownsampleData,odd));
+
+			If(odd == 0)
+			{
+				For(Int j = y0d, j < y1d, j++)
+				{
+					Int Y[2] = { j * 2, j * 2 + 1 };
+
+					For(Int i = 0, i < dWidth, i++)
+					{
+						Int X[2] = { i * 2, i * 2 + 1 };
+
+						Float4 color = Float4(0.0f);
+
+						for(int t = 0; t < texels; t++)
+						{
+							Pointer<Byte> slice = (t & 4) ? source1 : source0;
+							Pointer<Byte> s = slice + ComputeOffset(X[t & 1], Y[(t >> 1) & 1], sPitchB, bytes, quadLayout);
+
+							valid = valid && filter(s, color, Float4(1.0f / texels));
+						}
+
+						valid = valid && store(color, i, j);
+					}
+				}
+			}
+			Else
+			{
+				Pointer<Byte> source2 = *Pointer<Pointer<Byte>>(data + OFFSET(DownsampleData,source2));
+				Pointer<Byte> slices[3] = { source0, source1, source2 };
+				Float wz[3];
+
+				for(int z = 0; z < 3; z++)
+				{
+					wz[z] = state.filter3D ? *Pointer<Float>(data + OFFSET(DownsampleData,zWeight) + 4 * z) : Float(z == 0 ? 1.0f : 0.0f);
+				}
+
+				For(Int j = y0d, j < y1d, j++)
+				{
+					Int Y[3] = { j * 2, Min(j * 2 + 1, sHeight - 1), Min(j * 2 + 2, sHeight - 1) };
+					Float wy[3];
+					axisWeights(wy, j, sHeight);
+
+					For(Int i = 0, i < dWidth, i++)
+					{
+						Int X[3] = { i * 2, Min(i * 2 + 1, sWidth - 1), Min(i * 2 + 2, sWidth - 1) };
+						Float wx[3];
+						axisWeights(wx, i, sWidth);
+
+						Float4 color = Float4(0.0f);
+
+						for(int z = 0; z < (state.filter3D ? 3 : 1); z++)
+						{
+							for(int y = 0; y < 3; y++)
+							{
+								for(int x = 0; x < 3; x++)
+								{
+									Pointer<Byte> s = slices[z] + ComputeOffset(X[x], Y[y], sPitchB, bytes, quadLayout);
+
+									valid = valid && filter(s, color, Float4(wx[x] * wy[y] * wz[z]));
+								}
+							}
+						}
+
+						valid = valid && store(color, i, j);
+					}
+				}
+			}
+
+			if(!valid)
+			{
+				return nullptr;
+			}
+		}
+
+		return function(L"DownsampleRoutine");
+	}
+
+	bool Blitter::downsample(Surface *const *source, Surface *const *dest, int count)
+	{
+		Format format = source[0]->getInternalFormat();
+
+		for(int i = 0; i < count; i++)
+		{
+			if(source[i]->getInternalFormat() != format || dest[i]->getInternalFormat() != format ||
+			   dest[i]->getDepth() != dest[0]->getDepth() || source[i]->getDepth() != source[0]->getDepth())
+			{
+				return false;
+			}
+		}
+
+		if(Surface::isNonNormalizedInteger(format) || Surface::isDepth(format) || Surface::isStencil(format))
+		{
+			return false;
+		}
+
+		State state(Options(true, false, true));
+		state.sourceFormat = format;
+		state.destFormat = format;
+		state.destSamples = 1;
+		state.filter3D = dest[0]->getDepth() < source[0]->getDepth();   // 3D textures halve their depth, arrays don't
+
+		criticalSection.lock();
+		Routine *downsampleRoutine = downsampleCache->query(state);
+
+		if(!downsampleRoutine)
+		{
+			downsampleRoutine = generateDownsample(state);
+
+			if(downsampleRoutine)
+			{
+				downsampleCache->add(state, downsampleRoutine);
+			}
+		}
+
+		criticalSection.unlock();
+
+		if(!downsampleRoutine)
+		{
+			return false;
+		}
+
+		std::vector<DownsampleData> slices;
+		int rows = 0;
+
+		for(int i = 0; i < count; i++)
+		{
+			const byte *sourceBuffer = (const byte*)source[i]->lockInternal(0, 0, 0, LOCK_READONLY, PUBLIC);
+			byte *destBuffer = (byte*)dest[i]->lockInternal(0, 0, 0, LOCK_DISCARD, PUBLIC);
+			int sSliceB = source[i]->getInternalSliceB();
+			int sDepth = source[i]->getDepth();
+
+			for(int z = 0; z < dest[i]->getDepth(); z++)
+			{
+				DownsampleData data;
+
+				if(state.filter3D)
+				{
+					data.source0 = sourceBuffer + 2 * z * sSliceB;
+					data.source1 = sourceBuffer + min(2 * z + 1, sDepth - 1) * sSliceB;
+					data.source2 = sourceBuffer + min(2 * z + 2, sDepth - 1) * sSliceB;
+
+					if(sDepth & 1)   // Same three tap weighting as odd widths and heights
+					{
+						int n = sDepth >> 1;
+						data.zWeight[0] = float(n - z) / sDepth;
+						data.zWeight[1] = float(n) / sDepth;
+						data.zWeight[2] = float(z + 1) / sDepth;
+					}
+					else
+					{
+						data.zWeight[0] = 0.5f;
+						data.zWeight[1] = 0.5f;
+						data.zWeight[2] = 0.0f;
+					}
+				}
+				else
+				{
+					data.source0 = sourceBuffer + z * sSliceB;
+					data.source1 = data.source0;
+					data.source2 = data.source0;
+					data.zWeight[0] = 1.0f;
+					data.zWeight[1] = 0.0f;
+					data.zWeight[2] = 0.0f;
+				}
+
+				data.dest = destBuffer + z * dest[i]->getInternalSliceB();
+				data.sPitchB = source[i]->getInternalPitchB();
+				data.dPitchB = dest[i]->getInternalPitchB();
+				data.sWidth = source[i]->getWidth();
+				data.sHeight = source[i]->getHeight();
+				data.dWidth = dest[i]->getWidth();
+				data.y0d = 0;
+				data.y1d = dest[i]->getHeight();
+				data.odd = (data.sWidth | data.sHeight | (state.filter3D ? sDepth : 0)) & 1;
+
+				slices.push_back(data);
+				rows += data.y1d;
+			}
+		}
+
+		// Bands of rows are independent, but only large levels are worth spreading over the workers
+		const int minimumTexelsPerBand = 16384;
+
+		DownsampleTask task;
+		task.downsample = (void(*)(const DownsampleData*))downsampleRoutine->getEntry();
+		task.slices = slices.data();
+		task.sliceCount = static_cast<int>(slices.size());
+
+		ThreadPool::Get().parallelForRange(rows, dest[0]->getWidth(), minimumTexelsPerBand, [&](unsigned int first, unsigned int last)
+		{
+			downsampleRows(task, first, last);
+		});
+
+		for(int i = 0; i < count; i++)
+		{
+			source[i]->unlockInternal();
+			dest[i]->unlockInternal();
+		}
+
+		return true;
+	}
+
+	void Blitter::downsampleRows(const DownsampleTask &task, int first, int last)
+	{
+		int row = 0;   // First row of the current slice
+
+		for(int i = 0; i < task.sliceCount && row < last; i++)
+		{
+			const DownsampleData &slice = task.slices[i];
+			int height = slice.y1d - slice.y0d;
+
+			if(row + height > first)
+			{
+				DownsampleData data = slice;
+				data.y0d = max(first - row, 0);
+				data.y1d = min(last - row, height);
+
+				task.downsample(&data);
+			}
+
+			row += height;
+		}
+	}
+
 	bool Blitter::blitReactor(Surface *source, const SliceRectF &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options &options)
 	{
 		ASSERT(!options.clearOperation || ((source->getWidth() == 1) && (source->getHeight() == 1) && (source->getDepth() == 1)));
@@ -18,6 +18,7 @@
 #include "Surface.hpp"
 #include "RoutineCache.hpp"
 #include "Reactor/Reactor.hpp"
+#include "Common/MutexLock.hpp"
 
 #include <string.h>
 
@@ -66,6 +67,7 @@ namespace sw
 			Format sourceFormat;
 			Format destFormat;
 			int destSamples;
+			bool filter3D = false;   // Downsampling also averages pairs of source slices
 		};
 
 		struct BlitData
@@ -90,6 +92,34 @@ namespace sw
 			int sHeight;
 		};
 
+		struct DownsampleData
+		{
+			const void *source0;   // Source slices averaged into the destination slice
+			const void *source1;
+			const void *source2;   // Only read for odd depths
+			float zWeight[3];
+			void *dest;
+			int sPitchB;
+			int dPitchB;
+
+			int sWidth;
+			int sHeight;
+			int dWidth;
+
+			int y0d;
+			int y1d;
+
+			int odd;   // Any odd size needs the three tap filter
+		};
+
+		// Destination slices are downsampled in bands of rows, spread over the workers
+		struct DownsampleTask
+		{
+			void (*downsample)(const DownsampleData *data);
+			const DownsampleData *slices;
+			int sliceCount;
+		};
+
 	public:
 		Blitter();
 		virtual ~Blitter();
@@ -97,6 +127,9 @@ namespace sw
 		void clear(void *pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
 		void blit(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
 		void blit3D(Surface *source, Surface *dest);
+		Routine *getResolveRoutine(Format format, int samples);   // void(void *element, int count, int sliceB)
+		void attachResolveRoutine(Surface *surface);   // Lets a multisampled surface written through this blitter resolve with its cache
+		bool downsample(Surface *const *source, Surface *const *dest, int count);   // 2x2 box filter into half size surfaces
 
 	private:
 		bool fastClear(void *pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
@@ -112,8 +145,13 @@ namespace sw
 		static Float4 sRGBtoLinear(Float4 &color);
 		bool blitReactor(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
 		Routine *generate(const State &state);
+		Routine *generateResolve(const State &state);
+		Routine *generateDownsample(const State &state);
+		static void downsampleRows(const DownsampleTask &task, int first, int last);   // Rows [first, last), over all slices
 
 		RoutineCache<State> *blitCache;
+		RoutineCache<State> *resolveCache;
+		RoutineCache<State> *downsampleCache;
 		MutexLock criticalSection;
 	};
 }
@@ -48,6 +48,8 @@ namespace sw
 			if(polygon.n >= 3) {
 			if(clipFlagsOr & CLIP_FAR)    clipFar(polygon);
 			if(polygon.n >= 3) {
+			if(clipFlagsOr & CLIP_SIDES)  clipFlagsOr = (clipFlagsOr & ~CLIP_SIDES) | computeGuardBandFlags(polygon, *draw.data);
+			if(polygon.n >= 3) {
 			if(clipFlagsOr & CLIP_LEFT)   clipLeft(polygon);
 			if(polygon.n >= 3) {
 			if(clipFlagsOr & CLIP_RIGHT)  clipRight(polygon);
@@ -55,7 +57,7 @@ namespace sw
 			if(clipFlagsOr & CLIP_TOP)    clipTop(polygon);
 			if(polygon.n >= 3) {
 			if(clipFlagsOr & CLIP_BOTTOM) clipBottom(polygon);
-			}}}}}
+			}}}}}}
 		}
 
 		if(clipFlagsOr & CLIP_USER)
@@ -81,6 +83,26 @@ namespace sw
 		return polygon.n >= 3;
 	}
 
+	unsigned int Clipper::computeGuardBandFlags(const Polygon &polygon, const DrawData &data)
+	{
+		const float4 *const *V = polygon.P[polygon.i];
+
+		unsigned int clipFlags = 0;
+
+		for(int i = 0; i < polygon.n; i++)
+		{
+			float gx = data.guardBandX * V[i]->w;
+			float gy = data.guardBandY * V[i]->w;
+
+			clipFlags |= ((V[i]->x > gx)  ? CLIP_RIGHT  : 0) |
+			             ((V[i]->y > gy)  ? CLIP_TOP    : 0) |
+			             ((V[i]->x < -gx) ? CLIP_LEFT   : 0) |
+			             ((V[i]->y < -gy) ? CLIP_BOTTOM : 0);
+		}
+
+		return clipFlags;
+	}
+
 	void Clipper::clipNear(Polygon &polygon)
 	{
 		const float4 **V = polygon.P[polygon.i];
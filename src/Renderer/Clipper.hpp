@@ -38,6 +38,7 @@ namespace sw
 			CLIP_NEAR   = 1 << 5,
 
 			CLIP_FRUSTUM = 0x003F,
+			CLIP_SIDES = CLIP_RIGHT | CLIP_TOP | CLIP_LEFT | CLIP_BOTTOM,
 
 			CLIP_FINITE = 1 << 7,   // All position coordinates are finite
 
@@ -60,6 +61,9 @@ namespace sw
 		bool clip(Polygon &polygon, int clipFlagsOr, const DrawCall &draw);
 
 	private:
+		// Sides beyond the guard band, which still have to be clipped. Within it, the scissor suffices.
+		unsigned int computeGuardBandFlags(const Polygon &polygon, const DrawData &data);
+
 		void clipNear(Polygon &polygon);
 		void clipFar(Polygon &polygon);
 		void clipLeft(Polygon &polygon);
@@ -223,9 +223,12 @@ namespace sw
 		for(int i = 0; i < RENDERTARGETS; ++i)
 		{
 			renderTarget[i] = nullptr;
+			renderTargetSerial[i] = 0;
 		}
 		depthBuffer = nullptr;
+		depthBufferSerial = 0;
 		stencilBuffer = nullptr;
+		stencilBufferSerial = 0;
 
 		stencilEnable = false;
 		stencilCompareMode = STENCIL_ALWAYS;
@@ -318,6 +321,8 @@ namespace sw
 
 		colorLogicOpEnabled = false;
 		logicalOperation = LOGICALOP_COPY;
+
+		dirtyStates = DIRTY_ALL;
 	}
 
 	const float &Context::exp2Bias()
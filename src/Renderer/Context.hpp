@@ -277,6 +277,39 @@ namespace sw
 		TRANSPARENCY_LAST = TRANSPARENCY_ALPHA_TO_COVERAGE
 	};
 
+	// Groups of context state which the processor states are derived from, so each
+	// processor state only gets re-derived when one of its inputs was modified
+	enum DirtyState ENUM_UNDERLYING_TYPE_UNSIGNED_INT
+	{
+		DIRTY_SHADERS            = 0x00000001,
+		DIRTY_PRIMITIVE_TYPE     = 0x00000002,   // Points, lines or triangles, and the fill mode
+		DIRTY_INDEX_TYPE         = 0x00000004,
+		DIRTY_VERTEX_INPUT       = 0x00000008,   // Stream formats
+		DIRTY_VERTEX_SAMPLERS    = 0x00000010,
+		DIRTY_PIXEL_SAMPLERS     = 0x00000020,
+		DIRTY_TRANSFORM_FEEDBACK = 0x00000040,
+		DIRTY_RENDER_TARGETS     = 0x00000080,
+		DIRTY_DEPTH_STENCIL      = 0x00000100,   // Including the depth and stencil buffers
+		DIRTY_RASTERIZER         = 0x00000200,   // Culling, shading, depth bias and rasterizer discard
+		DIRTY_OUTPUT_MERGER      = 0x00000400,   // Blending, color writes and alpha testing
+		DIRTY_MULTISAMPLE_MASK   = 0x00000800,
+		DIRTY_OCCLUSION          = 0x00001000,
+		DIRTY_FIXED_FUNCTION     = 0x00002000,   // Lighting, fog, texture stages, point sprites, etc.
+		DIRTY_INSTRUMENTATION    = 0x00004000,
+
+		DIRTY_ALL = 0x00007FFF,
+
+		// Inputs of each processor state when both shaders are set. The fixed-function
+		// states are derived from nearly all of the context, so they use DIRTY_ALL.
+		VERTEX_DEPENDENCIES = DIRTY_SHADERS | DIRTY_PRIMITIVE_TYPE | DIRTY_INDEX_TYPE | DIRTY_VERTEX_INPUT | DIRTY_VERTEX_SAMPLERS |
+		                      DIRTY_TRANSFORM_FEEDBACK | DIRTY_RENDER_TARGETS | DIRTY_OUTPUT_MERGER | DIRTY_FIXED_FUNCTION | DIRTY_INSTRUMENTATION,
+		SETUP_DEPENDENCIES = DIRTY_SHADERS | DIRTY_PRIMITIVE_TYPE | DIRTY_RENDER_TARGETS | DIRTY_DEPTH_STENCIL | DIRTY_RASTERIZER |
+		                     DIRTY_OUTPUT_MERGER | DIRTY_FIXED_FUNCTION,
+		PIXEL_DEPENDENCIES = DIRTY_SHADERS | DIRTY_PRIMITIVE_TYPE | DIRTY_PIXEL_SAMPLERS | DIRTY_RENDER_TARGETS | DIRTY_DEPTH_STENCIL |
+		                     DIRTY_RASTERIZER | DIRTY_OUTPUT_MERGER | DIRTY_MULTISAMPLE_MASK | DIRTY_OCCLUSION | DIRTY_FIXED_FUNCTION |
+		                     DIRTY_INSTRUMENTATION
+	};
+
 	class Context
 	{
 	public:
@@ -470,6 +503,11 @@ namespace sw
 		Surface *stencilBuffer;
 		unsigned int stencilBufferLayer;
 
+		// Serials of the bound surfaces, or 0 if none, since a new surface can reuse a deleted one's address
+		uint64_t renderTargetSerial[RENDERTARGETS];
+		uint64_t depthBufferSerial;
+		uint64_t stencilBufferSerial;
+
 		// Fog
 		bool fogEnable;
 		FogMode pixelFogMode;
@@ -534,6 +572,8 @@ namespace sw
 
 		bool colorLogicOpEnabled;
 		LogicalOperation logicalOperation;
+
+		unsigned int dirtyStates;   // DirtyState groups modified since the processor states were last derived
 	};
 }
 
@@ -20,6 +20,7 @@
 #include "Shader/PixelProgram.hpp"
 #include "Shader/PixelShader.hpp"
 #include "Shader/Constants.hpp"
+#include "Common/Timer.hpp"
 #include "Common/Debug.hpp"
 
 #include <string.h>
@@ -161,19 +162,43 @@ namespace sw
 
 	void PixelProcessor::setRenderTarget(int index, Surface *renderTarget, unsigned int layer)
 	{
+		uint64_t serial = renderTarget ? renderTarget->getSerial() : 0;
+
+		if(context->renderTargetSerial[index] != serial)
+		{
+			context->dirtyStates |= DIRTY_RENDER_TARGETS;
+		}
+
 		context->renderTarget[index] = renderTarget;
+		context->renderTargetSerial[index] = serial;
 		context->renderTargetLayer[index] = layer;
 	}
 
 	void PixelProcessor::setDepthBuffer(Surface *depthBuffer, unsigned int layer)
 	{
+		uint64_t serial = depthBuffer ? depthBuffer->getSerial() : 0;
+
+		if(context->depthBufferSerial != serial)
+		{
+			context->dirtyStates |= DIRTY_DEPTH_STENCIL;
+		}
+
 		context->depthBuffer = depthBuffer;
+		context->depthBufferSerial = serial;
 		context->depthBufferLayer = layer;
 	}
 
 	void PixelProcessor::setStencilBuffer(Surface *stencilBuffer, unsigned int layer)
 	{
+		uint64_t serial = stencilBuffer ? stencilBuffer->getSerial() : 0;
+
+		if(context->stencilBufferSerial != serial)
+		{
+			context->dirtyStates |= DIRTY_DEPTH_STENCIL;
+		}
+
 		context->stencilBuffer = stencilBuffer;
+		context->stencilBufferSerial = serial;
 		context->stencilBufferLayer = layer;
 	}
 
@@ -182,6 +207,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setTexCoordIndex(texCoordIndex);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -191,6 +217,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setStageOperation(stageOperation);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -200,6 +227,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setFirstArgument(firstArgument);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -209,6 +237,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setSecondArgument(secondArgument);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -218,6 +247,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setThirdArgument(thirdArgument);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -227,6 +257,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setStageOperationAlpha(stageOperationAlpha);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -236,6 +267,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setFirstArgumentAlpha(firstArgumentAlpha);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -245,6 +277,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setSecondArgumentAlpha(secondArgumentAlpha);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -254,6 +287,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setThirdArgumentAlpha(thirdArgumentAlpha);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -263,6 +297,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setFirstModifier(firstModifier);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -272,6 +307,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setSecondModifier(secondModifier);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -281,6 +317,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setThirdModifier(thirdModifier);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -290,6 +327,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setFirstModifierAlpha(firstModifierAlpha);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -299,6 +337,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setSecondModifierAlpha(secondModifierAlpha);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -308,6 +347,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setThirdModifierAlpha(thirdModifierAlpha);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -317,6 +357,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->textureStage[stage].setDestinationArgument(destinationArgument);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -362,6 +403,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setTextureFilter(textureFilter);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -371,6 +413,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMipmapFilter(mipmapFilter);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -380,6 +423,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setGatherEnable(enable);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -389,6 +433,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setAddressingModeU(addressMode);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -398,6 +443,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setAddressingModeV(addressMode);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -407,6 +453,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setAddressingModeW(addressMode);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -416,6 +463,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setReadSRGB(sRGB);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -443,6 +491,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMaxAnisotropy(maxAnisotropy);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -452,6 +501,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setHighPrecisionFiltering(highPrecisionFiltering);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -461,6 +511,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleR(swizzleR);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -470,6 +521,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleG(swizzleG);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -479,6 +531,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleB(swizzleB);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -488,6 +541,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleA(swizzleA);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -497,6 +551,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setCompareFunc(compFunc);
+			context->dirtyStates |= DIRTY_PIXEL_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -548,63 +603,88 @@ namespace sw
 
 	void PixelProcessor::setWriteSRGB(bool sRGB)
 	{
-		context->setWriteSRGB(sRGB);
+		if(context->setWriteSRGB(sRGB))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setColorLogicOpEnabled(bool colorLogicOpEnabled)
 	{
-		context->setColorLogicOpEnabled(colorLogicOpEnabled);
+		if(context->setColorLogicOpEnabled(colorLogicOpEnabled))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setLogicalOperation(LogicalOperation logicalOperation)
 	{
-		context->setLogicalOperation(logicalOperation);
+		if(context->setLogicalOperation(logicalOperation))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setDepthBufferEnable(bool depthBufferEnable)
 	{
-		context->setDepthBufferEnable(depthBufferEnable);
+		if(context->setDepthBufferEnable(depthBufferEnable))
+		{
+			context->dirtyStates |= DIRTY_DEPTH_STENCIL;
+		}
 	}
 
 	void PixelProcessor::setDepthCompare(DepthCompareMode depthCompareMode)
 	{
 		context->depthCompareMode = depthCompareMode;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setAlphaCompare(AlphaCompareMode alphaCompareMode)
 	{
 		context->alphaCompareMode = alphaCompareMode;
+		context->dirtyStates |= DIRTY_OUTPUT_MERGER;
 	}
 
 	void PixelProcessor::setDepthWriteEnable(bool depthWriteEnable)
 	{
 		context->depthWriteEnable = depthWriteEnable;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setAlphaTestEnable(bool alphaTestEnable)
 	{
 		context->alphaTestEnable = alphaTestEnable;
+		context->dirtyStates |= DIRTY_OUTPUT_MERGER;
 	}
 
 	void PixelProcessor::setCullMode(CullMode cullMode, bool frontFacingCCW)
 	{
-		context->cullMode = cullMode;
-		context->frontFacingCCW = frontFacingCCW;
+		if(context->cullMode != cullMode || context->frontFacingCCW != frontFacingCCW)
+		{
+			context->cullMode = cullMode;
+			context->frontFacingCCW = frontFacingCCW;
+			context->dirtyStates |= DIRTY_RASTERIZER;
+		}
 	}
 
 	void PixelProcessor::setColorWriteMask(int index, int rgbaMask)
 	{
-		context->setColorWriteMask(index, rgbaMask);
+		if(context->setColorWriteMask(index, rgbaMask))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setStencilEnable(bool stencilEnable)
 	{
 		context->stencilEnable = stencilEnable;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilCompare(StencilCompareMode stencilCompareMode)
 	{
 		context->stencilCompareMode = stencilCompareMode;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilReference(int stencilReference)
@@ -623,64 +703,76 @@ namespace sw
 	{
 		context->stencilMask = stencilMask;
 		stencil.set(context->stencilReference, stencilMask, context->stencilWriteMask);
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilMaskCCW(int stencilMaskCCW)
 	{
 		context->stencilMaskCCW = stencilMaskCCW;
 		stencilCCW.set(context->stencilReferenceCCW, stencilMaskCCW, context->stencilWriteMaskCCW);
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilFailOperation(StencilOperation stencilFailOperation)
 	{
 		context->stencilFailOperation = stencilFailOperation;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilPassOperation(StencilOperation stencilPassOperation)
 	{
 		context->stencilPassOperation = stencilPassOperation;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilZFailOperation(StencilOperation stencilZFailOperation)
 	{
 		context->stencilZFailOperation = stencilZFailOperation;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilWriteMask(int stencilWriteMask)
 	{
 		context->stencilWriteMask = stencilWriteMask;
 		stencil.set(context->stencilReference, context->stencilMask, stencilWriteMask);
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilWriteMaskCCW(int stencilWriteMaskCCW)
 	{
 		context->stencilWriteMaskCCW = stencilWriteMaskCCW;
 		stencilCCW.set(context->stencilReferenceCCW, context->stencilMaskCCW, stencilWriteMaskCCW);
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setTwoSidedStencil(bool enable)
 	{
 		context->twoSidedStencil = enable;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilCompareCCW(StencilCompareMode stencilCompareMode)
 	{
 		context->stencilCompareModeCCW = stencilCompareMode;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilFailOperationCCW(StencilOperation stencilFailOperation)
 	{
 		context->stencilFailOperationCCW = stencilFailOperation;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilPassOperationCCW(StencilOperation stencilPassOperation)
 	{
 		context->stencilPassOperationCCW = stencilPassOperation;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setStencilZFailOperationCCW(StencilOperation stencilZFailOperation)
 	{
 		context->stencilZFailOperationCCW = stencilZFailOperation;
+		context->dirtyStates |= DIRTY_DEPTH_STENCIL;
 	}
 
 	void PixelProcessor::setTextureFactor(const Color<float> &textureFactor)
@@ -810,56 +902,83 @@ namespace sw
 	void PixelProcessor::setFillMode(FillMode fillMode)
 	{
 		context->fillMode = fillMode;
+		context->dirtyStates |= DIRTY_PRIMITIVE_TYPE;
 	}
 
 	void PixelProcessor::setShadingMode(ShadingMode shadingMode)
 	{
 		context->shadingMode = shadingMode;
+		context->dirtyStates |= DIRTY_RASTERIZER;
 	}
 
 	void PixelProcessor::setAlphaBlendEnable(bool alphaBlendEnable)
 	{
-		context->setAlphaBlendEnable(alphaBlendEnable);
+		if(context->setAlphaBlendEnable(alphaBlendEnable))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setSourceBlendFactor(BlendFactor sourceBlendFactor)
 	{
-		context->setSourceBlendFactor(sourceBlendFactor);
+		if(context->setSourceBlendFactor(sourceBlendFactor))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setDestBlendFactor(BlendFactor destBlendFactor)
 	{
-		context->setDestBlendFactor(destBlendFactor);
+		if(context->setDestBlendFactor(destBlendFactor))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setBlendOperation(BlendOperation blendOperation)
 	{
-		context->setBlendOperation(blendOperation);
+		if(context->setBlendOperation(blendOperation))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setSeparateAlphaBlendEnable(bool separateAlphaBlendEnable)
 	{
-		context->setSeparateAlphaBlendEnable(separateAlphaBlendEnable);
+		if(context->setSeparateAlphaBlendEnable(separateAlphaBlendEnable))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setSourceBlendFactorAlpha(BlendFactor sourceBlendFactorAlpha)
 	{
-		context->setSourceBlendFactorAlpha(sourceBlendFactorAlpha);
+		if(context->setSourceBlendFactorAlpha(sourceBlendFactorAlpha))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setDestBlendFactorAlpha(BlendFactor destBlendFactorAlpha)
 	{
-		context->setDestBlendFactorAlpha(destBlendFactorAlpha);
+		if(context->setDestBlendFactorAlpha(destBlendFactorAlpha))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setBlendOperationAlpha(BlendOperation blendOperationAlpha)
 	{
-		context->setBlendOperationAlpha(blendOperationAlpha);
+		if(context->setBlendOperationAlpha(blendOperationAlpha))
+		{
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	void PixelProcessor::setAlphaReference(float alphaReference)
 	{
 		context->alphaReference = alphaReference;
+		context->dirtyStates |= DIRTY_OUTPUT_MERGER;
 
 		factor.alphaReference4[0] = (word)iround(alphaReference * 0x1000 / 0xFF);
 		factor.alphaReference4[1] = (word)iround(alphaReference * 0x1000 / 0xFF);
@@ -918,16 +1037,19 @@ namespace sw
 	void PixelProcessor::setPixelFogMode(FogMode fogMode)
 	{
 		context->pixelFogMode = fogMode;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void PixelProcessor::setPerspectiveCorrection(bool perspectiveEnable)
 	{
 		perspectiveCorrection = perspectiveEnable;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void PixelProcessor::setOcclusionEnabled(bool enable)
 	{
 		context->occlusionEnabled = enable;
+		context->dirtyStates |= DIRTY_OCCLUSION;
 	}
 
 	void PixelProcessor::setRoutineCacheSize(int cacheSize)
@@ -1007,6 +1129,7 @@ namespace sw
 		}
 
 		state.occlusionEnabled = context->occlusionEnabled;
+		state.instrumented = profiler.isInstrumenting();
 
 		state.fogActive = context->fogActive();
 		state.pixelFogMode = context->pixelFogActive();
@@ -1182,12 +1305,36 @@ namespace sw
 		return state;
 	}
 
+	bool PixelProcessor::isSamplerModified(const State &state) const
+	{
+		if(!context->pixelShader)
+		{
+			return true;   // The texture stages depend on the sampled formats
+		}
+
+		for(unsigned int i = 0; i < TEXTURE_IMAGE_UNITS; i++)
+		{
+			if(context->pixelShader->usesSampler(i))
+			{
+				Sampler::State samplerState = context->sampler[i].samplerState();
+
+				if(memcmp(&samplerState, &state.sampler[i], sizeof(Sampler::State)) != 0)
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
 	Routine *PixelProcessor::routine(const State &state)
 	{
 		Routine *routine = routineCache->query(state);
 
 		if(!routine)
 		{
+			int64_t compileBegin = profiler.isTracing() ? Timer::counter() : 0;
 			const bool integerPipeline = (context->pixelShaderModel() <= 0x0104);
 			QuadRasterizer *generator = nullptr;
 
@@ -1201,10 +1348,15 @@ namespace sw
 			}
 
 			generator->generate();
-			routine = (*generator)(L"PixelRoutine_%0.8X", state.shaderID);
+			routine = (*generator)(L"PixelRoutine_%0.8X_%0.8X", state.shaderID, state.hash);
 			delete generator;
 
 			routineCache->add(state, routine);
+
+			if(profiler.isTracing())
+			{
+				profiler.trace("compile pixel routine", Profiler::TRACE_APPLICATION_THREAD, state.hash, compileBegin, Timer::counter());
+			}
 		}
 
 		return routine;
@@ -64,6 +64,7 @@ namespace sw
 			FogMode pixelFogMode                      : BITS(FOG_LAST);
 			bool specularAdd                          : 1;
 			bool occlusionEnabled                     : 1;
+			bool instrumented                         : 1;   // Gather the pixel counters and stage timings
 			bool wBasedFog                            : 1;
 			bool perspective                          : 1;
 			bool depthClamp                           : 1;
@@ -307,6 +308,7 @@ namespace sw
 	protected:
 		const State update() const;
 		Routine *routine(const State &state);
+		bool isSamplerModified(const State &state) const;   // Whether re-specified samplers differ from those the state was derived from
 		void setRoutineCacheSize(int routineCacheSize);
 
 		// Shader constants
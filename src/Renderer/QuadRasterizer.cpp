@@ -38,14 +38,21 @@ namespace sw
 
 	void QuadRasterizer::generate()
 	{
-		#if PERF_PROFILE
-			for(int i = 0; i < PERF_TIMERS; i++)
+		Long pixelTime;
+
+		if(state.instrumented)
+		{
+			for(int i = PERF_PIXEL; i < PERF_TIMERS; i++)
 			{
 				cycles[i] = 0;
 			}
 
-			Long pixelTime = Ticks();
-		#endif
+			pixelsShaded = 0;
+			quadsKilled = 0;
+			texelFetches = 0;
+
+			pixelTime = Ticks();
+		}
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
 		occlusion = 0;
@@ -78,14 +85,22 @@ namespace sw
 			*Pointer<UInt>(data + OFFSET(DrawData,occlusion) + 4 * cluster) = clusterOcclusion;
 		}
 
-		#if PERF_PROFILE
+		if(state.instrumented)
+		{
 			cycles[PERF_PIXEL] = Ticks() - pixelTime;
 
-			for(int i = 0; i < PERF_TIMERS; i++)
+			// The vertex and setup timers are accumulated by the worker threads instead
+			Pointer<Byte> statistics = data + OFFSET(DrawData,statistics) + (int)sizeof(DrawStatistics) * cluster;
+
+			for(int i = PERF_PIXEL; i < PERF_TIMERS; i++)
 			{
-				*Pointer<Long>(data + OFFSET(DrawData,cycles[i]) + 8 * cluster) += cycles[i];
+				*Pointer<Long>(statistics + OFFSET(DrawStatistics,ticks[i])) += cycles[i];
 			}
-		#endif
+
+			*Pointer<Long>(statistics + OFFSET(DrawStatistics,pixelsShaded)) += Long(pixelsShaded);
+			*Pointer<Long>(statistics + OFFSET(DrawStatistics,quadsKilled)) += Long(quadsKilled);
+			*Pointer<Long>(statistics + OFFSET(DrawStatistics,texelFetches)) += Long(texelFetches);
+		}
 
 		Return();
 	}
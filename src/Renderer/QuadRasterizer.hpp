@@ -40,9 +40,11 @@ namespace sw
 
 		UInt occlusion;
 
-#if PERF_PROFILE
+		// Only updated by instrumented routines
 		Long cycles[PERF_TIMERS];
-#endif
+		UInt pixelsShaded;
+		UInt quadsKilled;
+		UInt texelFetches;
 
 		virtual void quad(Pointer<Byte> cBuffer[4], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int cMask[4], Int &x, Int &y) = 0;
 
@@ -31,6 +31,10 @@
 #include "Common/Timer.hpp"
 #include "Common/Debug.hpp"
 
+#if defined(__i386__) || defined(__x86_64__)
+	#include <emmintrin.h>
+#endif
+
 #undef max
 
 bool disableServer = true;
@@ -96,7 +100,7 @@ namespace sw
 		int threadIndex;
 	};
 
-	Query::Query(Type type) : building(false), data(0), type(type), reference(1)
+	Query::Query(Type type) : building(false), data(0), type(type), reference(1), pendingDraws(0)
 	{
 	}
 
@@ -117,9 +121,33 @@ namespace sw
 		}
 	}
 
+	void Query::addDraw()
+	{
+		addRef();
+		++pendingDraws; // Atomic
+	}
+
+	void Query::retireDraw()
+	{
+		--pendingDraws; // Atomic
+
+		if(isReady())
+		{
+			ready.signal();   // Wakes up waiters once the result is known
+		}
+
+		release();
+	}
+
+	void Query::wait()
+	{
+		ready.wait();
+	}
+
 	DrawCall::DrawCall()
 	{
 		queries = 0;
+		condition = nullptr;
 
 		vsDirtyConstF = VERTEX_UNIFORM_VECTORS + 1;
 		vsDirtyConstI = 16;
@@ -155,9 +183,7 @@ namespace sw
 		updateProjectionMatrix = true;
 		updateClipPlanes = true;
 
-		#if PERF_HUD
-			resetTimers();
-		#endif
+		resetTimers();
 
 		for(int i = 0; i < 16; i++)
 		{
@@ -174,6 +200,9 @@ namespace sw
 		currentDraw = 0;
 		nextDraw = 0;
 
+		condition = nullptr;
+		conditionWait = false;
+
 		qHead = 0;
 		qSize = 0;
 
@@ -220,6 +249,12 @@ namespace sw
 		terminateThreads();
 		delete resumeApp;
 
+		// All draws have retired, so their statistics are complete
+		if(!statisticsFile.empty())
+		{
+			profiler.dumpStatistics(statisticsFile.c_str());
+		}
+
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
 			delete drawCall[draw];
@@ -249,10 +284,36 @@ namespace sw
 			}
 		#endif
 
+		if(condition && condition->isReady() && condition->data == 0)
+		{
+			return;   // Known to be discarded, no need to queue it
+		}
+
+		if((drawType & 0x0F) != (context->drawType & 0x0F))
+		{
+			context->dirtyStates |= DIRTY_PRIMITIVE_TYPE;
+		}
+
+		if((drawType & 0xF0) != (context->drawType & 0xF0))
+		{
+			context->dirtyStates |= DIRTY_INDEX_TYPE;
+		}
+
 		context->drawType = drawType;
 
+		if(context->occlusionEnabled && !isCountingOcclusion())
+		{
+			setOcclusionEnabled(false);   // Until the next query begins
+		}
+
+		if(profiler.isInstrumenting() != (vertexState.instrumented && pixelState.instrumented))
+		{
+			context->dirtyStates |= DIRTY_INSTRUMENTATION;
+		}
+
 		updateConfiguration();
 		updateClipper();
+		updateTransformAndLighting();
 
 		int ss = context->getSuperSampleCount();
 		int ms = context->getMultiSampleCount();
@@ -270,15 +331,57 @@ namespace sw
 
 			sync->lock(sw::PRIVATE);
 
+			if(oldMultiSampleMask != context->multiSampleMask)
+			{
+				context->dirtyStates |= DIRTY_MULTISAMPLE_MASK;
+			}
+
 			if(update || oldMultiSampleMask != context->multiSampleMask)
 			{
-				vertexState = VertexProcessor::update(drawType);
-				setupState = SetupProcessor::update();
-				pixelState = PixelProcessor::update();
+				unsigned int dirtyStates = context->dirtyStates;
+
+				if(context->vertexShader && context->pixelShader)
+				{
+					// Streams and samplers get specified anew before each draw, so check whether they actually changed
+					if((dirtyStates & DIRTY_VERTEX_INPUT) && !VertexProcessor::isInputModified(vertexState))
+					{
+						dirtyStates &= ~DIRTY_VERTEX_INPUT;
+					}
+
+					if((dirtyStates & DIRTY_VERTEX_SAMPLERS) && !VertexProcessor::isSamplerModified(vertexState))
+					{
+						dirtyStates &= ~DIRTY_VERTEX_SAMPLERS;
+					}
+
+					if((dirtyStates & DIRTY_PIXEL_SAMPLERS) && !PixelProcessor::isSamplerModified(pixelState))
+					{
+						dirtyStates &= ~DIRTY_PIXEL_SAMPLERS;
+					}
+				}
+				else if(dirtyStates)
+				{
+					dirtyStates = DIRTY_ALL;   // The fixed-function states depend on nearly all of the context
+				}
+
+				if(dirtyStates & VERTEX_DEPENDENCIES)
+				{
+					vertexState = VertexProcessor::update(drawType);
+					vertexRoutine = VertexProcessor::routine(vertexState);
+				}
+
+				if(dirtyStates & SETUP_DEPENDENCIES)
+				{
+					setupState = SetupProcessor::update();
+					setupRoutine = SetupProcessor::routine(setupState);
+				}
 
-				vertexRoutine = VertexProcessor::routine(vertexState);
-				setupRoutine = SetupProcessor::routine(setupState);
-				pixelRoutine = PixelProcessor::routine(pixelState);
+				if(dirtyStates & PIXEL_DEPENDENCIES)
+				{
+					pixelState = PixelProcessor::update();
+					pixelRoutine = PixelProcessor::routine(pixelState);
+				}
+
+				context->dirtyStates = 0;
 			}
 
 			int batch = batchSize / ms;
@@ -346,12 +449,21 @@ namespace sw
 				{
 					if(includePrimitivesWrittenQueries || (query->type != Query::TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN))
 					{
-						query->addRef();
+						query->addDraw();
 						draw->queries->push_back(query);
 					}
 				}
 			}
 
+			draw->condition = condition;
+			draw->conditionWait = conditionWait;
+			draw->discarded = false;
+
+			if(condition)
+			{
+				condition->addRef();
+			}
+
 			draw->drawType = drawType;
 			draw->batchSize = batch;
 
@@ -559,15 +671,12 @@ namespace sw
 				}
 			}
 
-			#if PERF_PROFILE
-				for(int cluster = 0; cluster < clusterCount; cluster++)
-				{
-					for(int i = 0; i < PERF_TIMERS; i++)
-					{
-						data->cycles[i][cluster] = 0;
-					}
-				}
-			#endif
+			draw->instrumented = vertexState.instrumented && pixelState.instrumented;
+
+			if(draw->instrumented)
+			{
+				memset(data->statistics, 0, sizeof(data->statistics));
+			}
 
 			// Viewport
 			{
@@ -619,6 +728,12 @@ namespace sw
 				data->halfPixelX = replicate(0.5f / W);
 				data->halfPixelY = replicate(0.5f / H);
 				data->viewportHeight = abs(viewport.height);
+
+				// Primitives are only clipped against the sides when they extend past the guard band. Within
+				// it, the products of 28.4 fixed-point coordinate deltas in SetupRoutine::edge() fit in 32 bits.
+				const float guardBand = 1024.0f;   // Pixels from the viewport center
+				data->guardBandX = max(guardBand / abs(W), 1.0f);
+				data->guardBandY = max(guardBand / abs(H), 1.0f);
 				data->slopeDepthBias = context->slopeDepthBias;
 				data->depthRange = Z;
 				data->depthNear = N;
@@ -646,6 +761,8 @@ namespace sw
 						unsigned int layer = context->renderTargetLayer[index];
 						requiresSync |= context->renderTarget[index]->requiresSync();
 						data->colorBuffer[index] = (unsigned int*)context->renderTarget[index]->lockInternal(0, 0, layer, LOCK_READWRITE, MANAGED);
+						blitter->attachResolveRoutine(context->renderTarget[index]);
+						context->renderTarget[index]->markSamplesDirty(scissor, layer);
 						data->colorBuffer[index] += q * ms * context->renderTarget[index]->getSliceB(true);
 						data->colorPitchB[index] = context->renderTarget[index]->getInternalPitchB();
 						data->colorSliceB[index] = context->renderTarget[index]->getInternalSliceB();
@@ -654,6 +771,9 @@ namespace sw
 
 				draw->depthBuffer = context->depthBuffer;
 				draw->stencilBuffer = context->stencilBuffer;
+				draw->depthWrite = context->depthWriteActive();
+				draw->hierarchicalDepth = false;
+				draw->depthIncrease = false;
 
 				if(draw->depthBuffer)
 				{
@@ -663,6 +783,23 @@ namespace sw
 					data->depthBuffer += q * ms * context->depthBuffer->getSliceB(true);
 					data->depthPitchB = context->depthBuffer->getInternalPitchB();
 					data->depthSliceB = context->depthBuffer->getInternalSliceB();
+					draw->depthLayer = layer;
+
+					if(context->depthBuffer->hasHiZ() && !complementaryDepthBuffer)
+					{
+						DepthCompareMode depthCompareMode = context->depthCompareMode;
+						bool lessCompare = (depthCompareMode == DEPTH_LESS || depthCompareMode == DEPTH_LESSEQUAL);
+						bool depthOverride = context->pixelShader && context->pixelShader->depthOverride();
+
+						// Pixels failing the depth test have no other effect when stencil is inactive
+						draw->hierarchicalDepth = context->depthBufferActive() && lessCompare && !depthOverride && !context->stencilActive() && ms == 1;
+
+						if(draw->depthWrite && !lessCompare && depthCompareMode != DEPTH_EQUAL && depthCompareMode != DEPTH_NEVER)
+						{
+							draw->depthIncrease = true;
+							context->depthBuffer->beginDepthIncrease();
+						}
+					}
 				}
 
 				if(draw->stencilBuffer)
@@ -678,10 +815,17 @@ namespace sw
 
 			// Scissor
 			{
-				data->scissorX0 = scissor.x0;
-				data->scissorX1 = scissor.x1;
-				data->scissorY0 = scissor.y0;
-				data->scissorY1 = scissor.y1;
+				// Primitives within the guard band are no longer clipped against the viewport's sides, so
+				// the scissor rectangle must not exceed the pixels whose centers lie within the viewport.
+				float viewportX0 = min(viewport.x0, viewport.x0 + viewport.width);
+				float viewportX1 = max(viewport.x0, viewport.x0 + viewport.width);
+				float viewportY0 = min(viewport.y0, viewport.y0 + viewport.height);
+				float viewportY1 = max(viewport.y0, viewport.y0 + viewport.height);
+
+				data->scissorX0 = max(scissor.x0, (int)ceil(viewportX0 - 0.5f));
+				data->scissorX1 = min(scissor.x1, (int)ceil(viewportX1 - 0.5f));
+				data->scissorY0 = max(scissor.y0, (int)ceil(viewportY0 - 0.5f));
+				data->scissorY1 = min(scissor.y1, (int)ceil(viewportY1 - 0.5f));
 			}
 
 			draw->primitive = 0;
@@ -738,6 +882,11 @@ namespace sw
 		blitter->blit3D(source, dest);
 	}
 
+	bool Renderer::downsample(Surface *const *source, Surface *const *dest, int count)
+	{
+		return blitter->downsample(source, dest, count);
+	}
+
 	void Renderer::threadFunction(void *parameters)
 	{
 		Renderer *renderer = static_cast<Parameters*>(parameters)->renderer;
@@ -831,6 +980,11 @@ namespace sw
 				draw = drawList[currentDraw & DRAW_COUNT_BITS];
 			}
 
+			if(draw->condition && draw->primitive == 0 && !resolveCondition(draw))
+			{
+				return;   // Retried once earlier draws retired
+			}
+
 			if(!primitiveProgress[unit].references)   // Task not already being executed and not still in use by a pixel unit
 			{
 				primitive = draw->primitive;
@@ -902,9 +1056,9 @@ namespace sw
 
 	void Renderer::executeTask(int threadIndex)
 	{
-		#if PERF_HUD
-			int64_t startTick = Timer::ticks();
-		#endif
+		int64_t startTick = Timer::ticks();
+		bool tracing = profiler.isTracing();
+		int64_t traceBegin = tracing ? Timer::counter() : 0;
 
 		switch(task[threadIndex].type)
 		{
@@ -914,42 +1068,59 @@ namespace sw
 
 				int input = primitiveProgress[unit].firstPrimitive;
 				int count = primitiveProgress[unit].primitiveCount;
-				DrawCall *draw = drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
+				int drawCall = primitiveProgress[unit].drawCall;
+				DrawCall *draw = drawList[drawCall & DRAW_COUNT_BITS];
 				int (Renderer::*setupPrimitives)(int batch, int count) = draw->setupPrimitives;
 
-				processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
+				if(!draw->discarded)
+				{
+					processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
+				}
 
-				#if PERF_HUD
-					int64_t time = Timer::ticks();
-					vertexTime[threadIndex] += time - startTick;
-					startTick = time;
-				#endif
+				int64_t vertexTick = draw->instrumented ? Timer::ticks() : 0;
 
 				int visible = 0;
 
-				if(!draw->setupState.rasterizerDiscard)
+				if(!draw->setupState.rasterizerDiscard && !draw->discarded)
 				{
 					visible = (this->*setupPrimitives)(unit, count);
 				}
 
+				if(draw->instrumented)
+				{
+					int64_t setupTick = Timer::ticks();
+					DrawStatistics &statistics = draw->data->statistics[threadIndex];
+
+					statistics.primitivesIn += draw->discarded ? 0 : count;
+					statistics.primitivesOut += visible;
+					statistics.ticks[PERF_VERTEX] += vertexTick - startTick;
+					statistics.ticks[PERF_SETUP] += setupTick - vertexTick;
+
+					vertexTime[threadIndex] += vertexTick - startTick;
+					setupTime[threadIndex] += setupTick - vertexTick;
+				}
+
 				primitiveProgress[unit].visible = visible;
 				primitiveProgress[unit].references = clusterCount;
 
-				#if PERF_HUD
-					setupTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
+				if(tracing)
+				{
+					profiler.trace("primitives", threadIndex, drawCall, traceBegin, Timer::counter());
+				}
 			}
 			break;
 		case Task::PIXELS:
 			{
 				int unit = task[threadIndex].primitiveUnit;
 				int visible = primitiveProgress[unit].visible;
+				int cluster = task[threadIndex].pixelCluster;
+				int drawCall = pixelProgress[cluster].drawCall;
+				DrawCall *draw = drawList[drawCall & DRAW_COUNT_BITS];
+				bool instrumented = draw->instrumented;   // The draw call may retire below
 
 				if(visible > 0)
 				{
-					int cluster = task[threadIndex].pixelCluster;
 					Primitive *primitive = primitiveBatch[unit];
-					DrawCall *draw = drawList[pixelProgress[cluster].drawCall & DRAW_COUNT_BITS];
 					DrawData *data = draw->data;
 					PixelProcessor::RoutinePointer pixelRoutine = draw->pixelPointer;
 
@@ -958,9 +1129,15 @@ namespace sw
 
 				finishRendering(task[threadIndex]);
 
-				#if PERF_HUD
+				if(instrumented)
+				{
 					pixelTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
+				}
+
+				if(tracing)
+				{
+					profiler.trace("pixels", threadIndex, drawCall, traceBegin, Timer::counter());
+				}
 			}
 			break;
 		case Task::RESUME:
@@ -1005,15 +1182,17 @@ namespace sw
 
 			if(ref == 0)
 			{
-				#if PERF_PROFILE
-					for(int cluster = 0; cluster < clusterCount; cluster++)
+				if(draw.instrumented)
+				{
+					DrawStatistics statistics = data.statistics[0];
+
+					for(int i = 1; i < 16; i++)
 					{
-						for(int i = 0; i < PERF_TIMERS; i++)
-						{
-							profiler.cycles[i] += data.cycles[i][cluster];
-						}
+						statistics.accumulate(data.statistics[i]);
 					}
-				#endif
+
+					profiler.record(statistics);
+				}
 
 				if(draw.queries)
 				{
@@ -1022,25 +1201,32 @@ namespace sw
 						switch(query->type)
 						{
 						case Query::FRAGMENTS_PASSED:
+						case Query::ANY_FRAGMENTS_PASSED:
 							for(int cluster = 0; cluster < clusterCount; cluster++)
 							{
 								query->data += data.occlusion[cluster];
 							}
 							break;
 						case Query::TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN:
-							query->data += processedPrimitives;
+							query->data += draw.discarded ? 0 : processedPrimitives;
 							break;
 						default:
 							break;
 						}
 
-						query->release();
+						query->retireDraw();
 					}
 
 					delete draw.queries;
 					draw.queries = 0;
 				}
 
+				if(draw.condition)
+				{
+					draw.condition->release();
+					draw.condition = nullptr;
+				}
+
 				for(int i = 0; i < RENDERTARGETS; i++)
 				{
 					if(draw.renderTarget[i])
@@ -1051,6 +1237,11 @@ namespace sw
 
 				if(draw.depthBuffer)
 				{
+					if(draw.depthIncrease)
+					{
+						draw.depthBuffer->endDepthIncrease();
+					}
+
 					draw.depthBuffer->unlockInternal();
 				}
 
@@ -1559,11 +1750,172 @@ namespace sw
 		task->primitiveStart = start;
 		task->vertexCount = triangleCount * 3;
 		vertexRoutine(&triangle->v0, (unsigned int*)&batch, task, data);
+
+		if(draw->instrumented)
+		{
+			DrawStatistics &statistics = data->statistics[thread];
+
+			statistics.vertexCacheHits += task->vertexCount - task->cacheMisses;
+			statistics.vertexCacheMisses += task->cacheMisses;
+		}
+	}
+
+	int Renderer::cullTriangles(const Triangle *triangle, int count, const DrawCall &draw, unsigned char *survivors)
+	{
+		// Performs the trivial rejection, and the setup routine's area and culling tests, ahead of
+		// clipping and setup. Triangles which don't need clipping are also rejected when they cover
+		// no pixel centers, or none within the scissor rectangle.
+		const SetupProcessor::State &state = draw.setupState;
+		const DrawData &data = *draw.data;
+
+		const int pos = state.positionRegister;
+		const int ms = state.multiSample;
+		const CullMode cullMode = state.cullMode;
+		const int yMinBias = (ms > 1) ? 0x0A : 0x0F;
+		const int yMaxBias = (ms > 1) ? 0x14 : 0x0F;
+
+		int surviving = 0;
+		int i = 0;
+
+		#if defined(__i386__) || defined(__x86_64__)
+			if(CPUID::supportsSSE2())
+			{
+				const __m128i finite = _mm_set1_epi32(Clipper::CLIP_FINITE);
+				const __m128i unclipped = _mm_set1_epi32(Clipper::CLIP_FINITE | draw.clipFlags);
+				const __m128i scissorX0 = _mm_set1_epi32(data.scissorX0);
+				const __m128i scissorX1 = _mm_set1_epi32(data.scissorX1);
+				const __m128i scissorY0 = _mm_set1_epi32(data.scissorY0);
+				const __m128i scissorY1 = _mm_set1_epi32(data.scissorY1);
+				const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+				const __m128 zero = _mm_setzero_ps();
+
+				// SSE2 lacks signed 32-bit integer minimum and maximum
+				auto min4 = [](__m128i a, __m128i b) { __m128i lt = _mm_cmplt_epi32(a, b); return _mm_or_si128(_mm_and_si128(lt, a), _mm_andnot_si128(lt, b)); };
+				auto max4 = [](__m128i a, __m128i b) { __m128i gt = _mm_cmpgt_epi32(a, b); return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b)); };
+
+				for(; i + 4 <= count; i += 4)
+				{
+					const Triangle *t = triangle + i;
+
+					#define GATHER(vertex, field) _mm_setr_epi32(t[0].vertex.field, t[1].vertex.field, t[2].vertex.field, t[3].vertex.field)
+					__m128i C0 = GATHER(v0, clipFlags);
+					__m128i C1 = GATHER(v1, clipFlags);
+					__m128i C2 = GATHER(v2, clipFlags);
+					__m128i X0 = GATHER(v0, X);
+					__m128i X1 = GATHER(v1, X);
+					__m128i X2 = GATHER(v2, X);
+					__m128i Y0 = GATHER(v0, Y);
+					__m128i Y1 = GATHER(v1, Y);
+					__m128i Y2 = GATHER(v2, Y);
+					__m128 W = _mm_castsi128_ps(_mm_xor_si128(_mm_xor_si128(
+						_mm_setr_epi32((const int&)t[0].v0.v[pos].w, (const int&)t[1].v0.v[pos].w, (const int&)t[2].v0.v[pos].w, (const int&)t[3].v0.v[pos].w),
+						_mm_setr_epi32((const int&)t[0].v1.v[pos].w, (const int&)t[1].v1.v[pos].w, (const int&)t[2].v1.v[pos].w, (const int&)t[3].v1.v[pos].w)),
+						_mm_setr_epi32((const int&)t[0].v2.v[pos].w, (const int&)t[1].v2.v[pos].w, (const int&)t[2].v2.v[pos].w, (const int&)t[3].v2.v[pos].w)));
+					#undef GATHER
+
+					// Outside the same frustum plane, or not finite
+					__m128i keep = _mm_cmpeq_epi32(_mm_and_si128(_mm_and_si128(C0, C1), C2), finite);
+
+					// Evaluated in the same order as the setup routine, for identical results
+					__m128 x0 = _mm_cvtepi32_ps(X0);
+					__m128 x1 = _mm_cvtepi32_ps(X1);
+					__m128 x2 = _mm_cvtepi32_ps(X2);
+					__m128 y0 = _mm_cvtepi32_ps(Y0);
+					__m128 y1 = _mm_cvtepi32_ps(Y1);
+					__m128 y2 = _mm_cvtepi32_ps(Y2);
+					__m128 A = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(y2, y0), x1), _mm_mul_ps(_mm_sub_ps(y1, y2), x0)), _mm_mul_ps(_mm_sub_ps(y0, y1), x2));
+					A = _mm_xor_ps(A, _mm_and_ps(W, signMask));
+
+					__m128 facing = _mm_cmpneq_ps(A, zero);
+					if(cullMode == CULL_CLOCKWISE) facing = _mm_and_ps(facing, _mm_cmpnge_ps(A, zero));
+					if(cullMode == CULL_COUNTERCLOCKWISE) facing = _mm_and_ps(facing, _mm_cmpnle_ps(A, zero));
+					keep = _mm_and_si128(keep, _mm_castps_si128(facing));
+
+					// Rows, and for single-sampling columns, of pixel centers within the scissor rectangle
+					__m128i yMin = max4(_mm_srai_epi32(_mm_add_epi32(min4(min4(Y0, Y1), Y2), _mm_set1_epi32(yMinBias)), 4), scissorY0);
+					__m128i yMax = min4(_mm_srai_epi32(_mm_add_epi32(max4(max4(Y0, Y1), Y2), _mm_set1_epi32(yMaxBias)), 4), scissorY1);
+					__m128i covered = _mm_cmplt_epi32(yMin, yMax);
+
+					if(ms == 1)
+					{
+						__m128i xMin = max4(_mm_srai_epi32(_mm_add_epi32(min4(min4(X0, X1), X2), _mm_set1_epi32(0x0F)), 4), scissorX0);
+						__m128i xMax = min4(_mm_srai_epi32(_mm_add_epi32(max4(max4(X0, X1), X2), _mm_set1_epi32(0x0F)), 4), scissorX1);
+						covered = _mm_and_si128(covered, _mm_cmplt_epi32(xMin, xMax));
+					}
+
+					__m128i clipped = _mm_xor_si128(_mm_cmpeq_epi32(_mm_or_si128(_mm_or_si128(_mm_or_si128(C0, C1), C2), unclipped), unclipped), _mm_set1_epi32(-1));
+					keep = _mm_and_si128(keep, _mm_or_si128(covered, clipped));
+
+					int mask = _mm_movemask_ps(_mm_castsi128_ps(keep));
+
+					for(int lane = 0; lane < 4; lane++)
+					{
+						if(mask & (1 << lane))
+						{
+							survivors[surviving++] = i + lane;
+						}
+					}
+				}
+			}
+		#endif
+
+		for(; i < count; i++)
+		{
+			const Vertex &v0 = triangle[i].v0;
+			const Vertex &v1 = triangle[i].v1;
+			const Vertex &v2 = triangle[i].v2;
+
+			if((v0.clipFlags & v1.clipFlags & v2.clipFlags) != Clipper::CLIP_FINITE)
+			{
+				continue;
+			}
+
+			float x0 = (float)v0.X;
+			float x1 = (float)v1.X;
+			float x2 = (float)v2.X;
+			float y0 = (float)v0.Y;
+			float y1 = (float)v1.Y;
+			float y2 = (float)v2.Y;
+
+			// Each product is rounded on its own, like in the setup routine. A single expression
+			// would allow the compiler to contract it into fused multiply-adds.
+			float A01 = (y2 - y0) * x1;
+			float A12 = (y1 - y2) * x0;
+			float A20 = (y0 - y1) * x2;
+			float A = A01 + A12;
+			A = A + A20;
+
+			if(((const int&)v0.v[pos].w ^ (const int&)v1.v[pos].w ^ (const int&)v2.v[pos].w) < 0)
+			{
+				A = -A;
+			}
+
+			if(A == 0.0f || (cullMode == CULL_CLOCKWISE && A >= 0.0f) || (cullMode == CULL_COUNTERCLOCKWISE && A <= 0.0f))
+			{
+				continue;
+			}
+
+			if((v0.clipFlags | v1.clipFlags | v2.clipFlags | draw.clipFlags) == Clipper::CLIP_FINITE)
+			{
+				int yMin = max((min(min(v0.Y, v1.Y), v2.Y) + yMinBias) >> 4, data.scissorY0);
+				int yMax = min((max(max(v0.Y, v1.Y), v2.Y) + yMaxBias) >> 4, data.scissorY1);
+				int xMin = max((min(min(v0.X, v1.X), v2.X) + 0x0F) >> 4, data.scissorX0);
+				int xMax = min((max(max(v0.X, v1.X), v2.X) + 0x0F) >> 4, data.scissorX1);
+
+				if(yMin >= yMax || (ms == 1 && xMin >= xMax))
+				{
+					continue;
+				}
+			}
+
+			survivors[surviving++] = i;
+		}
+
+		return surviving;
 	}
 
 	int Renderer::setupSolidTriangles(int unit, int count)
 	{
-		Triangle *triangle = triangleBatch[unit];
 		Primitive *primitive = primitiveBatch[unit];
 
 		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
@@ -1575,31 +1927,38 @@ namespace sw
 		const DrawData *data = draw.data;
 		int visible = 0;
 
-		for(int i = 0; i < count; i++, triangle++)
+		unsigned char survivors[batchSize];
+		int surviving = cullTriangles(triangleBatch[unit], count, draw, survivors);
+
+		for(int i = 0; i < surviving; i++)
 		{
+			Triangle *triangle = &triangleBatch[unit][survivors[i]];
+
 			Vertex &v0 = triangle->v0;
 			Vertex &v1 = triangle->v1;
 			Vertex &v2 = triangle->v2;
 
-			if((v0.clipFlags & v1.clipFlags & v2.clipFlags) == Clipper::CLIP_FINITE)
-			{
-				Polygon polygon(&v0.v[pos], &v1.v[pos], &v2.v[pos]);
+			Polygon polygon(&v0.v[pos], &v1.v[pos], &v2.v[pos]);
 
-				int clipFlagsOr = v0.clipFlags | v1.clipFlags | v2.clipFlags | draw.clipFlags;
+			int clipFlagsOr = v0.clipFlags | v1.clipFlags | v2.clipFlags | draw.clipFlags;
 
-				if(clipFlagsOr != Clipper::CLIP_FINITE)
+			if(clipFlagsOr != Clipper::CLIP_FINITE)
+			{
+				if(!clipper->clip(polygon, clipFlagsOr, draw))
 				{
-					if(!clipper->clip(polygon, clipFlagsOr, draw))
-					{
-						continue;
-					}
+					continue;
 				}
+			}
 
-				if(setupRoutine(primitive, triangle, &polygon, data))
+			if(setupRoutine(primitive, triangle, &polygon, data))
+			{
+				if(draw.hierarchicalDepth && !hierarchicalDepthTest(*primitive, draw))
 				{
-					primitive += ms;
-					visible++;
+					continue;
 				}
+
+				primitive += ms;
+				visible++;
 			}
 		}
 
@@ -1757,6 +2116,105 @@ namespace sw
 		return visible;
 	}
 
+	bool Renderer::hierarchicalDepthTest(Primitive &primitive, const DrawCall &draw)
+	{
+		Surface *depthBuffer = draw.depthBuffer;
+		const int tileSize = Surface::HIZ_TILE_SIZE;
+		const int layer = draw.depthLayer;
+
+		if(!depthBuffer->isHiZValid() || primitive.yMin >= primitive.yMax)
+		{
+			return true;
+		}
+
+		// The rasterizer evaluates z = C + A * (x + xQuad) + B * (y + yQuad) at pixel coordinates. Bounds derived
+		// from the plane equation are lowered by a margin well above the rounding error of that evaluation.
+		const float A = primitive.z.A[0];
+		const float B = primitive.z.B[0];
+		const float C = primitive.z.C[0];
+		const float xQuad = primitive.xQuad[0];
+		const float yQuad = primitive.yQuad[0];
+		const float margin = (abs(C) + abs(A) * (depthBuffer->getWidth() + abs(xQuad)) + abs(B) * (depthBuffer->getHeight() + abs(yQuad))) * (1.0f / (1 << 20));
+
+		int visibleY0 = primitive.yMax;
+		int visibleY1 = primitive.yMin;
+
+		for(int tileY = primitive.yMin / tileSize; tileY * tileSize < primitive.yMax; tileY++)
+		{
+			int y0 = max(tileY * tileSize, primitive.yMin);
+			int y1 = min((tileY + 1) * tileSize, primitive.yMax);
+
+			int left = primitive.outline[y0].left;
+			int right = primitive.outline[y0].right;
+
+			for(int y = y0 + 1; y < y1; y++)
+			{
+				left = min(left, (int)primitive.outline[y].left);
+				right = max(right, (int)primitive.outline[y].right);
+			}
+
+			if(left >= right)
+			{
+				continue;
+			}
+
+			float zy = C + min(B * (y0 + yQuad), B * (y1 - 1 + yQuad)) - margin;
+
+			// Find the first and last tiles which the primitive isn't entirely behind
+			int tileX0 = left / tileSize;
+			int tileX1 = (right - 1) / tileSize;
+
+			for(; tileX0 <= tileX1; tileX0++)
+			{
+				int x0 = max(tileX0 * tileSize, left);
+				int x1 = min((tileX0 + 1) * tileSize, right);
+				float zMin = min(zy + min(A * (x0 + xQuad), A * (x1 - 1 + xQuad)), 1.0f);   // Depth may be clamped
+
+				if(!(zMin > depthBuffer->getHiZ(tileX0, tileY, layer))) break;
+			}
+
+			for(; tileX1 > tileX0; tileX1--)
+			{
+				int x0 = max(tileX1 * tileSize, left);
+				int x1 = min((tileX1 + 1) * tileSize, right);
+				float zMin = min(zy + min(A * (x0 + xQuad), A * (x1 - 1 + xQuad)), 1.0f);
+
+				if(!(zMin > depthBuffer->getHiZ(tileX1, tileY, layer))) break;
+			}
+
+			// Trim the spans to the remaining tiles, which leaves them empty if there are none
+			int clampX0 = (tileX0 <= tileX1) ? max(tileX0 * tileSize, left) : 0;
+			int clampX1 = (tileX0 <= tileX1) ? min((tileX1 + 1) * tileSize, right) : 0;
+
+			for(int y = y0; y < y1; y++)
+			{
+				primitive.outline[y].left = clamp((int)primitive.outline[y].left, clampX0, clampX1);
+				primitive.outline[y].right = clamp((int)primitive.outline[y].right, clampX0, clampX1);
+			}
+
+			if(tileX0 <= tileX1)
+			{
+				visibleY0 = min(visibleY0, y0);
+				visibleY1 = max(visibleY1, y1);
+
+				if(draw.depthWrite)
+				{
+					depthBuffer->markHiZStale(tileX0, tileX1, tileY, layer);
+				}
+			}
+		}
+
+		if(visibleY0 >= visibleY1)
+		{
+			return false;
+		}
+
+		primitive.yMin = visibleY0;
+		primitive.yMax = visibleY1;
+
+		return true;
+	}
+
 	bool Renderer::setupLine(Primitive &primitive, Triangle &triangle, const DrawCall &draw)
 	{
 		const SetupProcessor::RoutinePointer &setupRoutine = draw.setupPointer;
@@ -2201,7 +2659,11 @@ namespace sw
 
 	void Renderer::setTransparencyAntialiasing(TransparencyAntialiasing transparencyAntialiasing)
 	{
-		sw::transparencyAntialiasing = transparencyAntialiasing;
+		if(sw::transparencyAntialiasing != transparencyAntialiasing)
+		{
+			sw::transparencyAntialiasing = transparencyAntialiasing;
+			context->dirtyStates |= DIRTY_OUTPUT_MERGER;
+		}
 	}
 
 	bool Renderer::isReadWriteTexture(int sampler)
@@ -2263,6 +2725,7 @@ namespace sw
 		ASSERT(sampler < TOTAL_IMAGE_UNITS && face < 6 && level < MIPMAP_LEVELS);
 
 		context->sampler[sampler].setTextureLevel(face, level, surface, type);
+		context->dirtyStates |= (sampler < TEXTURE_IMAGE_UNITS) ? DIRTY_PIXEL_SAMPLERS : DIRTY_VERTEX_SAMPLERS;
 	}
 
 	void Renderer::setTextureFilter(SamplerType type, int sampler, FilterType textureFilter)
@@ -2520,11 +2983,13 @@ namespace sw
 	void Renderer::setPointSpriteEnable(bool pointSpriteEnable)
 	{
 		context->setPointSpriteEnable(pointSpriteEnable);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void Renderer::setPointScaleEnable(bool pointScaleEnable)
 	{
 		context->setPointScaleEnable(pointScaleEnable);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void Renderer::setLineWidth(float width)
@@ -2535,20 +3000,32 @@ namespace sw
 	void Renderer::setDepthBias(float bias)
 	{
 		context->depthBias = bias;
+		context->dirtyStates |= DIRTY_RASTERIZER;
 	}
 
 	void Renderer::setSlopeDepthBias(float slopeBias)
 	{
 		context->slopeDepthBias = slopeBias;
+		context->dirtyStates |= DIRTY_RASTERIZER;
 	}
 
 	void Renderer::setRasterizerDiscard(bool rasterizerDiscard)
 	{
-		context->rasterizerDiscard = rasterizerDiscard;
+		if(context->rasterizerDiscard != rasterizerDiscard)
+		{
+			context->rasterizerDiscard = rasterizerDiscard;
+			context->dirtyStates |= DIRTY_RASTERIZER;
+		}
 	}
 
 	void Renderer::setPixelShader(const PixelShader *shader)
 	{
+		// Serial IDs identify shaders even when a deleted one's address gets reused
+		if((shader ? shader->getSerialID() : 0) != pixelState.shaderID)
+		{
+			context->dirtyStates |= DIRTY_SHADERS;
+		}
+
 		context->pixelShader = shader;
 
 		loadConstants(shader);
@@ -2556,6 +3033,11 @@ namespace sw
 
 	void Renderer::setVertexShader(const VertexShader *shader)
 	{
+		if(static_cast<uint64_t>(shader ? shader->getSerialID() : 0) != vertexState.shaderID)
+		{
+			context->dirtyStates |= DIRTY_SHADERS;
+		}
+
 		context->vertexShader = shader;
 
 		loadConstants(shader);
@@ -2696,37 +3178,78 @@ namespace sw
 		queries.remove(query);
 	}
 
-	#if PERF_HUD
-		int Renderer::getThreadCount()
-		{
-			return threadCount;
-		}
+	void Renderer::setCondition(Query *query, bool wait)
+	{
+		condition = query;
+		conditionWait = wait;
+	}
 
-		int64_t Renderer::getVertexTime(int thread)
+	bool Renderer::resolveCondition(DrawCall *draw)
+	{
+		if(draw->discarded)
 		{
-			return vertexTime[thread];
+			return true;
 		}
 
-		int64_t Renderer::getSetupTime(int thread)
+		if(!draw->condition->isReady())
 		{
-			return setupTime[thread];
+			return !draw->conditionWait;   // Otherwise rendered as if the condition passed
 		}
 
-		int64_t Renderer::getPixelTime(int thread)
+		if(draw->condition->data == 0)
 		{
-			return pixelTime[thread];
+			// A single empty batch retires the draw, in order with the ones around it
+			draw->discarded = true;
+			draw->count = 1;
+			draw->references = 1;
 		}
 
-		void Renderer::resetTimers()
+		return true;
+	}
+
+	bool Renderer::isCountingOcclusion() const
+	{
+		for(auto &query : queries)
 		{
-			for(int thread = 0; thread < threadCount; thread++)
+			// Boolean queries can stop counting once a sample of an earlier draw passed
+			if(query->type == Query::FRAGMENTS_PASSED || (query->type == Query::ANY_FRAGMENTS_PASSED && query->data == 0))
 			{
-				vertexTime[thread] = 0;
-				setupTime[thread] = 0;
-				pixelTime[thread] = 0;
+				return true;
 			}
 		}
-	#endif
+
+		return false;
+	}
+
+	int Renderer::getThreadCount()
+	{
+		return threadCount;
+	}
+
+	int64_t Renderer::getVertexTime(int thread)
+	{
+		return vertexTime[thread];
+	}
+
+	int64_t Renderer::getSetupTime(int thread)
+	{
+		return setupTime[thread];
+	}
+
+	int64_t Renderer::getPixelTime(int thread)
+	{
+		return pixelTime[thread];
+	}
+
+	void Renderer::resetTimers()
+	{
+		for(int thread = 0; thread < 16; thread++)
+		{
+			vertexTime[thread] = 0;
+			setupTime[thread] = 0;
+			pixelTime[thread] = 0;
+		}
+	}
 
 	void Renderer::setViewport(const Viewport &viewport)
 	{
@@ -2772,6 +3295,7 @@ namespace sw
 			VertexProcessor::setRoutineCacheSize(configuration.vertexRoutineCacheSize);
 			PixelProcessor::setRoutineCacheSize(configuration.pixelRoutineCacheSize);
 			SetupProcessor::setRoutineCacheSize(configuration.setupRoutineCacheSize);
+			context->dirtyStates = DIRTY_ALL;   // The routines need to be looked up in the new caches
 
 			switch(configuration.textureSampleQuality)
 			{
@@ -2861,6 +3385,24 @@ namespace sw
 			exactColorRounding = configuration.exactColorRounding;
 			forceClearRegisters = configuration.forceClearRegisters;
 
+			statisticsFile = configuration.statisticsFile;
+
+			// Don't override profiling enabled through the API when another renderer starts up
+			if(configuration.instrumentation || newConfiguration)
+			{
+				profiler.setInstrumentation(configuration.instrumentation);
+			}
+
+			if(configuration.tracing || newConfiguration)
+			{
+				profiler.setTracing(configuration.tracing);
+			}
+
+			if(configuration.perfMap || newConfiguration)
+			{
+				perfMap = configuration.perfMap;
+			}
+
 		#ifndef NDEBUG
 			minPrimitives = configuration.minPrimitives;
 			maxPrimitives = configuration.maxPrimitives;
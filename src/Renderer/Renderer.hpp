@@ -87,13 +87,17 @@ namespace sw
 
 	struct Query
 	{
-		enum Type { FRAGMENTS_PASSED, TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN };
+		enum Type { FRAGMENTS_PASSED, ANY_FRAGMENTS_PASSED, TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN };
 
 		Query(Type type);
 
 		void addRef();
 		void release();
 
+		// Draws contributing to the result also hold a reference until they retired
+		void addDraw();
+		void retireDraw();
+
 		inline void begin()
 		{
 			building = true;
@@ -105,11 +109,20 @@ namespace sw
 			building = false;
 		}
 
+		// The result is final once the draws using the query retired, or as soon as any of them
+		// had a sample pass for queries which only report whether one did
 		inline bool isReady() const
 		{
-			return (reference == 1);
+			return (pendingDraws == 0) || (type == ANY_FRAGMENTS_PASSED && data != 0);
+		}
+
+		inline bool isShared() const
+		{
+			return (reference > 1);
 		}
 
+		void wait();   // Blocks until the query may have become ready
+
 		bool building;
 		AtomicInt data;
 
@@ -118,6 +131,8 @@ namespace sw
 		~Query() {} // Only delete a query within the release() function
 
 		AtomicInt reference;
+		AtomicInt pendingDraws;
+		Event ready;
 	};
 
 	struct DrawData
@@ -170,9 +185,8 @@ namespace sw
 		PixelProcessor::Factor factor;
 		unsigned int occlusion[16];   // Number of pixels passing depth test
 
-		#if PERF_PROFILE
-			int64_t cycles[PERF_TIMERS][16];
-		#endif
+		// Pixel counters are gathered per cluster, the others per thread
+		DrawStatistics statistics[16];
 
 		TextureStage::Uniforms textureStage[8];
 
@@ -185,6 +199,8 @@ namespace sw
 		float4 halfPixelX;
 		float4 halfPixelY;
 		float viewportHeight;
+		float guardBandX;   // Guard band extent relative to the viewport
+		float guardBandY;
 		float slopeDepthBias;
 		float depthRange;
 		float depthNear;
@@ -284,6 +300,7 @@ namespace sw
 		void clear(void *value, Format format, Surface *dest, const Rect &rect, unsigned int rgbaMask);
 		void blit(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil = false, bool sRGBconversion = true);
 		void blit3D(Surface *source, Surface *dest);
+		bool downsample(Surface *const *source, Surface *const *dest, int count);
 
 		void setIndexBuffer(Resource *indexBuffer);
 
@@ -351,16 +368,17 @@ namespace sw
 		void addQuery(Query *query);
 		void removeQuery(Query *query);
 
+		// Draws are discarded by the worker threads when no samples passed for the condition's query
+		void setCondition(Query *query, bool wait);
+
 		void synchronize();
 
-		#if PERF_HUD
-			// Performance timers
-			int getThreadCount();
-			int64_t getVertexTime(int thread);
-			int64_t getSetupTime(int thread);
-			int64_t getPixelTime(int thread);
-			void resetTimers();
-		#endif
+		// Performance timers, running while instrumentation is enabled
+		int getThreadCount();
+		int64_t getVertexTime(int thread);
+		int64_t getSetupTime(int thread);
+		int64_t getPixelTime(int thread);
+		void resetTimers();
 
 		static int getClusterCount() { return clusterCount; }
 
@@ -375,6 +393,7 @@ namespace sw
 
 		void processPrimitiveVertices(int unit, unsigned int start, unsigned int count, unsigned int loop, int thread);
 
+		int cullTriangles(const Triangle *triangle, int count, const DrawCall &draw, unsigned char *survivors);
 		int setupSolidTriangles(int batch, int count);
 		int setupWireframeTriangle(int batch, int count);
 		int setupVertexTriangle(int batch, int count);
@@ -382,9 +401,12 @@ namespace sw
 		int setupPoints(int batch, int count);
 
 		bool setupLine(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
+		bool hierarchicalDepthTest(Primitive &primitive, const DrawCall &draw);
 		bool setupPoint(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
 
 		bool isReadWriteTexture(int sampler);
+		bool isCountingOcclusion() const;
+		bool resolveCondition(DrawCall *draw);
 		void updateClipper();
 		void updateConfiguration(bool initialUpdate = false);
 		void initializeThreads();
@@ -442,17 +464,18 @@ namespace sw
 
 		MutexLock schedulerMutex;
 
-		#if PERF_HUD
-			int64_t vertexTime[16];
-			int64_t setupTime[16];
-			int64_t pixelTime[16];
-		#endif
+		int64_t vertexTime[16];
+		int64_t setupTime[16];
+		int64_t pixelTime[16];
 
 		VertexTask *vertexTask[16];
 
 		SwiftConfig *swiftConfig;
+		std::string statisticsFile;
 
 		std::list<Query*> queries;
+		Query *condition;
+		bool conditionWait;
 		Resource *sync;
 
 		VertexProcessor::State vertexState;
@@ -490,6 +513,11 @@ namespace sw
 		Surface *depthBuffer;
 		Surface *stencilBuffer;
 		Resource *texture[TOTAL_IMAGE_UNITS];
+
+		unsigned int depthLayer;
+		bool depthWrite;
+		bool hierarchicalDepth;   // Primitives are tested against the depth buffer's tile bounds
+		bool depthIncrease;       // May raise depth values, which invalidates the tile bounds
 		Resource* pUniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
 		Resource* vUniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
 		Resource* transformFeedbackBuffers[MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS];
@@ -503,6 +531,10 @@ namespace sw
 		unsigned int psDirtyConstB;
 
 		std::list<Query*> *queries;
+		Query *condition;      // Only rendered if a sample passed for this query
+		bool conditionWait;    // Held back until the condition's result is known
+		bool discarded;
+		bool instrumented;
 
 		AtomicInt clipFlags;
 
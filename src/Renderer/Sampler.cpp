@@ -52,6 +52,7 @@ namespace sw
 		externalTextureFormat = FORMAT_NULL;
 		internalTextureFormat = FORMAT_NULL;
 		textureType = TEXTURE_NULL;
+		compressedSampling = false;
 
 		textureFilter = FILTER_LINEAR;
 		addressingModeU = ADDRESSING_WRAP;
@@ -103,10 +104,7 @@ namespace sw
 			state.swizzleA = swizzleA;
 			state.highPrecisionFiltering = highPrecisionFiltering;
 			state.compare = getCompareFunc();
-
-			#if PERF_PROFILE
-				state.compressedFormat = Surface::isCompressed(externalTextureFormat);
-			#endif
+			state.compressedFormat = compressedSampling ? externalTextureFormat : FORMAT_NULL;
 		}
 
 		return state;
@@ -117,20 +115,33 @@ namespace sw
 		if(surface)
 		{
 			Mipmap &mipmap = texture.mipmap[level];
+			bool compressed = isDirectlySampled(surface);
 
-			border = surface->getBorder();
-			mipmap.buffer[face] = surface->lockInternal(-border, -border, 0, LOCK_UNLOCKED, PRIVATE);
+			if(compressed)
+			{
+				// Sample the compressed blocks, so the decoded internal buffer never gets allocated
+				border = 0;
+				mipmap.buffer[face] = surface->lockExternal(0, 0, 0, LOCK_UNLOCKED, PRIVATE);
+			}
+			else
+			{
+				border = surface->getBorder();
+				mipmap.buffer[face] = surface->lockInternal(-border, -border, 0, LOCK_UNLOCKED, PRIVATE);
+			}
 
 			if(face == 0)
 			{
 				externalTextureFormat = surface->getExternalFormat();
 				internalTextureFormat = surface->getInternalFormat();
+				compressedSampling = compressed;
 
 				int width = surface->getWidth();
 				int height = surface->getHeight();
 				int depth = surface->getDepth();
-				int pitchP = surface->getInternalPitchP();
-				int sliceP = surface->getInternalSliceP();
+
+				// Compressed textures are addressed in bytes per row of blocks
+				int pitchP = compressed ? surface->getExternalPitchB() : surface->getInternalPitchP();
+				int sliceP = compressed ? surface->getExternalSliceB() : surface->getInternalSliceP();
 
 				if(level == 0)
 				{
@@ -511,4 +522,27 @@ namespace sw
 
 		return compare;
 	}
+
+	bool Sampler::isDirectlySampled(const Surface *surface)
+	{
+		// Bordered surfaces need their internal copy for seamless cube filtering
+		if(surface->getBorder() != 0)
+		{
+			return false;
+		}
+
+		// Only S3TC blocks are decoded by the sampler. ETC2 blocks select one of five modes per block, which would
+		// all have to be evaluated for every lane and filter tap, making each fetch costlier than reading the decoded
+		// copy. EAC blocks decode to 32-bit float internal formats, which the 16-bit fixed-point compressed path
+		// can't reproduce exactly. Both keep using the decode path.
+		switch(surface->getExternalFormat())
+		{
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+			return surface->getInternalFormat() == FORMAT_A8R8G8B8;
+		default:
+			return false;
+		}
+	}
 }
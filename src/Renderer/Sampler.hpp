@@ -160,10 +160,7 @@ namespace sw
 			SwizzleType swizzleA           : BITS(SWIZZLE_LAST);
 			bool highPrecisionFiltering    : 1;
 			CompareFunc compare            : BITS(COMPARE_LAST);
-
-			#if PERF_PROFILE
-			bool compressedFormat          : 1;
-			#endif
+			Format compressedFormat        : BITS(FORMAT_LAST);   // Block format sampled without decoding, or FORMAT_NULL
 		};
 
 		Sampler();
@@ -216,6 +213,9 @@ namespace sw
 		AddressingMode getAddressingModeW() const;
 		CompareFunc getCompareFunc() const;
 
+		// True for DXT1/3/5 surfaces, whose blocks get sampled without an intermediate decoded copy
+		static bool isDirectlySampled(const Surface *surface);
+
 		Format externalTextureFormat;
 		Format internalTextureFormat;
 		TextureType textureType;
@@ -229,6 +229,7 @@ namespace sw
 		bool gather;
 		bool highPrecisionFiltering;
 		bool syncRequired;
+		bool compressedSampling;
 		int border;
 
 		SwizzleType swizzleR;
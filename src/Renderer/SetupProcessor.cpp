@@ -20,6 +20,7 @@
 #include "Renderer.hpp"
 #include "Shader/SetupRoutine.hpp"
 #include "Shader/Constants.hpp"
+#include "Common/Timer.hpp"
 #include "Common/Debug.hpp"
 
 namespace sw
@@ -229,12 +230,19 @@ namespace sw
 
 		if(!routine)
 		{
+			int64_t compileBegin = profiler.isTracing() ? Timer::counter() : 0;
+
 			SetupRoutine *generator = new SetupRoutine(state);
 			generator->generate();
 			routine = generator->getRoutine();
 			delete generator;
 
 			routineCache->add(state, routine);
+
+			if(profiler.isTracing())
+			{
+				profiler.trace("compile setup routine", Profiler::TRACE_APPLICATION_THREAD, state.hash, compileBegin, Timer::counter());
+			}
 		}
 
 		return routine;
@@ -18,6 +18,14 @@
 #include "Color.hpp"
 #include "Main/Config.hpp"
 #include "Common/Resource.hpp"
+#include "Common/Thread.hpp"
+
+#include <atomic>
+
+namespace rr
+{
+	class Routine;
+}
 
 namespace sw
 {
@@ -292,6 +300,9 @@ namespace sw
 		inline int getHeight() const;
 		inline int getDepth() const;
 		inline int getBorder() const;
+
+		// Never shared with another surface, unlike the address, which may get reused once this one is deleted
+		uint64_t getSerial() const { return serial; }
 		inline Format getFormat(bool internal = false) const;
 		inline int getPitchB(bool internal = false) const;
 		inline int getPitchP(bool internal = false) const;
@@ -327,6 +338,21 @@ namespace sw
 		inline int getSamples() const;
 		inline int getMultiSampleCount() const;
 		inline int getSuperSampleCount() const;
+		void markSamplesDirty(const Rect &rect, int layer);   // Adds a region rendered to by the renderer to the next resolve
+		bool hasResolveRoutine() const { return resolveRoutine != nullptr; }
+		void setResolveRoutine(rr::Routine *routine);   // Provided by the renderer writing to the samples
+
+		// Hierarchical depth: an upper bound of the depth values of each tile of HIZ_TILE_SIZE x HIZ_TILE_SIZE
+		// pixels, which lets the renderer skip primitives behind the contents of a single-sample depth buffer.
+		// Rendering with a LESS or LESSEQUAL comparison only ever lowers depth values, which keeps the bounds
+		// valid. Draws which may raise them must be bracketed by beginDepthIncrease() and endDepthIncrease().
+		enum {HIZ_TILE_SIZE = 8};
+		inline bool hasHiZ() const;
+		inline bool isHiZValid() const;   // False while depth values may be raised by pending draws
+		float getHiZ(int tileX, int tileY, int layer);   // Recomputes the bound from the depth values if marked stale
+		void markHiZStale(int tileX0, int tileX1, int tileY, int layer);   // Tiles [tileX0, tileX1] are about to be rendered to
+		void beginDepthIncrease();
+		void endDepthIncrease();
 
 		bool isEntire(const Rect& rect) const;
 		Rect getRect() const;
@@ -481,6 +507,52 @@ namespace sw
 		static void decodeETC2(Buffer &internal, Buffer &external, int nbAlphaBits, bool isSRGB);
 		static void decodeASTC(Buffer &internal, Buffer &external, int xSize, int ySize, int zSize, bool isSRGB);
 
+		// Compressed images are decoded in bands of block rows, which are independent and can be spread over the workers
+		struct DecodeTask
+		{
+			void (*decode)(const DecodeTask &task, int first, int last);   // Decodes block rows [first, last)
+
+			const Buffer *internal;
+			const Buffer *external;
+			byte *destination;
+			const byte *source;
+
+			int columns;      // Blocks per row
+			int rows;         // Total number of block rows, over all slices
+			int blockWidth;   // Texels per block
+			int blockHeight;
+			int blockBytes;
+			int parameter;    // Format specific (e.g. ETC_Decoder input type)
+			bool isSRGB;
+		};
+
+		static void decodeBlocks(DecodeTask &task, Buffer &internal, Buffer &external, int slices, Lock lock = LOCK_UPDATE, int blockWidth = 4, int blockHeight = 4);
+
+		static void decodeDXT1Rows(const DecodeTask &task, int first, int last);
+		static void decodeDXT3Rows(const DecodeTask &task, int first, int last);
+		static void decodeDXT5Rows(const DecodeTask &task, int first, int last);
+		static void decodeATI1Rows(const DecodeTask &task, int first, int last);
+		static void decodeATI2Rows(const DecodeTask &task, int first, int last);
+		static void decodeEACRows(const DecodeTask &task, int first, int last);
+		static void decodeETC2Rows(const DecodeTask &task, int first, int last);
+		static void decodeASTCRows(const DecodeTask &task, int first, int last);
+
+		// Multisample resolves average spans of elements, in bands of rows spread over the workers like decoding
+		struct ResolveTask
+		{
+			void (*resolve)(void *element, int count, int sliceB);
+
+			byte *buffer;
+			int rowsPerLayer;
+			int layerB;        // Bytes between the first samples of consecutive layers
+			int pitchB;        // Bytes between rows (row pairs for quad layout)
+			int offsetB;       // Offset of the first element within each row
+			int count;         // Elements per row
+			int sliceB;        // Bytes between samples
+		};
+
+		static void resolveRows(const ResolveTask &task, int first, int last);   // Rows [first, last), over all layers
+
 		static void update(Buffer &destination, Buffer &source);
 		static void genericUpdate(Buffer &destination, Buffer &source);
 		static void *allocateBuffer(int width, int height, int depth, int border, int samples, Format format);
@@ -491,10 +563,33 @@ namespace sw
 
 		void resolve();
 
+		// Read and marked stale by concurrent setup threads
+		struct HiZTile
+		{
+			std::atomic<float> maxZ;
+			std::atomic<bool> stale;   // The depth values may be lower than maxZ
+		};
+
+		void invalidateHiZ();
+		void updateHiZ(float depth, int x0, int y0, int x1, int y1);
+
+		HiZTile *hiZ;   // Per layer, tile row and column, null when not maintained
+		int hiZColumns;
+		int hiZRows;
+		AtomicInt depthIncreases;   // Pending draws which may raise depth values
+
+		Rect resolveRect;   // Region written since the last resolve, empty if none
+		int resolveLayer0;
+		int resolveLayer1;
+		rr::Routine *resolveRoutine;   // From the routine cache of a blitter, null until the samples get written or resolved
+
 		Buffer external;
 		Buffer internal;
 		Buffer stencil;
 
+		const uint64_t serial;
+		static std::atomic<uint64_t> serialCounter;
+
 		const bool lockable;
 		const bool renderTarget;
 
@@ -649,6 +744,16 @@ namespace sw
 		return internal.samples > 4 ? internal.samples / 4 : 1;
 	}
 
+	bool Surface::hasHiZ() const
+	{
+		return hiZ != nullptr;
+	}
+
+	bool Surface::isHiZValid() const
+	{
+		return depthIncreases == 0;
+	}
+
 	bool Surface::isUnlocked() const
 	{
 		return external.lock == LOCK_UNLOCKED &&
@@ -20,6 +20,7 @@
 #include "Shader/PixelShader.hpp"
 #include "Shader/Constants.hpp"
 #include "Common/Math.hpp"
+#include "Common/Timer.hpp"
 #include "Common/Debug.hpp"
 
 #include <string.h>
@@ -30,7 +31,7 @@ namespace sw
 
 	void VertexCache::clear()
 	{
-		for(int i = 0; i < 16; i++)
+		for(int i = 0; i < 64; i++)
 		{
 			tag[i] = 0x80000000;
 		}
@@ -131,6 +132,7 @@ namespace sw
 	void VertexProcessor::setInputStream(int index, const Stream &stream)
 	{
 		context->input[index] = stream;
+		context->dirtyStates |= DIRTY_VERTEX_INPUT;
 	}
 
 	void VertexProcessor::resetInputStreams(bool preTransformed)
@@ -140,7 +142,13 @@ namespace sw
 			context->input[i].defaults();
 		}
 
-		context->preTransformed = preTransformed;
+		if(context->preTransformed != preTransformed)
+		{
+			context->preTransformed = preTransformed;
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
+		}
+
+		context->dirtyStates |= DIRTY_VERTEX_INPUT;
 	}
 
 	void VertexProcessor::setFloatConstant(unsigned int index, const float value[4])
@@ -246,7 +254,14 @@ namespace sw
 	void VertexProcessor::setProjectionMatrix(const Matrix &P)
 	{
 		this->P = P;
-		context->wBasedFog = (P[3][0] != 0.0f) || (P[3][1] != 0.0f) || (P[3][2] != 0.0f) || (P[3][3] != 1.0f);
+
+		bool wBasedFog = (P[3][0] != 0.0f) || (P[3][1] != 0.0f) || (P[3][2] != 0.0f) || (P[3][3] != 1.0f);
+
+		if(context->wBasedFog != wBasedFog)
+		{
+			context->wBasedFog = wBasedFog;
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
+		}
 
 		updateMatrix = true;
 		updateProjectionMatrix = true;
@@ -255,6 +270,7 @@ namespace sw
 	void VertexProcessor::setLightingEnable(bool lightingEnable)
 	{
 		context->setLightingEnable(lightingEnable);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 
 		updateLighting = true;
 	}
@@ -264,6 +280,7 @@ namespace sw
 		if(light < 8)
 		{
 			context->setLightEnable(light, lightEnable);
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 
@@ -273,6 +290,7 @@ namespace sw
 	void VertexProcessor::setSpecularEnable(bool specularEnable)
 	{
 		context->setSpecularEnable(specularEnable);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 
 		updateLighting = true;
 	}
@@ -347,11 +365,13 @@ namespace sw
 	void VertexProcessor::setFogEnable(bool fogEnable)
 	{
 		context->fogEnable = fogEnable;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setVertexFogMode(FogMode fogMode)
 	{
 		context->vertexFogMode = fogMode;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setInstanceID(int instanceID)
@@ -362,26 +382,31 @@ namespace sw
 	void VertexProcessor::setColorVertexEnable(bool colorVertexEnable)
 	{
 		context->setColorVertexEnable(colorVertexEnable);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setDiffuseMaterialSource(MaterialSource diffuseMaterialSource)
 	{
 		context->setDiffuseMaterialSource(diffuseMaterialSource);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setSpecularMaterialSource(MaterialSource specularMaterialSource)
 	{
 		context->setSpecularMaterialSource(specularMaterialSource);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setAmbientMaterialSource(MaterialSource ambientMaterialSource)
 	{
 		context->setAmbientMaterialSource(ambientMaterialSource);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setEmissiveMaterialSource(MaterialSource emissiveMaterialSource)
 	{
 		context->setEmissiveMaterialSource(emissiveMaterialSource);
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setGlobalAmbient(const Color<float> &globalAmbient)
@@ -444,11 +469,13 @@ namespace sw
 	void VertexProcessor::setRangeFogEnable(bool enable)
 	{
 		context->rangeFogEnable = enable;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setIndexedVertexBlendEnable(bool indexedVertexBlendEnable)
 	{
 		context->indexedVertexBlendEnable = indexedVertexBlendEnable;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setVertexBlendMatrixCount(unsigned int vertexBlendMatrixCount)
@@ -456,6 +483,7 @@ namespace sw
 		if(vertexBlendMatrixCount <= 4)
 		{
 			context->vertexBlendMatrixCount = vertexBlendMatrixCount;
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -465,6 +493,7 @@ namespace sw
 		if(stage < TEXTURE_IMAGE_UNITS)
 		{
 			context->textureWrap[stage] = mask;
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 
@@ -481,6 +510,7 @@ namespace sw
 		if(stage < 8)
 		{
 			context->texGen[stage] = texGen;
+			context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 		}
 		else ASSERT(false);
 	}
@@ -488,11 +518,13 @@ namespace sw
 	void VertexProcessor::setLocalViewer(bool localViewer)
 	{
 		context->localViewer = localViewer;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setNormalizeNormals(bool normalizeNormals)
 	{
 		context->normalizeNormals = normalizeNormals;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setTextureMatrix(int stage, const Matrix &T)
@@ -510,6 +542,7 @@ namespace sw
 	{
 		context->textureTransformCount[stage] = count;
 		context->textureTransformProject[stage] = project;
+		context->dirtyStates |= DIRTY_FIXED_FUNCTION;
 	}
 
 	void VertexProcessor::setTextureFilter(unsigned int sampler, FilterType textureFilter)
@@ -517,6 +550,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setTextureFilter(textureFilter);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -526,6 +560,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMipmapFilter(mipmapFilter);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -535,6 +570,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setGatherEnable(enable);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -544,6 +580,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setAddressingModeU(addressMode);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -553,6 +590,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setAddressingModeV(addressMode);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -562,6 +600,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setAddressingModeW(addressMode);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -571,6 +610,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setReadSRGB(sRGB);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -598,6 +638,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMaxAnisotropy(maxAnisotropy);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -606,7 +647,8 @@ namespace sw
 	{
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
-			context->sampler[sampler].setHighPrecisionFiltering(highPrecisionFiltering);
+			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setHighPrecisionFiltering(highPrecisionFiltering);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -616,6 +658,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleR(swizzleR);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -625,6 +668,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleG(swizzleG);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -634,6 +678,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleB(swizzleB);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -643,6 +688,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleA(swizzleA);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -652,6 +698,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setCompareFunc(compFunc);
+			context->dirtyStates |= DIRTY_VERTEX_SAMPLERS;
 		}
 		else ASSERT(false);
 	}
@@ -733,12 +780,20 @@ namespace sw
 
 	void VertexProcessor::setTransformFeedbackQueryEnabled(bool enable)
 	{
-		context->transformFeedbackQueryEnabled = enable;
+		if(context->transformFeedbackQueryEnabled != enable)
+		{
+			context->transformFeedbackQueryEnabled = enable;
+			context->dirtyStates |= DIRTY_TRANSFORM_FEEDBACK;
+		}
 	}
 
 	void VertexProcessor::enableTransformFeedback(uint64_t enable)
 	{
-		context->transformFeedbackEnabled = enable;
+		if(context->transformFeedbackEnabled != enable)
+		{
+			context->transformFeedbackEnabled = enable;
+			context->dirtyStates |= DIRTY_TRANSFORM_FEEDBACK;
+		}
 	}
 
 	const Matrix &VertexProcessor::getModelTransform(int i)
@@ -902,7 +957,7 @@ namespace sw
 		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536), precacheVertex ? "sw-vertex" : 0);
 	}
 
-	const VertexProcessor::State VertexProcessor::update(DrawType drawType)
+	void VertexProcessor::updateTransformAndLighting()
 	{
 		if(isFixedFunction())
 		{
@@ -922,7 +977,10 @@ namespace sw
 				updateLighting = false;
 			}
 		}
+	}
 
+	const VertexProcessor::State VertexProcessor::update(DrawType drawType)
+	{
 		State state;
 
 		if(context->vertexShader)
@@ -936,6 +994,8 @@ namespace sw
 
 		state.fixedFunction = !context->vertexShader && context->pixelShaderModel() < 0x0300;
 		state.textureSampling = context->vertexShader ? context->vertexShader->containsTextureSampling() : false;
+		state.gatherVertices = (drawType & DRAW_INDEXED32) && !state.textureSampling;   // Set for 8, 16 and 32-bit indices
+		state.instrumented = profiler.isInstrumenting();
 		state.positionRegister = context->vertexShader ? context->vertexShader->getPositionRegister() : Pos;
 		state.pointSizeRegister = context->vertexShader ? context->vertexShader->getPointSizeRegister() : Pts;
 
@@ -1089,12 +1149,51 @@ namespace sw
 		return state;
 	}
 
+	bool VertexProcessor::isInputModified(const State &state) const
+	{
+		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
+		{
+			if(state.input[i].type != context->input[i].type ||
+			   state.input[i].count != context->input[i].count ||
+			   state.input[i].normalized != context->input[i].normalized)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool VertexProcessor::isSamplerModified(const State &state) const
+	{
+		if(!context->vertexShader)
+		{
+			return false;
+		}
+
+		for(unsigned int i = 0; i < VERTEX_TEXTURE_IMAGE_UNITS; i++)
+		{
+			if(context->vertexShader->usesSampler(i))
+			{
+				Sampler::State samplerState = context->sampler[TEXTURE_IMAGE_UNITS + i].samplerState();
+
+				if(memcmp(&samplerState, &state.sampler[i], sizeof(Sampler::State)) != 0)
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
 	Routine *VertexProcessor::routine(const State &state)
 	{
 		Routine *routine = routineCache->query(state);
 
 		if(!routine)   // Create one
 		{
+			int64_t compileBegin = profiler.isTracing() ? Timer::counter() : 0;
 			VertexRoutine *generator = nullptr;
 
 			if(state.fixedFunction)
@@ -1107,10 +1206,15 @@ namespace sw
 			}
 
 			generator->generate();
-			routine = (*generator)(L"VertexRoutine_%0.8X", state.shaderID);
+			routine = (*generator)(L"VertexRoutine_%0.8X_%0.8X", state.shaderID, state.hash);
 			delete generator;
 
 			routineCache->add(state, routine);
+
+			if(profiler.isTracing())
+			{
+				profiler.trace("compile vertex routine", Profiler::TRACE_APPLICATION_THREAD, state.hash, compileBegin, Timer::counter());
+			}
 		}
 
 		return routine;
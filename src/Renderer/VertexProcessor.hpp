@@ -29,7 +29,7 @@ namespace sw
 		void clear();
 
 		Vertex vertex[16][4];
-		unsigned int tag[16];
+		unsigned int tag[64];   // Quads of vertices use the first 16, gathered vertices one per cache line
 
 		int drawCall;
 	};
@@ -38,6 +38,7 @@ namespace sw
 	{
 		unsigned int vertexCount;
 		unsigned int primitiveStart;
+		unsigned int cacheMisses;   // Written by instrumented routines
 		VertexCache vertexCache;
 	};
 
@@ -52,6 +53,8 @@ namespace sw
 
 			bool fixedFunction             : 1;   // TODO: Eliminate by querying shader.
 			bool textureSampling           : 1;   // TODO: Eliminate by querying shader.
+			bool gatherVertices            : 1;   // Shade unique indices four at a time instead of aligned quads
+			bool instrumented              : 1;   // Count vertex cache misses
 			unsigned int positionRegister  : BITS(MAX_VERTEX_OUTPUTS);   // TODO: Eliminate by querying shader.
 			unsigned int pointSizeRegister : BITS(MAX_VERTEX_OUTPUTS);   // TODO: Eliminate by querying shader.
 
@@ -284,9 +287,14 @@ namespace sw
 		const Matrix &getModelTransform(int i);
 		const Matrix &getViewTransform();
 
+		void updateTransformAndLighting();   // Fixed-function constants, needed by every draw
 		const State update(DrawType drawType);
 		Routine *routine(const State &state);
 
+		// Whether re-specified inputs differ from those the state was derived from
+		bool isInputModified(const State &state) const;
+		bool isSamplerModified(const State &state) const;
+
 		bool isFixedFunction();
 		void setRoutineCacheSize(int cacheSize);
 
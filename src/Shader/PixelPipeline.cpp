@@ -1230,9 +1230,13 @@ namespace sw
 	{
 		Vector4s c;
 
-		#if PERF_PROFILE
-			Long texTime = Ticks();
-		#endif
+		Long texTime;
+
+		if(state.instrumented)
+		{
+			texelFetches += UInt(4);   // One lookup per pixel of the quad
+			texTime = Ticks();
+		}
 
 		Vector4f dsx;
 		Vector4f dsy;
@@ -1254,9 +1258,10 @@ namespace sw
 			c = SamplerCore(constants, state.sampler[stage]).sampleTexture(texture, u_q, v_q, w_q, q, q, dsx, dsy);
 		}
 
-		#if PERF_PROFILE
+		if(state.instrumented)
+		{
 			cycles[PERF_TEX] += Ticks() - texTime;
-		#endif
+		}
 
 		return c;
 	}
@@ -752,16 +752,21 @@ namespace sw
 
 	Vector4f PixelProgram::sampleTexture(int samplerIndex, Vector4f &uvwq, Float4 &bias, Vector4f &dsx, Vector4f &dsy, Vector4f &offset, SamplerFunction function)
 	{
-		#if PERF_PROFILE
-			Long texTime = Ticks();
-		#endif
+		Long texTime;
+
+		if(state.instrumented)
+		{
+			texelFetches += UInt(4);   // One lookup per pixel of the quad
+			texTime = Ticks();
+		}
 
 		Pointer<Byte> texture = data + OFFSET(DrawData, mipmap) + samplerIndex * sizeof(Texture);
 		Vector4f c = SamplerCore(constants, state.sampler[samplerIndex]).sampleTexture(texture, uvwq.x, uvwq.y, uvwq.z, uvwq.w, bias, dsx, dsy, offset, function);
 
-		#if PERF_PROFILE
+		if(state.instrumented)
+		{
 			cycles[PERF_TEX] += Ticks() - texTime;
-		#endif
+		}
 
 		return c;
 	}
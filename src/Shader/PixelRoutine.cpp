@@ -50,9 +50,12 @@ namespace sw
 
 	void PixelRoutine::quad(Pointer<Byte> cBuffer[RENDERTARGETS], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int cMask[4], Int &x, Int &y)
 	{
-		#if PERF_PROFILE
-			Long pipeTime = Ticks();
-		#endif
+		Long pipeTime;
+
+		if(state.instrumented)
+		{
+			pipeTime = Ticks();
+		}
 
 		const bool earlyDepthTest = !state.depthOverride && !state.alphaTestActive();
 
@@ -98,13 +101,24 @@ namespace sw
 			{
 				depthPass = depthPass || depthTest(zBuffer, q, x, z[q], sMask[q], zMask[q], cMask[q]);
 			}
+
+			if(state.instrumented)
+			{
+				If(!depthPass)
+				{
+					quadsKilled += UInt(1);
+				}
+			}
 		}
 
 		If(depthPass || Bool(!earlyDepthTest))
 		{
-			#if PERF_PROFILE
-				Long interpTime = Ticks();
-			#endif
+			Long interpTime;
+
+			if(state.instrumented)
+			{
+				interpTime = Ticks();
+			}
 
 			Float4 yyyy = Float4(Float(y)) + *Pointer<Float4>(primitive + OFFSET(Primitive,yQuad), 16);
 
@@ -190,23 +204,36 @@ namespace sw
 
 			setBuiltins(x, y, z, w);
 
-			#if PERF_PROFILE
+			if(state.instrumented)
+			{
 				cycles[PERF_INTERP] += Ticks() - interpTime;
-			#endif
+			}
 
 			Bool alphaPass = true;
 
 			if(colorUsed())
 			{
-				#if PERF_PROFILE
-					Long shaderTime = Ticks();
-				#endif
+				Long shaderTime;
+
+				if(state.instrumented)
+				{
+					Int coverage = cMask[0];
+
+					for(unsigned int q = 1; q < state.multiSample; q++)
+					{
+						coverage |= cMask[q];
+					}
+
+					pixelsShaded += *Pointer<UInt>(constants + OFFSET(Constants,occlusionCount) + 4 * coverage);
+					shaderTime = Ticks();
+				}
 
 				applyShader(cMask);
 
-				#if PERF_PROFILE
+				if(state.instrumented)
+				{
 					cycles[PERF_SHADER] += Ticks() - shaderTime;
-				#endif
+				}
 
 				alphaPass = alphaTest(cMask);
 
@@ -230,9 +257,12 @@ namespace sw
 					}
 				}
 
-				#if PERF_PROFILE
-					Long ropTime = Ticks();
-				#endif
+				Long ropTime;
+
+				if(state.instrumented)
+				{
+					ropTime = Ticks();
+				}
 
 				If(depthPass || Bool(earlyDepthTest))
 				{
@@ -251,17 +281,14 @@ namespace sw
 
 					if(colorUsed())
 					{
-						#if PERF_PROFILE
-							AddAtomic(Pointer<Long>(&profiler.ropOperations), 4);
-						#endif
-
 						rasterOperation(f, cBuffer, x, sMask, zMask, cMask);
 					}
 				}
 
-				#if PERF_PROFILE
+				if(state.instrumented)
+				{
 					cycles[PERF_ROP] += Ticks() - ropTime;
-				#endif
+				}
 			}
 		}
 
@@ -273,9 +300,10 @@ namespace sw
 			}
 		}
 
-		#if PERF_PROFILE
+		if(state.instrumented)
+		{
 			cycles[PERF_PIPE] += Ticks() - pipeTime;
-		#endif
+		}
 	}
 
 	Float4 PixelRoutine::interpolateCentroid(Float4 &x, Float4 &y, Float4 &rhw, Pointer<Byte> planeEquation, bool flat, bool perspective)
@@ -65,15 +65,6 @@ namespace sw
 	{
 		Vector4s c;
 
-		#if PERF_PROFILE
-			AddAtomic(Pointer<Long>(&profiler.texOperations), 4);
-
-			if(state.compressedFormat)
-			{
-				AddAtomic(Pointer<Long>(&profiler.compressedTex), 4);
-			}
-		#endif
-
 		if(state.textureType == TEXTURE_NULL)
 		{
 			c.x = Short4(0x0000);
@@ -276,15 +267,6 @@ namespace sw
 	{
 		Vector4f c;
 
-		#if PERF_PROFILE
-			AddAtomic(Pointer<Long>(&profiler.texOperations), 4);
-
-			if(state.compressedFormat)
-			{
-				AddAtomic(Pointer<Long>(&profiler.compressedTex), 4);
-			}
-		#endif
-
 		if(state.textureType == TEXTURE_NULL)
 		{
 			c.x = Float4(0.0f);
@@ -1225,9 +1207,12 @@ namespace sw
 		address(v, y0, y1, fv, mipmap, offset.y, filter, OFFSET(Mipmap, height), state.addressingModeV, function);
 		address(w, z0, z0, fv, mipmap, offset.z, filter, OFFSET(Mipmap, depth), state.addressingModeW, function);
 
+		// Compressed textures are addressed by block, using the unscaled coordinates
+		bool scale = !hasCompressedFormat();
+
 		Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
-		y0 *= pitchP;
-		if(hasThirdCoordinate())
+		if(scale) y0 *= pitchP;
+		if(hasThirdCoordinate() && scale)
 		{
 			Int4 sliceP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, sliceP), 16);
 			z0 *= sliceP;
@@ -1239,7 +1224,7 @@ namespace sw
 		}
 		else
 		{
-			y1 *= pitchP;
+			if(scale) y1 *= pitchP;
 
 			Vector4f c0 = sampleTexel(x0, y0, z0, q, mipmap, buffer, function);
 			Vector4f c1 = sampleTexel(x1, y0, z0, q, mipmap, buffer, function);
@@ -1294,10 +1279,13 @@ namespace sw
 		address(v, y0, y1, fv, mipmap, offset.y, filter, OFFSET(Mipmap, height), state.addressingModeV, function);
 		address(w, z0, z1, fw, mipmap, offset.z, filter, OFFSET(Mipmap, depth), state.addressingModeW, function);
 
+		// Compressed textures are addressed by block, using the unscaled coordinates
+		bool scale = !hasCompressedFormat();
+
 		Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
 		Int4 sliceP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, sliceP), 16);
-		y0 *= pitchP;
-		z0 *= sliceP;
+		if(scale) y0 *= pitchP;
+		if(scale) z0 *= sliceP;
 
 		if(state.textureFilter == FILTER_POINT || (function == Fetch))
 		{
@@ -1305,8 +1293,8 @@ namespace sw
 		}
 		else
 		{
-			y1 *= pitchP;
-			z1 *= sliceP;
+			if(scale) y1 *= pitchP;
+			if(scale) z1 *= sliceP;
 
 			Vector4f c0 = sampleTexel(x0, y0, z0, w, mipmap, buffer, function);
 			Vector4f c1 = sampleTexel(x1, y0, z0, w, mipmap, buffer, function);
@@ -2006,6 +1994,14 @@ namespace sw
 	{
 		Vector4s c;
 
+		if(hasCompressedFormat())
+		{
+			Int4 x, y, z;
+			computeTexelCoordinates(x, y, z, uuuu, vvvv, wwww, offset, mipmap, function);
+
+			return sampleCompressedTexel(x, y, z, mipmap, buffer);
+		}
+
 		UInt index[4];
 		computeIndices(index, uuuu, vvvv, wwww, offset, mipmap, function);
 
@@ -2115,6 +2111,19 @@ namespace sw
 	{
 		Vector4f c;
 
+		if(hasCompressedFormat())
+		{
+			// The coordinates are not premultiplied by the pitch for compressed textures
+			Vector4s cs = sampleCompressedTexel(uuuu, vvvv, wwww, mipmap, buffer);
+
+			for(int n = 0; n < 4; n++)
+			{
+				c[n] = Float4(As<UShort4>(cs[n]));
+			}
+
+			return c;
+		}
+
 		UInt index[4];
 		computeIndices(index, uuuu, vvvv, wwww, mipmap, function);
 
@@ -2231,6 +2240,217 @@ namespace sw
 		return c;
 	}
 
+	void SamplerCore::computeTexelCoordinates(Int4 &x, Int4 &y, Int4 &z, Short4 uuuu, Short4 vvvv, Short4 wwww, Vector4f &offset, const Pointer<Byte> &mipmap, SamplerFunction function)
+	{
+		bool texelFetch = (function == Fetch);
+		bool hasOffset = (function.option == Offset);
+
+		UShort4 width = *Pointer<UShort4>(mipmap + OFFSET(Mipmap, width));
+		UShort4 height = *Pointer<UShort4>(mipmap + OFFSET(Mipmap, height));
+
+		if(!texelFetch)
+		{
+			uuuu = MulHigh(As<UShort4>(uuuu), width);
+			vvvv = MulHigh(As<UShort4>(vvvv), height);
+		}
+
+		if(hasOffset)
+		{
+			uuuu = applyOffset(uuuu, offset.x, Int4(width), texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeU);
+			vvvv = applyOffset(vvvv, offset.y, Int4(height), texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeV);
+		}
+
+		x = Int4(As<UShort4>(uuuu));
+		y = Int4(As<UShort4>(vvvv));
+		z = Int4(0);
+
+		if(hasThirdCoordinate())
+		{
+			UShort4 depth = *Pointer<UShort4>(mipmap + OFFSET(Mipmap, depth));
+
+			if(state.textureType != TEXTURE_2D_ARRAY)
+			{
+				if(!texelFetch)
+				{
+					wwww = MulHigh(As<UShort4>(wwww), depth);
+				}
+
+				if(hasOffset)
+				{
+					wwww = applyOffset(wwww, offset.z, Int4(depth), texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeW);
+				}
+			}
+
+			z = Int4(As<UShort4>(wwww));
+
+			if(texelFetch)
+			{
+				z = Min(z, Int4(depth) - Int4(1));
+			}
+		}
+
+		if(texelFetch)
+		{
+			// Negative coordinates were reinterpreted as large unsigned values
+			x = Min(x, Int4(width) - Int4(1));
+			y = Min(y, Int4(height) - Int4(1));
+		}
+	}
+
+	Vector4s SamplerCore::sampleCompressedTexel(Int4 &x, Int4 &y, Int4 &z, Pointer<Byte> &mipmap, Pointer<Byte> buffer[4])
+	{
+		Vector4s c;
+
+		// Blocks of 4x4 texels, with the alpha data of DXT3 and DXT5 preceding the color data
+		int blockBytes = (state.compressedFormat == FORMAT_DXT1) ? 8 : 16;
+		int colorOffset = blockBytes - 8;
+
+		Int4 offset = (y >> 2) * *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16) + (x >> 2) * Int4(blockBytes);
+
+		if(hasThirdCoordinate())
+		{
+			offset += z * *Pointer<Int4>(mipmap + OFFSET(Mipmap, sliceP), 16);
+		}
+
+		Int4 texel = ((y & Int4(3)) << 2) | (x & Int4(3));
+
+		Int4 colors;
+		Int4 colorLUT;
+		Int4 alphas;     // DXT5 alpha endpoints
+		Int4 alphaLUT0;  // DXT3 alpha bits 0-31, or DXT5 index bits 0-31
+		Int4 alphaLUT1;  // DXT3 alpha bits 32-63, or DXT5 index bits 16-47
+
+		for(int i = 0; i < 4; i++)
+		{
+			Pointer<Byte> block = buffer[state.textureType == TEXTURE_CUBE ? i : 0] + Extract(offset, i);
+
+			colors = Insert(colors, *Pointer<Int>(block + colorOffset), i);
+			colorLUT = Insert(colorLUT, *Pointer<Int>(block + colorOffset + 4), i);
+
+			switch(state.compressedFormat)
+			{
+			case FORMAT_DXT3:
+				alphaLUT0 = Insert(alphaLUT0, *Pointer<Int>(block), i);
+				alphaLUT1 = Insert(alphaLUT1, *Pointer<Int>(block + 4), i);
+				break;
+			case FORMAT_DXT5:
+				alphas = Insert(alphas, *Pointer<Int>(block), i);
+				alphaLUT0 = Insert(alphaLUT0, *Pointer<Int>(block + 2), i);
+				alphaLUT1 = Insert(alphaLUT1, *Pointer<Int>(block + 4), i);
+				break;
+			default:
+				break;
+			}
+		}
+
+		Int4 c0 = colors & Int4(0xFFFF);
+		Int4 c1 = As<Int4>(As<UInt4>(colors) >> 16);
+		Int4 index = As<Int4>(As<UInt4>(colorLUT) >> As<UInt4>(texel << 1)) & Int4(3);
+
+		// Only DXT1 has the three color mode with transparent black, selected by c0 <= c1
+		Int4 opaque = Int4(-1);
+
+		if(state.compressedFormat == FORMAT_DXT1)
+		{
+			opaque = CmpLT(c1, c0);
+		}
+
+		Int4 select0 = CmpEQ(index, Int4(0));
+		Int4 select1 = CmpEQ(index, Int4(1));
+		Int4 select2 = CmpEQ(index, Int4(2));
+		Int4 select3 = CmpEQ(index, Int4(3));
+
+		// Expand the R5G6B5 endpoints with bit replication, and interpolate like the decoder in Surface does
+		Int4 e0[3];
+		Int4 e1[3];
+
+		e0[0] = ((c0 & Int4(0xF800)) >> 8) + ((c0 & Int4(0xE000)) >> 13);
+		e0[1] = ((c0 & Int4(0x07E0)) >> 3) + ((c0 & Int4(0x0600)) >> 9);
+		e0[2] = ((c0 & Int4(0x001F)) << 3) + ((c0 & Int4(0x001C)) >> 2);
+		e1[0] = ((c1 & Int4(0xF800)) >> 8) + ((c1 & Int4(0xE000)) >> 13);
+		e1[1] = ((c1 & Int4(0x07E0)) >> 3) + ((c1 & Int4(0x0600)) >> 9);
+		e1[2] = ((c1 & Int4(0x001F)) << 3) + ((c1 & Int4(0x001C)) >> 2);
+
+		Int4 rgb[3];
+
+		for(int n = 0; n < 3; n++)
+		{
+			// x / 3 == (x * 0xAAAB) >> 17 for the range of these sums
+			Int4 c2 = (((e0[n] << 1) + e1[n] + Int4(1)) * Int4(0xAAAB)) >> 17;
+			Int4 c3 = ((e0[n] + (e1[n] << 1) + Int4(1)) * Int4(0xAAAB)) >> 17;
+
+			c2 = (c2 & opaque) | (((e0[n] + e1[n]) >> 1) & ~opaque);
+			c3 = c3 & opaque;
+
+			rgb[n] = (e0[n] & select0) | (e1[n] & select1) | (c2 & select2) | (c3 & select3);
+		}
+
+		Int4 alpha;
+
+		switch(state.compressedFormat)
+		{
+		case FORMAT_DXT1:
+			alpha = ~(select3 & ~opaque) & Int4(0xFF);
+			break;
+		case FORMAT_DXT3:
+			{
+				Int4 low = CmpLT(texel, Int4(8));
+				Int4 bits = (alphaLUT0 & low) | (alphaLUT1 & ~low);
+				alpha = As<Int4>(As<UInt4>(bits) >> As<UInt4>((texel & Int4(7)) << 2)) & Int4(0xF);
+				alpha = (alpha << 4) | alpha;
+			}
+			break;
+		case FORMAT_DXT5:
+			{
+				Int4 a0 = alphas & Int4(0xFF);
+				Int4 a1 = (alphas >> 8) & Int4(0xFF);
+
+				// 3-bit indices, taken from whichever dword holds all of their bits
+				Int4 low = CmpLT(texel, Int4(10));
+				Int4 bit = (texel << 1) + texel;
+				Int4 bits = (alphaLUT0 & low) | (alphaLUT1 & ~low);
+				Int4 shift = (bit & low) | ((bit - Int4(16)) & ~low);
+				Int4 alphaIndex = As<Int4>(As<UInt4>(bits) >> As<UInt4>(shift)) & Int4(7);
+
+				Int4 weight0 = Int4(8) - alphaIndex;
+				Int4 weight1 = alphaIndex - Int4(1);
+
+				// x / 7 == (x * 0x2493) >> 16 and x / 5 == (x * 0x3334) >> 16 for the range of these sums
+				Int4 eightAlphas = ((weight0 * a0 + weight1 * a1 + Int4(3)) * Int4(0x2493)) >> 16;
+				Int4 sixAlphas = (((weight0 - Int4(2)) * a0 + weight1 * a1 + Int4(2)) * Int4(0x3334)) >> 16;
+
+				Int4 alpha6 = CmpEQ(alphaIndex, Int4(6));
+				Int4 alpha7 = CmpEQ(alphaIndex, Int4(7));
+				sixAlphas = (sixAlphas & ~(alpha6 | alpha7)) | (Int4(0xFF) & alpha7);
+
+				Int4 eight = CmpLT(a1, a0);
+				Int4 interpolated = (eightAlphas & eight) | (sixAlphas & ~eight);
+
+				Int4 alpha0 = CmpEQ(alphaIndex, Int4(0));
+				Int4 alpha1 = CmpEQ(alphaIndex, Int4(1));
+				alpha = (a0 & alpha0) | (a1 & alpha1) | (interpolated & ~(alpha0 | alpha1));
+			}
+			break;
+		default:
+			ASSERT(false);
+		}
+
+		// Replicate to 16-bit, like the A8R8G8B8 texels of the decoded image
+		c.x = Short4(rgb[0] * Int4(0x0101));
+		c.y = Short4(rgb[1] * Int4(0x0101));
+		c.z = Short4(rgb[2] * Int4(0x0101));
+		c.w = Short4(alpha * Int4(0x0101));
+
+		if(state.sRGB)
+		{
+			sRGBtoLinear16_8_16(c.x);
+			sRGBtoLinear16_8_16(c.y);
+			sRGBtoLinear16_8_16(c.z);
+		}
+
+		return c;
+	}
+
 	void SamplerCore::selectMipmap(Pointer<Byte> &texture, Pointer<Byte> buffer[4], Pointer<Byte> &mipmap, Float &lod, Int face[4], bool secondLOD)
 	{
 		if(state.mipmapFilter == MIPMAP_NONE)
@@ -2961,6 +3181,11 @@ namespace sw
 		return false;
 	}
 
+	bool SamplerCore::hasCompressedFormat() const
+	{
+		return state.compressedFormat != FORMAT_NULL;
+	}
+
 	bool SamplerCore::isRGBComponent(int component) const
 	{
 		switch(state.textureFormat)
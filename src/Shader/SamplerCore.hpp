@@ -82,6 +82,8 @@ namespace sw
 		Vector4s sampleTexel(Short4 &u, Short4 &v, Short4 &s, Vector4f &offset, Pointer<Byte> &mipmap, Pointer<Byte> buffer[4], SamplerFunction function);
 		Vector4s sampleTexel(UInt index[4], Pointer<Byte> buffer[4]);
 		Vector4f sampleTexel(Int4 &u, Int4 &v, Int4 &s, Float4 &z, Pointer<Byte> &mipmap, Pointer<Byte> buffer[4], SamplerFunction function);
+		void computeTexelCoordinates(Int4 &x, Int4 &y, Int4 &z, Short4 uuuu, Short4 vvvv, Short4 wwww, Vector4f &offset, const Pointer<Byte> &mipmap, SamplerFunction function);
+		Vector4s sampleCompressedTexel(Int4 &x, Int4 &y, Int4 &z, Pointer<Byte> &mipmap, Pointer<Byte> buffer[4]);
 		void selectMipmap(Pointer<Byte> &texture, Pointer<Byte> buffer[4], Pointer<Byte> &mipmap, Float &lod, Int face[4], bool secondLOD);
 		Short4 address(Float4 &uw, AddressingMode addressingMode, Pointer<Byte>& mipmap);
 		void address(Float4 &uw, Int4& xyz0, Int4& xyz1, Float4& f, Pointer<Byte>& mipmap, Float4 &texOffset, Int4 &filter, int whd, AddressingMode addressingMode, SamplerFunction function);
@@ -106,6 +108,7 @@ namespace sw
 		bool has16bitTextureComponents() const;
 		bool has32bitIntegerTextureComponents() const;
 		bool hasYuvFormat() const;
+		bool hasCompressedFormat() const;
 		bool isRGBComponent(int component) const;
 
 		Pointer<Byte> &constants;
@@ -240,15 +240,33 @@ namespace sw
 
 				// Rasterize
 				{
-					Int i = 0;
+					Bool small = false;
 
-					Do
+					if(solidTriangle && state.multiSample == 1)
 					{
-						edge(primitive, data, Xq[i + 1 - d], Yq[i + 1 - d], Xq[i + d], Yq[i + d], q);
+						Int xMin = (Min(Min(X[0], X[1]), X[2]) + 0x0F) >> 4;
+						Int xMax = (Max(Max(X[0], X[1]), X[2]) + 0x0F) >> 4;
 
-						i++;
+						small = (n == 3) && (xMax - xMin <= 4) && (yMax - yMin <= 4);
+
+						If(small)
+						{
+							smallTriangle(primitive, data, Xq, Yq, d, xMin, yMin, yMax);
+						}
+					}
+
+					If(!small)
+					{
+						Int i = 0;
+
+						Do
+						{
+							edge(primitive, data, Xq[i + 1 - d], Yq[i + 1 - d], Xq[i + d], Yq[i + d], q);
+
+							i++;
+						}
+						Until(i >= n)
 					}
-					Until(i >= n)
 				}
 
 				if(state.multiSample == 1)
@@ -476,7 +494,7 @@ namespace sw
 			Return(true);
 		}
 
-		routine = function(L"SetupRoutine");
+		routine = function(L"SetupRoutine_%0.8X", state.hash);
 	}
 
 	void SetupRoutine::setupGradient(Pointer<Byte> &primitive, Pointer<Byte> &triangle, Float4 &w012, Float4 (&m)[3], Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2, int attribute, int planeEquation, bool flat, bool sprite, bool perspective, bool wrap, int component)
@@ -622,6 +640,56 @@ namespace sw
 		}
 	}
 
+	void SetupRoutine::smallTriangle(Pointer<Byte> &primitive, Pointer<Byte> &data, Array<Int> &X, Array<Int> &Y, Int &d, const Int &x0, const Int &yMin, const Int &yMax)
+	{
+		// Fills the outline of triangles spanning at most four columns of pixel centers using edge
+		// functions, instead of walking the edges. Like the outline produced by edge(), it includes
+		// centers on left edges, which point down, and excludes those on right edges. Horizontal
+		// edges only bound the range of rows.
+		Int4 column = Int4(x0) + Int4(0, 1, 2, 3);
+
+		Int4 E[3];      // (16 * x - Xa) * DY - (16 * y - Ya) * DX
+		Int4 dEdy[3];
+		Int4 bias[3];   // Covered when E > bias, which always holds for horizontal edges
+
+		for(int i = 0; i < 3; i++)
+		{
+			Int Xa = X[i + 1 - d];
+			Int Ya = Y[i + 1 - d];
+			Int DX = X[i + d] - Xa;
+			Int DY = Y[i + d] - Ya;
+
+			E[i] = ((column << 4) - Int4(Xa)) * Int4(DY) - Int4(((yMin << 4) - Ya) * DX);
+			dEdy[i] = Int4(DX << 4);
+			bias[i] = Int4(IfThenElse(DY > 0, Int(-1), IfThenElse(DY < 0, Int(0), Int(-0x7FFFFFFF - 1))));
+		}
+
+		Int xMin = *Pointer<Int>(data + OFFSET(DrawData,scissorX0));
+		Int xMax = *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
+
+		Pointer<Byte> leftEdge = primitive + OFFSET(Primitive,outline->left);
+		Pointer<Byte> rightEdge = primitive + OFFSET(Primitive,outline->right);
+
+		For(Int y = yMin, y < yMax, y++)
+		{
+			Int4 covered = CmpNLE(E[0], bias[0]) & CmpNLE(E[1], bias[1]) & CmpNLE(E[2], bias[2]);
+
+			// Covered centers are contiguous, rows without any get an empty span
+			Int4 left = (column & covered) | (Int4(x0 + 4) & ~covered);
+			Int4 right = ((column + Int4(1)) & covered) | (Int4(x0) & ~covered);
+
+			Int l = Min(Min(Extract(left, 0), Extract(left, 1)), Min(Extract(left, 2), Extract(left, 3)));
+			Int r = Max(Max(Extract(right, 0), Extract(right, 1)), Max(Extract(right, 2), Extract(right, 3)));
+
+			*Pointer<Short>(leftEdge + y * sizeof(Primitive::Span)) = Short(Clamp(l, xMin, xMax));
+			*Pointer<Short>(rightEdge + y * sizeof(Primitive::Span)) = Short(Clamp(Max(l, r), xMin, xMax));
+
+			E[0] -= dEdy[0];
+			E[1] -= dEdy[1];
+			E[2] -= dEdy[2];
+		}
+	}
+
 	void SetupRoutine::conditionalRotate1(Bool condition, Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2)
 	{
 		#if 0   // Rely on LLVM optimization
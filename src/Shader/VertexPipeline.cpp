@@ -158,7 +158,7 @@ namespace sw
 		return dst;
 	}
 
-	void VertexPipeline::pipeline(UInt &index)
+	void VertexPipeline::pipeline(Int4 &indices)
 	{
 		Vector4f position;
 		Vector4f normal;
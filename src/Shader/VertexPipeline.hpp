@@ -30,7 +30,7 @@ namespace sw
 		virtual ~VertexPipeline();
 
 	private:
-		void pipeline(UInt &index) override;
+		void pipeline(Int4 &indices) override;
 		void processTextureCoordinate(int stage, Vector4f &normal, Vector4f &position);
 		void processPointSize();
 
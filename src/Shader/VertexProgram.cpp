@@ -54,11 +54,11 @@ namespace sw
 	{
 	}
 
-	void VertexProgram::pipeline(UInt &index)
+	void VertexProgram::pipeline(Int4 &indices)
 	{
 		if(!state.preTransformed)
 		{
-			program(index);
+			program(indices);
 		}
 		else
 		{
@@ -66,7 +66,7 @@ namespace sw
 		}
 	}
 
-	void VertexProgram::program(UInt &index)
+	void VertexProgram::program(Int4 &indices)
 	{
 	//	shader->print("VertexShader-%0.8X.txt", state.shaderID);
 
@@ -82,17 +82,7 @@ namespace sw
 
 		if(shader->isVertexIdDeclared())
 		{
-			if(state.textureSampling)
-			{
-				vertexID = Int4(index);
-			}
-			else
-			{
-				vertexID = Insert(vertexID, As<Int>(index), 0);
-				vertexID = Insert(vertexID, As<Int>(index + 1), 1);
-				vertexID = Insert(vertexID, As<Int>(index + 2), 2);
-				vertexID = Insert(vertexID, As<Int>(index + 3), 3);
-			}
+			vertexID = indices;
 		}
 
 		// Create all call site return blocks up front
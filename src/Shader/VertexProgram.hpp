@@ -63,8 +63,8 @@ namespace sw
 		typedef Shader::Control Control;
 		typedef Shader::Usage Usage;
 
-		void pipeline(UInt &index) override;
-		void program(UInt &index);
+		void pipeline(Int4 &indices) override;
+		void program(Int4 &indices);
 		void passThrough();
 
 		Vector4f fetchRegister(const Src &src, unsigned int offset = 0);
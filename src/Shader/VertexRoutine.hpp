@@ -54,16 +54,18 @@ namespace sw
 		const VertexProcessor::State &state;
 
 	private:
-		virtual void pipeline(UInt &index) = 0;
+		virtual void pipeline(Int4 &indices) = 0;
 
 		typedef VertexProcessor::State::Input Stream;
 
-		Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const UInt &index);
-		void readInput(UInt &index);
+		Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const Int4 &indices);
+		void shade(Int4 &indices, Pointer<Byte> &vertexCache, const Int4 &cacheIndices);
+		void readInput(const Int4 &indices);
 		void computeClipFlags();
 		void postTransform();
-		void writeCache(Pointer<Byte> &cacheLine);
+		void writeCache(Pointer<Byte> &vertexCache, const Int4 &cacheIndices);
 		void writeVertex(const Pointer<Byte> &vertex, Pointer<Byte> &cacheLine);
+		void outputVertex(Pointer<Byte> &cacheLine, UInt &primitiveNumber, UInt &indexInPrimitive);
 		void transformFeedback(const Pointer<Byte> &vertex, const UInt &primitiveNumber, const UInt &indexInPrimitive);
 	};
 }
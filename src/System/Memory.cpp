@@ -98,6 +98,23 @@ size_t memoryPageSize()
 	return pageSize;
 }
 
+size_t hugePageSize()
+{
+	return 2 * 1024 * 1024;   // Translation granule of large pages on x86-64 and ARM64
+}
+
+uint64_t physicalMemorySize()
+{
+	#if defined(_WIN32)
+		MEMORYSTATUSEX status;
+		status.dwLength = sizeof(status);
+		return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+	#else
+		long pageCount = sysconf(_SC_PHYS_PAGES);
+		return (pageCount > 0) ? uint64_t(pageCount) * memoryPageSize() : 0;
+	#endif
+}
+
 void *allocate(size_t bytes, size_t alignment)
 {
 	void *memory = allocateRaw(bytes, alignment);
@@ -125,6 +142,111 @@ void deallocate(void *memory)
 	#endif
 }
 
+void *allocatePages(size_t bytes)
+{
+	size_t pageSize = memoryPageSize();
+	size_t length = (bytes + pageSize - 1) & ~(pageSize - 1);
+	size_t alignment = hugePageSize();
+	bool huge = length >= alignment;
+
+	#if defined(_WIN32)
+		if(!huge)
+		{
+			return VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		}
+
+		// Find an aligned range by reserving extra, then map exactly that range.
+		// Another thread could take it in between, so retry a few times.
+		for(int attempt = 0; attempt < 8; attempt++)
+		{
+			void *reservation = VirtualAlloc(nullptr, length + alignment, MEM_RESERVE, PAGE_NOACCESS);
+
+			if(!reservation)
+			{
+				return nullptr;
+			}
+
+			VirtualFree(reservation, 0, MEM_RELEASE);
+
+			void *aligned = (void*)(((uintptr_t)reservation + alignment - 1) & ~(uintptr_t)(alignment - 1));
+			void *mapping = VirtualAlloc(aligned, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+			if(mapping)
+			{
+				return mapping;
+			}
+		}
+
+		return nullptr;
+	#else
+		void *mapping = MAP_FAILED;
+
+		#if defined(MAP_HUGETLB)
+			// Only succeeds when the system has reserved huge pages
+			if(length % alignment == 0)
+			{
+				mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			}
+		#endif
+
+		if(mapping != MAP_FAILED)
+		{
+			return mapping;
+		}
+
+		if(!huge)
+		{
+			mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+			return (mapping != MAP_FAILED) ? mapping : nullptr;
+		}
+
+		// Transparent huge pages can only back aligned ranges, so map extra and trim to alignment
+		unsigned char *reservation = (unsigned char*)mmap(nullptr, length + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if(reservation == MAP_FAILED)
+		{
+			return nullptr;
+		}
+
+		unsigned char *aligned = (unsigned char*)(((uintptr_t)reservation + alignment - 1) & ~(uintptr_t)(alignment - 1));
+		size_t head = aligned - reservation;
+		size_t tail = alignment - head;
+
+		if(head > 0)
+		{
+			munmap(reservation, head);
+		}
+
+		if(tail > 0)
+		{
+			munmap(aligned + length, tail);
+		}
+
+		#if defined(MADV_HUGEPAGE)
+			madvise(aligned, length, MADV_HUGEPAGE);
+		#endif
+
+		return aligned;
+	#endif
+}
+
+void deallocatePages(void *memory, size_t bytes)
+{
+	if(!memory)
+	{
+		return;
+	}
+
+	#if defined(_WIN32)
+		VirtualFree(memory, 0, MEM_RELEASE);
+	#else
+		size_t pageSize = memoryPageSize();
+		size_t length = (bytes + pageSize - 1) & ~(pageSize - 1);
+		munmap(memory, length);
+	#endif
+}
+
 void clear(uint16_t *memory, uint16_t element, size_t count)
 {
 	#if defined(_MSC_VER) && defined(__x86__) && !defined(MEMORY_SANITIZER)
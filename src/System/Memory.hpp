@@ -21,10 +21,17 @@
 namespace sw
 {
 size_t memoryPageSize();
+size_t hugePageSize();
+uint64_t physicalMemorySize();
 
 void *allocate(size_t bytes, size_t alignment = 16);
 void deallocate(void *memory);
 
+// Zero-filled, page aligned mappings. Mappings of at least the huge page size
+// are aligned to it, and backed by huge pages where the system allows.
+void *allocatePages(size_t bytes);
+void deallocatePages(void *memory, size_t bytes);
+
 void clear(uint16_t *memory, uint16_t element, size_t count);
 void clear(uint32_t *memory, uint32_t element, size_t count);
 }
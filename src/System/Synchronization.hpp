@@ -0,0 +1,86 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_Synchronization_hpp
+#define sw_Synchronization_hpp
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+
+namespace sw
+{
+	// Counts outstanding work, so that threads can block until all of it has completed
+	class WaitGroup
+	{
+	public:
+		void add(unsigned int n = 1)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			count += n;
+		}
+
+		void done()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			if(--count == 0)
+			{
+				condition.notify_all();
+			}
+		}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return count == 0; });
+		}
+
+	private:
+		unsigned int count = 0;
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
+
+	// Thread-safe FIFO, where take() blocks until an item is available
+	template<typename T>
+	class Chan
+	{
+	public:
+		void put(const T &item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queue.push(item);
+			added.notify_one();
+		}
+
+		T take()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			added.wait(lock, [this] { return !queue.empty(); });
+
+			T item = queue.front();
+			queue.pop();
+
+			return item;
+		}
+
+	private:
+		std::queue<T> queue;
+		std::mutex mutex;
+		std::condition_variable added;
+	};
+}
+
+#endif   // sw_Synchronization_hpp
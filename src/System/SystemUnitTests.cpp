@@ -0,0 +1,343 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Resource.hpp"
+#include "ThreadPool.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace sw;
+
+TEST(ThreadPoolTest, ParallelForRunsEachIndexOnce)
+{
+	ThreadPool &threadPool = ThreadPool::Get();
+	EXPECT_GE(threadPool.getConcurrency(), 1u);
+
+	const unsigned int counts[] = { 0, 1, 2, 3, 7, 64, 1000 };
+
+	for(unsigned int count : counts)
+	{
+		std::unique_ptr<std::atomic<int>[]> calls(new std::atomic<int>[count + 1]);
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			calls[i] = 0;
+		}
+
+		std::atomic<unsigned int> maxParticipant(0);
+
+		threadPool.parallelFor(count, [&](unsigned int index, unsigned int participant)
+		{
+			calls[index]++;
+
+			unsigned int previous = maxParticipant;
+			while(participant > previous && !maxParticipant.compare_exchange_weak(previous, participant)) {}
+		});
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			EXPECT_EQ(1, calls[i].load());
+		}
+
+		if(count > 0)
+		{
+			EXPECT_LT(maxParticipant.load(), std::min(count, threadPool.getConcurrency()));
+		}
+	}
+}
+
+TEST(ThreadPoolTest, ParticipantsHaveExclusiveUse)
+{
+	ThreadPool &threadPool = ThreadPool::Get();
+
+	// Each participant number must only be used by one thread at a time, since it selects scratch memory
+	std::unique_ptr<std::atomic<int>[]> busy(new std::atomic<int>[threadPool.getConcurrency()]);
+
+	for(unsigned int i = 0; i < threadPool.getConcurrency(); i++)
+	{
+		busy[i] = 0;
+	}
+
+	std::atomic<int> overlaps(0);
+
+	threadPool.parallelFor(10000, [&](unsigned int index, unsigned int participant)
+	{
+		if(busy[participant]++ != 0)
+		{
+			overlaps++;
+		}
+
+		std::this_thread::yield();
+		busy[participant]--;
+	});
+
+	EXPECT_EQ(0, overlaps.load());
+}
+
+TEST(ThreadPoolTest, ConcurrentCallers)
+{
+	ThreadPool &threadPool = ThreadPool::Get();
+
+	const int callerCount = 4;
+	const unsigned int count = 500;
+	std::atomic<unsigned int> sums[callerCount];
+	std::atomic<int> participantErrors(0);
+	std::vector<std::thread> callers;
+
+	for(int caller = 0; caller < callerCount; caller++)
+	{
+		sums[caller] = 0;
+
+		callers.push_back(std::thread([&, caller]()
+		{
+			for(int repeat = 0; repeat < 20; repeat++)
+			{
+				threadPool.parallelFor(count, [&](unsigned int index, unsigned int participant)
+				{
+					sums[caller] += index;
+
+					if(participant >= threadPool.getConcurrency())
+					{
+						participantErrors++;
+					}
+				});
+			}
+		}));
+	}
+
+	for(auto &caller : callers)
+	{
+		caller.join();
+	}
+
+	for(int caller = 0; caller < callerCount; caller++)
+	{
+		EXPECT_EQ(20 * (count * (count - 1) / 2), sums[caller].load());
+	}
+
+	EXPECT_EQ(0, participantErrors.load());
+}
+
+TEST(ThreadPoolTest, ParallelForRangeCoversEachIndexOnce)
+{
+	ThreadPool &threadPool = ThreadPool::Get();
+
+	const unsigned int counts[] = { 0, 1, 5, 100, 4097 };
+
+	for(unsigned int count : counts)
+	{
+		for(unsigned int minimumCost : { 1u, 64u, 1000000u })
+		{
+			std::unique_ptr<std::atomic<int>[]> calls(new std::atomic<int>[count + 1]);
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				calls[i] = 0;
+			}
+
+			std::atomic<unsigned int> ranges(0);
+
+			threadPool.parallelForRange(count, 16, minimumCost, [&](unsigned int first, unsigned int last)
+			{
+				EXPECT_LT(first, last);
+				EXPECT_LE(last, count);
+
+				ranges++;
+
+				for(unsigned int i = first; i < last; i++)
+				{
+					calls[i]++;
+				}
+			});
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				EXPECT_EQ(1, calls[i].load());
+			}
+
+			EXPECT_LE(ranges.load(), threadPool.getConcurrency());
+
+			// Work below the minimum stays in one piece
+			if(count > 0 && uint64_t(count) * 16 < 2 * minimumCost)
+			{
+				EXPECT_EQ(1u, ranges.load());
+			}
+		}
+	}
+}
+
+TEST(ResourceTest, AccessorExclusion)
+{
+	Resource *resource = new Resource(64);
+
+	// Threads of the same accessor share the lock, while PRIVATE and EXCLUSIVE ones exclude each other
+	std::atomic<int> inside[2];
+	inside[0] = 0;
+	inside[1] = 0;
+	std::atomic<int> violations(0);
+	std::vector<std::thread> threads;
+
+	for(int t = 0; t < 8; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			int side = t % 2;
+			Accessor accessor = side ? PRIVATE : EXCLUSIVE;
+
+			for(int i = 0; i < 10000; i++)
+			{
+				resource->lock(accessor);
+				inside[side]++;
+
+				if(inside[1 - side] != 0)
+				{
+					violations++;
+				}
+
+				inside[side]--;
+				resource->unlock();
+			}
+		}));
+	}
+
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(0, violations.load());
+
+	resource->destruct();
+}
+
+TEST(ResourceTest, RelinquishToOtherAccessor)
+{
+	Resource *resource = new Resource(64);
+
+	void *buffer = resource->lock(PUBLIC);
+	EXPECT_NE(nullptr, buffer);
+	EXPECT_EQ(buffer, resource->lock(PUBLIC, PRIVATE));   // Hands the lock over without blocking
+	resource->unlock();
+	EXPECT_EQ(buffer, resource->lock(PRIVATE, PUBLIC));
+	resource->unlock(PUBLIC);
+
+	resource->destruct();
+}
+
+TEST(ResourceTest, DestructWithBlockedWaiter)
+{
+	for(int i = 0; i < 100; i++)
+	{
+		Resource *resource = new Resource(16);
+		resource->lock(EXCLUSIVE);
+
+		std::atomic<bool> started(false);
+		std::atomic<bool> locked(false);
+
+		std::thread waiter([&]()
+		{
+			started = true;
+			resource->lock(PRIVATE);   // Blocks until the exclusive lock is released
+			locked = true;
+			resource->unlock();   // Deletes the orphaned resource
+		});
+
+		while(!started)
+		{
+			std::this_thread::yield();
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		EXPECT_FALSE(locked);
+
+		// The resource must outlive the waiter
+		resource->destruct();
+		resource->unlock();
+
+		waiter.join();
+		EXPECT_TRUE(locked);
+	}
+}
+
+// Measures the lock and unlock pair performed for each resource used by a draw call.
+// Disabled by default; run with --gtest_also_run_disabled_tests.
+TEST(ResourceTest, DISABLED_LockPerformance)
+{
+	Resource *resource = new Resource(64);
+
+	// Keep a second thread alive, since some C libraries skip atomic operations in single-threaded processes
+	std::atomic<bool> done(false);
+	std::thread idle([&]()
+	{
+		while(!done)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	const int iterations = 10000000;
+	auto start = std::chrono::steady_clock::now();
+
+	for(int i = 0; i < iterations; i++)
+	{
+		resource->lock(PUBLIC, PRIVATE);
+		resource->unlock();
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	printf("Uncontended lock/unlock: %.1f ns\n", std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+
+	std::vector<std::thread> threads;
+	start = std::chrono::steady_clock::now();
+
+	for(int t = 0; t < 8; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			Accessor accessor = (t % 2) ? PRIVATE : EXCLUSIVE;
+
+			for(int i = 0; i < 100000; i++)
+			{
+				resource->lock(accessor);
+				resource->unlock();
+			}
+		}));
+	}
+
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	end = std::chrono::steady_clock::now();
+	printf("8 threads, 100k shared/exclusive lock pairs each: %.1f ms\n", std::chrono::duration<double, std::milli>(end - start).count());
+
+	done = true;
+	idle.join();
+	resource->destruct();
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
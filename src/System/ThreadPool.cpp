@@ -0,0 +1,132 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace sw
+{
+	struct ThreadPool::Job
+	{
+		unsigned int count;
+		const std::function<void(unsigned int, unsigned int)> &task;
+
+		std::atomic<unsigned int> nextIndex;
+		std::atomic<unsigned int> participants;
+		WaitGroup helpers;   // Workers which were handed this job and haven't let go of it
+	};
+
+	ThreadPool &ThreadPool::Get()
+	{
+		// The calling thread always takes part, so it doesn't need a worker of its own
+		static ThreadPool threadPool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+
+		return threadPool;
+	}
+
+	ThreadPool::ThreadPool(unsigned int threadCount)
+	{
+		for(unsigned int i = 0; i < threadCount; i++)
+		{
+			workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		for(size_t i = 0; i < workers.size(); i++)
+		{
+			pending.put(nullptr);
+		}
+
+		for(auto &worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::parallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)> &task)
+	{
+		if(count == 0)
+		{
+			return;
+		}
+
+		Job job = { count, task };
+		job.nextIndex = 0;
+		job.participants = 0;
+
+		// Indices are handed out one at a time, so workers which are busy with other
+		// jobs when this one is posted simply find nothing left to do once they get to it
+		unsigned int helperCount = std::min(count, getConcurrency()) - 1;
+		job.helpers.add(helperCount);
+
+		for(unsigned int i = 0; i < helperCount; i++)
+		{
+			pending.put(&job);
+		}
+
+		run(job);
+
+		job.helpers.wait();
+	}
+
+	void ThreadPool::parallelForRange(unsigned int count, unsigned int cost, unsigned int minimumCost, const std::function<void(unsigned int, unsigned int)> &task)
+	{
+		if(count == 0)
+		{
+			return;
+		}
+
+		uint64_t totalCost = uint64_t(count) * cost;
+		unsigned int rangeCount = static_cast<unsigned int>(std::min(totalCost / std::max(minimumCost, 1u), uint64_t(getConcurrency())));
+		rangeCount = std::min(rangeCount, count);
+
+		if(rangeCount <= 1)
+		{
+			task(0, count);
+			return;
+		}
+
+		parallelFor(rangeCount, [&](unsigned int range, unsigned int)
+		{
+			unsigned int first = static_cast<unsigned int>(uint64_t(count) * range / rangeCount);
+			unsigned int last = static_cast<unsigned int>(uint64_t(count) * (range + 1) / rangeCount);
+
+			task(first, last);
+		});
+	}
+
+	void ThreadPool::run(Job &job)
+	{
+		unsigned int participant = job.participants++;
+
+		for(unsigned int index = job.nextIndex++; index < job.count; index = job.nextIndex++)
+		{
+			job.task(index, participant);
+		}
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while(Job *job = pending.take())
+		{
+			run(*job);
+			job->helpers.done();
+		}
+	}
+}
@@ -0,0 +1,60 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_ThreadPool_hpp
+#define sw_ThreadPool_hpp
+
+#include "Synchronization.hpp"
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace sw
+{
+	// Worker threads shared by all work which can be split into independent tasks
+	class ThreadPool
+	{
+	public:
+		static ThreadPool &Get();
+
+		// Upper bound on the number of threads taking part in one parallelFor()
+		unsigned int getConcurrency() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+		// Calls task(index, participant) for every index in [0, count), on the workers and the
+		// calling thread, and returns once all calls have completed. Each thread taking part gets
+		// its own participant number, below min(count, getConcurrency()), so tasks can use it to
+		// select per-thread scratch memory. Several calls may be in flight at once.
+		void parallelFor(unsigned int count, const std::function<void(unsigned int index, unsigned int participant)> &task);
+
+		// Calls task(first, last) for consecutive ranges which together cover [0, count), one range
+		// per thread taking part. Every index costs about 'cost', and only ranges worth at least
+		// 'minimumCost' get split off, so small amounts of work stay on the calling thread.
+		void parallelForRange(unsigned int count, unsigned int cost, unsigned int minimumCost, const std::function<void(unsigned int first, unsigned int last)> &task);
+
+	private:
+		ThreadPool(unsigned int threadCount);
+		~ThreadPool();
+
+		struct Job;
+
+		static void run(Job &job);
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		Chan<Job*> pending;   // A null job stops the worker which takes it
+	};
+}
+
+#endif   // sw_ThreadPool_hpp
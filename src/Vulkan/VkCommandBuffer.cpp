@@ -13,34 +13,668 @@
 // limitations under the License.
 
 #include "VkCommandBuffer.hpp"
+#include "VkEvent.hpp"
+#include <cstring>
 
 namespace vk
 {
 
-CommandBuffer::CommandBuffer(VkCommandBufferLevel pLevel) : level(pLevel)
+// Commands are recorded as packets: this header, the command's parameters, then copies of
+// its array parameters. The parameters point into the packet, which never moves once recorded.
+struct CommandBuffer::Command
+{
+	enum Type : uint32_t
+	{
+		BEGIN_RENDER_PASS,
+		NEXT_SUBPASS,
+		END_RENDER_PASS,
+		EXECUTE_COMMANDS,
+		SET_DEVICE_MASK,
+		DISPATCH_BASE,
+		PIPELINE_BARRIER,
+		BIND_PIPELINE,
+		BIND_VERTEX_BUFFERS,
+		BEGIN_QUERY,
+		END_QUERY,
+		RESET_QUERY_POOL,
+		WRITE_TIMESTAMP,
+		COPY_QUERY_POOL_RESULTS,
+		PUSH_CONSTANTS,
+		SET_VIEWPORT,
+		SET_SCISSOR,
+		SET_LINE_WIDTH,
+		SET_DEPTH_BIAS,
+		SET_BLEND_CONSTANTS,
+		SET_DEPTH_BOUNDS,
+		SET_STENCIL_COMPARE_MASK,
+		SET_STENCIL_WRITE_MASK,
+		SET_STENCIL_REFERENCE,
+		BIND_DESCRIPTOR_SETS,
+		BIND_INDEX_BUFFER,
+		DISPATCH,
+		DISPATCH_INDIRECT,
+		COPY_BUFFER,
+		COPY_IMAGE,
+		BLIT_IMAGE,
+		COPY_BUFFER_TO_IMAGE,
+		COPY_IMAGE_TO_BUFFER,
+		UPDATE_BUFFER,
+		FILL_BUFFER,
+		CLEAR_COLOR_IMAGE,
+		CLEAR_DEPTH_STENCIL_IMAGE,
+		CLEAR_ATTACHMENTS,
+		RESOLVE_IMAGE,
+		SET_EVENT,
+		RESET_EVENT,
+		WAIT_EVENTS,
+		DRAW,
+		DRAW_INDEXED,
+		DRAW_INDIRECT,
+		DRAW_INDEXED_INDIRECT,
+	};
+
+	Type type;
+	uint32_t size;   // Bytes from the start of this packet to the next one
+};
+
+struct CommandBuffer::ExecutionState
+{
+	VkPipeline pipelines[VK_PIPELINE_BIND_POINT_RANGE_SIZE] = {};
+
+	struct VertexInputBinding
+	{
+		VkBuffer buffer;
+		VkDeviceSize offset;
+	};
+	VertexInputBinding vertexInputBindings[MAX_VERTEX_INPUT_BINDINGS] = {};
+
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE;
+};
+
+namespace
+{
+
+using Command = CommandBuffer::Command;
+
+struct CmdBeginRenderPass : Command
+{
+	static constexpr Type TYPE = BEGIN_RENDER_PASS;
+
+	VkRenderPass renderPass;
+	VkFramebuffer framebuffer;
+	VkRect2D renderArea;
+	uint32_t clearValueCount;
+	const VkClearValue* pClearValues;
+	VkSubpassContents contents;
+};
+
+struct CmdNextSubpass : Command
+{
+	static constexpr Type TYPE = NEXT_SUBPASS;
+
+	VkSubpassContents contents;
+};
+
+struct CmdEndRenderPass : Command
+{
+	static constexpr Type TYPE = END_RENDER_PASS;
+};
+
+struct CmdExecuteCommands : Command
+{
+	static constexpr Type TYPE = EXECUTE_COMMANDS;
+
+	uint32_t commandBufferCount;
+	const VkCommandBuffer* pCommandBuffers;
+};
+
+struct CmdSetDeviceMask : Command
+{
+	static constexpr Type TYPE = SET_DEVICE_MASK;
+
+	uint32_t deviceMask;
+};
+
+struct CmdDispatchBase : Command
+{
+	static constexpr Type TYPE = DISPATCH_BASE;
+
+	uint32_t baseGroupX;
+	uint32_t baseGroupY;
+	uint32_t baseGroupZ;
+	uint32_t groupCountX;
+	uint32_t groupCountY;
+	uint32_t groupCountZ;
+};
+
+struct CmdPipelineBarrier : Command
+{
+	static constexpr Type TYPE = PIPELINE_BARRIER;
+
+	VkPipelineStageFlags srcStageMask;
+	VkPipelineStageFlags dstStageMask;
+	VkDependencyFlags dependencyFlags;
+	uint32_t memoryBarrierCount;
+	const VkMemoryBarrier* pMemoryBarriers;
+	uint32_t bufferMemoryBarrierCount;
+	const VkBufferMemoryBarrier* pBufferMemoryBarriers;
+	uint32_t imageMemoryBarrierCount;
+	const VkImageMemoryBarrier* pImageMemoryBarriers;
+};
+
+struct CmdBindPipeline : Command
+{
+	static constexpr Type TYPE = BIND_PIPELINE;
+
+	VkPipelineBindPoint pipelineBindPoint;
+	VkPipeline pipeline;
+};
+
+struct CmdBindVertexBuffers : Command
+{
+	static constexpr Type TYPE = BIND_VERTEX_BUFFERS;
+
+	uint32_t firstBinding;
+	uint32_t bindingCount;
+	const VkBuffer* pBuffers;
+	const VkDeviceSize* pOffsets;
+};
+
+struct CmdBeginQuery : Command
+{
+	static constexpr Type TYPE = BEGIN_QUERY;
+
+	VkQueryPool queryPool;
+	uint32_t query;
+	VkQueryControlFlags flags;
+};
+
+struct CmdEndQuery : Command
+{
+	static constexpr Type TYPE = END_QUERY;
+
+	VkQueryPool queryPool;
+	uint32_t query;
+};
+
+struct CmdResetQueryPool : Command
+{
+	static constexpr Type TYPE = RESET_QUERY_POOL;
+
+	VkQueryPool queryPool;
+	uint32_t firstQuery;
+	uint32_t queryCount;
+};
+
+struct CmdWriteTimestamp : Command
+{
+	static constexpr Type TYPE = WRITE_TIMESTAMP;
+
+	VkPipelineStageFlagBits pipelineStage;
+	VkQueryPool queryPool;
+	uint32_t query;
+};
+
+struct CmdCopyQueryPoolResults : Command
+{
+	static constexpr Type TYPE = COPY_QUERY_POOL_RESULTS;
+
+	VkQueryPool queryPool;
+	uint32_t firstQuery;
+	uint32_t queryCount;
+	VkBuffer dstBuffer;
+	VkDeviceSize dstOffset;
+	VkDeviceSize stride;
+	VkQueryResultFlags flags;
+};
+
+struct CmdPushConstants : Command
+{
+	static constexpr Type TYPE = PUSH_CONSTANTS;
+
+	VkPipelineLayout layout;
+	VkShaderStageFlags stageFlags;
+	uint32_t offset;
+	uint32_t size;
+	const uint8_t* pValues;
+};
+
+struct CmdSetViewport : Command
+{
+	static constexpr Type TYPE = SET_VIEWPORT;
+
+	uint32_t firstViewport;
+	uint32_t viewportCount;
+	const VkViewport* pViewports;
+};
+
+struct CmdSetScissor : Command
+{
+	static constexpr Type TYPE = SET_SCISSOR;
+
+	uint32_t firstScissor;
+	uint32_t scissorCount;
+	const VkRect2D* pScissors;
+};
+
+struct CmdSetLineWidth : Command
+{
+	static constexpr Type TYPE = SET_LINE_WIDTH;
+
+	float lineWidth;
+};
+
+struct CmdSetDepthBias : Command
+{
+	static constexpr Type TYPE = SET_DEPTH_BIAS;
+
+	float depthBiasConstantFactor;
+	float depthBiasClamp;
+	float depthBiasSlopeFactor;
+};
+
+struct CmdSetBlendConstants : Command
+{
+	static constexpr Type TYPE = SET_BLEND_CONSTANTS;
+
+	float blendConstants[4];
+};
+
+struct CmdSetDepthBounds : Command
+{
+	static constexpr Type TYPE = SET_DEPTH_BOUNDS;
+
+	float minDepthBounds;
+	float maxDepthBounds;
+};
+
+struct CmdSetStencilCompareMask : Command
+{
+	static constexpr Type TYPE = SET_STENCIL_COMPARE_MASK;
+
+	VkStencilFaceFlags faceMask;
+	uint32_t compareMask;
+};
+
+struct CmdSetStencilWriteMask : Command
+{
+	static constexpr Type TYPE = SET_STENCIL_WRITE_MASK;
+
+	VkStencilFaceFlags faceMask;
+	uint32_t writeMask;
+};
+
+struct CmdSetStencilReference : Command
+{
+	static constexpr Type TYPE = SET_STENCIL_REFERENCE;
+
+	VkStencilFaceFlags faceMask;
+	uint32_t reference;
+};
+
+struct CmdBindDescriptorSets : Command
+{
+	static constexpr Type TYPE = BIND_DESCRIPTOR_SETS;
+
+	VkPipelineBindPoint pipelineBindPoint;
+	VkPipelineLayout layout;
+	uint32_t firstSet;
+	uint32_t descriptorSetCount;
+	const VkDescriptorSet* pDescriptorSets;
+	uint32_t dynamicOffsetCount;
+	const uint32_t* pDynamicOffsets;
+};
+
+struct CmdBindIndexBuffer : Command
+{
+	static constexpr Type TYPE = BIND_INDEX_BUFFER;
+
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	VkIndexType indexType;
+};
+
+struct CmdDispatch : Command
+{
+	static constexpr Type TYPE = DISPATCH;
+
+	uint32_t groupCountX;
+	uint32_t groupCountY;
+	uint32_t groupCountZ;
+};
+
+struct CmdDispatchIndirect : Command
+{
+	static constexpr Type TYPE = DISPATCH_INDIRECT;
+
+	VkBuffer buffer;
+	VkDeviceSize offset;
+};
+
+struct CmdCopyBuffer : Command
+{
+	static constexpr Type TYPE = COPY_BUFFER;
+
+	VkBuffer srcBuffer;
+	VkBuffer dstBuffer;
+	uint32_t regionCount;
+	const VkBufferCopy* pRegions;
+};
+
+struct CmdCopyImage : Command
+{
+	static constexpr Type TYPE = COPY_IMAGE;
+
+	VkImage srcImage;
+	VkImageLayout srcImageLayout;
+	VkImage dstImage;
+	VkImageLayout dstImageLayout;
+	uint32_t regionCount;
+	const VkImageCopy* pRegions;
+};
+
+struct CmdBlitImage : Command
+{
+	static constexpr Type TYPE = BLIT_IMAGE;
+
+	VkImage srcImage;
+	VkImageLayout srcImageLayout;
+	VkImage dstImage;
+	VkImageLayout dstImageLayout;
+	uint32_t regionCount;
+	const VkImageBlit* pRegions;
+	VkFilter filter;
+};
+
+struct CmdCopyBufferToImage : Command
+{
+	static constexpr Type TYPE = COPY_BUFFER_TO_IMAGE;
+
+	VkBuffer srcBuffer;
+	VkImage dstImage;
+	VkImageLayout dstImageLayout;
+	uint32_t regionCount;
+	const VkBufferImageCopy* pRegions;
+};
+
+struct CmdCopyImageToBuffer : Command
+{
+	static constexpr Type TYPE = COPY_IMAGE_TO_BUFFER;
+
+	VkImage srcImage;
+	VkImageLayout srcImageLayout;
+	VkBuffer dstBuffer;
+	uint32_t regionCount;
+	const VkBufferImageCopy* pRegions;
+};
+
+struct CmdUpdateBuffer : Command
+{
+	static constexpr Type TYPE = UPDATE_BUFFER;
+
+	VkBuffer dstBuffer;
+	VkDeviceSize dstOffset;
+	VkDeviceSize dataSize;
+	const uint8_t* pData;
+};
+
+struct CmdFillBuffer : Command
+{
+	static constexpr Type TYPE = FILL_BUFFER;
+
+	VkBuffer dstBuffer;
+	VkDeviceSize dstOffset;
+	VkDeviceSize size;
+	uint32_t data;
+};
+
+struct CmdClearColorImage : Command
+{
+	static constexpr Type TYPE = CLEAR_COLOR_IMAGE;
+
+	VkImage image;
+	VkImageLayout imageLayout;
+	VkClearColorValue color;
+	uint32_t rangeCount;
+	const VkImageSubresourceRange* pRanges;
+};
+
+struct CmdClearDepthStencilImage : Command
+{
+	static constexpr Type TYPE = CLEAR_DEPTH_STENCIL_IMAGE;
+
+	VkImage image;
+	VkImageLayout imageLayout;
+	VkClearDepthStencilValue depthStencil;
+	uint32_t rangeCount;
+	const VkImageSubresourceRange* pRanges;
+};
+
+struct CmdClearAttachments : Command
+{
+	static constexpr Type TYPE = CLEAR_ATTACHMENTS;
+
+	uint32_t attachmentCount;
+	const VkClearAttachment* pAttachments;
+	uint32_t rectCount;
+	const VkClearRect* pRects;
+};
+
+struct CmdResolveImage : Command
+{
+	static constexpr Type TYPE = RESOLVE_IMAGE;
+
+	VkImage srcImage;
+	VkImageLayout srcImageLayout;
+	VkImage dstImage;
+	VkImageLayout dstImageLayout;
+	uint32_t regionCount;
+	const VkImageResolve* pRegions;
+};
+
+struct CmdSetEvent : Command
+{
+	static constexpr Type TYPE = SET_EVENT;
+
+	VkEvent event;
+	VkPipelineStageFlags stageMask;
+};
+
+struct CmdResetEvent : Command
+{
+	static constexpr Type TYPE = RESET_EVENT;
+
+	VkEvent event;
+	VkPipelineStageFlags stageMask;
+};
+
+struct CmdWaitEvents : Command
+{
+	static constexpr Type TYPE = WAIT_EVENTS;
+
+	uint32_t eventCount;
+	const VkEvent* pEvents;
+	VkPipelineStageFlags srcStageMask;
+	VkPipelineStageFlags dstStageMask;
+	uint32_t memoryBarrierCount;
+	const VkMemoryBarrier* pMemoryBarriers;
+	uint32_t bufferMemoryBarrierCount;
+	const VkBufferMemoryBarrier* pBufferMemoryBarriers;
+	uint32_t imageMemoryBarrierCount;
+	const VkImageMemoryBarrier* pImageMemoryBarriers;
+};
+
+struct CmdDraw : Command
+{
+	static constexpr Type TYPE = DRAW;
+
+	uint32_t vertexCount;
+	uint32_t instanceCount;
+	uint32_t firstVertex;
+	uint32_t firstInstance;
+};
+
+struct CmdDrawIndexed : Command
+{
+	static constexpr Type TYPE = DRAW_INDEXED;
+
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t firstInstance;
+};
+
+struct CmdDrawIndirect : Command
+{
+	static constexpr Type TYPE = DRAW_INDIRECT;
+
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	uint32_t drawCount;
+	uint32_t stride;
+};
+
+struct CmdDrawIndexedIndirect : Command
+{
+	static constexpr Type TYPE = DRAW_INDEXED_INDIRECT;
+
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	uint32_t drawCount;
+	uint32_t stride;
+};
+
+// Keeps every packet, and every array within one, 8 byte aligned
+inline size_t Align(size_t size)
+{
+	return (size + 7) & ~size_t(7);
+}
+
+template<typename T>
+size_t ArraySize(uint32_t count)
+{
+	return Align(sizeof(T) * count);
+}
+
+// Array parameters are stored after the fixed size part of the packet
+template<typename T>
+uint8_t* Payload(T* command)
+{
+	return reinterpret_cast<uint8_t*>(command) + Align(sizeof(T));
+}
+
+template<typename T>
+const T* CopyArray(uint8_t*& payload, const T* array, uint32_t count)
+{
+	T* copy = reinterpret_cast<T*>(payload);
+	if(count > 0)
+	{
+		memcpy(copy, array, sizeof(T) * count);
+	}
+	payload += ArraySize<T>(count);
+
+	return copy;
+}
+
+} // anonymous namespace
+
+CommandBuffer::CommandBuffer(CommandPool* pPool, VkCommandBufferLevel pLevel) : level(pLevel), pool(pPool)
 {
-	pipelines[VK_PIPELINE_BIND_POINT_GRAPHICS] = VK_NULL_HANDLE;
-	pipelines[VK_PIPELINE_BIND_POINT_COMPUTE] = VK_NULL_HANDLE;
 }
 
 void CommandBuffer::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	releaseCommands();
+}
+
+template<typename T>
+T* CommandBuffer::addCommand(size_t payloadSize)
+{
+	ASSERT(state == RECORDING);
+
+	size_t size = Align(sizeof(T)) + payloadSize;
+	T* command = reinterpret_cast<T*>(allocateCommand(size));
+
+	if(command)
+	{
+		command->type = T::TYPE;
+		command->size = static_cast<uint32_t>(size);
+	}
+
+	return command;
+}
+
+void* CommandBuffer::allocateCommand(size_t size)
+{
+	if(!lastChunk || (lastChunk->used + size > lastChunk->size))
+	{
+		CommandPool::Chunk* chunk = pool->acquireChunk(size);
+
+		if(!chunk)
+		{
+			// Reported by end()
+			outOfMemory = true;
+			return nullptr;
+		}
+
+		if(lastChunk)
+		{
+			lastChunk->next = chunk;
+		}
+		else
+		{
+			firstChunk = chunk;
+		}
+
+		lastChunk = chunk;
+	}
+
+	void* command = lastChunk->data() + lastChunk->used;
+	lastChunk->used += size;
+
+	return command;
+}
+
+void CommandBuffer::releaseCommands()
+{
+	if(firstChunk)
+	{
+		pool->releaseChunks(firstChunk, lastChunk);
+	}
+
+	firstChunk = nullptr;
+	lastChunk = nullptr;
+	outOfMemory = false;
 }
 
 VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo* pInheritanceInfo)
 {
-	state = RECORDING;
+	ASSERT((state != RECORDING) && (state != PENDING));
 
-	UNIMPLEMENTED();
+	// Beginning a command buffer which isn't in the initial state implicitly resets it
+	releaseCommands();
+
+	usageFlags = flags;
+	state = RECORDING;
 
 	return VK_SUCCESS;
 }
 
 VkResult CommandBuffer::end()
 {
-	state = EXECUTABLE;
+	ASSERT(state == RECORDING);
 
-	UNIMPLEMENTED();
+	if(outOfMemory)
+	{
+		state = INVALID;
+
+		return VK_ERROR_OUT_OF_HOST_MEMORY;
+	}
+
+	state = EXECUTABLE;
 
 	return VK_SUCCESS;
 }
@@ -49,9 +683,9 @@ VkResult CommandBuffer::reset(VkCommandPoolResetFlags flags)
 {
 	ASSERT(state != PENDING);
 
-	UNIMPLEMENTED();
+	// The chunks go back to the pool, which decides when to release them
+	releaseCommands();
 
-	// FIXME: put command buffer back to the initial state
 	state = INITIAL;
 
 	return VK_SUCCESS;
@@ -60,33 +694,61 @@ VkResult CommandBuffer::reset(VkCommandPoolResetFlags flags)
 void CommandBuffer::beginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkRect2D renderArea,
                                     uint32_t clearValueCount, const VkClearValue* pClearValues, VkSubpassContents contents)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdBeginRenderPass>(ArraySize<VkClearValue>(clearValueCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->renderPass = renderPass;
+	command->framebuffer = framebuffer;
+	command->renderArea = renderArea;
+	command->clearValueCount = clearValueCount;
+	command->pClearValues = CopyArray(payload, pClearValues, clearValueCount);
+	command->contents = contents;
 }
 
 void CommandBuffer::nextSubpass(VkSubpassContents contents)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdNextSubpass>();
+	if(!command) { return; }
+
+	command->contents = contents;
 }
 
 void CommandBuffer::endRenderPass()
 {
-	UNIMPLEMENTED();
+	addCommand<CmdEndRenderPass>();
 }
 
 void CommandBuffer::executeCommands(uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdExecuteCommands>(ArraySize<VkCommandBuffer>(commandBufferCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->commandBufferCount = commandBufferCount;
+	command->pCommandBuffers = CopyArray(payload, pCommandBuffers, commandBufferCount);
 }
 
 void CommandBuffer::setDeviceMask(uint32_t deviceMask)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetDeviceMask>();
+	if(!command) { return; }
+
+	command->deviceMask = deviceMask;
 }
 
 void CommandBuffer::dispatchBase(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
                                  uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdDispatchBase>();
+	if(!command) { return; }
+
+	command->baseGroupX = baseGroupX;
+	command->baseGroupY = baseGroupY;
+	command->baseGroupZ = baseGroupZ;
+	command->groupCountX = groupCountX;
+	command->groupCountY = groupCountY;
+	command->groupCountZ = groupCountZ;
 }
 
 void CommandBuffer::pipelineBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
@@ -95,66 +757,135 @@ void CommandBuffer::pipelineBarrier(VkPipelineStageFlags srcStageMask, VkPipelin
                                     uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers,
                                     uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdPipelineBarrier>(ArraySize<VkMemoryBarrier>(memoryBarrierCount) +
+	                                              ArraySize<VkBufferMemoryBarrier>(bufferMemoryBarrierCount) +
+	                                              ArraySize<VkImageMemoryBarrier>(imageMemoryBarrierCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->srcStageMask = srcStageMask;
+	command->dstStageMask = dstStageMask;
+	command->dependencyFlags = dependencyFlags;
+	command->memoryBarrierCount = memoryBarrierCount;
+	command->pMemoryBarriers = CopyArray(payload, pMemoryBarriers, memoryBarrierCount);
+	command->bufferMemoryBarrierCount = bufferMemoryBarrierCount;
+	command->pBufferMemoryBarriers = CopyArray(payload, pBufferMemoryBarriers, bufferMemoryBarrierCount);
+	command->imageMemoryBarrierCount = imageMemoryBarrierCount;
+	command->pImageMemoryBarriers = CopyArray(payload, pImageMemoryBarriers, imageMemoryBarrierCount);
 }
 
 void CommandBuffer::bindPipeline(VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
 {
-	pipelines[pipelineBindPoint] = pipeline;
+	auto command = addCommand<CmdBindPipeline>();
+	if(!command) { return; }
+
+	command->pipelineBindPoint = pipelineBindPoint;
+	command->pipeline = pipeline;
 }
 
 void CommandBuffer::bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount,
                                       const VkBuffer* pBuffers, const VkDeviceSize* pOffsets)
 {
-	for(uint32_t i = firstBinding; i < (firstBinding + bindingCount); ++i)
-	{
-		vertexInputBindings[i].buffer = pBuffers[i];
-		vertexInputBindings[i].offset = pOffsets[i];
-	}
+	auto command = addCommand<CmdBindVertexBuffers>(ArraySize<VkBuffer>(bindingCount) + ArraySize<VkDeviceSize>(bindingCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->firstBinding = firstBinding;
+	command->bindingCount = bindingCount;
+	command->pBuffers = CopyArray(payload, pBuffers, bindingCount);
+	command->pOffsets = CopyArray(payload, pOffsets, bindingCount);
 }
 
 void CommandBuffer::beginQuery(VkQueryPool queryPool, uint32_t query, VkQueryControlFlags flags)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdBeginQuery>();
+	if(!command) { return; }
+
+	command->queryPool = queryPool;
+	command->query = query;
+	command->flags = flags;
 }
 
 void CommandBuffer::endQuery(VkQueryPool queryPool, uint32_t query)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdEndQuery>();
+	if(!command) { return; }
+
+	command->queryPool = queryPool;
+	command->query = query;
 }
 
 void CommandBuffer::resetQueryPool(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdResetQueryPool>();
+	if(!command) { return; }
+
+	command->queryPool = queryPool;
+	command->firstQuery = firstQuery;
+	command->queryCount = queryCount;
 }
 
 void CommandBuffer::writeTimestamp(VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdWriteTimestamp>();
+	if(!command) { return; }
+
+	command->pipelineStage = pipelineStage;
+	command->queryPool = queryPool;
+	command->query = query;
 }
 
 void CommandBuffer::copyQueryPoolResults(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount,
 	VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize stride, VkQueryResultFlags flags)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdCopyQueryPoolResults>();
+	if(!command) { return; }
+
+	command->queryPool = queryPool;
+	command->firstQuery = firstQuery;
+	command->queryCount = queryCount;
+	command->dstBuffer = dstBuffer;
+	command->dstOffset = dstOffset;
+	command->stride = stride;
+	command->flags = flags;
 }
 
 void CommandBuffer::pushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags,
 	uint32_t offset, uint32_t size, const void* pValues)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdPushConstants>(ArraySize<uint8_t>(size));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->layout = layout;
+	command->stageFlags = stageFlags;
+	command->offset = offset;
+	command->size = size;
+	command->pValues = CopyArray(payload, reinterpret_cast<const uint8_t*>(pValues), size);
 }
 
 void CommandBuffer::setViewport(uint32_t firstViewport, uint32_t viewportCount, const VkViewport* pViewports)
 {
 	// Note: The bound graphics pipeline must have been created with the VK_DYNAMIC_STATE_VIEWPORT dynamic state enabled
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetViewport>(ArraySize<VkViewport>(viewportCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->firstViewport = firstViewport;
+	command->viewportCount = viewportCount;
+	command->pViewports = CopyArray(payload, pViewports, viewportCount);
 }
 
 void CommandBuffer::setScissor(uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* pScissors)
 {
 	// Note: The bound graphics pipeline must have been created with the VK_DYNAMIC_STATE_SCISSOR dynamic state enabled
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetScissor>(ArraySize<VkRect2D>(scissorCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->firstScissor = firstScissor;
+	command->scissorCount = scissorCount;
+	command->pScissors = CopyArray(payload, pScissors, scissorCount);
 }
 
 void CommandBuffer::setLineWidth(float lineWidth)
@@ -164,7 +895,10 @@ void CommandBuffer::setLineWidth(float lineWidth)
 	// If the wide lines feature is not enabled, lineWidth must be 1.0
 	ASSERT(lineWidth == 1.0f);
 
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetLineWidth>();
+	if(!command) { return; }
+
+	command->lineWidth = lineWidth;
 }
 
 void CommandBuffer::setDepthBias(float depthBiasConstantFactor, float depthBiasClamp, float depthBiasSlopeFactor)
@@ -174,7 +908,12 @@ void CommandBuffer::setDepthBias(float depthBiasConstantFactor, float depthBiasC
 	// If the depth bias clamping feature is not enabled, depthBiasClamp must be 0.0
 	ASSERT(depthBiasClamp == 0.0f);
 
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetDepthBias>();
+	if(!command) { return; }
+
+	command->depthBiasConstantFactor = depthBiasConstantFactor;
+	command->depthBiasClamp = depthBiasClamp;
+	command->depthBiasSlopeFactor = depthBiasSlopeFactor;
 }
 
 void CommandBuffer::setBlendConstants(const float blendConstants[4])
@@ -184,7 +923,10 @@ void CommandBuffer::setBlendConstants(const float blendConstants[4])
 	// blendConstants is an array of four values specifying the R, G, B, and A components
 	// of the blend constant color used in blending, depending on the blend factor.
 
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetBlendConstants>();
+	if(!command) { return; }
+
+	memcpy(command->blendConstants, blendConstants, sizeof(command->blendConstants));
 }
 
 void CommandBuffer::setDepthBounds(float minDepthBounds, float maxDepthBounds)
@@ -195,7 +937,11 @@ void CommandBuffer::setDepthBounds(float minDepthBounds, float maxDepthBounds)
 	ASSERT(minDepthBounds >= 0.0f && minDepthBounds <= 1.0f);
 	ASSERT(maxDepthBounds >= 0.0f && maxDepthBounds <= 1.0f);
 
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetDepthBounds>();
+	if(!command) { return; }
+
+	command->minDepthBounds = minDepthBounds;
+	command->maxDepthBounds = maxDepthBounds;
 }
 
 void CommandBuffer::setStencilCompareMask(VkStencilFaceFlags faceMask, uint32_t compareMask)
@@ -205,7 +951,11 @@ void CommandBuffer::setStencilCompareMask(VkStencilFaceFlags faceMask, uint32_t
 	// faceMask must not be 0
 	ASSERT(faceMask != 0);
 
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetStencilCompareMask>();
+	if(!command) { return; }
+
+	command->faceMask = faceMask;
+	command->compareMask = compareMask;
 }
 
 void CommandBuffer::setStencilWriteMask(VkStencilFaceFlags faceMask, uint32_t writeMask)
@@ -215,7 +965,11 @@ void CommandBuffer::setStencilWriteMask(VkStencilFaceFlags faceMask, uint32_t wr
 	// faceMask must not be 0
 	ASSERT(faceMask != 0);
 
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetStencilWriteMask>();
+	if(!command) { return; }
+
+	command->faceMask = faceMask;
+	command->writeMask = writeMask;
 }
 
 void CommandBuffer::setStencilReference(VkStencilFaceFlags faceMask, uint32_t reference)
@@ -225,102 +979,227 @@ void CommandBuffer::setStencilReference(VkStencilFaceFlags faceMask, uint32_t re
 	// faceMask must not be 0
 	ASSERT(faceMask != 0);
 
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetStencilReference>();
+	if(!command) { return; }
+
+	command->faceMask = faceMask;
+	command->reference = reference;
 }
 
 void CommandBuffer::bindDescriptorSets(VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout,
 	uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets,
 	uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdBindDescriptorSets>(ArraySize<VkDescriptorSet>(descriptorSetCount) +
+	                                                 ArraySize<uint32_t>(dynamicOffsetCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->pipelineBindPoint = pipelineBindPoint;
+	command->layout = layout;
+	command->firstSet = firstSet;
+	command->descriptorSetCount = descriptorSetCount;
+	command->pDescriptorSets = CopyArray(payload, pDescriptorSets, descriptorSetCount);
+	command->dynamicOffsetCount = dynamicOffsetCount;
+	command->pDynamicOffsets = CopyArray(payload, pDynamicOffsets, dynamicOffsetCount);
 }
 
 void CommandBuffer::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdBindIndexBuffer>();
+	if(!command) { return; }
+
+	command->buffer = buffer;
+	command->offset = offset;
+	command->indexType = indexType;
 }
 
 void CommandBuffer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdDispatch>();
+	if(!command) { return; }
+
+	command->groupCountX = groupCountX;
+	command->groupCountY = groupCountY;
+	command->groupCountZ = groupCountZ;
 }
 
 void CommandBuffer::dispatchIndirect(VkBuffer buffer, VkDeviceSize offset)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdDispatchIndirect>();
+	if(!command) { return; }
+
+	command->buffer = buffer;
+	command->offset = offset;
 }
 
 void CommandBuffer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy* pRegions)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdCopyBuffer>(ArraySize<VkBufferCopy>(regionCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->srcBuffer = srcBuffer;
+	command->dstBuffer = dstBuffer;
+	command->regionCount = regionCount;
+	command->pRegions = CopyArray(payload, pRegions, regionCount);
 }
 
 void CommandBuffer::copyImage(VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout,
 	uint32_t regionCount, const VkImageCopy* pRegions)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdCopyImage>(ArraySize<VkImageCopy>(regionCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->srcImage = srcImage;
+	command->srcImageLayout = srcImageLayout;
+	command->dstImage = dstImage;
+	command->dstImageLayout = dstImageLayout;
+	command->regionCount = regionCount;
+	command->pRegions = CopyArray(payload, pRegions, regionCount);
 }
 
 void CommandBuffer::blitImage(VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout,
 	uint32_t regionCount, const VkImageBlit* pRegions, VkFilter filter)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdBlitImage>(ArraySize<VkImageBlit>(regionCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->srcImage = srcImage;
+	command->srcImageLayout = srcImageLayout;
+	command->dstImage = dstImage;
+	command->dstImageLayout = dstImageLayout;
+	command->regionCount = regionCount;
+	command->pRegions = CopyArray(payload, pRegions, regionCount);
+	command->filter = filter;
 }
 
 void CommandBuffer::copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout,
 	uint32_t regionCount, const VkBufferImageCopy* pRegions)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdCopyBufferToImage>(ArraySize<VkBufferImageCopy>(regionCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->srcBuffer = srcBuffer;
+	command->dstImage = dstImage;
+	command->dstImageLayout = dstImageLayout;
+	command->regionCount = regionCount;
+	command->pRegions = CopyArray(payload, pRegions, regionCount);
 }
 
 void CommandBuffer::copyImageToBuffer(VkImage srcImage, VkImageLayout srcImageLayout, VkBuffer dstBuffer,
 	uint32_t regionCount, const VkBufferImageCopy* pRegions)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdCopyImageToBuffer>(ArraySize<VkBufferImageCopy>(regionCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->srcImage = srcImage;
+	command->srcImageLayout = srcImageLayout;
+	command->dstBuffer = dstBuffer;
+	command->regionCount = regionCount;
+	command->pRegions = CopyArray(payload, pRegions, regionCount);
 }
 
 void CommandBuffer::updateBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize dataSize, const void* pData)
 {
-	UNIMPLEMENTED();
+	// dataSize is at most 65536 bytes, so the data is stored in the command stream itself
+	auto command = addCommand<CmdUpdateBuffer>(ArraySize<uint8_t>(static_cast<uint32_t>(dataSize)));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->dstBuffer = dstBuffer;
+	command->dstOffset = dstOffset;
+	command->dataSize = dataSize;
+	command->pData = CopyArray(payload, reinterpret_cast<const uint8_t*>(pData), static_cast<uint32_t>(dataSize));
 }
 
 void CommandBuffer::fillBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdFillBuffer>();
+	if(!command) { return; }
+
+	command->dstBuffer = dstBuffer;
+	command->dstOffset = dstOffset;
+	command->size = size;
+	command->data = data;
 }
 
 void CommandBuffer::clearColorImage(VkImage image, VkImageLayout imageLayout, const VkClearColorValue* pColor,
 	uint32_t rangeCount, const VkImageSubresourceRange* pRanges)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdClearColorImage>(ArraySize<VkImageSubresourceRange>(rangeCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->image = image;
+	command->imageLayout = imageLayout;
+	command->color = *pColor;
+	command->rangeCount = rangeCount;
+	command->pRanges = CopyArray(payload, pRanges, rangeCount);
 }
 
 void CommandBuffer::clearDepthStencilImage(VkImage image, VkImageLayout imageLayout, const VkClearDepthStencilValue* pDepthStencil,
 	uint32_t rangeCount, const VkImageSubresourceRange* pRanges)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdClearDepthStencilImage>(ArraySize<VkImageSubresourceRange>(rangeCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->image = image;
+	command->imageLayout = imageLayout;
+	command->depthStencil = *pDepthStencil;
+	command->rangeCount = rangeCount;
+	command->pRanges = CopyArray(payload, pRanges, rangeCount);
 }
 
 void CommandBuffer::clearAttachments(uint32_t attachmentCount, const VkClearAttachment* pAttachments,
 	uint32_t rectCount, const VkClearRect* pRects)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdClearAttachments>(ArraySize<VkClearAttachment>(attachmentCount) + ArraySize<VkClearRect>(rectCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->attachmentCount = attachmentCount;
+	command->pAttachments = CopyArray(payload, pAttachments, attachmentCount);
+	command->rectCount = rectCount;
+	command->pRects = CopyArray(payload, pRects, rectCount);
 }
 
 void CommandBuffer::resolveImage(VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout,
 	uint32_t regionCount, const VkImageResolve* pRegions)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdResolveImage>(ArraySize<VkImageResolve>(regionCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->srcImage = srcImage;
+	command->srcImageLayout = srcImageLayout;
+	command->dstImage = dstImage;
+	command->dstImageLayout = dstImageLayout;
+	command->regionCount = regionCount;
+	command->pRegions = CopyArray(payload, pRegions, regionCount);
 }
 
 void CommandBuffer::setEvent(VkEvent event, VkPipelineStageFlags stageMask)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdSetEvent>();
+	if(!command) { return; }
+
+	command->event = event;
+	command->stageMask = stageMask;
 }
 
 void CommandBuffer::resetEvent(VkEvent event, VkPipelineStageFlags stageMask)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdResetEvent>();
+	if(!command) { return; }
+
+	command->event = event;
+	command->stageMask = stageMask;
 }
 
 void CommandBuffer::waitEvents(uint32_t eventCount, const VkEvent* pEvents, VkPipelineStageFlags srcStageMask,
@@ -328,38 +1207,183 @@ void CommandBuffer::waitEvents(uint32_t eventCount, const VkEvent* pEvents, VkPi
 	uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers,
 	uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdWaitEvents>(ArraySize<VkEvent>(eventCount) +
+	                                         ArraySize<VkMemoryBarrier>(memoryBarrierCount) +
+	                                         ArraySize<VkBufferMemoryBarrier>(bufferMemoryBarrierCount) +
+	                                         ArraySize<VkImageMemoryBarrier>(imageMemoryBarrierCount));
+	if(!command) { return; }
+
+	uint8_t* payload = Payload(command);
+	command->eventCount = eventCount;
+	command->pEvents = CopyArray(payload, pEvents, eventCount);
+	command->srcStageMask = srcStageMask;
+	command->dstStageMask = dstStageMask;
+	command->memoryBarrierCount = memoryBarrierCount;
+	command->pMemoryBarriers = CopyArray(payload, pMemoryBarriers, memoryBarrierCount);
+	command->bufferMemoryBarrierCount = bufferMemoryBarrierCount;
+	command->pBufferMemoryBarriers = CopyArray(payload, pBufferMemoryBarriers, bufferMemoryBarrierCount);
+	command->imageMemoryBarrierCount = imageMemoryBarrierCount;
+	command->pImageMemoryBarriers = CopyArray(payload, pImageMemoryBarriers, imageMemoryBarrierCount);
 }
 
 void CommandBuffer::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdDraw>();
+	if(!command) { return; }
+
+	command->vertexCount = vertexCount;
+	command->instanceCount = instanceCount;
+	command->firstVertex = firstVertex;
+	command->firstInstance = firstInstance;
 }
 
 void CommandBuffer::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdDrawIndexed>();
+	if(!command) { return; }
+
+	command->indexCount = indexCount;
+	command->instanceCount = instanceCount;
+	command->firstIndex = firstIndex;
+	command->vertexOffset = vertexOffset;
+	command->firstInstance = firstInstance;
 }
 
 void CommandBuffer::drawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdDrawIndirect>();
+	if(!command) { return; }
+
+	command->buffer = buffer;
+	command->offset = offset;
+	command->drawCount = drawCount;
+	command->stride = stride;
 }
 
 void CommandBuffer::drawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
 {
-	UNIMPLEMENTED();
+	auto command = addCommand<CmdDrawIndexedIndirect>();
+	if(!command) { return; }
+
+	command->buffer = buffer;
+	command->offset = offset;
+	command->drawCount = drawCount;
+	command->stride = stride;
 }
 
 void CommandBuffer::submit()
 {
+	ASSERT(state == EXECUTABLE);
+
 	// Perform recorded work
 	state = PENDING;
 
-	UNIMPLEMENTED();
+	ExecutionState executionState;
+	execute(executionState);
 
-	// After work is completed
-	state = EXECUTABLE;
+	// After work is completed. A one-time submission can't be submitted again until it's re-recorded.
+	state = (usageFlags & VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT) ? INVALID : EXECUTABLE;
+}
+
+void CommandBuffer::execute(ExecutionState& state) const
+{
+	for(const CommandPool::Chunk* chunk = firstChunk; chunk; chunk = chunk->next)
+	{
+		const uint8_t* command = chunk->data();
+		const uint8_t* end = command + chunk->used;
+
+		while(command < end)
+		{
+			const Command* header = reinterpret_cast<const Command*>(command);
+			execute(header, state);
+			command += header->size;
+		}
+	}
+}
+
+void CommandBuffer::ExecuteSecondaries(uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers, const ExecutionState& primaryState)
+{
+	// According to the Vulkan spec, section 5.6. Secondary Command Buffer Execution:
+	// "If vkCmdExecuteCommands is being called within a render pass instance, that render pass
+	//  instance is considered to be continued within the secondary command buffers."
+	// Nothing else is inherited, so each secondary command buffer starts out with fresh state.
+	ExecutionState initialState;
+	initialState.renderPass = primaryState.renderPass;
+	initialState.framebuffer = primaryState.framebuffer;
+
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		ExecutionState state = initialState;
+		Cast(pCommandBuffers[i])->execute(state);
+	}
+}
+
+void CommandBuffer::execute(const Command* command, ExecutionState& state) const
+{
+	switch(command->type)
+	{
+	case Command::BEGIN_RENDER_PASS:
+		{
+			auto beginRenderPass = static_cast<const CmdBeginRenderPass*>(command);
+			state.renderPass = beginRenderPass->renderPass;
+			state.framebuffer = beginRenderPass->framebuffer;
+			state.subpassContents = beginRenderPass->contents;
+			UNIMPLEMENTED();   // Attachment load operations
+		}
+		break;
+	case Command::NEXT_SUBPASS:
+		{
+			auto nextSubpass = static_cast<const CmdNextSubpass*>(command);
+			state.subpassContents = nextSubpass->contents;
+		}
+		break;
+	case Command::END_RENDER_PASS:
+		{
+			state.renderPass = VK_NULL_HANDLE;
+			state.framebuffer = VK_NULL_HANDLE;
+			state.subpassContents = VK_SUBPASS_CONTENTS_INLINE;
+			UNIMPLEMENTED();   // Attachment store operations
+		}
+		break;
+	case Command::BIND_PIPELINE:
+		{
+			auto bindPipeline = static_cast<const CmdBindPipeline*>(command);
+			state.pipelines[bindPipeline->pipelineBindPoint] = bindPipeline->pipeline;
+		}
+		break;
+	case Command::BIND_VERTEX_BUFFERS:
+		{
+			auto bindVertexBuffers = static_cast<const CmdBindVertexBuffers*>(command);
+			for(uint32_t i = 0; i < bindVertexBuffers->bindingCount; i++)
+			{
+				state.vertexInputBindings[bindVertexBuffers->firstBinding + i].buffer = bindVertexBuffers->pBuffers[i];
+				state.vertexInputBindings[bindVertexBuffers->firstBinding + i].offset = bindVertexBuffers->pOffsets[i];
+			}
+		}
+		break;
+	case Command::SET_EVENT:
+		{
+			// Commands execute as they're submitted, so all earlier work has completed
+			auto setEvent = static_cast<const CmdSetEvent*>(command);
+			Cast(setEvent->event)->signal();
+		}
+		break;
+	case Command::RESET_EVENT:
+		{
+			auto resetEvent = static_cast<const CmdResetEvent*>(command);
+			Cast(resetEvent->event)->reset();
+		}
+		break;
+	case Command::EXECUTE_COMMANDS:
+		{
+			auto executeCommands = static_cast<const CmdExecuteCommands*>(command);
+			ExecuteSecondaries(executeCommands->commandBufferCount, executeCommands->pCommandBuffers, state);
+		}
+		break;
+	default:
+		UNIMPLEMENTED();
+		break;
+	}
 }
 
-} // namespace vk
\ No newline at end of file
+} // namespace vk
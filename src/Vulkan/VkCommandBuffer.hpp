@@ -15,8 +15,10 @@
 #ifndef VK_COMMAND_BUFFER_HPP_
 #define VK_COMMAND_BUFFER_HPP_
 
+#include "VkCommandPool.hpp"
 #include "VkConfig.h"
 #include "VkObject.hpp"
+#include <atomic>
 
 namespace vk
 {
@@ -26,7 +28,7 @@ class CommandBuffer
 public:
 	static constexpr VkSystemAllocationScope GetAllocationScope() { return VK_SYSTEM_ALLOCATION_SCOPE_OBJECT; }
 
-	CommandBuffer(VkCommandBufferLevel pLevel);
+	CommandBuffer(CommandPool* pPool, VkCommandBufferLevel pLevel);
 
 	void destroy(const VkAllocationCallbacks* pAllocator);
 
@@ -109,18 +111,29 @@ public:
 
 	void submit();
 
+	struct Command;   // Header of each packet in the recorded command stream
+
 private:
+	template<typename T>
+	T* addCommand(size_t payloadSize = 0);
+	void* allocateCommand(size_t size);
+	void releaseCommands();
+
+	struct ExecutionState;   // Bound state, which each command buffer execution tracks separately
+
+	void execute(ExecutionState& state) const;
+	void execute(const Command* command, ExecutionState& state) const;
+	static void ExecuteSecondaries(uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers, const ExecutionState& primaryState);
+
 	enum State { INITIAL, RECORDING, EXECUTABLE, PENDING, INVALID };
-	State state = INITIAL;
+	std::atomic<State> state { INITIAL };   // Changed by the queue thread, and checked by begin() and reset() on the application's threads
+	VkCommandBufferUsageFlags usageFlags = 0;
 	VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	VkPipeline pipelines[VK_PIPELINE_BIND_POINT_RANGE_SIZE];
-
-	struct VertexInputBindings
-	{
-		VkBuffer buffer;
-		VkDeviceSize offset;
-	};
-	VertexInputBindings vertexInputBindings[MAX_VERTEX_INPUT_BINDINGS];
+
+	CommandPool* pool = nullptr;
+	CommandPool::Chunk* firstChunk = nullptr;
+	CommandPool::Chunk* lastChunk = nullptr;
+	bool outOfMemory = false;
 };
 
 using DispatchableCommandBuffer = DispatchableObject<CommandBuffer, VkCommandBuffer>;
@@ -13,16 +13,30 @@
 // limitations under the License.
 
 #include "VkCommandPool.hpp"
+#include "VkCommandBuffer.hpp"
+#include "VkDestroy.h"
+#include <algorithm>
+#include <new> // Must #include this to use "placement new"
 
 namespace vk
 {
 
 CommandPool::CommandPool(const VkCommandPoolCreateInfo* pCreateInfo, void* mem)
 {
+	commandBuffers = new std::set<VkCommandBuffer>();
 }
 
 void CommandPool::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	// Free command buffers allocated from this pool
+	for(VkCommandBuffer commandBuffer : *commandBuffers)
+	{
+		vk::destroy(commandBuffer, DEVICE_MEMORY);
+	}
+
+	delete commandBuffers;
+
+	freeChunks();
 }
 
 size_t CommandPool::ComputeRequiredAllocationSize(const VkCommandPoolCreateInfo* pCreateInfo)
@@ -30,4 +44,106 @@ size_t CommandPool::ComputeRequiredAllocationSize(const VkCommandPoolCreateInfo*
 	return 0;
 }
 
+VkResult CommandPool::allocateCommandBuffers(VkCommandBufferLevel level, uint32_t commandBufferCount, VkCommandBuffer* pCommandBuffers)
+{
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		DispatchableCommandBuffer* commandBuffer = new (DEVICE_MEMORY) DispatchableCommandBuffer(this, level);
+
+		if(!commandBuffer)
+		{
+			freeCommandBuffers(i, pCommandBuffers);
+
+			for(uint32_t j = 0; j < commandBufferCount; j++)
+			{
+				pCommandBuffers[j] = VK_NULL_HANDLE;
+			}
+
+			return VK_ERROR_OUT_OF_HOST_MEMORY;
+		}
+
+		pCommandBuffers[i] = *commandBuffer;
+		commandBuffers->insert(pCommandBuffers[i]);
+	}
+
+	return VK_SUCCESS;
+}
+
+void CommandPool::freeCommandBuffers(uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers)
+{
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		if(pCommandBuffers[i] != VK_NULL_HANDLE)
+		{
+			commandBuffers->erase(pCommandBuffers[i]);
+			vk::destroy(pCommandBuffers[i], DEVICE_MEMORY);
+		}
+	}
+}
+
+VkResult CommandPool::reset(VkCommandPoolResetFlags flags)
+{
+	// Resetting a command buffer only hands its chunks back to the pool
+	for(VkCommandBuffer commandBuffer : *commandBuffers)
+	{
+		vk::Cast(commandBuffer)->reset(0);
+	}
+
+	if(flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT)
+	{
+		freeChunks();
+	}
+
+	return VK_SUCCESS;
+}
+
+void CommandPool::trim(VkCommandPoolTrimFlags flags)
+{
+	freeChunks();
+}
+
+CommandPool::Chunk* CommandPool::acquireChunk(size_t size)
+{
+	Chunk* chunk = freeList;
+
+	// Only the most recently released chunk is considered, so oversized commands can't cause a search
+	if(chunk && chunk->size >= size)
+	{
+		freeList = chunk->next;
+	}
+	else
+	{
+		size = std::max(size, size_t(COMMAND_CHUNK_SIZE));
+		chunk = reinterpret_cast<Chunk*>(vk::allocate(sizeof(Chunk) + size, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY));
+
+		if(!chunk)
+		{
+			return nullptr;
+		}
+
+		chunk->size = size;
+	}
+
+	chunk->next = nullptr;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+void CommandPool::releaseChunks(Chunk* first, Chunk* last)
+{
+	last->next = freeList;
+	freeList = first;
+}
+
+void CommandPool::freeChunks()
+{
+	while(freeList)
+	{
+		Chunk* next = freeList->next;
+		vk::deallocate(freeList, DEVICE_MEMORY);
+		freeList = next;
+	}
+}
+
 } // namespace vk
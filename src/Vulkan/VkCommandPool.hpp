@@ -16,6 +16,7 @@
 #define VK_COMMAND_POOL_HPP_
 
 #include "VkObject.hpp"
+#include <set>
 
 namespace vk
 {
@@ -29,7 +30,31 @@ public:
 
 	static size_t ComputeRequiredAllocationSize(const VkCommandPoolCreateInfo* pCreateInfo);
 
+	VkResult allocateCommandBuffers(VkCommandBufferLevel level, uint32_t commandBufferCount, VkCommandBuffer* pCommandBuffers);
+	void freeCommandBuffers(uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers);
+	VkResult reset(VkCommandPoolResetFlags flags);
+	void trim(VkCommandPoolTrimFlags flags);
+
+	// Command buffers record their commands into chunks owned by the pool.
+	// Chunks are recycled on reset instead of being returned to the system.
+	struct Chunk
+	{
+		Chunk* next;
+		size_t size;   // Bytes of command storage following this header
+		size_t used;
+
+		uint8_t* data() { return reinterpret_cast<uint8_t*>(this + 1); }
+		const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+	};
+
+	Chunk* acquireChunk(size_t size);
+	void releaseChunks(Chunk* first, Chunk* last);
+
 private:
+	void freeChunks();
+
+	std::set<VkCommandBuffer>* commandBuffers;
+	Chunk* freeList = nullptr;
 };
 
 static inline CommandPool* Cast(VkCommandPool object)
@@ -39,6 +39,7 @@ enum
 {
 	REQUIRED_MEMORY_ALIGNMENT = 8, // For 64 bit formats on ARM64
 	MEMORY_TYPE_GENERIC_BIT = 0x1, // Generic system memory.
+	MEMORY_TYPE_LAZILY_ALLOCATED_BIT = 0x2, // Transient attachments, only committed once accessed.
 };
 
 enum
@@ -55,6 +56,20 @@ enum
 	MAX_VERTEX_INPUT_BINDINGS = 16,
 };
 
+enum
+{
+	QUEUE_FAMILY_GRAPHICS = 0, // Graphics, compute and transfer
+	QUEUE_FAMILY_COMPUTE = 1,  // Compute and transfer
+	QUEUE_FAMILY_TRANSFER = 2, // Transfer only
+	QUEUE_FAMILY_COUNT = 3,
+	QUEUE_COUNT_PER_FAMILY = 4, // Each queue executes its submissions on its own thread
+};
+
+enum
+{
+	COMMAND_CHUNK_SIZE = 16 * 1024, // Default size of the blocks command buffers record into
+};
+
 }
 
 #endif // VK_CONFIG_HPP_
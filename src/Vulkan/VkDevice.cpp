@@ -15,6 +15,7 @@
 #include "VkConfig.h"
 #include "VkDebug.hpp"
 #include "VkDevice.hpp"
+#include "VkFence.hpp"
 #include "VkQueue.hpp"
 #include <new> // Must #include this to use "placement new"
 
@@ -45,6 +46,11 @@ Device::Device(const Device::CreateInfo* info, void* mem)
 
 void Device::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		queues[i].~Queue();
+	}
+
 	vk::deallocate(queues, pAllocator);
 }
 
@@ -61,9 +67,38 @@ size_t Device::ComputeRequiredAllocationSize(const Device::CreateInfo* info)
 
 VkQueue Device::getQueue(uint32_t queueFamilyIndex, uint32_t queueIndex) const
 {
-	ASSERT(queueFamilyIndex == 0);
+	// Queues are stored in the order they were requested, so the n-th queue of a family is the n-th match
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		if(queues[i].getFamilyIndex() == queueFamilyIndex)
+		{
+			if(queueIndex == 0)
+			{
+				return queues[i];
+			}
+
+			queueIndex--;
+		}
+	}
+
+	ASSERT(false);
+
+	return VK_NULL_HANDLE;
+}
+
+VkResult Device::waitForFences(uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout)
+{
+	return Fence::Wait(fenceCount, pFences, waitAll == VK_TRUE, timeout);
+}
+
+VkResult Device::waitIdle()
+{
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		queues[i].waitIdle();
+	}
 
-	return queues[queueIndex];
+	return VK_SUCCESS;
 }
 
 void Device::getDescriptorSetLayoutSupport(const VkDescriptorSetLayoutCreateInfo* pCreateInfo,
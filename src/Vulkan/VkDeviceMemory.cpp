@@ -15,10 +15,162 @@
 #include "VkDeviceMemory.hpp"
 
 #include "VkConfig.h"
+#include "System/Memory.hpp"
+
+#include <cstring>
+#include <mutex>
+#include <set>
 
 namespace vk
 {
 
+namespace
+{
+
+// Device memory is carved out of huge page sized chunks, using a buddy allocator,
+// so that rasterizing into many small images doesn't cost a TLB entry per 4 kB page.
+// Allocations larger than half a chunk get a mapping of their own.
+class Heap
+{
+public:
+	void* allocate(size_t size)
+	{
+		unsigned int order = Order(size);
+
+		if(order > MAX_ORDER)
+		{
+			return sw::allocatePages(size);
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		unsigned int freeOrder = order;
+		while(freeOrder <= CHUNK_ORDER && freeBlocks[freeOrder].empty())
+		{
+			freeOrder++;
+		}
+
+		uint8_t* block = nullptr;
+
+		if(freeOrder > CHUNK_ORDER)
+		{
+			block = reinterpret_cast<uint8_t*>(sw::allocatePages(ChunkSize()));
+
+			if(!block)
+			{
+				return nullptr;
+			}
+
+			freeOrder = CHUNK_ORDER;
+		}
+		else
+		{
+			block = *freeBlocks[freeOrder].begin();
+			freeBlocks[freeOrder].erase(freeBlocks[freeOrder].begin());
+
+			if(freeOrder == CHUNK_ORDER)
+			{
+				spareChunk = false;
+			}
+		}
+
+		// Split, keeping the lower half and freeing the upper one
+		while(freeOrder > order)
+		{
+			freeOrder--;
+			freeBlocks[freeOrder].insert(block + BlockSize(freeOrder));
+		}
+
+		lock.unlock();
+
+		// Recycled blocks must look like fresh allocations
+		memset(block, 0, BlockSize(order));
+
+		return block;
+	}
+
+	void deallocate(void* memory, size_t size)
+	{
+		unsigned int order = Order(size);
+
+		if(order > MAX_ORDER)
+		{
+			sw::deallocatePages(memory, size);
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		uint8_t* block = reinterpret_cast<uint8_t*>(memory);
+
+		// Merge with free buddies. Chunks are aligned to their size, so a block's buddy is found by flipping one address bit.
+		while(order < CHUNK_ORDER)
+		{
+			uint8_t* buddy = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(block) ^ BlockSize(order));
+			auto freeBuddy = freeBlocks[order].find(buddy);
+
+			if(freeBuddy == freeBlocks[order].end())
+			{
+				break;
+			}
+
+			freeBlocks[order].erase(freeBuddy);
+			block = std::min(block, buddy);
+			order++;
+		}
+
+		if(order < CHUNK_ORDER)
+		{
+			freeBlocks[order].insert(block);
+		}
+		else if(!spareChunk)
+		{
+			// Keep one empty chunk around, so that repeatedly allocating and freeing a small block doesn't map each time
+			freeBlocks[CHUNK_ORDER].insert(block);
+			spareChunk = true;
+		}
+		else
+		{
+			lock.unlock();
+			sw::deallocatePages(block, ChunkSize());
+		}
+	}
+
+private:
+	enum
+	{
+		MIN_ORDER = 8,     // 256 byte blocks
+		CHUNK_ORDER = 21,  // Matches sw::hugePageSize()
+		MAX_ORDER = CHUNK_ORDER - 1,
+	};
+
+	static size_t BlockSize(unsigned int order) { return size_t(1) << order; }
+	static size_t ChunkSize() { return BlockSize(CHUNK_ORDER); }
+
+	static unsigned int Order(size_t size)
+	{
+		unsigned int order = MIN_ORDER;
+		while(BlockSize(order) < size && order <= MAX_ORDER)
+		{
+			order++;
+		}
+
+		return order;
+	}
+
+	std::mutex mutex;
+	std::set<uint8_t*> freeBlocks[CHUNK_ORDER + 1];
+	bool spareChunk = false;
+};
+
+Heap& GetHeap()
+{
+	static Heap heap;
+	return heap;
+}
+
+} // anonymous namespace
+
 DeviceMemory::DeviceMemory(const VkMemoryAllocateInfo* pCreateInfo, void* mem) :
 	size(pCreateInfo->allocationSize), memoryTypeIndex(pCreateInfo->memoryTypeIndex)
 {
@@ -27,7 +179,10 @@ DeviceMemory::DeviceMemory(const VkMemoryAllocateInfo* pCreateInfo, void* mem) :
 
 void DeviceMemory::destroy(const VkAllocationCallbacks* pAllocator)
 {
-	vk::deallocate(buffer, DEVICE_MEMORY);
+	if(buffer)
+	{
+		GetHeap().deallocate(buffer, static_cast<size_t>(size));
+	}
 }
 
 size_t DeviceMemory::ComputeRequiredAllocationSize(const VkMemoryAllocateInfo* pCreateInfo)
@@ -38,9 +193,14 @@ size_t DeviceMemory::ComputeRequiredAllocationSize(const VkMemoryAllocateInfo* p
 
 VkResult DeviceMemory::allocate()
 {
+	if(isLazilyAllocated())
+	{
+		return VK_SUCCESS;
+	}
+
 	if(!buffer)
 	{
-		buffer = vk::allocate(size, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY);
+		buffer = GetHeap().allocate(static_cast<size_t>(size));
 	}
 
 	if(!buffer)
@@ -60,14 +220,31 @@ VkResult DeviceMemory::map(VkDeviceSize pOffset, VkDeviceSize pSize, void** ppDa
 
 VkDeviceSize DeviceMemory::getCommittedMemoryInBytes() const
 {
-	return size;
+	std::unique_lock<std::mutex> lock(commitMutex);
+
+	return buffer ? size : 0;
 }
 
 void* DeviceMemory::getOffsetPointer(VkDeviceSize pOffset)
 {
+	if(isLazilyAllocated())
+	{
+		std::unique_lock<std::mutex> lock(commitMutex);
+
+		if(!buffer)
+		{
+			buffer = GetHeap().allocate(static_cast<size_t>(size));
+		}
+	}
+
 	ASSERT(buffer);
 
 	return reinterpret_cast<char*>(buffer) + pOffset;
 }
 
+bool DeviceMemory::isLazilyAllocated() const
+{
+	return ((1u << memoryTypeIndex) & MEMORY_TYPE_LAZILY_ALLOCATED_BIT) != 0;
+}
+
 } // namespace vk
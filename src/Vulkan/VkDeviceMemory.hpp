@@ -16,6 +16,7 @@
 #define VK_DEVICE_MEMORY_HPP_
 
 #include "VkObject.hpp"
+#include <mutex>
 
 namespace vk
 {
@@ -35,10 +36,14 @@ public:
 	void* getOffsetPointer(VkDeviceSize pOffset);
 	uint32_t getMemoryTypeIndex() const { return memoryTypeIndex; }
 
+	// Lazily allocated memory commits nothing until it's first accessed
+	bool isLazilyAllocated() const;
+
 private:
 	void*        buffer = nullptr;
 	VkDeviceSize size = 0;
 	uint32_t     memoryTypeIndex = 0;
+	mutable std::mutex commitMutex;   // Lazily allocated memory gets committed by whichever thread accesses it first
 };
 
 static inline DeviceMemory* Cast(VkDeviceMemory object)
@@ -0,0 +1,77 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VkFence.hpp"
+
+#include <chrono>
+#include <limits>
+
+namespace vk
+{
+
+std::mutex Fence::mutex;
+std::condition_variable Fence::signaled;
+
+void Fence::signal()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	status = VK_SUCCESS;
+	signaled.notify_all();
+}
+
+void Fence::reset()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	status = VK_NOT_READY;
+}
+
+VkResult Fence::getStatus() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return status;
+}
+
+VkResult Fence::Wait(uint32_t fenceCount, const VkFence* pFences, bool waitAll, uint64_t timeout)
+{
+	auto isSignaled = [=]()
+	{
+		for(uint32_t i = 0; i < fenceCount; i++)
+		{
+			bool fenceSignaled = (Cast(pFences[i])->status == VK_SUCCESS);
+
+			if(fenceSignaled != waitAll)
+			{
+				return fenceSignaled;
+			}
+		}
+
+		return waitAll;
+	};
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	// Timeouts beyond a few centuries can't be represented as a deadline, and are infinite in practice
+	if(timeout >= static_cast<uint64_t>(std::numeric_limits<int64_t>::max() / 2))
+	{
+		signaled.wait(lock, isSignaled);
+
+		return VK_SUCCESS;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(timeout);
+
+	return signaled.wait_until(lock, deadline, isSignaled) ? VK_SUCCESS : VK_TIMEOUT;
+}
+
+} // namespace vk
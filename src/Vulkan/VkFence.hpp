@@ -16,6 +16,8 @@
 #define VK_FENCE_HPP_
 
 #include "VkObject.hpp"
+#include <condition_variable>
+#include <mutex>
 
 namespace vk
 {
@@ -35,23 +37,20 @@ public:
 		return 0;
 	}
 
-	void signal()
-	{
-		status = VK_SUCCESS;
-	}
-
-	void reset()
-	{
-		status = VK_NOT_READY;
-	}
+	void signal();
+	void reset();
+	VkResult getStatus() const;
 
-	VkResult getStatus() const
-	{
-		return status;
-	}
+	// Blocks until all (or any) of the fences are signaled, or the timeout in nanoseconds expires
+	static VkResult Wait(uint32_t fenceCount, const VkFence* pFences, bool waitAll, uint64_t timeout);
 
 private:
 	VkResult status = VK_NOT_READY;
+
+	// Fences are signaled at most once per submission, so they share a single lock,
+	// which lets a thread wait for any one of several fences without polling them.
+	static std::mutex mutex;
+	static std::condition_variable signaled;
 };
 
 static inline Fence* Cast(VkFence object)
@@ -14,6 +14,8 @@
 
 #include "VkPhysicalDevice.hpp"
 #include "VkConfig.h"
+#include "System/Memory.hpp"
+#include <algorithm>
 #include <memory.h>
 
 namespace vk
@@ -381,28 +383,56 @@ void PhysicalDevice::getImageFormatProperties(VkFormat format, VkImageType type,
 
 uint32_t PhysicalDevice::getQueueFamilyPropertyCount() const
 {
-	return 1;
+	return QUEUE_FAMILY_COUNT;
 }
 
 void PhysicalDevice::getQueueFamilyProperties(uint32_t pQueueFamilyPropertyCount,
                                               VkQueueFamilyProperties* pQueueFamilyProperties) const
 {
+	static const VkQueueFlags queueFlags[QUEUE_FAMILY_COUNT] =
+	{
+		VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, // QUEUE_FAMILY_GRAPHICS
+		VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT,                         // QUEUE_FAMILY_COMPUTE
+		VK_QUEUE_TRANSFER_BIT,                                                // QUEUE_FAMILY_TRANSFER
+	};
+
+	pQueueFamilyPropertyCount = std::min(pQueueFamilyPropertyCount, getQueueFamilyPropertyCount());
+
 	for(uint32_t i = 0; i < pQueueFamilyPropertyCount; i++)
 	{
 		pQueueFamilyProperties[i].minImageTransferGranularity.width = 1;
 		pQueueFamilyProperties[i].minImageTransferGranularity.height = 1;
 		pQueueFamilyProperties[i].minImageTransferGranularity.depth = 1;
-		pQueueFamilyProperties[i].queueCount = 1;
-		pQueueFamilyProperties[i].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+		pQueueFamilyProperties[i].queueCount = QUEUE_COUNT_PER_FAMILY;
+		pQueueFamilyProperties[i].queueFlags = queueFlags[i];
 		pQueueFamilyProperties[i].timestampValidBits = 0; // No support for time stamps
 	}
 }
 
+static VkDeviceSize GetMemoryHeapSize()
+{
+	// Leave half of the system's memory to everything else
+	VkDeviceSize heapSize = sw::physicalMemorySize() / 2;
+
+	if(heapSize == 0)
+	{
+		heapSize = 1ull << 31;
+	}
+
+	// 32-bit processes run out of address space first
+	if(sizeof(void*) == 4)
+	{
+		heapSize = std::min(heapSize, VkDeviceSize(1ull << 30));
+	}
+
+	return heapSize;
+}
+
 const VkPhysicalDeviceMemoryProperties& PhysicalDevice::getMemoryProperties() const
 {
 	static const VkPhysicalDeviceMemoryProperties properties
 	{
-		1, // memoryTypeCount
+		2, // memoryTypeCount
 		{
 			// vk::MEMORY_TYPE_GENERIC_BIT
 			{
@@ -412,11 +442,17 @@ const VkPhysicalDeviceMemoryProperties& PhysicalDevice::getMemoryProperties() co
 				VK_MEMORY_PROPERTY_HOST_CACHED_BIT, // propertyFlags
 				0 // heapIndex
 			},
+			// vk::MEMORY_TYPE_LAZILY_ALLOCATED_BIT
+			{
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+				VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, // propertyFlags
+				0 // heapIndex
+			},
 		},
 		1, // memoryHeapCount
 		{
 			{
-				1ull << 31, // size, FIXME(sugoi): This should be configurable based on available RAM
+				GetMemoryHeapSize(), // size
 				VK_MEMORY_HEAP_DEVICE_LOCAL_BIT // flags
 			},
 		}
@@ -13,16 +13,120 @@
 // limitations under the License.
 
 #include "VkPipeline.hpp"
+#include "VkDebug.hpp"
+#include "VkPipelineCache.hpp"
+#include "VkShaderModule.hpp"
+#include "System/Math.hpp"
+#include <cstring>
 
 namespace vk
 {
 
+std::vector<uint8_t> ShaderBatch::ComputeKey(const VkPipelineShaderStageCreateInfo& stage)
+{
+	// Everything the compiled stage depends on
+	std::vector<uint8_t> key;
+	auto append = [&key](const void* bytes, size_t size)
+	{
+		key.insert(key.end(), reinterpret_cast<const uint8_t*>(bytes), reinterpret_cast<const uint8_t*>(bytes) + size);
+	};
+
+	// The whole module, so that different modules can't collide
+	const ShaderModule* module = Cast(stage.module);
+	uint64_t moduleSize = module->getWordCount();
+	append(&moduleSize, sizeof(moduleSize));
+	append(module->getCode(), module->getWordCount() * sizeof(uint32_t));
+	append(&stage.stage, sizeof(stage.stage));
+	append(stage.pName, strlen(stage.pName) + 1);
+
+	if(stage.pSpecializationInfo)
+	{
+		const VkSpecializationInfo* specializationInfo = stage.pSpecializationInfo;
+		append(specializationInfo->pMapEntries, specializationInfo->mapEntryCount * sizeof(VkSpecializationMapEntry));
+		append(specializationInfo->pData, specializationInfo->dataSize);
+	}
+
+	return key;
+}
+
+void ShaderBatch::add(const VkPipelineShaderStageCreateInfo& stage, ShaderStage* output)
+{
+	if(stage.pNext || stage.flags)
+	{
+		UNIMPLEMENTED();
+	}
+
+	std::vector<uint8_t> key = ComputeKey(stage);
+
+	auto jobIndex = jobIndices.find(key);
+	if(jobIndex != jobIndices.end())
+	{
+		jobs[jobIndex->second].outputs.push_back(output);
+		return;
+	}
+
+	uint64_t hash = sw::FNV_1a(key.data(), static_cast<int>(key.size()));
+
+	jobIndices[key] = jobs.size();
+	jobs.push_back({ &stage, hash, key, { output } });
+}
+
+void ShaderBatch::compile(Job& job)
+{
+	// Cache entries hold the entry point, followed by the specialized code
+	std::vector<uint8_t> data;
+	PipelineCache* cache = (pipelineCache != VK_NULL_HANDLE) ? Cast(pipelineCache) : nullptr;
+
+	if(!cache || !cache->find(job.hash, job.key, data))
+	{
+		const ShaderModule* module = Cast(job.stage->module);
+
+		uint32_t entryPoint = 0;
+		bool found = module->findEntryPoint(job.stage->pName, job.stage->stage, &entryPoint);
+		ASSERT(found);   // Valid usage requires the entry point to exist
+		(void)found;
+
+		std::vector<uint32_t> code = module->specialize(job.stage->pSpecializationInfo);
+
+		data.resize(sizeof(uint32_t) * (1 + code.size()));
+		memcpy(data.data(), &entryPoint, sizeof(uint32_t));
+		memcpy(data.data() + sizeof(uint32_t), code.data(), sizeof(uint32_t) * code.size());
+
+		if(cache)
+		{
+			cache->insert(job.hash, job.key, data.data(), data.size());
+		}
+	}
+
+	ASSERT(data.size() >= sizeof(uint32_t) && data.size() % sizeof(uint32_t) == 0);
+	const uint32_t* words = reinterpret_cast<const uint32_t*>(data.data());
+	size_t wordCount = data.size() / sizeof(uint32_t);
+
+	for(ShaderStage* output : job.outputs)
+	{
+		output->entryPoint = words[0];
+		output->code = new std::vector<uint32_t>(words + 1, words + wordCount);
+	}
+}
+
+void ShaderBatch::compile()
+{
+	for(Job& job : jobs)
+	{
+		compile(job);
+	}
+}
+
 GraphicsPipeline::GraphicsPipeline(const VkGraphicsPipelineCreateInfo* pCreateInfo, void* mem)
 {
 }
 
 void GraphicsPipeline::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	for(ShaderStage& stage : stages)
+	{
+		delete stage.code;
+	}
 }
 
 size_t GraphicsPipeline::ComputeRequiredAllocationSize(const VkGraphicsPipelineCreateInfo* pCreateInfo)
@@ -30,18 +134,33 @@ size_t GraphicsPipeline::ComputeRequiredAllocationSize(const VkGraphicsPipelineC
 	return 0;
 }
 
+void GraphicsPipeline::compileShaders(ShaderBatch& shaderBatch, const VkGraphicsPipelineCreateInfo* pCreateInfo)
+{
+	ASSERT(pCreateInfo->stageCount <= MAX_SHADER_STAGES);
+
+	for(uint32_t i = 0; i < pCreateInfo->stageCount; i++)
+	{
+		shaderBatch.add(pCreateInfo->pStages[i], &stages[i]);
+	}
+}
+
 ComputePipeline::ComputePipeline(const VkComputePipelineCreateInfo* pCreateInfo, void* mem)
 {
 }
 
 void ComputePipeline::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	delete stage.code;
 }
 
-
 size_t ComputePipeline::ComputeRequiredAllocationSize(const VkComputePipelineCreateInfo* pCreateInfo)
 {
 	return 0;
 }
 
+void ComputePipeline::compileShaders(ShaderBatch& shaderBatch, const VkComputePipelineCreateInfo* pCreateInfo)
+{
+	shaderBatch.add(pCreateInfo->stage, &stage);
+}
+
 } // namespace vk
@@ -16,10 +16,47 @@
 #define VK_PIPELINE_HPP_
 
 #include "VkObject.hpp"
+#include <map>
+#include <vector>
 
 namespace vk
 {
 
+// A shader stage ready for translation: its entry point, and its module's code with the
+// specialization constants applied
+struct ShaderStage
+{
+	uint32_t entryPoint = 0;
+	std::vector<uint32_t>* code = nullptr;   // Owned by the pipeline
+};
+
+// Collects the shader stages of all pipelines created by one vkCreate*Pipelines call,
+// so that identical stages are compiled once.
+class ShaderBatch
+{
+public:
+	ShaderBatch(VkPipelineCache pipelineCache) : pipelineCache(pipelineCache) {}
+
+	void add(const VkPipelineShaderStageCreateInfo& stage, ShaderStage* output);
+	void compile();
+
+private:
+	struct Job
+	{
+		const VkPipelineShaderStageCreateInfo* stage;
+		uint64_t hash;              // Of the key, for indexing the pipeline cache
+		std::vector<uint8_t> key;   // Module code, stage, entry point and specialization
+		std::vector<ShaderStage*> outputs;   // Of every pipeline using this stage
+	};
+
+	static std::vector<uint8_t> ComputeKey(const VkPipelineShaderStageCreateInfo& stage);
+	void compile(Job& job);
+
+	VkPipelineCache pipelineCache;
+	std::vector<Job> jobs;
+	std::map<std::vector<uint8_t>, size_t> jobIndices;
+};
+
 class Pipeline
 {
 public:
@@ -44,6 +81,13 @@ public:
 #endif
 
 	static size_t ComputeRequiredAllocationSize(const VkGraphicsPipelineCreateInfo* pCreateInfo);
+
+	void compileShaders(ShaderBatch& shaderBatch, const VkGraphicsPipelineCreateInfo* pCreateInfo);
+
+private:
+	enum { MAX_SHADER_STAGES = 5 };   // Vertex, tessellation control and evaluation, geometry, fragment
+
+	ShaderStage stages[MAX_SHADER_STAGES];
 };
 
 class ComputePipeline : public Pipeline, public Object<ComputePipeline, VkPipeline>
@@ -61,6 +105,11 @@ public:
 #endif
 
 	static size_t ComputeRequiredAllocationSize(const VkComputePipelineCreateInfo* pCreateInfo);
+
+	void compileShaders(ShaderBatch& shaderBatch, const VkComputePipelineCreateInfo* pCreateInfo);
+
+private:
+	ShaderStage stage;
 };
 
 static inline Pipeline* Cast(VkPipeline object)
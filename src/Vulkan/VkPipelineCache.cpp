@@ -0,0 +1,226 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VkPipelineCache.hpp"
+#include "VkConfig.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace vk
+{
+
+static size_t PaddedSize(size_t size)
+{
+	return (size + 7) & ~size_t(7);
+}
+
+PipelineCache::PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem)
+{
+	entries = new std::map<uint64_t, Entry>();
+	mutex = new std::mutex();
+
+	if(pCreateInfo->initialDataSize > 0)
+	{
+		load(pCreateInfo->pInitialData, pCreateInfo->initialDataSize);
+	}
+}
+
+void PipelineCache::destroy(const VkAllocationCallbacks* pAllocator)
+{
+	delete entries;
+	delete mutex;
+}
+
+size_t PipelineCache::ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo* pCreateInfo)
+{
+	return 0;
+}
+
+PipelineCache::Header PipelineCache::CurrentHeader()
+{
+	Header header;
+	header.headerSize = offsetof(Header, driverVersion);
+	header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+	header.vendorID = VENDOR_ID;
+	header.deviceID = DEVICE_ID;
+	memcpy(header.pipelineCacheUUID, SWIFTSHADER_UUID, VK_UUID_SIZE);
+	header.driverVersion = DRIVER_VERSION;
+	header.entryCount = 0;
+
+	return header;
+}
+
+void PipelineCache::load(const void* pInitialData, size_t initialDataSize)
+{
+	// According to the Vulkan spec, section 9.6. Pipeline Cache:
+	// "If the pipeline cache data is incompatible with the device, the pipeline
+	//  cache will be initially empty."
+	if(initialDataSize < sizeof(Header))
+	{
+		return;
+	}
+
+	Header header;
+	memcpy(&header, pInitialData, sizeof(Header));
+
+	Header current = CurrentHeader();
+	if(memcmp(&header, &current, offsetof(Header, entryCount)) != 0)
+	{
+		return;
+	}
+
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(pInitialData) + sizeof(Header);
+	const uint8_t* end = reinterpret_cast<const uint8_t*>(pInitialData) + initialDataSize;
+
+	for(uint32_t i = 0; i < header.entryCount; i++)
+	{
+		EntryHeader entry;
+		if(size_t(end - data) < sizeof(EntryHeader))
+		{
+			return;
+		}
+
+		memcpy(&entry, data, sizeof(EntryHeader));
+		data += sizeof(EntryHeader);
+
+		// Truncated data still yields the entries which were written completely. The sizes
+		// are compared against what remains, so that corrupt ones can't overflow the sums.
+		size_t remaining = size_t(end - data);
+		if(entry.keySize > remaining || PaddedSize(entry.keySize) > remaining ||
+		   entry.dataSize > remaining - PaddedSize(entry.keySize))
+		{
+			return;
+		}
+
+		Entry& loaded = (*entries)[entry.hash];
+		loaded.key.assign(data, data + entry.keySize);
+		data += PaddedSize(entry.keySize);
+		loaded.data.assign(data, data + entry.dataSize);
+		data += std::min(PaddedSize(entry.dataSize), size_t(end - data));
+	}
+}
+
+VkResult PipelineCache::getData(size_t* pDataSize, void* pData)
+{
+	std::unique_lock<std::mutex> lock(*mutex);
+
+	if(!pData)
+	{
+		size_t size = sizeof(Header);
+		for(const auto& entry : *entries)
+		{
+			size += sizeof(EntryHeader) + PaddedSize(entry.second.key.size()) + PaddedSize(entry.second.data.size());
+		}
+
+		*pDataSize = size;
+
+		return VK_SUCCESS;
+	}
+
+	// According to the Vulkan spec, section 9.6. Pipeline Cache:
+	// "If pDataSize is less than the maximum size that can be retrieved by the
+	//  pipeline cache, at most pDataSize bytes will be written to pData, and
+	//  vkGetPipelineCacheData will return VK_INCOMPLETE. Any data written to pData
+	//  is valid and can be provided as the pInitialData member of the
+	//  VkPipelineCacheCreateInfo structure passed to vkCreatePipelineCache."
+	if(*pDataSize < sizeof(Header))
+	{
+		*pDataSize = 0;
+
+		return VK_INCOMPLETE;
+	}
+
+	Header header = CurrentHeader();
+	uint8_t* data = reinterpret_cast<uint8_t*>(pData) + sizeof(Header);
+	size_t size = sizeof(Header);
+	VkResult result = VK_SUCCESS;
+
+	for(const auto& entry : *entries)
+	{
+		const std::vector<uint8_t>& key = entry.second.key;
+		const std::vector<uint8_t>& entryData = entry.second.data;
+
+		size_t entrySize = sizeof(EntryHeader) + PaddedSize(key.size()) + PaddedSize(entryData.size());
+		if(size + entrySize > *pDataSize)
+		{
+			result = VK_INCOMPLETE;
+			break;
+		}
+
+		EntryHeader entryHeader = { entry.first, key.size(), entryData.size() };
+		memcpy(data, &entryHeader, sizeof(EntryHeader));
+		data += sizeof(EntryHeader);
+
+		memcpy(data, key.data(), key.size());
+		memset(data + key.size(), 0, PaddedSize(key.size()) - key.size());
+		data += PaddedSize(key.size());
+
+		memcpy(data, entryData.data(), entryData.size());
+		memset(data + entryData.size(), 0, PaddedSize(entryData.size()) - entryData.size());
+		data += PaddedSize(entryData.size());
+
+		size += entrySize;
+		header.entryCount++;
+	}
+
+	memcpy(pData, &header, sizeof(Header));
+	*pDataSize = size;
+
+	return result;
+}
+
+VkResult PipelineCache::merge(uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches)
+{
+	std::unique_lock<std::mutex> lock(*mutex);
+
+	for(uint32_t i = 0; i < srcCacheCount; i++)
+	{
+		PipelineCache* srcCache = Cast(pSrcCaches[i]);
+		std::unique_lock<std::mutex> srcLock(*srcCache->mutex);
+
+		// Identical key material maps to identical code. On a hash collision, the entry already
+		// in this cache is kept, and lookups of the other key material miss.
+		entries->insert(srcCache->entries->begin(), srcCache->entries->end());
+	}
+
+	return VK_SUCCESS;
+}
+
+bool PipelineCache::find(uint64_t hash, const std::vector<uint8_t>& key, std::vector<uint8_t>& data)
+{
+	std::unique_lock<std::mutex> lock(*mutex);
+
+	auto entry = entries->find(hash);
+	if(entry == entries->end() || entry->second.key != key)
+	{
+		return false;
+	}
+
+	data = entry->second.data;
+
+	return true;
+}
+
+void PipelineCache::insert(uint64_t hash, const std::vector<uint8_t>& key, const void* data, size_t size)
+{
+	std::unique_lock<std::mutex> lock(*mutex);
+
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	Entry& entry = (*entries)[hash];
+	entry.key = key;
+	entry.data.assign(bytes, bytes + size);
+}
+
+} // namespace vk
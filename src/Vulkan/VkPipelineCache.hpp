@@ -16,6 +16,9 @@
 #define VK_PIPELINE_CACHE_HPP_
 
 #include "VkObject.hpp"
+#include <map>
+#include <mutex>
+#include <vector>
 
 namespace vk
 {
@@ -23,18 +26,58 @@ namespace vk
 class PipelineCache : public Object<PipelineCache, VkPipelineCache>
 {
 public:
-	PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem)
+	PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem);
+	~PipelineCache() = delete;
+	void destroy(const VkAllocationCallbacks* pAllocator);
+
+	static size_t ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo* pCreateInfo);
+
+	VkResult getData(size_t* pDataSize, void* pData);
+	VkResult merge(uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches);
+
+	// Entries are opaque blobs, indexed by a hash of everything the compiled code depends on.
+	// That key material is stored along with each entry and compared on lookup, so a hash
+	// collision causes a miss instead of returning another stage's code.
+	// Pipeline creation may run on several threads, so access is internally synchronized.
+	bool find(uint64_t hash, const std::vector<uint8_t>& key, std::vector<uint8_t>& data);
+	void insert(uint64_t hash, const std::vector<uint8_t>& key, const void* data, size_t size);
+
+private:
+	// Layout of the data returned by vkGetPipelineCacheData
+	struct Header
 	{
-	}
+		// According to the Vulkan spec, section 9.6. Pipeline Cache:
+		// "The first bytes of the data returned by vkGetPipelineCacheData are a header."
+		uint32_t headerSize;
+		uint32_t headerVersion;   // VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
 
-	~PipelineCache() = delete;
+		// Our own fields, so that data from another driver build is rejected
+		uint32_t driverVersion;
+		uint32_t entryCount;
+	};
 
-	static size_t ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo* pCreateInfo)
+	struct EntryHeader
 	{
-		return 0;
-	}
+		uint64_t hash;
+		uint64_t keySize;    // Followed by the key material, padded to a multiple of 8 bytes
+		uint64_t dataSize;   // Followed by the entry's data, padded to a multiple of 8 bytes
+	};
 
-private:
+	struct Entry
+	{
+		std::vector<uint8_t> key;
+		std::vector<uint8_t> data;
+	};
+
+	static Header CurrentHeader();
+	void load(const void* pInitialData, size_t initialDataSize);
+
+	// Heap allocated, because objects are released through destroy() and never destructed
+	std::map<uint64_t, Entry>* entries;
+	std::mutex* mutex;
 };
 
 static inline PipelineCache* Cast(VkPipelineCache object)
@@ -13,12 +13,162 @@
 // limitations under the License.
 
 #include "VkQueue.hpp"
+#include "VkCommandBuffer.hpp"
+#include "VkFence.hpp"
+#include "VkSemaphore.hpp"
+#include "System/Math.hpp"
+#include <cstring>
+
+namespace
+{
+
+// Advances size past count elements of type T, starting at T's alignment
+template<typename T>
+void ReserveArray(size_t& size, uint32_t count)
+{
+	size = sw::align(size, alignof(T)) + count * sizeof(T);
+}
+
+// Copies count elements to the next offset aligned for T, and advances offset past them
+template<typename T>
+const T* CopyArray(uint8_t* memory, size_t& offset, const T* source, uint32_t count)
+{
+	offset = sw::align(offset, alignof(T));
+	T* destination = reinterpret_cast<T*>(memory + offset);
+	memcpy(destination, source, count * sizeof(T));
+	offset += count * sizeof(T);
+
+	return destination;
+}
+
+} // anonymous namespace
 
 namespace vk
 {
 
 Queue::Queue(uint32_t pFamilyIndex, float pPriority) : familyIndex(pFamilyIndex), priority(pPriority)
 {
+	queueThread = std::thread(&Queue::taskLoop, this);
+}
+
+Queue::~Queue()
+{
+	Task task;
+	task.type = Task::KILL_THREAD;
+	pending.put(task);
+
+	queueThread.join();
+}
+
+VkSubmitInfo* Queue::DeepCopySubmitInfo(uint32_t submitCount, const VkSubmitInfo* pSubmits)
+{
+	size_t size = sizeof(VkSubmitInfo) * submitCount;
+	for(uint32_t i = 0; i < submitCount; i++)
+	{
+		// Non-dispatchable handles are 64-bit even on 32-bit platforms, so each array gets its own alignment
+		ReserveArray<VkSemaphore>(size, pSubmits[i].waitSemaphoreCount);
+		ReserveArray<VkPipelineStageFlags>(size, pSubmits[i].waitSemaphoreCount);
+		ReserveArray<VkCommandBuffer>(size, pSubmits[i].commandBufferCount);
+		ReserveArray<VkSemaphore>(size, pSubmits[i].signalSemaphoreCount);
+	}
+
+	uint8_t* memory = reinterpret_cast<uint8_t*>(vk::allocate(size, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY));
+	if(!memory)
+	{
+		return nullptr;
+	}
+
+	VkSubmitInfo* submits = reinterpret_cast<VkSubmitInfo*>(memory);
+	memcpy(submits, pSubmits, sizeof(VkSubmitInfo) * submitCount);
+	size_t offset = sizeof(VkSubmitInfo) * submitCount;
+
+	for(uint32_t i = 0; i < submitCount; i++)
+	{
+		submits[i].pWaitSemaphores = CopyArray(memory, offset, pSubmits[i].pWaitSemaphores, pSubmits[i].waitSemaphoreCount);
+		submits[i].pWaitDstStageMask = CopyArray(memory, offset, pSubmits[i].pWaitDstStageMask, pSubmits[i].waitSemaphoreCount);
+		submits[i].pCommandBuffers = CopyArray(memory, offset, pSubmits[i].pCommandBuffers, pSubmits[i].commandBufferCount);
+		submits[i].pSignalSemaphores = CopyArray(memory, offset, pSubmits[i].pSignalSemaphores, pSubmits[i].signalSemaphoreCount);
+	}
+
+	ASSERT(offset == size);
+
+	return submits;
+}
+
+VkResult Queue::submit(uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+{
+	Task task;
+	task.submitCount = submitCount;
+	task.fence = fence;
+
+	if(submitCount > 0)
+	{
+		task.pSubmits = DeepCopySubmitInfo(submitCount, pSubmits);
+
+		if(!task.pSubmits)
+		{
+			return VK_ERROR_OUT_OF_HOST_MEMORY;
+		}
+	}
+
+	outstanding.add();
+	pending.put(task);
+
+	return VK_SUCCESS;
+}
+
+VkResult Queue::waitIdle()
+{
+	outstanding.wait();
+
+	return VK_SUCCESS;
+}
+
+void Queue::taskLoop()
+{
+	while(true)
+	{
+		Task task = pending.take();
+
+		if(task.type == Task::KILL_THREAD)
+		{
+			return;
+		}
+
+		execute(task);
+	}
+}
+
+void Queue::execute(const Task& task)
+{
+	for(uint32_t i = 0; i < task.submitCount; i++)
+	{
+		const VkSubmitInfo& submitInfo = task.pSubmits[i];
+
+		for(uint32_t j = 0; j < submitInfo.waitSemaphoreCount; j++)
+		{
+			vk::Cast(submitInfo.pWaitSemaphores[j])->wait(submitInfo.pWaitDstStageMask[j]);
+		}
+
+		for(uint32_t j = 0; j < submitInfo.commandBufferCount; j++)
+		{
+			vk::Cast(submitInfo.pCommandBuffers[j])->submit();
+		}
+
+		for(uint32_t j = 0; j < submitInfo.signalSemaphoreCount; j++)
+		{
+			vk::Cast(submitInfo.pSignalSemaphores[j])->signal();
+		}
+	}
+
+	vk::deallocate(task.pSubmits, DEVICE_MEMORY);
+
+	if(task.fence != VK_NULL_HANDLE)
+	{
+		vk::Cast(task.fence)->signal();
+	}
+
+	outstanding.done();
 }
 
-} // namespace vk
\ No newline at end of file
+} // namespace vk
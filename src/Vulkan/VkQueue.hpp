@@ -16,6 +16,8 @@
 #define VK_QUEUE_HPP_
 
 #include "VkObject.hpp"
+#include "System/Synchronization.hpp"
+#include <thread>
 #include <vulkan/vk_icd.h>
 
 namespace vk
@@ -27,16 +29,38 @@ class Queue
 
 public:
 	Queue(uint32_t pFamilyIndex, float pPriority);
-	~Queue() = delete;
+	~Queue();
 
 	operator VkQueue()
 	{
 		return reinterpret_cast<VkQueue>(this);
 	}
 
+	uint32_t getFamilyIndex() const { return familyIndex; }
+	VkResult submit(uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence);
+	VkResult waitIdle();
+
 private:
+	struct Task
+	{
+		enum Type { SUBMIT_QUEUE, KILL_THREAD };
+		Type type = SUBMIT_QUEUE;
+
+		uint32_t submitCount = 0;
+		VkSubmitInfo* pSubmits = nullptr;   // Copied, so the application's arrays can be reused after vkQueueSubmit
+		VkFence fence = VK_NULL_HANDLE;
+	};
+
+	static VkSubmitInfo* DeepCopySubmitInfo(uint32_t submitCount, const VkSubmitInfo* pSubmits);
+	void taskLoop();
+	void execute(const Task& task);
+
 	uint32_t familyIndex = 0;
 	float    priority = 0.0f;
+
+	sw::Chan<Task> pending;
+	sw::WaitGroup outstanding;   // Submissions which haven't completed
+	std::thread queueThread;
 };
 
 static inline Queue* Cast(VkQueue object)
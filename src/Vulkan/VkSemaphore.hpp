@@ -16,6 +16,8 @@
 #define VK_SEMAPHORE_HPP_
 
 #include "VkObject.hpp"
+#include <condition_variable>
+#include <mutex>
 
 namespace vk
 {
@@ -34,22 +36,32 @@ public:
 
 	void wait()
 	{
-		// Semaphores are noop for now
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this] { return signaled; });
+
+		// A wait operation unsignals the semaphore
+		signaled = false;
 	}
 
 	void wait(const VkPipelineStageFlags& flag)
 	{
 		// VkPipelineStageFlags is the pipeline stage at which the semaphore wait will occur
 
-		// Semaphores are noop for now
+		// Submissions execute one at a time, so waiting before any of their stages is equivalent
+		wait();
 	}
 
 	void signal()
 	{
-		// Semaphores are noop for now
+		std::unique_lock<std::mutex> lock(mutex);
+		signaled = true;
+		condition.notify_all();
 	}
 
 private:
+	bool signaled = false;
+	std::mutex mutex;
+	std::condition_variable condition;
 };
 
 static inline Semaphore* Cast(VkSemaphore object)
@@ -13,12 +13,15 @@
 // limitations under the License.
 
 #include "VkShaderModule.hpp"
+#include <algorithm>
 #include <memory.h>
+#include <string.h>
 
 namespace vk
 {
 
-ShaderModule::ShaderModule(const VkShaderModuleCreateInfo* pCreateInfo, void* mem) : code(reinterpret_cast<uint32_t*>(mem))
+ShaderModule::ShaderModule(const VkShaderModuleCreateInfo* pCreateInfo, void* mem)
+	: code(reinterpret_cast<uint32_t*>(mem)), wordCount(pCreateInfo->codeSize / sizeof(uint32_t))
 {
 	memcpy(code, pCreateInfo->pCode, pCreateInfo->codeSize);
 }
@@ -33,4 +36,200 @@ size_t ShaderModule::ComputeRequiredAllocationSize(const VkShaderModuleCreateInf
 	return pCreateInfo->codeSize;
 }
 
+bool ShaderModule::findEntryPoint(const char* name, VkShaderStageFlagBits stage, uint32_t* id) const
+{
+	uint32_t executionModel = 0;
+	switch(stage)
+	{
+	case VK_SHADER_STAGE_VERTEX_BIT:                  executionModel = 0; break;   // ExecutionModelVertex
+	case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:    executionModel = 1; break;   // ExecutionModelTessellationControl
+	case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: executionModel = 2; break;   // ExecutionModelTessellationEvaluation
+	case VK_SHADER_STAGE_GEOMETRY_BIT:                executionModel = 3; break;   // ExecutionModelGeometry
+	case VK_SHADER_STAGE_FRAGMENT_BIT:                executionModel = 4; break;   // ExecutionModelFragment
+	case VK_SHADER_STAGE_COMPUTE_BIT:                 executionModel = 5; break;   // ExecutionModelGLCompute
+	default:
+		return false;
+	}
+
+	// According to the SPIR-V spec, section 2.3 Physical Layout of a SPIR-V Module and Instruction:
+	// the module starts with a five word header, followed by instructions whose first word
+	// holds the word count in the high-order 16 bits and the opcode in the low-order 16 bits.
+	const uint32_t headerSize = 5;
+	const uint32_t OpEntryPoint = 15;   // ExecutionModel, function ID, name, interface IDs
+
+	for(size_t i = headerSize; i < wordCount;)
+	{
+		uint32_t opcode = code[i] & 0xFFFF;
+		uint32_t length = code[i] >> 16;
+
+		if(length == 0 || i + length > wordCount)
+		{
+			return false;
+		}
+
+		if(opcode == OpEntryPoint && length >= 4 && code[i + 1] == executionModel)
+		{
+			const char* entryPointName = reinterpret_cast<const char*>(&code[i + 3]);
+			size_t maxLength = (length - 3) * sizeof(uint32_t);
+
+			if(strnlen(entryPointName, maxLength) < maxLength && strcmp(entryPointName, name) == 0)
+			{
+				*id = code[i + 2];
+				return true;
+			}
+		}
+
+		i += length;
+	}
+
+	return false;
+}
+
+std::vector<uint32_t> ShaderModule::specialize(const VkSpecializationInfo* specializationInfo) const
+{
+	const uint32_t headerSize = 5;
+	const uint32_t OpConstantTrue = 41;              // Result type, result
+	const uint32_t OpConstantFalse = 42;             // Result type, result
+	const uint32_t OpConstant = 43;                  // Result type, result, value
+	const uint32_t OpConstantComposite = 44;         // Result type, result, constituents
+	const uint32_t OpSpecConstantTrue = 48;          // Result type, result
+	const uint32_t OpSpecConstantFalse = 49;         // Result type, result
+	const uint32_t OpSpecConstant = 50;              // Result type, result, default value
+	const uint32_t OpSpecConstantComposite = 51;     // Result type, result, constituents
+	const uint32_t OpSpecConstantOp = 52;            // Result type, result, opcode, operands
+	const uint32_t OpDecorate = 71;                  // Target, decoration, literals
+	const uint32_t DecorationSpecId = 1;
+
+	if(wordCount < headerSize)
+	{
+		return std::vector<uint32_t>(code, code + wordCount);
+	}
+
+	const uint32_t bound = code[3];
+	std::vector<const VkSpecializationMapEntry*> overrides(bound, nullptr);
+	std::vector<bool> unfrozen(bound, false);   // Results of OpSpecConstantOp, and composites using them
+
+	// Decorations precede the constants they apply to
+	for(size_t i = headerSize; i < wordCount;)
+	{
+		uint32_t opcode = code[i] & 0xFFFF;
+		uint32_t length = code[i] >> 16;
+
+		if(length == 0 || i + length > wordCount)
+		{
+			break;
+		}
+
+		if(opcode == OpDecorate && length >= 4 && code[i + 2] == DecorationSpecId && code[i + 1] < bound && specializationInfo)
+		{
+			for(uint32_t j = 0; j < specializationInfo->mapEntryCount; j++)
+			{
+				if(specializationInfo->pMapEntries[j].constantID == code[i + 3])
+				{
+					overrides[code[i + 1]] = &specializationInfo->pMapEntries[j];
+				}
+			}
+		}
+
+		i += length;
+	}
+
+	std::vector<uint32_t> specialized(code, code + headerSize);
+	specialized.reserve(wordCount);
+
+	for(size_t i = headerSize; i < wordCount;)
+	{
+		uint32_t opcode = code[i] & 0xFFFF;
+		uint32_t length = code[i] >> 16;
+
+		if(length == 0 || i + length > wordCount)
+		{
+			ASSERT(false);   // Valid usage requires valid SPIR-V
+			break;
+		}
+
+		const uint32_t* instruction = &code[i];
+		uint32_t result = (length >= 3) ? instruction[2] : 0;
+		const VkSpecializationMapEntry* value = (result < bound) ? overrides[result] : nullptr;
+		size_t first = specialized.size();
+
+		switch(opcode)
+		{
+		case OpDecorate:
+			// The constants no longer are specialization constants
+			if(length < 3 || instruction[2] != DecorationSpecId)
+			{
+				specialized.insert(specialized.end(), instruction, instruction + length);
+			}
+			break;
+		case OpSpecConstantTrue:
+		case OpSpecConstantFalse:
+			{
+				bool constant = (opcode == OpSpecConstantTrue);
+
+				if(value)
+				{
+					VkBool32 data = VK_FALSE;
+					memcpy(&data, reinterpret_cast<const uint8_t*>(specializationInfo->pData) + value->offset, std::min(value->size, sizeof(data)));
+					constant = (data != VK_FALSE);
+				}
+
+				specialized.insert(specialized.end(), instruction, instruction + length);
+				specialized[first] = (length << 16) | (constant ? OpConstantTrue : OpConstantFalse);
+			}
+			break;
+		case OpSpecConstant:
+			specialized.insert(specialized.end(), instruction, instruction + length);
+			specialized[first] = (length << 16) | OpConstant;
+
+			if(value && length > 3)
+			{
+				// Literals wider than 32-bit take multiple words, low-order first
+				memcpy(&specialized[first + 3], reinterpret_cast<const uint8_t*>(specializationInfo->pData) + value->offset, std::min(value->size, size_t(length - 3) * sizeof(uint32_t)));
+			}
+			break;
+		case OpSpecConstantComposite:
+			{
+				bool frozen = true;
+
+				for(uint32_t j = 3; j < length; j++)
+				{
+					if(instruction[j] < bound && unfrozen[instruction[j]])
+					{
+						frozen = false;
+					}
+				}
+
+				specialized.insert(specialized.end(), instruction, instruction + length);
+
+				if(frozen)
+				{
+					specialized[first] = (length << 16) | OpConstantComposite;
+				}
+				else if(result < bound)
+				{
+					unfrozen[result] = true;
+				}
+			}
+			break;
+		case OpSpecConstantOp:
+			// Evaluating the operation is left to the translator
+			specialized.insert(specialized.end(), instruction, instruction + length);
+
+			if(result < bound)
+			{
+				unfrozen[result] = true;
+			}
+			break;
+		default:
+			specialized.insert(specialized.end(), instruction, instruction + length);
+			break;
+		}
+
+		i += length;
+	}
+
+	return specialized;
+}
+
 } // namespace vk
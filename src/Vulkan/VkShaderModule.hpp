@@ -16,6 +16,7 @@
 #define VK_SHADER_MODULE_HPP_
 
 #include "VkObject.hpp"
+#include <vector>
 
 namespace vk
 {
@@ -29,8 +30,17 @@ public:
 
 	static size_t ComputeRequiredAllocationSize(const VkShaderModuleCreateInfo* pCreateInfo);
 
+	const uint32_t* getCode() const { return code; }
+	size_t getWordCount() const { return wordCount; }
+	bool findEntryPoint(const char* name, VkShaderStageFlagBits stage, uint32_t* id) const;
+
+	// Copy of the module with its specialization constants turned into regular constants, holding
+	// the values of specializationInfo or their defaults. OpSpecConstantOp results stay unevaluated.
+	std::vector<uint32_t> specialize(const VkSpecializationInfo* specializationInfo) const;
+
 private:
 	uint32_t* code = nullptr;
+	size_t wordCount = 0;
 };
 
 static inline ShaderModule* Cast(VkShaderModule object)
@@ -27,10 +27,22 @@
 
 #if defined(_WIN32)
 #include <Windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
 
 #define EXPECT_GLENUM_EQ(expected, actual) EXPECT_EQ(static_cast<GLenum>(expected), static_cast<GLenum>(actual))
 
@@ -316,6 +328,120 @@ protected:
 		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
 	}
 
+	struct FramebufferHandles
+	{
+		GLuint framebuffer;
+		GLuint colorBuffer;
+		GLuint depthBuffer;
+	};
+
+	// Creates and binds a framebuffer with RGBA8 color and 24-bit depth renderbuffers, and sets the viewport to cover it
+	FramebufferHandles createColorDepthFramebuffer(GLsizei width, GLsizei height)
+	{
+		FramebufferHandles fb;
+		glGenFramebuffers(1, &fb.framebuffer);
+		glGenRenderbuffers(1, &fb.colorBuffer);
+		glGenRenderbuffers(1, &fb.depthBuffer);
+
+		glBindRenderbuffer(GL_RENDERBUFFER, fb.colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, fb.depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fb.framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, fb.colorBuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fb.depthBuffer);
+		EXPECT_GLENUM_EQ(GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+		glViewport(0, 0, width, height);
+
+		return fb;
+	}
+
+	// Creates and binds a framebuffer with only an RGBA8 color renderbuffer, and sets the viewport to cover it
+	FramebufferHandles createColorFramebuffer(GLsizei width, GLsizei height)
+	{
+		FramebufferHandles fb;
+		glGenFramebuffers(1, &fb.framebuffer);
+		glGenRenderbuffers(1, &fb.colorBuffer);
+		fb.depthBuffer = 0;
+
+		glBindRenderbuffer(GL_RENDERBUFFER, fb.colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fb.framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, fb.colorBuffer);
+		EXPECT_GLENUM_EQ(GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+		glViewport(0, 0, width, height);
+
+		return fb;
+	}
+
+	void deleteFramebuffer(const FramebufferHandles& fb)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fb.framebuffer);
+		glDeleteRenderbuffers(1, &fb.colorBuffer);
+		glDeleteRenderbuffers(1, &fb.depthBuffer);   // Ignored when zero
+
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+	}
+
+	// Creates and uses a program which passes the "position" attribute through to gl_Position and to
+	// the highp vec4 varying "vPosition", and which writes the fragColor expression to gl_FragColor
+	ProgramHandles createPassThroughProgram(const std::string& fragColor)
+	{
+		const std::string vs =
+			"attribute vec4 position;\n"
+			"varying highp vec4 vPosition;\n"
+			"void main()\n"
+			"{\n"
+			"    gl_Position = position;\n"
+			"    vPosition = position;\n"
+			"}\n";
+
+		const std::string fs =
+			"precision highp float;\n"
+			"varying highp vec4 vPosition;\n"
+			"void main()\n"
+			"{\n"
+			"    gl_FragColor = " + fragColor + ";\n"
+			"}\n";
+
+		const ProgramHandles ph = createProgram(vs, fs);
+		glUseProgram(ph.program);
+
+		return ph;
+	}
+
+	// Calls draw once to compile the routines, then runs times, each waited for with glFinish, and returns
+	// the fastest run in milliseconds. The optional prepare function runs untimed before each draw.
+	double bestDrawTime(int runs, const std::function<void()>& draw, const std::function<void()>& prepare = nullptr)
+	{
+		draw();
+		glFinish();
+
+		double best = 0.0;
+
+		for(int run = 0; run < runs; run++)
+		{
+			if(prepare)
+			{
+				prepare();
+				glFinish();
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			draw();
+			glFinish();
+			auto end = std::chrono::steady_clock::now();
+
+			double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+			best = (run == 0) ? milliseconds : std::min(best, milliseconds);
+		}
+
+		return best;
+	}
+
 	EGLDisplay getDisplay() const { return display; }
 	EGLConfig getConfig() const { return config; }
 	EGLSurface getSurface() const { return surface; }
@@ -973,6 +1099,1469 @@ TEST_F(SwiftShaderTest, OutOfMemory)
 	}
 }
 
+// Test decoding of ASTC LDR blocks. The expected colors of the encoded blocks are reference decodes,
+// computed with a separate implementation of the decoding procedure in the Khronos Data Format Specification.
+TEST_F(SwiftShaderTest, CompressedTexImage2D_ASTC)
+{
+	Initialize(3, false);
+
+	const std::string vs =
+		"#version 300 es\n"
+		"in vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"#version 300 es\n"
+		"precision mediump float;\n"
+		"uniform sampler2D tex;\n"
+		"out vec4 fragColor;\n"
+		"void main()\n"
+		"{\n"
+		"    fragColor = texelFetch(tex, ivec2(gl_FragCoord.xy) % textureSize(tex, 0), 0);\n"
+		"}\n";
+
+	// Void-extent block with constant color (1.0, 0.0, 0.25, 1.0)
+	const unsigned char voidExtent[16] =
+	{
+		0xFC, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF, 0x00, 0x00, 0x00, 0x40, 0xFF, 0xFF
+	};
+
+	// Single partition luminance block with endpoints 0 and 255, and a 4x4 grid of
+	// 2-bit weights which increase along each row
+	const unsigned char luminance[16] =
+	{
+		0x42, 0x00, 0x00, 0xFE, 0x01, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x27, 0x27, 0x27, 0x27
+	};
+
+	// Two partitions with RGB direct endpoints (red to yellow, blue to cyan), in the 0..39 quint range
+	const unsigned char twoPartitions[16] =
+	{
+		0x42, 0x48, 0x06, 0x30, 0x08, 0x20, 0x00, 0x00,
+		0x00, 0x20, 0x08, 0x01, 0x27, 0x27, 0x27, 0x27
+	};
+
+	// Three partitions with different endpoint modes: luminance direct, luminance-alpha direct,
+	// and luminance-alpha base+offset
+	const unsigned char threePartitions[16] =
+	{
+		0x42, 0xB0, 0xB6, 0x4C, 0x89, 0x7F, 0x00, 0xFA,
+		0xB3, 0xEF, 0x84, 0x40, 0xC9, 0x72, 0x9C, 0x27
+	};
+
+	// Dual plane block with RGBA direct endpoints, where the second weight plane drives blue
+	const unsigned char dualPlane[16] =
+	{
+		0x42, 0x84, 0xE1, 0xE0, 0x21, 0x20, 0x08, 0x88,
+		0x7F, 0x3B, 0x5D, 0x19, 0x6E, 0x2A, 0x4C, 0x08
+	};
+
+	// RGBA direct endpoints in the 0..95 trit range, with weights in the 0..11 trit range
+	const unsigned char trits[16] =
+	{
+		0x51, 0x82, 0x45, 0x85, 0xC7, 0x68, 0xCF, 0x43,
+		0x1F, 0xBA, 0xA2, 0x3F, 0xE1, 0x5B, 0xD2, 0x34
+	};
+
+	// 5x4 block with luminance-alpha endpoints and a 5x4 grid of weights in the 0..9 quint range
+	const unsigned char quints5x4[16] =
+	{
+		0xC1, 0x82, 0x00, 0xFE, 0xFF, 0xC1, 0x00, 0x80,
+		0xFA, 0x9D, 0x9B, 0x13, 0x3F, 0x85, 0xFA, 0x32
+	};
+
+	// 8x8 block with RGB base+offset endpoints and a 5x5 weight grid, which gets interpolated
+	const unsigned char infill8x8[16] =
+	{
+		0xF3, 0x20, 0x9F, 0xC7, 0x43, 0xD8, 0x4D, 0x87,
+		0x0B, 0x57, 0xAF, 0x0E, 0x1F, 0xAE, 0x5C, 0x1D
+	};
+
+	// 8x8 block with two partitions, which are selected without the small block coordinate scaling
+	const unsigned char twoPartitions8x8[16] =
+	{
+		0x53, 0x68, 0x1A, 0x10, 0x1E, 0xE0, 0xE1, 0xE1,
+		0x1F, 0x1E, 0xAF, 0xF0, 0x0A, 0xAF, 0xF0, 0x0A
+	};
+
+	// 12x12 block with RGB base+scale plus alpha endpoints and a 6x5 weight grid
+	const unsigned char infill12x12[16] =
+	{
+		0x62, 0x41, 0xFF, 0x01, 0x41, 0x00, 0x21, 0xE0,
+		0x01, 0x00, 0x63, 0x13, 0x11, 0x72, 0x02, 0x00
+	};
+
+	// 12x12 void-extent block with constant color (0x1234, 0x8000, 0xFFFF, 0xC000)
+	const unsigned char voidExtent12x12[16] =
+	{
+		0xFC, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		0x34, 0x12, 0x00, 0x80, 0xFF, 0xFF, 0x00, 0xC0
+	};
+
+	// sRGB block with RGBA direct endpoints, read back as linear colors
+	const unsigned char srgb[16] =
+	{
+		0x42, 0x80, 0x01, 0xFE, 0x81, 0x80, 0x01, 0x01,
+		0xFE, 0x01, 0x01, 0x00, 0x27, 0x27, 0x27, 0x27
+	};
+
+	// sRGB void-extent block, of which only the top 8 bits of each color component are used
+	const unsigned char srgbVoidExtent[16] =
+	{
+		0xFC, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF, 0x00, 0x80, 0x00, 0x20, 0x00, 0x40
+	};
+
+	struct Texel
+	{
+		int x;
+		int y;
+		unsigned char color[4];
+	};
+
+	const struct
+	{
+		GLenum format;
+		GLsizei width;
+		GLsizei height;
+		const unsigned char *block;
+		std::vector<Texel> expected;
+	}
+	tests[] =
+	{
+		{ GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, voidExtent, { { 0, 0, { 255, 0, 64, 255 } }, { 3, 3, { 255, 0, 64, 255 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, luminance, { { 0, 0, { 0, 0, 0, 255 } }, { 1, 0, { 84, 84, 84, 255 } }, { 2, 0, { 171, 171, 171, 255 } }, { 3, 0, { 255, 255, 255, 255 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, twoPartitions, { { 0, 0, { 255, 0, 0, 255 } }, { 3, 0, { 255, 255, 0, 255 } }, { 3, 1, { 0, 255, 255, 255 } }, { 1, 2, { 0, 84, 255, 255 } }, { 0, 3, { 0, 0, 255, 255 } }, { 2, 3, { 0, 171, 255, 255 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, threePartitions, { { 0, 0, { 40, 40, 40, 255 } }, { 1, 0, { 92, 92, 92, 255 } }, { 2, 0, { 49, 49, 49, 58 } }, { 1, 1, { 84, 84, 84, 193 } }, { 2, 2, { 255, 255, 255, 65 } }, { 0, 3, { 199, 199, 199, 255 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, dualPlane, { { 0, 0, { 0, 131, 0, 255 } }, { 3, 0, { 255, 65, 0, 32 } }, { 1, 1, { 84, 109, 84, 182 } }, { 2, 2, { 171, 87, 171, 105 } }, { 0, 3, { 0, 131, 255, 255 } }, { 3, 3, { 255, 65, 255, 32 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, trits, { { 0, 0, { 10, 199, 91, 255 } }, { 3, 0, { 200, 58, 165, 151 } }, { 1, 1, { 92, 138, 123, 210 } }, { 2, 2, { 157, 90, 148, 174 } }, { 0, 3, { 49, 170, 106, 233 } }, { 3, 3, { 239, 29, 180, 129 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_5x4_KHR, 5, 4, quints5x4, { { 0, 0, { 0, 0, 0, 255 } }, { 4, 0, { 199, 199, 199, 131 } }, { 2, 1, { 112, 112, 112, 185 } }, { 3, 2, { 199, 199, 199, 131 } }, { 0, 3, { 28, 28, 28, 238 } }, { 4, 3, { 255, 255, 255, 96 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 8, 8, infill8x8, { { 0, 0, { 30, 60, 89, 255 } }, { 7, 0, { 43, 67, 85, 255 } }, { 3, 2, { 45, 68, 84, 255 } }, { 4, 4, { 52, 72, 82, 255 } }, { 5, 6, { 49, 70, 83, 255 } }, { 7, 7, { 38, 65, 86, 255 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 8, 8, twoPartitions8x8, { { 0, 0, { 0, 0, 255, 255 } }, { 3, 0, { 147, 255, 108, 255 } }, { 7, 1, { 0, 255, 255, 255 } }, { 5, 3, { 191, 0, 64, 255 } }, { 2, 5, { 191, 255, 64, 255 } }, { 7, 7, { 255, 0, 0, 255 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_12x12_KHR, 12, 12, infill12x12, { { 0, 0, { 127, 64, 16, 16 } }, { 11, 0, { 127, 64, 16, 16 } }, { 3, 3, { 189, 95, 24, 125 } }, { 6, 5, { 203, 102, 26, 149 } }, { 9, 8, { 135, 68, 17, 30 } }, { 11, 11, { 127, 64, 16, 16 } } } },
+		{ GL_COMPRESSED_RGBA_ASTC_12x12_KHR, 12, 12, voidExtent12x12, { { 0, 0, { 18, 128, 255, 191 } }, { 5, 7, { 18, 128, 255, 191 } }, { 11, 11, { 18, 128, 255, 191 } } } },
+		{ GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR, 4, 4, srgb, { { 0, 0, { 0, 13, 55, 255 } }, { 1, 0, { 23, 37, 24, 213 } }, { 2, 0, { 104, 78, 6, 170 } }, { 3, 0, { 255, 134, 0, 128 } }, { 1, 3, { 23, 37, 24, 213 } } } },
+		{ GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR, 4, 4, srgbVoidExtent, { { 0, 0, { 255, 55, 4, 64 } }, { 3, 3, { 255, 55, 4, 64 } } } },
+	};
+
+	for(const auto &test : tests)
+	{
+		GLuint tex = 1;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glCompressedTexImage2D(GL_TEXTURE_2D, 0, test.format, test.width, test.height, 0, 16, test.block);
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+		const ProgramHandles ph = createProgram(vs, fs);
+
+		glUseProgram(ph.program);
+		GLint location = glGetUniformLocation(ph.program, "tex");
+		ASSERT_NE(-1, location);
+		glUniform1i(location, 0);
+
+		glClearColor(0.0, 0.0, 0.0, 0.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+		drawQuad(ph.program, "tex");
+
+		deleteProgram(ph);
+
+		for(const auto &texel : test.expected)
+		{
+			unsigned char color[4] = { 0 };
+			glReadPixels(texel.x, texel.y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+			EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+			for(int c = 0; c < 4; c++)
+			{
+				EXPECT_NEAR(texel.color[c], color[c], 1);
+			}
+		}
+	}
+
+	Uninitialize();
+}
+
+// Test sampling S3TC textures, which are read without decoding them first
+TEST_F(SwiftShaderTest, CompressedTexImage2D_S3TC)
+{
+	Initialize(3, false);
+
+	const std::string vs =
+		"#version 300 es\n"
+		"in vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"#version 300 es\n"
+		"precision mediump float;\n"
+		"uniform sampler2D tex;\n"
+		"out vec4 fragColor;\n"
+		"void main()\n"
+		"{\n"
+		"    fragColor = texture(tex, (vec2(ivec2(gl_FragCoord.xy) % 4) + 0.5) / 4.0);\n"
+		"}\n";
+
+	// Red and blue endpoints, with color indices 0 to 3 along each row
+	const unsigned char dxt1[8] =
+	{
+		0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4
+	};
+
+	// Alpha endpoints 255 and 0, with alpha indices 0 to 3 along each row, followed by the DXT1 block
+	const unsigned char dxt5[16] =
+	{
+		0xFF, 0x00, 0x88, 0x86, 0x68, 0x88, 0x86, 0x68,
+		0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4
+	};
+
+	const struct
+	{
+		GLenum format;
+		const unsigned char *block;
+		GLsizei size;
+		unsigned char expected[4][4];
+	}
+	tests[] =
+	{
+		{ GL_COMPRESSED_RGB_S3TC_DXT1_EXT, dxt1, 8, { { 255, 0, 0, 255 }, { 0, 0, 255, 255 }, { 170, 0, 85, 255 }, { 85, 0, 170, 255 } } },
+		{ GL_COMPRESSED_RGBA_S3TC_DXT5_ANGLE, dxt5, 16, { { 255, 0, 0, 255 }, { 0, 0, 255, 0 }, { 170, 0, 85, 219 }, { 85, 0, 170, 182 } } },
+	};
+
+	for(const auto &test : tests)
+	{
+		GLuint tex = 1;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glCompressedTexImage2D(GL_TEXTURE_2D, 0, test.format, 4, 4, 0, test.size, test.block);
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+		const ProgramHandles ph = createProgram(vs, fs);
+
+		glUseProgram(ph.program);
+		GLint location = glGetUniformLocation(ph.program, "tex");
+		ASSERT_NE(-1, location);
+		glUniform1i(location, 0);
+
+		glClearColor(0.0, 0.0, 0.0, 0.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+		drawQuad(ph.program, "tex");
+
+		deleteProgram(ph);
+
+		for(int x = 0; x < 4; x++)
+		{
+			expectFramebufferColor(test.expected[x], x, 0);
+		}
+	}
+
+	Uninitialize();
+}
+
+// Test resolving multisampled renderbuffers, after drawing to parts of them
+TEST_F(SwiftShaderTest, MultisampleResolve)
+{
+	Initialize(3, false);
+
+	const std::string vs =
+		"#version 300 es\n"
+		"in vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"#version 300 es\n"
+		"precision mediump float;\n"
+		"uniform vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main()\n"
+		"{\n"
+		"    fragColor = color;\n"
+		"}\n";
+
+	GLuint renderbuffers[2];
+	glGenRenderbuffers(2, renderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_RGBA8, 16, 16);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 16, 16);
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	GLuint framebuffers[2];
+	glGenFramebuffers(2, framebuffers);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[1]);
+	glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[1]);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	EXPECT_GLENUM_EQ(GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	glViewport(0, 0, 16, 16);
+
+	const ProgramHandles ph = createProgram(vs, fs);
+	glUseProgram(ph.program);
+	GLint location = glGetUniformLocation(ph.program, "color");
+	ASSERT_NE(-1, location);
+
+	auto resolve = [&]()
+	{
+		glDisable(GL_SCISSOR_TEST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+		glBlitFramebuffer(0, 0, 16, 16, 0, 0, 16, 16, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[1]);
+	};
+
+	glClearColor(0.0, 0.0, 0.0, 1.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// Each draw only touches the scissored region, which the next resolve must cover
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(2, 2, 4, 4);
+	glUniform4f(location, 1.0f, 0.0f, 0.0f, 1.0f);
+	drawQuad(ph.program);
+	resolve();
+
+	const unsigned char black[4] = { 0, 0, 0, 255 };
+	const unsigned char red[4] = { 255, 0, 0, 255 };
+	const unsigned char green[4] = { 0, 255, 0, 255 };
+	expectFramebufferColor(black, 1, 1);
+	expectFramebufferColor(red, 2, 2);
+	expectFramebufferColor(red, 5, 5);
+	expectFramebufferColor(black, 6, 6);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(8, 8, 8, 8);
+	glUniform4f(location, 0.0f, 1.0f, 0.0f, 1.0f);
+	drawQuad(ph.program);
+	resolve();
+
+	expectFramebufferColor(red, 3, 3);
+	expectFramebufferColor(black, 7, 7);
+	expectFramebufferColor(green, 8, 8);
+	expectFramebufferColor(green, 15, 15);
+
+	// Pixels along the diagonal of a triangle are partially covered
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	float vertices[9] = { -1.0f,  1.0f, 0.5f,
+	                      -1.0f, -1.0f, 0.5f,
+	                       1.0f, -1.0f, 0.5f };
+
+	GLint posLoc = glGetAttribLocation(ph.program, "position");
+	glUniform4f(location, 1.0f, 1.0f, 1.0f, 1.0f);
+	glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, 0, vertices);
+	glEnableVertexAttribArray(posLoc);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisableVertexAttribArray(posLoc);
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+	resolve();
+
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	const unsigned char gray[4] = { 128, 128, 128, 255 };   // Two of four samples covered
+	expectFramebufferColor(white, 6, 8);
+	expectFramebufferColor(gray, 7, 8);
+	expectFramebufferColor(black, 8, 8);
+
+	deleteProgram(ph);
+	glDeleteFramebuffers(2, framebuffers);
+	glDeleteRenderbuffers(2, renderbuffers);
+
+	Uninitialize();
+}
+
+// Returns the values of every occurrence of "key":<number> in a JSON document
+static std::vector<long long> jsonValues(const std::string &json, const std::string &key)
+{
+	std::vector<long long> values;
+	const std::string pattern = "\"" + key + "\":";
+
+	for(size_t pos = json.find(pattern); pos != std::string::npos; pos = json.find(pattern, pos + 1))
+	{
+		values.push_back(atoll(json.c_str() + pos + pattern.size()));
+	}
+
+	return values;
+}
+
+// Profiling is configured through SwiftShader.ini in the working directory, and the statistics
+// are dumped when the renderer shuts down. Tests run in a directory of their own, so they can't
+// pick up or overwrite a developer's configuration, and instrumentation is switched back off.
+class ProfilerTest : public SwiftShaderTest
+{
+protected:
+	void SetUp() override
+	{
+		SwiftShaderTest::SetUp();   // Loads the libraries relative to the original directory
+
+		char cwd[4096];
+		ASSERT_NE(nullptr, getcwd(cwd, sizeof(cwd)));
+		workingDirectory = cwd;
+
+		testDirectory = testing::TempDir() + "swiftshader_profiler_" + std::to_string(getpid());
+		ASSERT_EQ(0, makeDirectory(testDirectory.c_str()));
+		ASSERT_EQ(0, chdir(testDirectory.c_str()));
+		inTestDirectory = true;
+	}
+
+	void TearDown() override
+	{
+		if(!inTestDirectory)
+		{
+			return;
+		}
+
+		if(instrumenting)
+		{
+			drawAndCollect(false);
+		}
+
+		remove(iniFile);
+		remove(statisticsFile);
+
+		EXPECT_EQ(0, chdir(workingDirectory.c_str()));
+		EXPECT_EQ(0, rmdir(testDirectory.c_str()));
+	}
+
+	// Draws a quad over all pixels, then one over the half which passes the depth test, and
+	// returns the statistics recorded by the renderer
+	std::string drawAndCollect(bool instrumentation)
+	{
+		// Leaving out LastModified makes the file count as a new configuration, which is
+		// applied even when it disables instrumentation
+		FILE *ini = fopen(iniFile, "w");
+		EXPECT_NE(nullptr, ini);
+
+		if(ini)
+		{
+			fprintf(ini, "[Profiling]\nInstrumentation=%d\nStatisticsFile=%s\n", instrumentation ? 1 : 0, statisticsFile);
+			fclose(ini);
+		}
+
+		remove(statisticsFile);
+		instrumenting = true;   // Until a run without instrumentation has completed
+
+		const std::string vs =
+			"attribute vec4 position;\n"
+			"void main()\n"
+			"{\n"
+			"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+			"}\n";
+
+		const std::string fs =
+			"precision mediump float;\n"
+			"void main()\n"
+			"{\n"
+			"    gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0);\n"
+			"}\n";
+
+		Initialize(3, false);
+
+		const ProgramHandles ph = createProgram(vs, fs);
+		const FramebufferHandles fb = createColorDepthFramebuffer(64, 64);
+
+		drawQuad(ph.program);
+
+		glEnable(GL_DEPTH_TEST);
+		glClearDepthf(1.0f);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glEnable(GL_SCISSOR_TEST);
+		glClearDepthf(0.0f);
+		glScissor(0, 0, 32, 64);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+		drawQuad(ph.program);
+		glDisable(GL_DEPTH_TEST);
+
+		deleteFramebuffer(fb);
+		deleteProgram(ph);
+
+		Uninitialize();
+
+		instrumenting = instrumentation;
+
+		std::string json;
+		FILE *file = fopen(statisticsFile, "r");
+		EXPECT_NE(nullptr, file);
+
+		if(file)
+		{
+			char buffer[4096];
+			for(size_t size; (size = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+			{
+				json.append(buffer, size);
+			}
+
+			fclose(file);
+		}
+
+		return json;
+	}
+
+private:
+	static int makeDirectory(const char *path)
+	{
+		#if defined(_WIN32)
+			return _mkdir(path);
+		#else
+			return mkdir(path, 0700);
+		#endif
+	}
+
+	const char *const iniFile = "SwiftShader.ini";
+	const char *const statisticsFile = "statistics.json";
+
+	std::string workingDirectory;
+	std::string testDirectory;
+	bool inTestDirectory = false;
+	bool instrumenting = false;
+};
+
+// Test that instrumented draws record their primitive and shaded pixel counts
+TEST_F(ProfilerTest, Statistics)
+{
+	std::string json = drawAndCollect(true);
+	std::vector<long long> primitivesIn = jsonValues(json, "primitivesIn");
+	std::vector<long long> pixelsShaded = jsonValues(json, "pixelsShaded");
+	std::vector<long long> draw = jsonValues(json, "draw");
+
+	ASSERT_EQ(2u, primitivesIn.size());
+	ASSERT_EQ(2u, pixelsShaded.size());
+	ASSERT_EQ(2u, draw.size());
+	EXPECT_EQ(2, primitivesIn[0]);
+	EXPECT_EQ(64 * 64, pixelsShaded[0]);
+	EXPECT_EQ(draw[0] + 1, draw[1]);
+	EXPECT_EQ(2, primitivesIn[1]);
+	EXPECT_EQ(32 * 64, pixelsShaded[1]);   // Half of the pixels fail the depth test, and aren't shaded
+
+	// Nothing is recorded while instrumentation is disabled
+	json = drawAndCollect(false);
+	EXPECT_NE(std::string::npos, json.find("\"draws\":["));
+	EXPECT_EQ(0u, jsonValues(json, "draw").size());
+}
+
+// Test generating mipmaps, with sRGB textures averaged in linear space
+TEST_F(SwiftShaderTest, GenerateMipmap)
+{
+	Initialize(3, false);
+
+	const unsigned char texels[2 * 2 * 4] =
+	{
+		0, 100, 200, 255,   100, 0, 200, 255,
+		200, 100, 0, 255,   100, 200, 0, 255,
+	};
+
+	const unsigned char halves[2 * 2 * 4] =
+	{
+		0, 255, 0, 255,     255, 0, 0, 255,
+		0, 255, 255, 0,     255, 0, 255, 0,
+	};
+
+	const struct
+	{
+		GLenum internalFormat;
+		const unsigned char *texels;
+		unsigned char expected[4];
+	}
+	tests[] =
+	{
+		{ GL_RGBA8, texels, { 100, 100, 100, 255 } },
+		{ GL_SRGB8_ALPHA8, halves, { 188, 188, 188, 128 } },   // Linear 0.5, while alpha is not encoded
+	};
+
+	for(const auto &test : tests)
+	{
+		GLuint tex = 1;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, test.internalFormat, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, test.texels);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+		GLuint fbo = 1;
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 1);
+		EXPECT_GLENUM_EQ(GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+
+		expectFramebufferColor(test.expected);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteTextures(1, &tex);
+	}
+
+	Uninitialize();
+}
+
+// Test generating mipmaps of odd sized textures, where each texel of the next level covers more than 2x2 texels
+TEST_F(SwiftShaderTest, GenerateMipmapOddSizes)
+{
+	Initialize(3, false);
+
+	const struct
+	{
+		int size;
+		int x;   // Level 1 texel to check
+		unsigned char expected[4];
+	}
+	tests[] =
+	{
+		{ 3, 0, { 85, 85, 0, 255 } },   // A third of each axis lies in the last column or row
+		{ 5, 0, { 0, 0, 0, 255 } },
+		{ 5, 1, { 102, 0, 0, 255 } },   // The last column has a weight of 2/5
+	};
+
+	for(const auto &test : tests)
+	{
+		// Red in the last column and green in the last row, which a 2x2 box filter would skip
+		std::vector<unsigned char> texels(test.size * test.size * 4);
+
+		for(int y = 0; y < test.size; y++)
+		{
+			for(int x = 0; x < test.size; x++)
+			{
+				unsigned char *texel = &texels[(y * test.size + x) * 4];
+				texel[0] = (x == test.size - 1) ? 255 : 0;
+				texel[1] = (y == test.size - 1) ? 255 : 0;
+				texel[2] = 0;
+				texel[3] = 255;
+			}
+		}
+
+		GLuint tex = 1;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, test.size, test.size, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+		GLuint fbo = 1;
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 1);
+		EXPECT_GLENUM_EQ(GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+
+		expectFramebufferColor(test.expected, test.x, 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteTextures(1, &tex);
+	}
+
+	Uninitialize();
+}
+
+// Test indexed drawing where vertices sharing a primitive map to the same post-transform cache line
+TEST_F(SwiftShaderTest, ScatteredIndices)
+{
+	Initialize(3, false);
+
+	const std::string vs =
+		"#version 300 es\n"
+		"in vec4 position;\n"
+		"flat out vec2 color;\n"
+		"void main()\n"
+		"{\n"
+		"    color = vec2(float(gl_VertexID) == position.z ? 1.0 : 0.0, position.w);\n"
+		"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"#version 300 es\n"
+		"precision mediump float;\n"
+		"flat in vec2 color;\n"
+		"out vec4 fragColor;\n"
+		"void main()\n"
+		"{\n"
+		"    fragColor = vec4(0.0, color, 1.0);\n"
+		"}\n";
+
+	const ProgramHandles ph = createProgram(vs, fs);
+	glUseProgram(ph.program);
+
+	// Eight vertical bands, each a quad whose corners are 64 vertices apart
+	float vertices[256][4] = {};
+	unsigned short indices[8 * 6];
+
+	for(int q = 0; q < 8; q++)
+	{
+		for(int k = 0; k < 4; k++)
+		{
+			int index = q + 64 * k + 3;
+			vertices[index][0] = (q + (k & 1)) / 4.0f - 1.0f;
+			vertices[index][1] = (k & 2) ? 1.0f : -1.0f;
+			vertices[index][2] = (float)index;
+			vertices[index][3] = q * 32 / 255.0f;
+		}
+
+		const int corners[6] = { 0, 1, 2, 2, 1, 3 };
+
+		for(int i = 0; i < 6; i++)
+		{
+			indices[q * 6 + i] = q + 64 * corners[i] + 3;
+		}
+	}
+
+	GLuint buffers[2];
+	glGenBuffers(2, buffers);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	GLint posLoc = glGetAttribLocation(ph.program, "position");
+	glVertexAttribPointer(posLoc, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+	glEnableVertexAttribArray(posLoc);
+
+	glViewport(0, 0, 16, 16);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDrawElements(GL_TRIANGLES, 8 * 6, GL_UNSIGNED_SHORT, nullptr);
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	for(int q = 0; q < 8; q++)
+	{
+		unsigned char expected[4] = { 0, 255, (unsigned char)(q * 32), 255 };
+		expectFramebufferColor(expected, 2 * q, 8);
+		expectFramebufferColor(expected, 2 * q + 1, 15);
+	}
+
+	glDisableVertexAttribArray(posLoc);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glDeleteBuffers(2, buffers);
+	deleteProgram(ph);
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	Uninitialize();
+}
+
+// Test that state changed between draws is picked up when only some of the processor states depend on it
+TEST_F(SwiftShaderTest, StateChangesBetweenDraws)
+{
+	Initialize(3, false);
+
+	const std::string vs =
+		"attribute vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"precision mediump float;\n"
+		"uniform sampler2D tex;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_FragColor = texture2D(tex, vec2(0.5, 0.5));\n"
+		"}\n";
+
+	const ProgramHandles ph = createProgram(vs, fs);
+
+	GLuint tex[2] = { 0, 0 };
+	glGenTextures(2, tex);
+
+	const unsigned char green[4] = { 0, 255, 0, 255 };
+	glBindTexture(GL_TEXTURE_2D, tex[0]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, green);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	const unsigned char red = 255;
+	glBindTexture(GL_TEXTURE_2D, tex[1]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 1, 1, 0, GL_RED, GL_UNSIGNED_BYTE, &red);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glBindTexture(GL_TEXTURE_2D, tex[0]);
+	drawQuad(ph.program, "tex");
+	expectFramebufferColor(green);
+
+	// Only the sampled format differs
+	const unsigned char expectedRed[4] = { 255, 0, 0, 255 };
+	glBindTexture(GL_TEXTURE_2D, tex[1]);
+	drawQuad(ph.program, "tex");
+	expectFramebufferColor(expectedRed);
+
+	// Only the blend state differs
+	const unsigned char yellow[4] = { 255, 255, 0, 255 };
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glBindTexture(GL_TEXTURE_2D, tex[0]);
+	drawQuad(ph.program, "tex");
+	expectFramebufferColor(yellow);
+
+	// Same state again, with the texture's contents changed
+	glDisable(GL_BLEND);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, expectedRed);
+	drawQuad(ph.program, "tex");
+	expectFramebufferColor(expectedRed);
+
+	glDeleteTextures(2, tex);
+	deleteProgram(ph);
+
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	Uninitialize();
+}
+
+// Test that occluded primitives stay hidden, and that the coarse depth bounds used to
+// reject them follow depth clears and depth values being raised
+TEST_F(SwiftShaderTest, DepthTestOcclusion)
+{
+	Initialize(3, false);
+
+	const std::string vs =
+		"attribute vec4 position;\n"
+		"uniform vec3 rect;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_Position = vec4(mix(rect.x, rect.y, position.x * 0.5 + 0.5), position.y, rect.z, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"precision mediump float;\n"
+		"uniform vec4 color;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_FragColor = color;\n"
+		"}\n";
+
+	const ProgramHandles ph = createProgram(vs, fs);
+	glUseProgram(ph.program);
+	GLint rectLocation = glGetUniformLocation(ph.program, "rect");
+	GLint colorLocation = glGetUniformLocation(ph.program, "color");
+	GLint positionLocation = glGetAttribLocation(ph.program, "position");
+
+	const FramebufferHandles fb = createColorDepthFramebuffer(64, 64);
+
+	const float vertices[12] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f,
+	                             -1.0f,  1.0f, 1.0f, -1.0f,  1.0f, 1.0f };
+	glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+	glEnableVertexAttribArray(positionLocation);
+
+	// Draws a full height rectangle between x0 and x1, in normalized device coordinates
+	auto drawRect = [&](float x0, float x1, float z, const float color[4])
+	{
+		glUniform3f(rectLocation, x0, x1, z);
+		glUniform4fv(colorLocation, 1, color);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+	};
+
+	const float red[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+	const float green[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+	const float blue[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+	const unsigned char expectedRed[4] = { 255, 0, 0, 255 };
+	const unsigned char expectedGreen[4] = { 0, 255, 0, 255 };
+	const unsigned char expectedBlue[4] = { 0, 0, 255, 255 };
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClearDepthf(1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+
+	// Left half near, then everything farther away
+	drawRect(-1.0f, 0.0f, -0.5f, green);
+	drawRect(-1.0f, 1.0f, 0.5f, red);
+	expectFramebufferColor(expectedGreen, 8, 32);
+	expectFramebufferColor(expectedRed, 56, 32);
+
+	// Occluded everywhere
+	drawRect(-1.0f, 1.0f, 0.75f, blue);
+	expectFramebufferColor(expectedGreen, 8, 32);
+	expectFramebufferColor(expectedRed, 56, 32);
+
+	// Raising the depth values makes previously occluded primitives visible
+	glDepthFunc(GL_ALWAYS);
+	drawRect(-1.0f, 1.0f, 0.9f, red);
+	glDepthFunc(GL_LESS);
+	drawRect(-1.0f, 1.0f, 0.75f, blue);
+	expectFramebufferColor(expectedBlue, 8, 32);
+	expectFramebufferColor(expectedBlue, 56, 32);
+
+	// Clearing part of the depth buffer to the near plane occludes everything there
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(0, 0, 20, 64);
+	glClearDepthf(0.0f);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	drawRect(-1.0f, 1.0f, 0.0f, green);
+	expectFramebufferColor(expectedBlue, 8, 32);
+	expectFramebufferColor(expectedBlue, 19, 32);
+	expectFramebufferColor(expectedGreen, 20, 32);
+	expectFramebufferColor(expectedGreen, 56, 32);
+
+	// Clearing to the far plane makes everything visible again
+	glClearDepthf(1.0f);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	drawRect(-1.0f, 1.0f, 0.5f, red);
+	expectFramebufferColor(expectedRed, 8, 32);
+	expectFramebufferColor(expectedRed, 56, 32);
+
+	glDisableVertexAttribArray(positionLocation);
+	glDisable(GL_DEPTH_TEST);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	Uninitialize();
+}
+
+// Test that triangles extending past the viewport are rasterized and interpolated the same
+// whether they are left to the scissor within the guard band or clipped beyond it
+TEST_F(SwiftShaderTest, GuardBandClipping)
+{
+	Initialize(3, false);
+
+	const ProgramHandles ph = createPassThroughProgram("vec4(vPosition.x * 0.5 + 0.5, 0.0, 0.0, 1.0)");
+	GLint positionLocation = glGetAttribLocation(ph.program, "position");
+	const FramebufferHandles fb = createColorFramebuffer(64, 64);
+	glEnableVertexAttribArray(positionLocation);
+
+	// Right triangles in the lower left corner, with legs ending at x = extent and y = extent
+	// in normalized device coordinates. The guard band of a 64x64 viewport is 32 times its size.
+	const float extents[] = { 1.5f, 3.0f, 31.0f, 33.0f, 1.0e6f };
+
+	for(float extent : extents)
+	{
+		const float vertices[12] = { -1.0f, -1.0f, 0.0f, 1.0f,
+		                             extent, -1.0f, 0.0f, 1.0f,
+		                             -1.0f, extent, 0.0f, 1.0f };
+		glVertexAttribPointer(positionLocation, 4, GL_FLOAT, GL_FALSE, 0, vertices);
+
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		for(int y = 0; y < 64; y += 9)
+		{
+			for(int x = 0; x < 64; x += 9)
+			{
+				float ndcX = (x + 0.5f) / 32.0f - 1.0f;
+				float ndcY = (y + 0.5f) / 32.0f - 1.0f;
+				bool covered = (ndcX + ndcY) < (extent - 1.0f);
+
+				unsigned char color[4] = { 0 };
+				glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+				EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+				EXPECT_NEAR(covered ? (ndcX * 0.5f + 0.5f) * 255 : 0, color[0], 1);
+				EXPECT_EQ(covered ? 255 : 0, color[3]);
+			}
+		}
+	}
+
+	// A scissor rectangle larger than the viewport doesn't let the triangle escape the viewport
+	glViewport(16, 8, 32, 40);
+	glScissor(0, 0, 64, 64);
+	glEnable(GL_SCISSOR_TEST);
+
+	{
+		const float vertices[12] = { -1.0f, -1.0f, 0.0f, 1.0f,
+		                             3.0f, -1.0f, 0.0f, 1.0f,
+		                             -1.0f, 3.0f, 0.0f, 1.0f };
+		glVertexAttribPointer(positionLocation, 4, GL_FLOAT, GL_FALSE, 0, vertices);
+
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		std::vector<unsigned char> pixels(64 * 64 * 4);
+		glReadPixels(0, 0, 64, 64, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+		for(int y = 0; y < 64; y++)
+		{
+			for(int x = 0; x < 64; x++)
+			{
+				bool inside = (x >= 16) && (x < 48) && (y >= 8) && (y < 48);
+				EXPECT_EQ(inside ? 255 : 0, pixels[(y * 64 + x) * 4 + 3]);
+			}
+		}
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+	glDisableVertexAttribArray(positionLocation);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	Uninitialize();
+}
+
+// Measure the setup cost of triangles which extend past every side of the viewport but stay within
+// the guard band. The scissor rectangle is a single pixel, so that little time is spent on shading.
+// Disabled by default; run with --gtest_also_run_disabled_tests.
+TEST_F(SwiftShaderTest, DISABLED_GuardBandClippingPerformance)
+{
+	Initialize(3, false);
+
+	const ProgramHandles ph = createPassThroughProgram("vec4(1.0)");
+	GLint positionLocation = glGetAttribLocation(ph.program, "position");
+	const FramebufferHandles fb = createColorFramebuffer(256, 256);
+	glScissor(128, 128, 1, 1);
+	glEnable(GL_SCISSOR_TEST);
+
+	const int triangleCount = 200000;
+	std::vector<float> vertices;
+
+	for(int i = 0; i < triangleCount; i++)
+	{
+		float offset = (i % 64) / 256.0f;
+
+		const float triangle[12] = { -1.5f - offset, -1.5f, 0.0f, 1.0f,
+		                             3.5f + offset, -1.5f - offset, 0.0f, 1.0f,
+		                             -1.5f, 3.5f + offset, 0.0f, 1.0f };
+		vertices.insert(vertices.end(), triangle, triangle + 12);
+	}
+
+	glVertexAttribPointer(positionLocation, 4, GL_FLOAT, GL_FALSE, 0, vertices.data());
+	glEnableVertexAttribArray(positionLocation);
+
+	double milliseconds = bestDrawTime(5, [&]() { glDrawArrays(GL_TRIANGLES, 0, 3 * triangleCount); });
+	printf("%d triangles: best of 5 draws %.1f ns per triangle\n", triangleCount, milliseconds * 1.0e6 / triangleCount);
+
+	unsigned char color[4] = { 0 };
+	glReadPixels(128, 128, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+	EXPECT_EQ(255, color[0]);
+
+	glDisable(GL_SCISSOR_TEST);
+	glDisableVertexAttribArray(positionLocation);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	Uninitialize();
+}
+
+// Test that a mesh of small triangles with shared vertices covers each pixel exactly once
+TEST_F(SwiftShaderTest, SmallTriangleCoverage)
+{
+	Initialize(3, false);
+
+	const ProgramHandles ph = createPassThroughProgram("vec4(1.0 / 255.0)");
+	GLint positionLocation = glGetAttribLocation(ph.program, "position");
+	const FramebufferHandles fb = createColorFramebuffer(64, 64);
+
+	// Grid cells of two pixels, with the inner vertices moved by up to a fifth of a cell,
+	// and some of them exactly onto pixel centers
+	const int cells = 32;
+	std::vector<float> grid;
+
+	for(int j = 0; j <= cells; j++)
+	{
+		for(int i = 0; i <= cells; i++)
+		{
+			float x = (float)i / cells;
+			float y = (float)j / cells;
+
+			if(i > 0 && i < cells && j > 0 && j < cells)
+			{
+				if((i + j) % 3 == 0)
+				{
+					x = (floor(x * 64) + 0.5f) / 64;
+					y = (floor(y * 64) + 0.5f) / 64;
+				}
+				else
+				{
+					x += (float)((i * 7 + j * 13) % 17 - 8) / (40 * cells);
+					y += (float)((i * 11 + j * 5) % 17 - 8) / (40 * cells);
+				}
+			}
+
+			grid.push_back(x * 2 - 1);
+			grid.push_back(y * 2 - 1);
+		}
+	}
+
+	std::vector<unsigned short> indices;
+
+	for(int j = 0; j < cells; j++)
+	{
+		for(int i = 0; i < cells; i++)
+		{
+			unsigned short v00 = j * (cells + 1) + i;
+			unsigned short v10 = v00 + 1;
+			unsigned short v01 = v00 + cells + 1;
+			unsigned short v11 = v01 + 1;
+
+			if((i + j) % 2 == 0)
+			{
+				indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+			}
+			else
+			{
+				indices.insert(indices.end(), { v00, v10, v01, v10, v11, v01 });
+			}
+		}
+	}
+
+	glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, 0, grid.data());
+	glEnableVertexAttribArray(positionLocation);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_SHORT, indices.data());
+	glDisable(GL_BLEND);
+
+	std::vector<unsigned char> pixels(64 * 64 * 4);
+	glReadPixels(0, 0, 64, 64, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	for(int i = 0; i < 64 * 64; i++)
+	{
+		EXPECT_EQ(1, pixels[4 * i + 3]);
+	}
+
+	glDisableVertexAttribArray(positionLocation);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	Uninitialize();
+}
+
+// Test that the culling of triangle batches ahead of setup keeps exactly the triangles which setup
+// rasterizes. Each triangle is drawn at every position of batches of up to 8 triangles, so that it
+// is culled both four at a time and by the scalar loop which handles the remainder.
+TEST_F(SwiftShaderTest, TriangleCullingPrepass)
+{
+	Initialize(3, false);
+
+	const ProgramHandles ph = createPassThroughProgram("vec4(1.0 / 255.0)");
+	GLint positionLocation = glGetAttribLocation(ph.program, "position");
+	const FramebufferHandles fb = createColorFramebuffer(16, 16);
+
+	struct Case
+	{
+		const char *name;
+		float vertices[6];   // In pixels, counterclockwise unless the name says otherwise
+		GLenum cullFace;     // GL_NONE disables culling
+		bool scissor;        // Restricts rendering to the upper right quarter
+		int fragments;
+	};
+
+	const Case cases[] =
+	{
+		{ "unculled",                  { 0.0f, 0.0f, 8.25f, 0.0f, 0.0f, 8.25f }, GL_NONE, false, 36 },
+		{ "unculled clockwise",        { 0.0f, 0.0f, 0.0f, 8.25f, 8.25f, 0.0f }, GL_NONE, false, 36 },
+		{ "front facing",              { 0.0f, 0.0f, 8.25f, 0.0f, 0.0f, 8.25f }, GL_BACK, false, 36 },
+		{ "back facing",               { 0.0f, 0.0f, 0.0f, 8.25f, 8.25f, 0.0f }, GL_BACK, false, 0 },
+		{ "front culled",              { 0.0f, 0.0f, 8.25f, 0.0f, 0.0f, 8.25f }, GL_FRONT, false, 0 },
+		{ "clockwise back culled",     { 0.0f, 0.0f, 0.0f, 8.25f, 8.25f, 0.0f }, GL_FRONT, false, 36 },
+		{ "zero area",                 { 1.0f, 1.0f, 8.0f, 8.0f, 15.0f, 15.0f }, GL_NONE, false, 0 },
+		{ "sub-pixel on center",       { 3.3f, 3.3f, 3.8f, 3.4f, 3.4f, 3.8f }, GL_NONE, false, 1 },
+		{ "sub-pixel between centers", { 3.6f, 3.6f, 3.9f, 3.6f, 3.6f, 3.9f }, GL_NONE, false, 0 },
+		{ "outside scissor",           { 0.0f, 0.0f, 7.75f, 0.0f, 0.0f, 7.75f }, GL_NONE, true, 0 },
+		{ "scissor corner",            { 7.75f, 7.75f, 9.5f, 7.75f, 7.75f, 9.5f }, GL_NONE, true, 1 },
+		{ "across scissor",            { 4.0f, 4.0f, 15.75f, 4.0f, 4.0f, 15.75f }, GL_NONE, true, 6 },
+	};
+
+	glScissor(8, 8, 8, 8);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glEnableVertexAttribArray(positionLocation);
+
+	for(const Case &test : cases)
+	{
+		if(test.cullFace != GL_NONE)
+		{
+			glEnable(GL_CULL_FACE);
+			glCullFace(test.cullFace);
+		}
+
+		for(int position = 0; position < 8; position++)
+		{
+			// Batches ending with the triangle, and batches of 8, which have no remainder
+			for(int count : { position + 1, 8 })
+			{
+				// The other triangles have zero area, and are culled
+				std::vector<float> vertices(count * 6, 0.0f);
+				for(int i = 0; i < 6; i++)
+				{
+					vertices[position * 6 + i] = test.vertices[i] / 8.0f - 1.0f;
+				}
+
+				glDisable(GL_SCISSOR_TEST);
+				glClear(GL_COLOR_BUFFER_BIT);
+				if(test.scissor) glEnable(GL_SCISSOR_TEST);
+
+				glEnable(GL_BLEND);
+				glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, 0, vertices.data());
+				glDrawArrays(GL_TRIANGLES, 0, count * 3);
+				glDisable(GL_BLEND);
+
+				unsigned char pixels[16 * 16 * 4];
+				glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+				EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+				int fragments = 0;
+				for(int i = 0; i < 16 * 16; i++)
+				{
+					fragments += pixels[4 * i + 3];
+				}
+
+				EXPECT_EQ(test.fragments, fragments) << test.name << ", triangle " << position << " of " << count;
+			}
+		}
+
+		glDisable(GL_CULL_FACE);
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+	glDisableVertexAttribArray(positionLocation);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	Uninitialize();
+}
+
+// Measure the draw time of an indexed, tessellated sphere of 1M triangles with back-face culling.
+// Most triangles cover a pixel center or none, so setup and culling dominate. The checksum of the
+// image shows whether optimizations changed the rasterization.
+// Disabled by default; run with --gtest_also_run_disabled_tests.
+TEST_F(SwiftShaderTest, DISABLED_TessellatedSpherePerformance)
+{
+	Initialize(3, false);
+
+	const ProgramHandles ph = createPassThroughProgram("vPosition");
+	GLint positionLocation = glGetAttribLocation(ph.program, "position");
+
+	const int size = 1024;
+	const FramebufferHandles fb = createColorFramebuffer(size, size);
+
+	// An ellipsoid of 1000 rings and 500 slices
+	const int slices = 500;
+	const int rings = 1000;
+	const float pi = 3.14159265f;
+	std::vector<float> vertices;
+
+	for(int ring = 0; ring <= rings; ring++)
+	{
+		for(int slice = 0; slice <= slices; slice++)
+		{
+			float theta = pi * ring / rings;
+			float phi = 2 * pi * slice / slices;
+
+			vertices.push_back(0.9f * sinf(theta) * cosf(phi));
+			vertices.push_back(0.9f * cosf(theta));
+			vertices.push_back(0.5f * sinf(theta) * sinf(phi));
+			vertices.push_back(1.0f);
+		}
+	}
+
+	std::vector<unsigned int> indices;
+
+	for(int ring = 0; ring < rings; ring++)
+	{
+		for(int slice = 0; slice < slices; slice++)
+		{
+			unsigned int i0 = ring * (slices + 1) + slice;
+			unsigned int i1 = i0 + slices + 1;
+
+			const unsigned int quad[6] = { i0, i0 + 1, i1, i0 + 1, i1 + 1, i1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	const int triangleCount = static_cast<int>(indices.size() / 3);
+
+	glVertexAttribPointer(positionLocation, 4, GL_FLOAT, GL_FALSE, 0, vertices.data());
+	glEnableVertexAttribArray(positionLocation);
+	glEnable(GL_CULL_FACE);
+
+	double best = bestDrawTime(9, [&]() { glDrawElements(GL_TRIANGLES, 3 * triangleCount, GL_UNSIGNED_INT, indices.data()); },
+	                           []() { glClear(GL_COLOR_BUFFER_BIT); });
+
+	std::vector<unsigned char> pixels(size * size * 4);
+	glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	unsigned int checksum = 0;
+	for(unsigned char value : pixels)
+	{
+		checksum = checksum * 31 + value;
+	}
+
+	printf("%d triangles: best of 9 draws %.1f ms, image checksum %08X\n", triangleCount, best, checksum);
+
+	glDisable(GL_CULL_FACE);
+	glDisableVertexAttribArray(positionLocation);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	Uninitialize();
+}
+
+// Test that occlusion query results become available, and can be waited for, both when
+// samples pass and when none do
+TEST_F(SwiftShaderTest, OcclusionQueryResult)
+{
+	Initialize(3, false);
+
+	const std::string vs =
+		"attribute vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"precision mediump float;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0);\n"
+		"}\n";
+
+	const ProgramHandles ph = createProgram(vs, fs);
+
+	const FramebufferHandles fb = createColorDepthFramebuffer(64, 64);
+	glEnable(GL_DEPTH_TEST);
+
+	GLuint query = 0;
+	glGenQueries(1, &query);
+
+	for(int i = 0; i < 3; i++)
+	{
+		// The depth buffer gets cleared to the near plane on odd iterations, which occludes the quads
+		glClearDepthf((i % 2) ? 0.0f : 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+		drawQuad(ph.program);
+		drawQuad(ph.program);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+		GLuint result = GL_TRUE;
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT, &result);
+		EXPECT_EQ((i % 2) ? GLuint(GL_FALSE) : GLuint(GL_TRUE), result);
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		EXPECT_EQ(GLuint(GL_TRUE), available);
+	}
+
+	glDeleteQueries(1, &query);
+	glDisable(GL_DEPTH_TEST);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	Uninitialize();
+}
+
+// Test that draws and clears are discarded when no samples passed for the condition's query
+
+TEST_F(SwiftShaderTest, ConditionalRender)
+{
+	Initialize(3, false);
+
+	auto glBeginConditionalRenderNV = (PFNGLBEGINCONDITIONALRENDERNVPROC)eglGetProcAddress("glBeginConditionalRenderNV");
+	auto glEndConditionalRenderNV = (PFNGLENDCONDITIONALRENDERNVPROC)eglGetProcAddress("glEndConditionalRenderNV");
+	ASSERT_NE(nullptr, glBeginConditionalRenderNV);
+	ASSERT_NE(nullptr, glEndConditionalRenderNV);
+
+	const std::string vs =
+		"attribute vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_Position = vec4(position.xy, 0.0, 1.0);\n"
+		"}\n";
+
+	const std::string fs =
+		"precision mediump float;\n"
+		"void main()\n"
+		"{\n"
+		"    gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0);\n"
+		"}\n";
+
+	const ProgramHandles ph = createProgram(vs, fs);
+
+	const FramebufferHandles fb = createColorDepthFramebuffer(64, 64);
+
+	// The first query's quad is occluded by a depth buffer cleared to the near plane
+	GLuint queries[3] = { 0, 0, 0 };
+	glGenQueries(3, queries);
+	glEnable(GL_DEPTH_TEST);
+
+	for(int i = 0; i < 2; i++)
+	{
+		glClearDepthf((i == 0) ? 0.0f : 1.0f);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, queries[i]);
+		drawQuad(ph.program);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+	}
+
+	glDisable(GL_DEPTH_TEST);
+	glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	const unsigned char red[4] = { 255, 0, 0, 255 };
+	const unsigned char green[4] = { 0, 255, 0, 255 };
+
+	glBeginConditionalRenderNV(queries[0], GL_QUERY_WAIT_NV);
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+	drawQuad(ph.program);
+	glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glEndConditionalRenderNV();
+	expectFramebufferColor(red);
+
+	glBeginConditionalRenderNV(queries[1], GL_QUERY_BY_REGION_WAIT_NV);
+	drawQuad(ph.program);
+	glEndConditionalRenderNV();
+	expectFramebufferColor(green);
+
+	// Invalid use
+	glEndConditionalRenderNV();
+	EXPECT_GLENUM_EQ(GL_INVALID_OPERATION, glGetError());
+	glBeginConditionalRenderNV(queries[0], GL_NONE);
+	EXPECT_GLENUM_EQ(GL_INVALID_ENUM, glGetError());
+	glBeginConditionalRenderNV(queries[2], GL_QUERY_WAIT_NV);
+	EXPECT_GLENUM_EQ(GL_INVALID_VALUE, glGetError());
+
+	glBeginConditionalRenderNV(queries[0], GL_QUERY_NO_WAIT_NV);
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+	glBeginConditionalRenderNV(queries[1], GL_QUERY_NO_WAIT_NV);
+	EXPECT_GLENUM_EQ(GL_INVALID_OPERATION, glGetError());
+	glBeginQuery(GL_ANY_SAMPLES_PASSED, queries[0]);
+	EXPECT_GLENUM_EQ(GL_INVALID_OPERATION, glGetError());
+	glEndConditionalRenderNV();
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	glBeginQuery(GL_ANY_SAMPLES_PASSED, queries[2]);
+	glBeginConditionalRenderNV(queries[2], GL_QUERY_WAIT_NV);
+	EXPECT_GLENUM_EQ(GL_INVALID_OPERATION, glGetError());
+	glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+	glDeleteQueries(3, queries);
+	deleteFramebuffer(fb);
+	deleteProgram(ph);
+
+	EXPECT_GLENUM_EQ(GL_NONE, glGetError());
+
+	Uninitialize();
+}
+
 // Test using TexImage2D to define a rectangle texture
 
 TEST_F(SwiftShaderTest, TextureRectangle_TexImage2D)
@@ -21,7 +21,11 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vk_icd.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <vector>
 
 typedef PFN_vkVoidFunction(__stdcall *vk_icdGetInstanceProcAddrPtr)(VkInstance, const char*);
 
@@ -55,7 +59,65 @@ protected:
 		#endif
 	}
 
+	// Creates an instance and a device with one queue of the first family
+	void createDevice()
+	{
+		const VkInstanceCreateInfo createInfo =
+		{
+			VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO, // sType
+			nullptr, // pNext
+			0,       // flags
+			nullptr, // pApplicationInfo
+			0,       // enabledLayerCount
+			nullptr, // ppEnabledLayerNames
+			0,       // enabledExtensionCount
+			nullptr, // ppEnabledExtensionNames
+		};
+		VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		uint32_t pPhysicalDeviceCount = 1;
+		result = vkEnumeratePhysicalDevices(instance, &pPhysicalDeviceCount, &physicalDevice);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		const float queuePriority = 1.0f;
+		const VkDeviceQueueCreateInfo queueCreateInfo =
+		{
+			VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, // sType
+			nullptr,        // pNext
+			0,              // flags
+			0,              // queueFamilyIndex
+			1,              // queueCount
+			&queuePriority, // pQueuePriorities
+		};
+		const VkDeviceCreateInfo deviceCreateInfo =
+		{
+			VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, // sType
+			nullptr,          // pNext
+			0,                // flags
+			1,                // queueCreateInfoCount
+			&queueCreateInfo, // pQueueCreateInfos
+			0,                // enabledLayerCount
+			nullptr,          // ppEnabledLayerNames
+			0,                // enabledExtensionCount
+			nullptr,          // ppEnabledExtensionNames
+			nullptr,          // pEnabledFeatures
+		};
+		result = vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	void destroyDevice()
+	{
+		vkDestroyDevice(device, nullptr);
+		vkDestroyInstance(instance, nullptr);
+	}
+
 	vk_icdGetInstanceProcAddrPtr vk_icdGetInstanceProcAddr = nullptr;
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
 };
 
 TEST_F(SwiftShaderVulkanTest, API_Check)
@@ -311,3 +373,1362 @@ TEST_F(SwiftShaderVulkanTest, Version)
 
 	EXPECT_EQ(strncmp(physicalDeviceProperties.deviceName, "SwiftShader Device", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE), 0);
 }
+
+TEST_F(SwiftShaderVulkanTest, PipelineCacheData)
+{
+	createDevice();
+
+	VkPhysicalDeviceProperties physicalDeviceProperties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // initialDataSize
+		nullptr, // pInitialData
+	};
+	VkPipelineCache pipelineCache;
+	VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	size_t emptyDataSize = 0;
+	result = vkGetPipelineCacheData(device, pipelineCache, &emptyDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_GE(emptyDataSize, 16 + VK_UUID_SIZE);
+
+	// A compute shader with a specialization constant:
+	//   OpCapability Shader
+	//   OpMemoryModel Logical GLSL450
+	//   OpEntryPoint GLCompute %1 "main"
+	//   OpExecutionMode %1 LocalSize 1 1 1
+	//   OpDecorate %5 SpecId 0
+	//   %2 = OpTypeVoid
+	//   %3 = OpTypeFunction %2
+	//   %6 = OpTypeInt 32 0
+	//   %5 = OpSpecConstant %6 1
+	//   %1 = OpFunction %2 None %3
+	//   %4 = OpLabel
+	//   OpReturn
+	//   OpFunctionEnd
+	const uint32_t code[] =
+	{
+		0x07230203, 0x00010000, 0, 7, 0,
+		0x00020011, 1,
+		0x0003000E, 0, 1,
+		0x0005000F, 5, 1, 0x6E69616D, 0,
+		0x00060010, 1, 17, 1, 1, 1,
+		0x00040047, 5, 1, 0,
+		0x00020013, 2,
+		0x00030021, 3, 2,
+		0x00040015, 6, 32, 0,
+		0x00040032, 6, 5, 1,
+		0x00050036, 2, 1, 0, 3,
+		0x000200F8, 4,
+		0x000100FD,
+		0x00010038,
+	};
+
+	const VkShaderModuleCreateInfo shaderModuleCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, // sType
+		nullptr,      // pNext
+		0,            // flags
+		sizeof(code), // codeSize
+		code,         // pCode
+	};
+	VkShaderModule shaderModule;
+	result = vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModule);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // setLayoutCount
+		nullptr, // pSetLayouts
+		0,       // pushConstantRangeCount
+		nullptr, // pPushConstantRanges
+	};
+	VkPipelineLayout pipelineLayout;
+	result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	uint32_t specializationData = 42;
+	const VkSpecializationMapEntry specializationMapEntry = { 0, 0, sizeof(uint32_t) };
+	const VkSpecializationInfo specializationInfo =
+	{
+		1,                           // mapEntryCount
+		&specializationMapEntry,     // pMapEntries
+		sizeof(specializationData),  // dataSize
+		&specializationData,         // pData
+	};
+	const VkComputePipelineCreateInfo computePipelineCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, // sType
+			nullptr,                     // pNext
+			0,                           // flags
+			VK_SHADER_STAGE_COMPUTE_BIT, // stage
+			shaderModule,                // module
+			"main",                      // pName
+			&specializationInfo,         // pSpecializationInfo
+		},
+		pipelineLayout,  // layout
+		VK_NULL_HANDLE,  // basePipelineHandle
+		-1,              // basePipelineIndex
+	};
+
+	// Creating a pipeline adds its specialized shader to the cache
+	VkPipeline pipeline;
+	result = vkCreateComputePipelines(device, pipelineCache, 1, &computePipelineCreateInfo, nullptr, &pipeline);
+	EXPECT_EQ(result, VK_SUCCESS);
+	vkDestroyPipeline(device, pipeline, nullptr);
+
+	size_t dataSize = 0;
+	result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_GT(dataSize, emptyDataSize + sizeof(code));
+
+	uint8_t data[1024] = {};
+	ASSERT_LE(dataSize, sizeof(data));
+	result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, data);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	// Version one header: headerSize, headerVersion, vendorID, deviceID, pipelineCacheUUID
+	uint32_t header[4];
+	memcpy(header, data, sizeof(header));
+	EXPECT_EQ(header[0], 16 + VK_UUID_SIZE);
+	EXPECT_EQ(header[1], VK_PIPELINE_CACHE_HEADER_VERSION_ONE);
+	EXPECT_EQ(header[2], physicalDeviceProperties.vendorID);
+	EXPECT_EQ(header[3], physicalDeviceProperties.deviceID);
+	EXPECT_EQ(memcmp(data + 16, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE), 0);
+
+	// The entry's key holds the module as it was created, and its data the code with the specialization
+	// constant replaced by an OpConstant of value 42
+	const uint32_t specializedConstant[] = { 0x0004002B, 6, 5, 42 };
+	const uint32_t specConstant[] = { 0x00040032, 6, 5, 1 };
+	const uint8_t* dataBegin = data;
+	const uint8_t* dataEnd = data + dataSize;
+	const uint8_t* keyConstant = std::search(dataBegin, dataEnd, reinterpret_cast<const uint8_t*>(specConstant), reinterpret_cast<const uint8_t*>(specConstant + 4));
+	const uint8_t* codeConstant = std::search(dataBegin, dataEnd, reinterpret_cast<const uint8_t*>(specializedConstant), reinterpret_cast<const uint8_t*>(specializedConstant + 4));
+	EXPECT_LT(keyConstant, codeConstant);
+	EXPECT_NE(codeConstant, dataEnd);
+	EXPECT_EQ(std::search(codeConstant, dataEnd, reinterpret_cast<const uint8_t*>(specConstant), reinterpret_cast<const uint8_t*>(specConstant + 4)), dataEnd);
+
+	// Data too small for the header yields nothing
+	size_t smallDataSize = 8;
+	result = vkGetPipelineCacheData(device, pipelineCache, &smallDataSize, data);
+	EXPECT_EQ(result, VK_INCOMPLETE);
+	EXPECT_EQ(smallDataSize, 0);
+
+	// Data too small for the entry yields only the header
+	size_t headerDataSize = emptyDataSize;
+	result = vkGetPipelineCacheData(device, pipelineCache, &headerDataSize, data);
+	EXPECT_EQ(result, VK_INCOMPLETE);
+	EXPECT_EQ(headerDataSize, emptyDataSize);
+
+	// The data can be used to initialize another cache, which returns the same entries
+	result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, data);
+	EXPECT_EQ(result, VK_SUCCESS);
+	pipelineCacheCreateInfo.initialDataSize = dataSize;
+	pipelineCacheCreateInfo.pInitialData = data;
+	VkPipelineCache loadedPipelineCache;
+	result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &loadedPipelineCache);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	uint8_t loadedData[1024] = {};
+	size_t loadedDataSize = sizeof(loadedData);
+	result = vkGetPipelineCacheData(device, loadedPipelineCache, &loadedDataSize, loadedData);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(loadedDataSize, dataSize);
+	EXPECT_EQ(memcmp(loadedData, data, dataSize), 0);
+
+	// Pipelines created with the loaded cache find their shader in it, while other specializations get added
+	result = vkCreateComputePipelines(device, loadedPipelineCache, 1, &computePipelineCreateInfo, nullptr, &pipeline);
+	EXPECT_EQ(result, VK_SUCCESS);
+	vkDestroyPipeline(device, pipeline, nullptr);
+
+	result = vkGetPipelineCacheData(device, loadedPipelineCache, &loadedDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(loadedDataSize, dataSize);
+
+	specializationData = 7;
+	result = vkCreateComputePipelines(device, loadedPipelineCache, 1, &computePipelineCreateInfo, nullptr, &pipeline);
+	EXPECT_EQ(result, VK_SUCCESS);
+	vkDestroyPipeline(device, pipeline, nullptr);
+
+	result = vkGetPipelineCacheData(device, loadedPipelineCache, &loadedDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(loadedDataSize, dataSize + (dataSize - emptyDataSize));
+
+	// Merging adds the new entry, while the identical one is kept once
+	result = vkMergePipelineCaches(device, pipelineCache, 1, &loadedPipelineCache);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	size_t mergedDataSize = 0;
+	result = vkGetPipelineCacheData(device, pipelineCache, &mergedDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(mergedDataSize, loadedDataSize);
+
+	// An entry whose stored key doesn't match is not used, even though its hash does. Each entry
+	// starts with its key, so the first "main" is in the key's copy of the module, not in the code.
+	uint8_t tamperedData[1024] = {};
+	memcpy(tamperedData, data, dataSize);
+	uint8_t* tamperedEnd = tamperedData + dataSize;
+	const char entryPointName[] = "main";
+	uint8_t* keyName = std::search(tamperedData, tamperedEnd, entryPointName, entryPointName + 4);
+	ASSERT_NE(keyName, tamperedEnd);
+	keyName[0] = 'M';
+
+	const uint32_t tamperedConstant[] = { 0x0004002B, 6, 5, 99 };
+	uint8_t* constant = std::search(tamperedData, tamperedEnd, reinterpret_cast<const uint8_t*>(specializedConstant), reinterpret_cast<const uint8_t*>(specializedConstant + 4));
+	ASSERT_NE(constant, tamperedEnd);
+	memcpy(constant, tamperedConstant, sizeof(tamperedConstant));
+
+	pipelineCacheCreateInfo.initialDataSize = dataSize;
+	pipelineCacheCreateInfo.pInitialData = tamperedData;
+	VkPipelineCache tamperedPipelineCache;
+	result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &tamperedPipelineCache);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	specializationData = 42;
+	result = vkCreateComputePipelines(device, tamperedPipelineCache, 1, &computePipelineCreateInfo, nullptr, &pipeline);
+	EXPECT_EQ(result, VK_SUCCESS);
+	vkDestroyPipeline(device, pipeline, nullptr);
+
+	// The stage got specialized again, replacing the mismatched entry
+	size_t tamperedDataSize = sizeof(tamperedData);
+	result = vkGetPipelineCacheData(device, tamperedPipelineCache, &tamperedDataSize, tamperedData);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(tamperedDataSize, dataSize);
+	EXPECT_EQ(memcmp(tamperedData, data, dataSize), 0);
+
+	// Truncated data loads none of the incomplete entries
+	pipelineCacheCreateInfo.initialDataSize = emptyDataSize + (dataSize - emptyDataSize) / 2;
+	pipelineCacheCreateInfo.pInitialData = data;
+	VkPipelineCache truncatedPipelineCache;
+	result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &truncatedPipelineCache);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	size_t truncatedDataSize = 0;
+	result = vkGetPipelineCacheData(device, truncatedPipelineCache, &truncatedDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(truncatedDataSize, emptyDataSize);
+
+	// Neither does an entry whose data size would wrap around when added to its key size. The
+	// entry's hash, key size and data size follow the header.
+	uint8_t oversizedData[1024] = {};
+	memcpy(oversizedData, data, dataSize);
+	const uint64_t oversizedDataSize = ~uint64_t(0) - 7;
+	memcpy(oversizedData + emptyDataSize + 2 * sizeof(uint64_t), &oversizedDataSize, sizeof(oversizedDataSize));
+
+	pipelineCacheCreateInfo.initialDataSize = dataSize;
+	pipelineCacheCreateInfo.pInitialData = oversizedData;
+	VkPipelineCache oversizedPipelineCache;
+	result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &oversizedPipelineCache);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	size_t oversizedCacheDataSize = 0;
+	result = vkGetPipelineCacheData(device, oversizedPipelineCache, &oversizedCacheDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(oversizedCacheDataSize, emptyDataSize);
+
+	vkDestroyPipelineCache(device, oversizedPipelineCache, nullptr);
+	vkDestroyPipelineCache(device, truncatedPipelineCache, nullptr);
+	vkDestroyPipelineCache(device, tamperedPipelineCache, nullptr);
+	vkDestroyPipelineCache(device, loadedPipelineCache, nullptr);
+	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyShaderModule(device, shaderModule, nullptr);
+	destroyDevice();
+}
+
+TEST_F(SwiftShaderVulkanTest, ComputePipelineBatch)
+{
+	createDevice();
+
+	// Two compute shaders, which only differ in their workgroup size:
+	//   OpCapability Shader
+	//   OpMemoryModel Logical GLSL450
+	//   OpEntryPoint GLCompute %1 "main"
+	//   OpExecutionMode %1 LocalSize N 1 1
+	//   %2 = OpTypeVoid
+	//   %3 = OpTypeFunction %2
+	//   %1 = OpFunction %2 None %3
+	//   %4 = OpLabel
+	//   OpReturn
+	//   OpFunctionEnd
+	uint32_t code[] =
+	{
+		0x07230203, 0x00010000, 0, 5, 0,
+		0x00020011, 1,
+		0x0003000E, 0, 1,
+		0x0005000F, 5, 1, 0x6E69616D, 0,
+		0x00060010, 1, 17, 1, 1, 1,
+		0x00020013, 2,
+		0x00030021, 3, 2,
+		0x00050036, 2, 1, 0, 3,
+		0x000200F8, 4,
+		0x000100FD,
+		0x00010038,
+	};
+
+	VkShaderModuleCreateInfo shaderModuleCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, // sType
+		nullptr,      // pNext
+		0,            // flags
+		sizeof(code), // codeSize
+		code,         // pCode
+	};
+	VkShaderModule shaderModules[2];
+	VkResult result = vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModules[0]);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	code[18] = 64;   // LocalSize x
+	result = vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModules[1]);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // setLayoutCount
+		nullptr, // pSetLayouts
+		0,       // pushConstantRangeCount
+		nullptr, // pPushConstantRanges
+	};
+	VkPipelineLayout pipelineLayout;
+	result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkPipelineCacheCreateInfo pipelineCacheCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // initialDataSize
+		nullptr, // pInitialData
+	};
+	VkPipelineCache pipelineCache;
+	result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	size_t emptyDataSize = 0;
+	result = vkGetPipelineCacheData(device, pipelineCache, &emptyDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	// A batch using each of the two shaders many times
+	const uint32_t pipelineCount = 32;
+	VkComputePipelineCreateInfo createInfos[pipelineCount];
+	for(uint32_t i = 0; i < pipelineCount; i++)
+	{
+		createInfos[i] =
+		{
+			VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO, // sType
+			nullptr, // pNext
+			0,       // flags
+			{
+				VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, // sType
+				nullptr,                     // pNext
+				0,                           // flags
+				VK_SHADER_STAGE_COMPUTE_BIT, // stage
+				shaderModules[i % 2],        // module
+				"main",                      // pName
+				nullptr,                     // pSpecializationInfo
+			},
+			pipelineLayout,  // layout
+			VK_NULL_HANDLE,  // basePipelineHandle
+			-1,              // basePipelineIndex
+		};
+	}
+
+	VkPipeline pipelines[pipelineCount];
+	result = vkCreateComputePipelines(device, pipelineCache, pipelineCount, createInfos, nullptr, pipelines);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	for(uint32_t i = 0; i < pipelineCount; i++)
+	{
+		EXPECT_NE(pipelines[i], (VkPipeline)VK_NULL_HANDLE);
+		vkDestroyPipeline(device, pipelines[i], nullptr);
+	}
+
+	// Each of the two distinct stages got added to the cache once
+	size_t dataSize = 0;
+	result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_GT(dataSize, emptyDataSize + 2 * sizeof(code));
+
+	// Creating the batch again only finds cached stages
+	result = vkCreateComputePipelines(device, pipelineCache, pipelineCount, createInfos, nullptr, pipelines);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	for(uint32_t i = 0; i < pipelineCount; i++)
+	{
+		vkDestroyPipeline(device, pipelines[i], nullptr);
+	}
+
+	size_t cachedDataSize = 0;
+	result = vkGetPipelineCacheData(device, pipelineCache, &cachedDataSize, nullptr);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(cachedDataSize, dataSize);
+
+	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyShaderModule(device, shaderModules[0], nullptr);
+	vkDestroyShaderModule(device, shaderModules[1], nullptr);
+	destroyDevice();
+}
+
+// Measures creating a batch of compute pipelines whose stages all differ in their specialization,
+// so that each stage gets compiled. The module has many specialization constants, like large
+// shaders with many tunable parameters. Disabled by default; run with --gtest_also_run_disabled_tests.
+TEST_F(SwiftShaderVulkanTest, DISABLED_ComputePipelineBatchPerformance)
+{
+	createDevice();
+
+	//   OpCapability Shader
+	//   OpMemoryModel Logical GLSL450
+	//   OpEntryPoint GLCompute %1 "main"
+	//   OpExecutionMode %1 LocalSize 1 1 1
+	//   OpDecorate %(6 + i) SpecId i            for each constant i
+	//   %2 = OpTypeVoid
+	//   %3 = OpTypeFunction %2
+	//   %5 = OpTypeInt 32 0
+	//   %(6 + i) = OpSpecConstant %5 i          for each constant i
+	//   %1 = OpFunction %2 None %3
+	//   %4 = OpLabel
+	//   OpReturn
+	//   OpFunctionEnd
+	const uint32_t constantCount = 20000;
+	std::vector<uint32_t> code =
+	{
+		0x07230203, 0x00010000, 0, 6 + constantCount, 0,
+		0x00020011, 1,
+		0x0003000E, 0, 1,
+		0x0005000F, 5, 1, 0x6E69616D, 0,
+		0x00060010, 1, 17, 1, 1, 1,
+	};
+
+	for(uint32_t i = 0; i < constantCount; i++)
+	{
+		code.insert(code.end(), { 0x00040047, 6 + i, 1, i });
+	}
+
+	code.insert(code.end(), { 0x00020013, 2, 0x00030021, 3, 2, 0x00040015, 5, 32, 0 });
+
+	for(uint32_t i = 0; i < constantCount; i++)
+	{
+		code.insert(code.end(), { 0x00040032, 5, 6 + i, i });
+	}
+
+	code.insert(code.end(), { 0x00050036, 2, 1, 0, 3, 0x000200F8, 4, 0x000100FD, 0x00010038 });
+
+	const VkShaderModuleCreateInfo shaderModuleCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, // sType
+		nullptr,                        // pNext
+		0,                              // flags
+		code.size() * sizeof(uint32_t), // codeSize
+		code.data(),                    // pCode
+	};
+	VkShaderModule shaderModule;
+	VkResult result = vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModule);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // setLayoutCount
+		nullptr, // pSetLayouts
+		0,       // pushConstantRangeCount
+		nullptr, // pPushConstantRanges
+	};
+	VkPipelineLayout pipelineLayout;
+	result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	// Every pipeline overrides constant 0 with its own value
+	const uint32_t pipelineCount = 64;
+	uint32_t specializationData[pipelineCount];
+	const VkSpecializationMapEntry specializationMapEntry = { 0, 0, sizeof(uint32_t) };
+	VkSpecializationInfo specializationInfos[pipelineCount];
+	VkComputePipelineCreateInfo createInfos[pipelineCount];
+
+	for(uint32_t i = 0; i < pipelineCount; i++)
+	{
+		specializationData[i] = i;
+		specializationInfos[i] =
+		{
+			1,                        // mapEntryCount
+			&specializationMapEntry,  // pMapEntries
+			sizeof(uint32_t),         // dataSize
+			&specializationData[i],   // pData
+		};
+		createInfos[i] =
+		{
+			VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO, // sType
+			nullptr, // pNext
+			0,       // flags
+			{
+				VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, // sType
+				nullptr,                     // pNext
+				0,                           // flags
+				VK_SHADER_STAGE_COMPUTE_BIT, // stage
+				shaderModule,                // module
+				"main",                      // pName
+				&specializationInfos[i],     // pSpecializationInfo
+			},
+			pipelineLayout,  // layout
+			VK_NULL_HANDLE,  // basePipelineHandle
+			-1,              // basePipelineIndex
+		};
+	}
+
+	double best = 1e9;
+	VkPipeline pipelines[pipelineCount];
+
+	for(int repeat = 0; repeat < 5; repeat++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		result = vkCreateComputePipelines(device, VK_NULL_HANDLE, pipelineCount, createInfos, nullptr, pipelines);
+		auto end = std::chrono::steady_clock::now();
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+
+		for(uint32_t i = 0; i < pipelineCount; i++)
+		{
+			vkDestroyPipeline(device, pipelines[i], nullptr);
+		}
+	}
+
+	printf("%u pipelines with distinct stages of %u words: %.2f ms\n", pipelineCount, static_cast<unsigned int>(code.size()), best);
+
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyShaderModule(device, shaderModule, nullptr);
+	destroyDevice();
+}
+
+TEST_F(SwiftShaderVulkanTest, DeviceMemoryAllocations)
+{
+	createDevice();
+
+	// Sizes covering sub-allocated blocks as well as dedicated mappings
+	const VkDeviceSize sizes[] = { 1, 256, 300, 4096, 65536 + 4, 1 << 20, (1 << 20) + 1, 3 << 20 };
+	const uint32_t allocationCount = 3 * (sizeof(sizes) / sizeof(sizes[0]));
+	VkDeviceMemory memory[allocationCount];
+
+	for(int round = 0; round < 2; round++)
+	{
+		for(uint32_t i = 0; i < allocationCount; i++)
+		{
+			// The second round only replaces every other allocation
+			if(round == 1 && (i % 2) == 0)
+			{
+				continue;
+			}
+
+			const VkMemoryAllocateInfo allocateInfo =
+			{
+				VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, // sType
+				nullptr,                             // pNext
+				sizes[i % (allocationCount / 3)],    // allocationSize
+				0,                                   // memoryTypeIndex
+			};
+			VkResult result = vkAllocateMemory(device, &allocateInfo, nullptr, &memory[i]);
+			EXPECT_EQ(result, VK_SUCCESS);
+
+			uint8_t* data = nullptr;
+			result = vkMapMemory(device, memory[i], 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&data));
+			EXPECT_EQ(result, VK_SUCCESS);
+
+			EXPECT_EQ(data[0], 0);
+			EXPECT_EQ(data[allocateInfo.allocationSize - 1], 0);
+
+			memset(data, i + 1, static_cast<size_t>(allocateInfo.allocationSize));
+			vkUnmapMemory(device, memory[i]);
+		}
+
+		// Allocations must not overlap
+		for(uint32_t i = 0; i < allocationCount; i++)
+		{
+			VkDeviceSize size = sizes[i % (allocationCount / 3)];
+
+			uint8_t* data = nullptr;
+			VkResult result = vkMapMemory(device, memory[i], 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&data));
+			EXPECT_EQ(result, VK_SUCCESS);
+
+			EXPECT_EQ(data[0], uint8_t(i + 1));
+			EXPECT_EQ(data[size - 1], uint8_t(i + 1));
+			vkUnmapMemory(device, memory[i]);
+
+			if(round == 0 && (i % 2) == 1)
+			{
+				vkFreeMemory(device, memory[i], nullptr);
+			}
+		}
+	}
+
+	for(uint32_t i = 0; i < allocationCount; i++)
+	{
+		vkFreeMemory(device, memory[i], nullptr);
+	}
+
+	destroyDevice();
+}
+
+TEST_F(SwiftShaderVulkanTest, LazilyAllocatedMemory)
+{
+	createDevice();
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	uint32_t memoryTypeIndex = memoryProperties.memoryTypeCount;
+	for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if(memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+		{
+			memoryTypeIndex = i;
+			break;
+		}
+	}
+	EXPECT_NE(memoryTypeIndex, memoryProperties.memoryTypeCount);
+
+	const VkMemoryAllocateInfo allocateInfo =
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, // sType
+		nullptr,          // pNext
+		64 << 20,         // allocationSize
+		memoryTypeIndex,  // memoryTypeIndex
+	};
+	VkDeviceMemory memory;
+	VkResult result = vkAllocateMemory(device, &allocateInfo, nullptr, &memory);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	// Nothing is committed until the memory is first accessed
+	VkDeviceSize committedMemoryInBytes = ~VkDeviceSize(0);
+	vkGetDeviceMemoryCommitment(device, memory, &committedMemoryInBytes);
+	EXPECT_EQ(committedMemoryInBytes, 0);
+
+	vkFreeMemory(device, memory, nullptr);
+	destroyDevice();
+}
+
+TEST_F(SwiftShaderVulkanTest, SecondaryCommandBuffers)
+{
+	createDevice();
+
+	const VkBufferCreateInfo bufferCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, // sType
+		nullptr,                           // pNext
+		0,                                 // flags
+		4096,                              // size
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, // usage
+		VK_SHARING_MODE_EXCLUSIVE,         // sharingMode
+		0,                                 // queueFamilyIndexCount
+		nullptr,                           // pQueueFamilyIndices
+	};
+	VkBuffer vertexBuffer;
+	VkResult result = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &vertexBuffer);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements(device, vertexBuffer, &memoryRequirements);
+
+	const VkMemoryAllocateInfo memoryAllocateInfo =
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, // sType
+		nullptr,                        // pNext
+		memoryRequirements.size,        // allocationSize
+		0,                              // memoryTypeIndex
+	};
+	VkDeviceMemory memory;
+	result = vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	result = vkBindBufferMemory(device, vertexBuffer, memory, 0);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	// Many small secondary command buffers, each of which signals its own event
+	const uint32_t secondaryCount = 256;
+	VkEvent events[secondaryCount];
+	const VkEventCreateInfo eventCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_EVENT_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+	};
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		result = vkCreateEvent(device, &eventCreateInfo, nullptr, &events[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	const VkCommandPoolCreateInfo commandPoolCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // queueFamilyIndex
+	};
+	VkCommandPool commandPool;
+	result = vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	VkCommandBuffer secondaries[secondaryCount];
+	VkCommandBufferAllocateInfo allocateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, // sType
+		nullptr,                           // pNext
+		commandPool,                       // commandPool
+		VK_COMMAND_BUFFER_LEVEL_SECONDARY, // level
+		secondaryCount,                    // commandBufferCount
+	};
+	result = vkAllocateCommandBuffers(device, &allocateInfo, secondaries);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkCommandBufferInheritanceInfo inheritanceInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO, // sType
+		nullptr,        // pNext
+		VK_NULL_HANDLE, // renderPass
+		0,              // subpass
+		VK_NULL_HANDLE, // framebuffer
+		VK_FALSE,       // occlusionQueryEnable
+		0,              // queryFlags
+		0,              // pipelineStatistics
+	};
+	const VkCommandBufferBeginInfo secondaryBeginInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, // sType
+		nullptr,          // pNext
+		0,                // flags
+		&inheritanceInfo, // pInheritanceInfo
+	};
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		result = vkBeginCommandBuffer(secondaries[i], &secondaryBeginInfo);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		const VkDeviceSize offset = i;
+		vkCmdBindVertexBuffers(secondaries[i], i % 16, 1, &vertexBuffer, &offset);
+		vkCmdSetEvent(secondaries[i], events[i], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		result = vkEndCommandBuffer(secondaries[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	VkCommandBuffer primary;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	result = vkAllocateCommandBuffers(device, &allocateInfo, &primary);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkCommandBufferBeginInfo primaryBeginInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		nullptr, // pInheritanceInfo
+	};
+	result = vkBeginCommandBuffer(primary, &primaryBeginInfo);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	vkCmdExecuteCommands(primary, secondaryCount, secondaries);
+
+	result = vkEndCommandBuffer(primary);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	VkQueue queue;
+	vkGetDeviceQueue(device, 0, 0, &queue);
+
+	const VkSubmitInfo submitInfo =
+	{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+		nullptr,  // pNext
+		0,        // waitSemaphoreCount
+		nullptr,  // pWaitSemaphores
+		nullptr,  // pWaitDstStageMask
+		1,        // commandBufferCount
+		&primary, // pCommandBuffers
+		0,        // signalSemaphoreCount
+		nullptr,  // pSignalSemaphores
+	};
+
+	// Submitting twice executes all of the same secondaries again
+	for(int submit = 0; submit < 2; submit++)
+	{
+		for(uint32_t i = 0; i < secondaryCount; i++)
+		{
+			result = vkResetEvent(device, events[i]);
+			EXPECT_EQ(result, VK_SUCCESS);
+		}
+
+		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		result = vkQueueWaitIdle(queue);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		for(uint32_t i = 0; i < secondaryCount; i++)
+		{
+			EXPECT_EQ(VK_EVENT_SET, vkGetEventStatus(device, events[i])) << "submit " << submit << ", event " << i;
+		}
+	}
+
+	vkDestroyCommandPool(device, commandPool, nullptr);
+
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		vkDestroyEvent(device, events[i], nullptr);
+	}
+
+	vkDestroyBuffer(device, vertexBuffer, nullptr);
+	vkFreeMemory(device, memory, nullptr);
+	destroyDevice();
+}
+
+TEST_F(SwiftShaderVulkanTest, SecondaryCommandBufferOrder)
+{
+	createDevice();
+
+	const uint32_t secondaryCount = 16;
+	VkEvent events[secondaryCount];
+	const VkEventCreateInfo eventCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_EVENT_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+	};
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		VkResult result = vkCreateEvent(device, &eventCreateInfo, nullptr, &events[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	const VkCommandPoolCreateInfo commandPoolCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // queueFamilyIndex
+	};
+	VkCommandPool commandPool;
+	VkResult result = vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	VkCommandBuffer secondaries[secondaryCount];
+	VkCommandBufferAllocateInfo allocateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, // sType
+		nullptr,                           // pNext
+		commandPool,                       // commandPool
+		VK_COMMAND_BUFFER_LEVEL_SECONDARY, // level
+		secondaryCount,                    // commandBufferCount
+	};
+	result = vkAllocateCommandBuffers(device, &allocateInfo, secondaries);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkCommandBufferInheritanceInfo inheritanceInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO, // sType
+		nullptr,        // pNext
+		VK_NULL_HANDLE, // renderPass
+		0,              // subpass
+		VK_NULL_HANDLE, // framebuffer
+		VK_FALSE,       // occlusionQueryEnable
+		0,              // queryFlags
+		0,              // pipelineStatistics
+	};
+	const VkCommandBufferBeginInfo secondaryBeginInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, // sType
+		nullptr,          // pNext
+		0,                // flags
+		&inheritanceInfo, // pInheritanceInfo
+	};
+
+	// Secondary i resets the event set by secondary i - 1, so any two of them executing out of
+	// order leave an event other than the last one set
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		result = vkBeginCommandBuffer(secondaries[i], &secondaryBeginInfo);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		vkCmdSetEvent(secondaries[i], events[i], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		if(i > 0)
+		{
+			vkCmdResetEvent(secondaries[i], events[i - 1], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+
+		result = vkEndCommandBuffer(secondaries[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	VkCommandBuffer primary;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	result = vkAllocateCommandBuffers(device, &allocateInfo, &primary);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkCommandBufferBeginInfo primaryBeginInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		nullptr, // pInheritanceInfo
+	};
+	result = vkBeginCommandBuffer(primary, &primaryBeginInfo);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	// The secondaries must also execute after the primary's preceding commands
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		vkCmdSetEvent(primary, events[i], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	}
+
+	vkCmdExecuteCommands(primary, secondaryCount, secondaries);
+
+	result = vkEndCommandBuffer(primary);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	VkQueue queue;
+	vkGetDeviceQueue(device, 0, 0, &queue);
+
+	const VkSubmitInfo submitInfo =
+	{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+		nullptr,  // pNext
+		0,        // waitSemaphoreCount
+		nullptr,  // pWaitSemaphores
+		nullptr,  // pWaitDstStageMask
+		1,        // commandBufferCount
+		&primary, // pCommandBuffers
+		0,        // signalSemaphoreCount
+		nullptr,  // pSignalSemaphores
+	};
+	result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	result = vkQueueWaitIdle(queue);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		EXPECT_EQ((i == secondaryCount - 1) ? VK_EVENT_SET : VK_EVENT_RESET, vkGetEventStatus(device, events[i])) << "event " << i;
+	}
+
+	vkDestroyCommandPool(device, commandPool, nullptr);
+
+	for(uint32_t i = 0; i < secondaryCount; i++)
+	{
+		vkDestroyEvent(device, events[i], nullptr);
+	}
+
+	destroyDevice();
+}
+
+// Test that submissions signal their fence and semaphores, and that waits on semaphores
+// signaled by earlier submissions complete
+TEST_F(SwiftShaderVulkanTest, QueueSubmission)
+{
+	createDevice();
+
+	const uint32_t commandBufferCount = 4;
+	VkEvent events[commandBufferCount];
+	const VkEventCreateInfo eventCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_EVENT_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+	};
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		VkResult result = vkCreateEvent(device, &eventCreateInfo, nullptr, &events[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	VkSemaphore semaphores[2];
+	const VkSemaphoreCreateInfo semaphoreCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+	};
+	for(VkSemaphore& semaphore : semaphores)
+	{
+		VkResult result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	VkFence fence;
+	const VkFenceCreateInfo fenceCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+	};
+	VkResult result = vkCreateFence(device, &fenceCreateInfo, nullptr, &fence);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(VK_NOT_READY, vkGetFenceStatus(device, fence));
+
+	const VkCommandPoolCreateInfo commandPoolCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		0,       // queueFamilyIndex
+	};
+	VkCommandPool commandPool;
+	result = vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	VkCommandBuffer commandBuffers[commandBufferCount];
+	const VkCommandBufferAllocateInfo allocateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, // sType
+		nullptr,                         // pNext
+		commandPool,                     // commandPool
+		VK_COMMAND_BUFFER_LEVEL_PRIMARY, // level
+		commandBufferCount,              // commandBufferCount
+	};
+	result = vkAllocateCommandBuffers(device, &allocateInfo, commandBuffers);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkCommandBufferBeginInfo beginInfo =
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		nullptr, // pInheritanceInfo
+	};
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		result = vkBeginCommandBuffer(commandBuffers[i], &beginInfo);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		vkCmdSetEvent(commandBuffers[i], events[i], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		result = vkEndCommandBuffer(commandBuffers[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	VkQueue queue;
+	vkGetDeviceQueue(device, 0, 0, &queue);
+
+	// The first call chains two submissions through a semaphore, and signals the second one,
+	// which the next call waits on. The arrays of each submission are copied when it's queued,
+	// so vary their lengths to check that each copy is correctly placed.
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	const VkSubmitInfo submitInfos[] =
+	{
+		{
+			VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+			nullptr,            // pNext
+			0,                  // waitSemaphoreCount
+			nullptr,            // pWaitSemaphores
+			nullptr,            // pWaitDstStageMask
+			1,                  // commandBufferCount
+			&commandBuffers[0], // pCommandBuffers
+			1,                  // signalSemaphoreCount
+			&semaphores[0],     // pSignalSemaphores
+		},
+		{
+			VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+			nullptr,            // pNext
+			1,                  // waitSemaphoreCount
+			&semaphores[0],     // pWaitSemaphores
+			&waitStage,         // pWaitDstStageMask
+			2,                  // commandBufferCount
+			&commandBuffers[1], // pCommandBuffers
+			1,                  // signalSemaphoreCount
+			&semaphores[1],     // pSignalSemaphores
+		},
+		{
+			VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+			nullptr,            // pNext
+			1,                  // waitSemaphoreCount
+			&semaphores[1],     // pWaitSemaphores
+			&waitStage,         // pWaitDstStageMask
+			1,                  // commandBufferCount
+			&commandBuffers[3], // pCommandBuffers
+			0,                  // signalSemaphoreCount
+			nullptr,            // pSignalSemaphores
+		},
+	};
+	result = vkQueueSubmit(queue, 2, &submitInfos[0], VK_NULL_HANDLE);
+	EXPECT_EQ(result, VK_SUCCESS);
+	result = vkQueueSubmit(queue, 1, &submitInfos[2], fence);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	result = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(VK_SUCCESS, vkGetFenceStatus(device, fence));
+
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		EXPECT_EQ(VK_EVENT_SET, vkGetEventStatus(device, events[i])) << "event " << i;
+	}
+
+	result = vkResetFences(device, 1, &fence);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(VK_NOT_READY, vkGetFenceStatus(device, fence));
+
+	// A submission without any work still signals its fence, once the earlier ones completed
+	result = vkQueueSubmit(queue, 0, nullptr, fence);
+	EXPECT_EQ(result, VK_SUCCESS);
+	result = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	// Waiting for the queue to be idle waits for every submission, including ones without a fence
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		result = vkResetEvent(device, events[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+
+		const VkSubmitInfo submitInfo =
+		{
+			VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+			nullptr,            // pNext
+			0,                  // waitSemaphoreCount
+			nullptr,            // pWaitSemaphores
+			nullptr,            // pWaitDstStageMask
+			1,                  // commandBufferCount
+			&commandBuffers[i], // pCommandBuffers
+			0,                  // signalSemaphoreCount
+			nullptr,            // pSignalSemaphores
+		};
+		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	result = vkQueueWaitIdle(queue);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		EXPECT_EQ(VK_EVENT_SET, vkGetEventStatus(device, events[i])) << "event " << i;
+	}
+
+	vkDestroyCommandPool(device, commandPool, nullptr);
+	vkDestroyFence(device, fence, nullptr);
+
+	for(VkSemaphore semaphore : semaphores)
+	{
+		vkDestroySemaphore(device, semaphore, nullptr);
+	}
+
+	for(uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		vkDestroyEvent(device, events[i], nullptr);
+	}
+
+	destroyDevice();
+}
+
+// Test the reported queue families, and that a device created with queues of several families
+// returns a distinct queue for each family and index, which executes submissions independently
+TEST_F(SwiftShaderVulkanTest, QueueFamilies)
+{
+	const VkInstanceCreateInfo createInfo =
+	{
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+		nullptr, // pApplicationInfo
+		0,       // enabledLayerCount
+		nullptr, // ppEnabledLayerNames
+		0,       // enabledExtensionCount
+		nullptr, // ppEnabledExtensionNames
+	};
+	VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	uint32_t pPhysicalDeviceCount = 1;
+	result = vkEnumeratePhysicalDevices(instance, &pPhysicalDeviceCount, &physicalDevice);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+	ASSERT_EQ(3u, queueFamilyCount);
+
+	VkQueueFamilyProperties queueFamilyProperties[3];
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties);
+	EXPECT_EQ(3u, queueFamilyCount);
+
+	EXPECT_EQ(VkQueueFlags(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT), queueFamilyProperties[0].queueFlags);
+	EXPECT_EQ(VkQueueFlags(VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT), queueFamilyProperties[1].queueFlags);
+	EXPECT_EQ(VkQueueFlags(VK_QUEUE_TRANSFER_BIT), queueFamilyProperties[2].queueFlags);
+
+	for(const VkQueueFamilyProperties& properties : queueFamilyProperties)
+	{
+		EXPECT_EQ(4u, properties.queueCount);
+		EXPECT_EQ(1u, properties.minImageTransferGranularity.width);
+		EXPECT_EQ(1u, properties.minImageTransferGranularity.height);
+		EXPECT_EQ(1u, properties.minImageTransferGranularity.depth);
+	}
+
+	// Request the families out of order, so that the queues of a family aren't stored first
+	const float queuePriorities[] = { 1.0f, 0.5f, 0.5f, 0.0f };
+	const VkDeviceQueueCreateInfo queueCreateInfos[] =
+	{
+		{
+			VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, // sType
+			nullptr,         // pNext
+			0,               // flags
+			2,               // queueFamilyIndex
+			2,               // queueCount
+			queuePriorities, // pQueuePriorities
+		},
+		{
+			VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, // sType
+			nullptr,         // pNext
+			0,               // flags
+			0,               // queueFamilyIndex
+			4,               // queueCount
+			queuePriorities, // pQueuePriorities
+		},
+		{
+			VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, // sType
+			nullptr,         // pNext
+			0,               // flags
+			1,               // queueFamilyIndex
+			1,               // queueCount
+			queuePriorities, // pQueuePriorities
+		},
+	};
+	const VkDeviceCreateInfo deviceCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, // sType
+		nullptr,           // pNext
+		0,                 // flags
+		3,                 // queueCreateInfoCount
+		queueCreateInfos,  // pQueueCreateInfos
+		0,                 // enabledLayerCount
+		nullptr,           // ppEnabledLayerNames
+		0,                 // enabledExtensionCount
+		nullptr,           // ppEnabledExtensionNames
+		nullptr,           // pEnabledFeatures
+	};
+	result = vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	std::vector<VkQueue> queues;
+	for(const VkDeviceQueueCreateInfo& queueCreateInfo : queueCreateInfos)
+	{
+		for(uint32_t i = 0; i < queueCreateInfo.queueCount; i++)
+		{
+			VkQueue queue = VK_NULL_HANDLE;
+			vkGetDeviceQueue(device, queueCreateInfo.queueFamilyIndex, i, &queue);
+			EXPECT_NE(VkQueue(VK_NULL_HANDLE), queue);
+
+			// Getting the same queue again returns the same handle
+			VkQueue again = VK_NULL_HANDLE;
+			vkGetDeviceQueue(device, queueCreateInfo.queueFamilyIndex, i, &again);
+			EXPECT_EQ(queue, again);
+
+			queues.push_back(queue);
+		}
+	}
+
+	ASSERT_EQ(7u, queues.size());
+	for(size_t i = 0; i < queues.size(); i++)
+	{
+		for(size_t j = i + 1; j < queues.size(); j++)
+		{
+			EXPECT_NE(queues[i], queues[j]) << "queues " << i << " and " << j;
+		}
+	}
+
+	const VkSemaphoreCreateInfo semaphoreCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+	};
+	VkSemaphore semaphore;
+	result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	const VkFenceCreateInfo fenceCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, // sType
+		nullptr, // pNext
+		0,       // flags
+	};
+	std::vector<VkFence> fences(queues.size());
+	for(VkFence& fence : fences)
+	{
+		result = vkCreateFence(device, &fenceCreateInfo, nullptr, &fence);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	// The first queue waits for a semaphore which only the last queue signals, so the other
+	// queues have to make progress while it's blocked
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	const VkSubmitInfo waitSubmitInfo =
+	{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+		nullptr,    // pNext
+		1,          // waitSemaphoreCount
+		&semaphore, // pWaitSemaphores
+		&waitStage, // pWaitDstStageMask
+		0,          // commandBufferCount
+		nullptr,    // pCommandBuffers
+		0,          // signalSemaphoreCount
+		nullptr,    // pSignalSemaphores
+	};
+	result = vkQueueSubmit(queues.front(), 1, &waitSubmitInfo, fences.front());
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	for(size_t i = 1; i < queues.size() - 1; i++)
+	{
+		result = vkQueueSubmit(queues[i], 0, nullptr, fences[i]);
+		EXPECT_EQ(result, VK_SUCCESS);
+	}
+
+	result = vkWaitForFences(device, static_cast<uint32_t>(fences.size() - 2), &fences[1], VK_TRUE, UINT64_MAX);
+	EXPECT_EQ(result, VK_SUCCESS);
+	EXPECT_EQ(VK_NOT_READY, vkGetFenceStatus(device, fences.front()));
+
+	const VkSubmitInfo signalSubmitInfo =
+	{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO, // sType
+		nullptr,    // pNext
+		0,          // waitSemaphoreCount
+		nullptr,    // pWaitSemaphores
+		nullptr,    // pWaitDstStageMask
+		0,          // commandBufferCount
+		nullptr,    // pCommandBuffers
+		1,          // signalSemaphoreCount
+		&semaphore, // pSignalSemaphores
+	};
+	result = vkQueueSubmit(queues.back(), 1, &signalSubmitInfo, fences.back());
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	result = vkDeviceWaitIdle(device);
+	EXPECT_EQ(result, VK_SUCCESS);
+
+	for(size_t i = 0; i < fences.size(); i++)
+	{
+		EXPECT_EQ(VK_SUCCESS, vkGetFenceStatus(device, fences[i])) << "fence " << i;
+		vkDestroyFence(device, fences[i], nullptr);
+	}
+
+	vkDestroySemaphore(device, semaphore, nullptr);
+
+	destroyDevice();
+}